@@ -34,6 +34,7 @@ TARGET   = CHER-Ob
 #======================================================================
 HEADERS += ../src/mainWindow.h \
     ../src/vtkEnums.h \
+    ../src/function/bandCube.h \
     ../src/function/coeffenhanc.h \
     ../src/function/CTControl.h \
     ../src/function/defaultrendering.h \
@@ -45,6 +46,11 @@ HEADERS += ../src/mainWindow.h \
     ../src/function/lightControl.h \
     ../src/function/lightControlRTI.h \
     ../src/function/loadingdlg.h \
+    ../src/function/meshFlattener.h \
+    ../src/function/meshGeodesic.h \
+    ../src/function/meshLocator.h \
+    ../src/function/meshLOD.h \
+    ../src/function/meshSelection.h \
     ../src/function/mkColorConvert.h \
     ../src/function/mkTools.hpp \
     ../src/function/navigation.h \
@@ -58,12 +64,20 @@ HEADERS += ../src/mainWindow.h \
     ../src/function/reportFilter.h \
     ../src/function/reportGenerator.h \
     ../src/function/rtiBrowser.h \
+    ../src/function/spectralAnalysis.h \
     ../src/function/spectralPlot.h \
+    ../src/function/spectralProbe.h \
+    ../src/function/spectralSimilarity.h \
     ../src/function/specularenhanc.h \
     ../src/function/unsharpmasking.h \
+    ../src/io/bestviewindex.h \
     ../src/io/hsh.h \
+    ../src/io/hyperCubeCache.h \
+    ../src/io/inputimagecache.h \
     ../src/io/inputimageset.h \
+    ../src/io/meshCache.h \
     ../src/io/multiviewrti.h \
+    ../src/io/objReader.h \
     ../src/io/ptm.h \
     ../src/io/ptmCoeffVectorized.h \
     ../src/io/pyramid.h \
@@ -74,6 +88,7 @@ HEADERS += ../src/mainWindow.h \
     ../src/io/vtkOpenEXR.h \
     ../src/io/vtkPLYReader2.h \
     ../src/io/vtkVRMLSource2.h \
+    ../src/visualization/annotationMarks.h \
     ../src/visualization/lscm_engine.h \
     ../src/visualization/myVTKInteractorStyle.h \
     ../src/visualization/vcgRTIviewer.h \
@@ -94,15 +109,20 @@ HEADERS += ../src/mainWindow.h \
     ../src/CHE/saveCHEAsDialog.h \
     ../src/information/annotationFilterDialog.h \
     ../src/information/bookmark.h \
+    ../src/information/bookmarkStore.h \
     ../src/information/bookmarkTreeWidget.h \
     ../src/information/bookmarkWidget.h \
     ../src/information/bookmarkXMLReader.h \
+    ../src/information/cellIdCodec.h \
     ../src/information/fileInfoDialog.h \
     ../src/information/imageNote.h \
     ../src/information/informationWidget.h \
     ../src/information/metadata.h \
     ../src/information/newProjectDialog.h \
     ../src/information/note.h \
+    ../src/information/noteIndex.h \
+    ../src/information/noteRegistry.h \
+    ../src/information/noteSearcher.h \
     ../src/information/openWindowDialog.h \
     ../src/information/projectInfoDialog.h \
     ../src/information/removeObjectDialog.h \
@@ -110,6 +130,7 @@ HEADERS += ../src/mainWindow.h \
     ../src/information/searchWidget.h
 SOURCES += ../src/main.cpp \
     ../src/mainWindow.cpp \
+    ../src/function/bandCube.cpp \
     ../src/function/coeffenhanc.cpp \
     ../src/function/CTControl.cpp \
     ../src/function/detailenhanc.cpp \
@@ -120,6 +141,11 @@ SOURCES += ../src/main.cpp \
     ../src/function/lightControl.cpp \
     ../src/function/lightControlRTI.cpp \
     ../src/function/loadingdlg.cpp \
+    ../src/function/meshFlattener.cpp \
+    ../src/function/meshGeodesic.cpp \
+    ../src/function/meshLocator.cpp \
+    ../src/function/meshLOD.cpp \
+    ../src/function/meshSelection.cpp \
     ../src/function/mkColorConvert.cpp \
     ../src/function/navigation.cpp \
     ../src/function/normalenhanc.cpp \
@@ -131,12 +157,20 @@ SOURCES += ../src/main.cpp \
     ../src/function/reportFilter.cpp \
     ../src/function/reportGenerator.cpp \
     ../src/function/rtiBrowser.cpp \
+    ../src/function/spectralAnalysis.cpp \
     ../src/function/spectralPlot.cpp \
+    ../src/function/spectralProbe.cpp \
+    ../src/function/spectralSimilarity.cpp \
     ../src/function/specularenhanc.cpp \
     ../src/function/unsharpmasking.cpp \
+    ../src/io/bestviewindex.cpp \
     ../src/io/hsh.cpp \
+    ../src/io/hyperCubeCache.cpp \
+    ../src/io/inputimagecache.cpp \
     ../src/io/inputimageset.cpp \
+    ../src/io/meshCache.cpp \
     ../src/io/multiviewrti.cpp \
+    ../src/io/objReader.cpp \
     ../src/io/ptm.cpp \
     ../src/io/readCHEROb.cpp \
     ../src/io/universalrti.cpp \
@@ -154,21 +188,27 @@ SOURCES += ../src/main.cpp \
     ../src/CHE/saveCHEAsDialog.cpp \
     ../src/information/annotationFilterDialog.cpp \
     ../src/information/bookmark.cpp \
+    ../src/information/bookmarkStore.cpp \
     ../src/information/bookmarkTreeWidget.cpp \
     ../src/information/bookmarkWidget.cpp \
     ../src/information/bookmarkXMLReader.cpp \
+    ../src/information/cellIdCodec.cpp \
     ../src/information/fileInfoDialog.cpp \
     ../src/information/imageNote.cpp \
     ../src/information/informationWidget.cpp \
     ../src/information/metadata.cpp \
     ../src/information/newProjectDialog.cpp \
     ../src/information/note.cpp \
+    ../src/information/noteIndex.cpp \
+    ../src/information/noteRegistry.cpp \
+    ../src/information/noteSearcher.cpp \
     ../src/information/openWindowDialog.cpp \
     ../src/information/projectInfoDialog.cpp \
     ../src/information/removeObjectDialog.cpp \
     ../src/information/saveProjectAsDialog.cpp \
     ../src/information/searchWidget.cpp \
     ../src/NL/nl_single_file.c \
+    ../src/visualization/annotationMarks.cpp \
     ../src/visualization/lscm_engine.cpp \
     ../src/visualization/vcgRTIviewer.cpp \
     ../src/visualization/vtkInteractorStyleSurfaceWalkerCamera.cpp \
@@ -26,8 +26,9 @@
 *****************************************************************************/
 #include "importFromCHEDialog.h"
 #include "../vtkEnums.h"
+#include "../information/noteIndex.h"
 
-ImportFromCHEDialog::ImportFromCHEDialog(QVector<QString> objects)
+ImportFromCHEDialog::ImportFromCHEDialog(QVector<QString> objects, QVector<QString> notePaths)
 {
 	mDialog = new QDialog();
 	mVbox = new QVBoxLayout();
@@ -39,21 +40,36 @@ ImportFromCHEDialog::ImportFromCHEDialog(QVector<QString> objects)
 	mTreeWidget = new QTreeWidget();
 	QStringList ColumnNames;
 	ColumnNames << "Object";
+	bool hasCounts = notePaths.size() == objects.size() && !objects.isEmpty();
+	if (hasCounts)
+	{
+		ColumnNames << "Notes";
+		mTreeWidget->setColumnCount(2);
+		mTreeWidget->setColumnWidth(0, 275);
+	}
 	mTreeWidget->setHeaderLabels(ColumnNames);
 	mObject = objects;
 	for (int i = 0; i < objects.size() + 1; i++)
 	{
 		QTreeWidgetItem *item = new QTreeWidgetItem();
+		NoteIndex::Facets facets;
 		if (i == 0)
 			item->setText(0, QString("Category Information"));
 		else
 			item->setText(0, QString(objects[i - 1]));
+		if (i > 0 && hasCounts)
+		{
+			facets = NoteIndex::instance(notePaths[i - 1])->facets();
+			item->setText(1, QString::number(facets.total));
+		}
 		item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
 		item->setCheckState(0, Qt::Unchecked);
 		for (int j = 0; j < 11; j++)
 		{
 			QTreeWidgetItem *child = new QTreeWidgetItem();
 			child->setText(0, QString(num2category(j).c_str()));
+			if (i > 0 && hasCounts)
+				child->setText(1, QString::number(facets.categoryCount(j)));
 			child->setFlags(child->flags() | Qt::ItemIsUserCheckable);
 			child->setCheckState(0, Qt::Unchecked);
 			item->addChild(child);
@@ -64,9 +64,10 @@ class ImportFromCHEDialog : public QWidget
 public:
 	/**
 	 * @brief  Constructor. 
-	 * @param  objects  the vector of objects' full paths.
+	 * @param  objects    the vector of objects' full paths.
+	 * @param  notePaths  the Note folder of each object; if given, the note numbers of each category are shown.
 	 */
-	ImportFromCHEDialog(QVector<QString> objects);
+	ImportFromCHEDialog(QVector<QString> objects, QVector<QString> notePaths = QVector<QString>());
 
 	/**
 	 * @brief  Get the filter result, which contains all the objects that are not selected for import.
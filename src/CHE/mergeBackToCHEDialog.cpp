@@ -27,6 +27,7 @@
 #include "mergeBackToCHEDialog.h"
 #include "exportToProjectDialog.h"
 #include "mergeBackToCHELocationDialog.h"
+#include "../information/noteIndex.h"
 
 MergeBackToCHEDialog::MergeBackToCHEDialog(QMap<QString, QString> objects)
 {
@@ -39,8 +40,8 @@ MergeBackToCHEDialog::MergeBackToCHEDialog(QMap<QString, QString> objects)
 
 	mTreeWidget = new QTreeWidget();
 	QStringList ColumnNames;
-	mTreeWidget->setColumnCount(2);
-	ColumnNames << "Object" << "Location";
+	mTreeWidget->setColumnCount(3);
+	ColumnNames << "Object" << "Location" << "Notes";
 	mTreeWidget->setHeaderLabels(ColumnNames);
 	mTreeWidget->setColumnWidth(0, 275);
 	mTreeWidget->setColumnWidth(1, 120);
@@ -48,14 +49,18 @@ MergeBackToCHEDialog::MergeBackToCHEDialog(QMap<QString, QString> objects)
 	for (QMap<QString, QString>::iterator it = objects.begin(); it != objects.end(); it++)
 	{
 		QTreeWidgetItem *item = new QTreeWidgetItem();
+		// note numbers come from the object's note index, without reading the notes
+		NoteIndex::Facets facets = NoteIndex::instance(it.key() + QDir::separator() + QString("Note"))->facets();
 		item->setText(0, QString(it.key()));
 		item->setText(1, QString(it.value()));
+		item->setText(2, QString::number(facets.total));
 		item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
 		item->setCheckState(0, Qt::Unchecked);
 		for (int j = 0; j < 11; j++)
 		{
 			QTreeWidgetItem *child = new QTreeWidgetItem();
 			child->setText(0, QString(num2category(j).c_str()));
+			child->setText(2, QString::number(facets.categoryCount(j)));
 			child->setFlags(child->flags() | Qt::ItemIsUserCheckable);
 			child->setCheckState(0, Qt::Unchecked);
 			item->addChild(child);
@@ -1164,11 +1164,52 @@ static void nlSparseMatrix_mult_cols(
     }
 }
 
+/*
+ * Symmetric matrix stored both as rows (lower triangle) and columns
+ * (upper triangle), which is the layout the SSOR preconditioner asks for.
+ * Every y[i] is then a pure gather over row i and column i, so the rows
+ * are independent and can be shared among threads.
+ */
+static void nlSparseMatrix_mult_rows_cols_symmetric(
+        NLSparseMatrix* A,
+        NLdouble* x,
+        NLdouble* y) {
+    NLint n = (NLint)A->n ;
+    NLint i ;
+#ifdef _OPENMP
+    #pragma omp parallel for private(i) schedule(dynamic, 256) if(n > 4096)
+#endif
+    for(i=0; i<n; i++) {
+        NLuint ij ;
+        NLRowColumn* Ri = &(A->row[i]) ;
+        NLRowColumn* Ci = &(A->column[i]) ;
+        NLCoeff* c = NULL ;
+        NLdouble S = 0.0 ;
+        for(ij=0; ij<Ri->size; ij++) {
+            c = &(Ri->coeff[ij]) ;
+            S += c->value * x[c->index] ;
+        }
+        for(ij=0; ij<Ci->size; ij++) {
+            c = &(Ci->coeff[ij]) ;
+            if(c->index != (NLuint)i) {
+                S += c->value * x[c->index] ;
+            }
+        }
+        y[i] = S ;
+    }
+}
+
 /************************************************************************************/
 /* SparseMatrix x Vector routines, main driver routine */
 
 void nlSparseMatrixMult(NLSparseMatrix* A, NLdouble* x, NLdouble* y) {
-    if(A->storage & NL_MATRIX_STORE_ROWS) {
+    if(
+        (A->storage & NL_MATRIX_STORE_ROWS) &&
+        (A->storage & NL_MATRIX_STORE_COLUMNS) &&
+        (A->storage & NL_MATRIX_STORE_SYMMETRIC)
+    ) {
+        nlSparseMatrix_mult_rows_cols_symmetric(A, x, y) ;
+    } else if(A->storage & NL_MATRIX_STORE_ROWS) {
         if(A->storage & NL_MATRIX_STORE_SYMMETRIC) {
             nlSparseMatrix_mult_rows_symmetric(A, x, y) ;
         } else {
@@ -0,0 +1,268 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkImageData.h>
+
+#include "bandCube.h"
+
+#define PIXELBLOCK (64) // pixels transposed per block, keeps a block of the cube in cache
+
+BandCube::BandCube()
+{
+  mHyperImage = NULL;
+  clear();
+}
+
+BandCube::~BandCube()
+{
+  mFuture.waitForFinished();
+}
+
+void BandCube::clear()
+{
+  mWidth = mHeight = mBands = 0;
+  mIsBuilt = false;
+  std::vector<float>().swap(mBsq);
+  mMin.clear();
+  mMax.clear();
+  mHistograms.clear();
+}
+
+void BandCube::setImageData(vtkImageData* hyperImage)
+{
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+
+  mHyperImage = hyperImage;
+  clear();
+  if (!hyperImage || hyperImage->GetScalarType() != VTK_FLOAT)
+    return;
+
+  int dims[3];
+  hyperImage->GetDimensions(dims);
+  if (dims[0] <= 0 || dims[1] <= 0 || hyperImage->GetNumberOfScalarComponents() <= 0)
+    return;
+  mWidth = dims[0];
+  mHeight = dims[1];
+  mBands = hyperImage->GetNumberOfScalarComponents();
+}
+
+void BandCube::build()
+{
+  QMutexLocker locker(&mMutex);
+  if (mIsBuilt || mFuture.isRunning() || mBands <= 0)
+    return;
+  mFuture = QtConcurrent::run(this, &BandCube::buildMirror);
+}
+
+bool BandCube::isReady()
+{
+  QMutexLocker locker(&mMutex);
+  return mIsBuilt;
+}
+
+void BandCube::waitForMirror()
+{
+  build();
+  mFuture.waitForFinished();
+}
+
+void BandCube::buildMirror()
+{
+  const float* cube = static_cast<const float*>(mHyperImage->GetScalarPointer());
+  if (!cube)
+  {
+    // nothing to mirror; an empty cube stops callers from waiting for it
+    QMutexLocker locker(&mMutex);
+    mBands = 0;
+    return;
+  }
+
+  const int numPixels = mWidth * mHeight;
+  const int numBlocks = (numPixels + PIXELBLOCK - 1) / PIXELBLOCK;
+  const int bands = mBands;
+  std::vector<float> bsq((size_t)numPixels * bands);
+  float* pbsq = &bsq[0];
+
+  // BIP -> BSQ transpose, one block of pixels at a time
+  int k = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(k) schedule(static)
+  for (k = 0; k < numBlocks; k++)
+  {
+    int pBegin = k * PIXELBLOCK;
+    int pEnd = std::min(pBegin + PIXELBLOCK, numPixels);
+    for (int c = 0; c < bands; c++)
+    {
+      const float* src = cube + (size_t)pBegin * bands + c;
+      float* dst = pbsq + (size_t)c * numPixels;
+      for (int p = pBegin; p < pEnd; p++, src += bands)
+        dst[p] = *src;
+    }
+  }
+
+  // per-band statistics over contiguous memory
+  std::vector<float> bmin(bands), bmax(bands);
+  std::vector<std::vector<int> > histograms(bands, std::vector<int>(BANDCUBE_HISTOGRAM_BINS, 0));
+  int c = 0;
+  #pragma omp parallel for private(c) schedule(dynamic, 1)
+  for (c = 0; c < bands; c++)
+  {
+    const float* band = pbsq + (size_t)c * numPixels;
+    float lo = band[0], hi = band[0];
+    for (int p = 1; p < numPixels; p++)
+    {
+      if (band[p] < lo) lo = band[p];
+      if (band[p] > hi) hi = band[p];
+    }
+    bmin[c] = lo;
+    bmax[c] = hi;
+
+    int* hist = &histograms[c][0];
+    float scale = (hi > lo) ? (BANDCUBE_HISTOGRAM_BINS - 1) / (hi - lo) : 0.f;
+    for (int p = 0; p < numPixels; p++)
+    {
+      int bin = (int)((band[p] - lo) * scale);
+      if (bin >= 0 && bin < BANDCUBE_HISTOGRAM_BINS) hist[bin]++; // skips NaN
+    }
+  }
+
+  QMutexLocker locker(&mMutex);
+  mBsq.swap(bsq);
+  mMin.swap(bmin);
+  mMax.swap(bmax);
+  mHistograms.swap(histograms);
+  mIsBuilt = true;
+}
+
+const float* BandCube::getBand(int band)
+{
+  waitForMirror();
+  if (!mIsBuilt || band < 0 || band >= mBands)
+    return NULL;
+  return &mBsq[(size_t)band * mWidth * mHeight];
+}
+
+float BandCube::getBandMin(int band)
+{
+  waitForMirror();
+  if (!mIsBuilt || band < 0 || band >= mBands)
+    return 0.f;
+  return mMin[band];
+}
+
+float BandCube::getBandMax(int band)
+{
+  waitForMirror();
+  if (!mIsBuilt || band < 0 || band >= mBands)
+    return 0.f;
+  return mMax[band];
+}
+
+const std::vector<int>& BandCube::getBandHistogram(int band)
+{
+  static const std::vector<int> empty;
+  waitForMirror();
+  if (!mIsBuilt || band < 0 || band >= mBands)
+    return empty;
+  return mHistograms[band];
+}
+
+void BandCube::getBandRange(int band, double lowFraction, double highFraction, float& low, float& high)
+{
+  low = high = 0.f;
+  waitForMirror();
+  if (!mIsBuilt || band < 0 || band >= mBands)
+    return;
+
+  const std::vector<int>& hist = mHistograms[band];
+  const double total = (double)mWidth * mHeight;
+  const float binWidth = (mMax[band] - mMin[band]) / (BANDCUBE_HISTOGRAM_BINS - 1);
+
+  int lowBin = 0, highBin = BANDCUBE_HISTOGRAM_BINS - 1;
+  double count = 0;
+  for (int i = 0; i < BANDCUBE_HISTOGRAM_BINS; i++)
+  {
+    count += hist[i];
+    if (count > lowFraction * total) { lowBin = i; break; }
+  }
+  count = 0;
+  for (int i = BANDCUBE_HISTOGRAM_BINS - 1; i >= 0; i--)
+  {
+    count += hist[i];
+    if (count > (1.0 - highFraction) * total) { highBin = i; break; }
+  }
+  if (highBin < lowBin)
+    std::swap(lowBin, highBin);
+
+  low = mMin[band] + lowBin * binWidth;
+  high = mMin[band] + (highBin + 1) * binWidth;
+  if (high > mMax[band]) high = mMax[band];
+}
+
+bool BandCube::composite(int r, int g, int b, vtkImageData* rgbImage, double clipFraction)
+{
+  if (!rgbImage)
+    return false;
+  const float* bands[3] = {getBand(r), getBand(g), getBand(b)};
+  if (!bands[0] || !bands[1] || !bands[2])
+    return false;
+
+  float offset[3], scale[3];
+  int selected[3] = {r, g, b};
+  for (int k = 0; k < 3; k++)
+  {
+    float low, high;
+    getBandRange(selected[k], clipFraction, 1.0 - clipFraction, low, high);
+    offset[k] = low;
+    scale[k] = (high > low) ? 255.f / (high - low) : 0.f;
+  }
+
+  rgbImage->SetDimensions(mWidth, mHeight, 1);
+  rgbImage->SetScalarTypeToUnsignedChar();
+  rgbImage->SetNumberOfScalarComponents(3);
+  rgbImage->AllocateScalars();
+  unsigned char* out = static_cast<unsigned char*>(rgbImage->GetScalarPointer());
+
+  const int numPixels = mWidth * mHeight;
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    for (int k = 0; k < 3; k++)
+    {
+      float value = (bands[k][p] - offset[k]) * scale[k];
+      out[3 * p + k] = (unsigned char)(value < 0.f ? 0.f : (value > 255.f ? 255.f : value));
+    }
+  }
+  rgbImage->Modified();
+  return true;
+}
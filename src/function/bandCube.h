@@ -0,0 +1,87 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef BANDCUBE_H
+#define BANDCUBE_H
+
+#include <vector>
+#include <QFuture>
+#include <QMutex>
+
+class vtkImageData;
+
+#define BANDCUBE_HISTOGRAM_BINS (256)
+
+// Band-sequential mirror of the band-interleaved hyperspectral cube (mHyperImageData).
+// The mirror and the per-band min/max/histograms are built once in a background thread
+// the first time they are requested, so that extracting one band or a three band
+// false-colour composite reads contiguous memory instead of re-striding the whole cube.
+class BandCube
+{
+public:
+  BandCube();
+  ~BandCube();
+
+  // only remembers the cube; nothing is copied until build() or a band is requested
+  void setImageData(vtkImageData* hyperImage);
+  // starts building the mirror in the background (no-op if already built or running)
+  void build();
+  bool isReady();
+
+  int getWidth() const {return mWidth;}
+  int getHeight() const {return mHeight;}
+  int getNumberOfBands() const {return mBands;}
+
+  // the accessors below block until the mirror is ready
+  const float* getBand(int band);
+  float getBandMin(int band);
+  float getBandMax(int band);
+  const std::vector<int>& getBandHistogram(int band);
+  // value range between the given lower/upper fractions of the band histogram (e.g. 0.02, 0.98)
+  void getBandRange(int band, double lowFraction, double highFraction, float& low, float& high);
+
+  // writes bands (r, g, b) into a 3-channel unsigned char image of the cube size,
+  // linearly stretched between the clipFraction percentiles of each band
+  bool composite(int r, int g, int b, vtkImageData* rgbImage, double clipFraction = 0.01);
+
+private:
+  void buildMirror();
+  void waitForMirror();
+  void clear();
+
+  vtkImageData* mHyperImage;
+  int mWidth;
+  int mHeight;
+  int mBands;
+  bool mIsBuilt;
+
+  std::vector<float> mBsq; // band after band, mWidth*mHeight floats each
+  std::vector<float> mMin;
+  std::vector<float> mMax;
+  std::vector<std::vector<int> > mHistograms;
+
+  QFuture<void> mFuture;
+  QMutex mMutex;
+};
+
+#endif // BANDCUBE_H
@@ -0,0 +1,157 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkIdList.h>
+#include <vtkPoints.h>
+#include <vtkLandmarkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+#include "meshFlattener.h"
+#include "../visualization/lscm_engine.h"
+
+MeshFlattener::MeshFlattener(QObject* parent)
+  : QObject(parent), mEngine(new LSCM()), mHasPending(false), mGeneration(0), mMinGeneration(0)
+{
+  connect(&mWatcher, SIGNAL(finished()), this, SLOT(jobFinished()));
+}
+
+MeshFlattener::~MeshFlattener()
+{
+  cancel();
+  mFuture.waitForFinished();
+  delete mEngine;
+}
+
+void MeshFlattener::request(vtkPolyData* subset, vtkIdType localTargetFaceID, const double target[3][3])
+{
+  if (!subset || localTargetFaceID < 0 || localTargetFaceID >= subset->GetNumberOfCells())
+    return;
+
+  Job job;
+  job.subset = subset;
+  job.localTargetFaceID = localTargetFaceID;
+  for (int k = 0; k < 3; k++)
+    for (int c = 0; c < 3; c++)
+      job.target[k][c] = target[k][c];
+  job.generation = ++mGeneration;
+
+  if (mFuture.isRunning())
+  {
+    mPending = job;
+    mHasPending = true;
+    return;
+  }
+  start(job);
+}
+
+void MeshFlattener::cancel()
+{
+  QMutexLocker locker(&mMutex);
+  mMinGeneration = mGeneration + 1;
+  mHasPending = false;
+  mPending.subset = NULL;
+}
+
+void MeshFlattener::reset()
+{
+  cancel();
+  mFuture.waitForFinished();
+  mEngine->resetWarmStart();
+  mResult = NULL;
+}
+
+void MeshFlattener::start(const Job& job)
+{
+  mFuture = QtConcurrent::run(this, &MeshFlattener::flatten, job);
+  mWatcher.setFuture(mFuture);
+}
+
+void MeshFlattener::jobFinished()
+{
+  Result result = mFuture.result();
+  bool isCancelled;
+  {
+    QMutexLocker locker(&mMutex);
+    isCancelled = result.generation < mMinGeneration;
+  }
+  // a newer request may be waiting, but this result is still closer to the
+  // camera than the one on screen
+  if (!isCancelled && result.mesh)
+  {
+    mResult = result.mesh;
+    emit flattened();
+  }
+  if (mHasPending)
+  {
+    Job job = mPending;
+    mHasPending = false;
+    mPending.subset = NULL;
+    start(job);
+  }
+}
+
+MeshFlattener::Result MeshFlattener::flatten(Job job)
+{
+  Result result;
+  result.generation = job.generation;
+  {
+    QMutexLocker locker(&mMutex);
+    if (job.generation < mMinGeneration)
+      return result;
+  }
+  mEngine->FlattenMesh(job.subset);
+  result.mesh = alignWithTarget(job);
+  return result;
+}
+
+vtkSmartPointer<vtkPolyData> MeshFlattener::alignWithTarget(const Job& job)
+{
+  vtkSmartPointer<vtkIdList> vertexListFlat = vtkSmartPointer<vtkIdList>::New();
+  job.subset->GetCellPoints(job.localTargetFaceID, vertexListFlat);
+  if (vertexListFlat->GetNumberOfIds() < 3)
+    return NULL;
+
+  vtkSmartPointer<vtkPoints> sourcePts = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkPoints> targetPts = vtkSmartPointer<vtkPoints>::New();
+  for (int k = 0; k < 3; k++)
+  {
+    sourcePts->InsertNextPoint(job.subset->GetPoint(vertexListFlat->GetId(k)));
+    targetPts->InsertNextPoint(job.target[k]);
+  }
+  vtkSmartPointer<vtkLandmarkTransform> landmarkTransform = vtkSmartPointer<vtkLandmarkTransform>::New();
+  landmarkTransform->SetSourceLandmarks(sourcePts);
+  landmarkTransform->SetTargetLandmarks(targetPts);
+  landmarkTransform->SetModeToSimilarity();
+  landmarkTransform->Update();
+
+  vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  transformFilter->SetInput(job.subset);
+  transformFilter->SetTransform(landmarkTransform);
+  transformFilter->Update();
+  vtkSmartPointer<vtkPolyData> aligned = vtkSmartPointer<vtkPolyData>::New();
+  aligned->ShallowCopy(transformFilter->GetOutput());
+  return aligned;
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHFLATTENER_H
+#define MESHFLATTENER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+class LSCM;
+
+// Flattens the surface walker's subsets with LSCM in a background thread, one at
+// a time. A request made while a solve is running waits and replaces any older
+// waiting request; results arrive in request order through flattened() and the
+// last one stays available so the widget can keep it on screen meanwhile.
+// The solver keeps its previous solution, so walking on re-solves only the band
+// of the surface that came into view.
+class MeshFlattener : public QObject
+{
+  Q_OBJECT
+
+public:
+  MeshFlattener(QObject* parent = 0);
+  ~MeshFlattener();
+
+  // subset is handed over and flattened in place; the flat mesh is then aligned
+  // by similarity so that cell localTargetFaceID lands on the triangle target
+  void request(vtkPolyData* subset, vtkIdType localTargetFaceID, const double target[3][3]);
+  // drops the waiting request and the result of the running one
+  void cancel();
+  // cancel() and forget the previous solution (another mesh is being walked)
+  void reset();
+
+  bool isBusy() const {return mFuture.isRunning();}
+  // last flattening delivered by flattened()
+  vtkPolyData* getResult() const {return mResult;}
+
+signals:
+  void flattened();
+
+private slots:
+  void jobFinished();
+
+private:
+  struct Job
+  {
+    vtkSmartPointer<vtkPolyData> subset;
+    vtkIdType localTargetFaceID;
+    double target[3][3];
+    int generation;
+  };
+  struct Result
+  {
+    vtkSmartPointer<vtkPolyData> mesh;
+    int generation;
+  };
+
+  void start(const Job& job);
+  Result flatten(Job job);
+  static vtkSmartPointer<vtkPolyData> alignWithTarget(const Job& job);
+
+  LSCM* mEngine; // only ever used by the running job
+  vtkSmartPointer<vtkPolyData> mResult;
+  Job mPending;
+  bool mHasPending;
+  int mGeneration;    // of the latest request
+  int mMinGeneration; // requests older than this were cancelled
+
+  QFuture<Result> mFuture;
+  QFutureWatcher<Result> mWatcher;
+  QMutex mMutex;
+};
+
+#endif // MESHFLATTENER_H
@@ -0,0 +1,391 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <functional>
+#include <algorithm>
+
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellType.h>
+
+#include "meshGeodesic.h"
+
+#define INITIAL_BOUND (1.5) // first search region: |x - start| + |x - end| < 1.5 * |start - end|
+#define MAX_ROUNDS (32)
+
+typedef std::pair<double, int> HeapEntry;
+typedef std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry> > Heap;
+
+static double distance(const double* a, const double* b)
+{
+  double d0 = a[0] - b[0], d1 = a[1] - b[1], d2 = a[2] - b[2];
+  return sqrt(d0*d0 + d1*d1 + d2*d2);
+}
+
+MeshGeodesic::MeshGeodesic()
+  : mMesh(NULL), mIsBuilt(false), mCurrentStamp(0)
+{
+}
+
+MeshGeodesic::~MeshGeodesic()
+{
+  mFuture.waitForFinished();
+}
+
+void MeshGeodesic::build(vtkPolyData* mesh)
+{
+  QMutexLocker locker(&mMutex);
+  if (mesh == mMesh && (mIsBuilt || mFuture.isRunning()))
+    return;
+  locker.unlock();
+  clear();
+  if (!mesh || mesh->GetNumberOfCells() == 0)
+    return;
+
+  locker.relock();
+  mMesh = mesh;
+  // build the cell table here so that the worker only reads the mesh
+  mesh->GetCellType(0);
+  mFuture = QtConcurrent::run(this, &MeshGeodesic::buildTables);
+}
+
+void MeshGeodesic::clear()
+{
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+  mMesh = NULL;
+  mIsBuilt = false;
+  std::vector<double>().swap(mPoints);
+  std::vector<int>().swap(mTriangles);
+  std::vector<int>().swap(mCellTriangles);
+  std::vector<int>().swap(mVertexOffsets);
+  std::vector<int>().swap(mVertexTriangles);
+  std::vector<double>().swap(mDistance);
+  std::vector<unsigned int>().swap(mStamp);
+  std::vector<char>().swap(mIsFrozen);
+}
+
+bool MeshGeodesic::isReady()
+{
+  QMutexLocker locker(&mMutex);
+  return mIsBuilt;
+}
+
+void MeshGeodesic::buildTables()
+{
+  int numPoints = mMesh->GetNumberOfPoints();
+  int numCells = mMesh->GetNumberOfCells();
+  int i;
+
+  mPoints.resize(3 * numPoints);
+#pragma omp parallel for private(i)
+  for (i = 0; i < numPoints; i++)
+    mMesh->GetPoint(i, &mPoints[3 * i]);
+
+  // polygons are fanned, strips are unrolled; lines and vertices have no triangles
+  mCellTriangles.assign(numCells + 1, 0);
+  for (i = 0; i < numCells; i++)
+  {
+    vtkIdType npts, *pts;
+    mMesh->GetCellPoints(i, npts, pts);
+    int type = mMesh->GetCellType(i);
+    bool isSurface = type == VTK_TRIANGLE || type == VTK_QUAD || type == VTK_POLYGON || type == VTK_TRIANGLE_STRIP;
+    mCellTriangles[i + 1] = mCellTriangles[i] + (isSurface && npts >= 3 ? (int)npts - 2 : 0);
+  }
+  int numTriangles = mCellTriangles[numCells];
+  mTriangles.resize(3 * numTriangles);
+#pragma omp parallel for private(i)
+  for (i = 0; i < numCells; i++)
+  {
+    vtkIdType npts, *pts;
+    mMesh->GetCellPoints(i, npts, pts);
+    bool isStrip = mMesh->GetCellType(i) == VTK_TRIANGLE_STRIP;
+    int* tri = mTriangles.empty() ? NULL : &mTriangles[3 * mCellTriangles[i]];
+    for (int j = 0; j < mCellTriangles[i + 1] - mCellTriangles[i]; j++)
+    {
+      tri[3*j] = isStrip ? pts[j] : pts[0];
+      tri[3*j + 1] = pts[j + 1];
+      tri[3*j + 2] = pts[j + 2];
+    }
+  }
+
+  mVertexOffsets.assign(numPoints + 1, 0);
+  for (i = 0; i < 3 * numTriangles; i++)
+    mVertexOffsets[mTriangles[i] + 1]++;
+  for (i = 0; i < numPoints; i++)
+    mVertexOffsets[i + 1] += mVertexOffsets[i];
+  mVertexTriangles.resize(mVertexOffsets[numPoints]);
+  std::vector<int> cursor(mVertexOffsets.begin(), mVertexOffsets.end() - 1);
+  for (i = 0; i < 3 * numTriangles; i++)
+    mVertexTriangles[cursor[mTriangles[i]]++] = i / 3;
+
+  mDistance.resize(numPoints);
+  mStamp.assign(numPoints, 0);
+  mIsFrozen.resize(numPoints);
+  mCurrentStamp = 0;
+
+  QMutexLocker locker(&mMutex);
+  mIsBuilt = true;
+}
+
+double MeshGeodesic::computeDistance(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, vtkPoints* path)
+{
+  mFuture.waitForFinished();
+  if (!isReady() || startCell < 0 || endCell < 0
+      || startCell >= (vtkIdType)mCellTriangles.size() - 1 || endCell >= (vtkIdType)mCellTriangles.size() - 1)
+    return -1;
+  if (startCell == endCell)
+  {
+    // a cell is flat, the straight segment lies on it
+    if (path)
+    {
+      path->Reset();
+      path->InsertNextPoint(start);
+      path->InsertNextPoint(end);
+    }
+    return distance(start, end);
+  }
+
+  // the first region must at least reach across the two picked cells
+  std::vector<int> vertices;
+  double slack = 0;
+  cellVertices(startCell, vertices);
+  for (size_t k = 0; k < vertices.size(); k++)
+    slack = std::max(slack, distance(&mPoints[3 * vertices[k]], start));
+  cellVertices(endCell, vertices);
+  for (size_t k = 0; k < vertices.size(); k++)
+    slack = std::max(slack, distance(&mPoints[3 * vertices[k]], end));
+  double bound = INITIAL_BOUND * distance(start, end) + 2 * slack;
+
+  // Any point x on a path of length L satisfies |x - start| + |x - end| <= L, so
+  // once the path found inside the region is no longer than the region bound,
+  // enlarging the region cannot give a shorter one.
+  double length = -1;
+  for (int round = 0; round < MAX_ROUNDS; round++)
+  {
+    bool isClipped;
+    length = march(start, startCell, end, endCell, bound, isClipped);
+    if (!isClipped || (length >= 0 && length <= bound))
+      break;
+    bound = length >= 0 ? length * 1.01 : bound * 2;
+  }
+
+  if (length >= 0 && path)
+    tracePath(start, startCell, end, endCell, path);
+  return length;
+}
+
+void MeshGeodesic::cellVertices(vtkIdType cellId, std::vector<int>& vertices) const
+{
+  vertices.clear();
+  for (int t = mCellTriangles[cellId]; t < mCellTriangles[cellId + 1]; t++)
+    for (int k = 0; k < 3; k++)
+      if (std::find(vertices.begin(), vertices.end(), mTriangles[3*t + k]) == vertices.end())
+        vertices.push_back(mTriangles[3*t + k]);
+}
+
+void MeshGeodesic::touch(int v)
+{
+  if (mStamp[v] == mCurrentStamp)
+    return;
+  mStamp[v] = mCurrentStamp;
+  mDistance[v] = std::numeric_limits<double>::max();
+  mIsFrozen[v] = 0;
+}
+
+// Distance at c from the front through the frozen vertices a and b, assuming it is
+// locally planar across the triangle. Returns max() when the front does not come
+// from inside the triangle (obtuse corners), the caller then uses the edges.
+double MeshGeodesic::updateTriangle(int c, int a, int b) const
+{
+  const double* pc = &mPoints[3 * c];
+  double x1[3], x2[3];
+  for (int k = 0; k < 3; k++)
+  {
+    x1[k] = mPoints[3*a + k] - pc[k];
+    x2[k] = mPoints[3*b + k] - pc[k];
+  }
+  double g11 = x1[0]*x1[0] + x1[1]*x1[1] + x1[2]*x1[2];
+  double g12 = x1[0]*x2[0] + x1[1]*x2[1] + x1[2]*x2[2];
+  double g22 = x2[0]*x2[0] + x2[1]*x2[1] + x2[2]*x2[2];
+  double det = g11 * g22 - g12 * g12;
+  if (det <= 1e-12 * g11 * g22)
+    return std::numeric_limits<double>::max();
+  double q11 = g22 / det, q12 = -g12 / det, q22 = g11 / det;
+
+  // |grad T| = 1 for the linear T taking the values ta, tb at a, b and p at c
+  double ta = mDistance[a], tb = mDistance[b];
+  double qa = q11 + q12, qb = q12 + q22;
+  double qq = qa + qb;
+  double qt = qa * ta + qb * tb;
+  double tqt = q11 * ta * ta + 2 * q12 * ta * tb + q22 * tb * tb;
+  double disc = qt * qt - qq * (tqt - 1);
+  if (disc < 0)
+    return std::numeric_limits<double>::max();
+  double p = (qt + sqrt(disc)) / qq;
+
+  // upwind: the characteristic must enter c between a and b
+  double w1 = q11 * (ta - p) + q12 * (tb - p);
+  double w2 = q12 * (ta - p) + q22 * (tb - p);
+  if (p < std::max(ta, tb) || w1 > 0 || w2 > 0)
+    return std::numeric_limits<double>::max();
+  return p;
+}
+
+double MeshGeodesic::march(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, double bound, bool& isClipped)
+{
+  if (++mCurrentStamp == 0)
+  {
+    std::fill(mStamp.begin(), mStamp.end(), 0);
+    mCurrentStamp = 1;
+  }
+  isClipped = false;
+
+  Heap heap;
+  std::vector<int> seeds, targets;
+  cellVertices(startCell, seeds);
+  cellVertices(endCell, targets);
+  for (size_t k = 0; k < seeds.size(); k++)
+  {
+    int v = seeds[k];
+    touch(v);
+    mDistance[v] = distance(&mPoints[3 * v], start);
+    heap.push(HeapEntry(mDistance[v], v));
+  }
+
+  int remaining = (int)targets.size();
+  while (!heap.empty() && remaining > 0)
+  {
+    HeapEntry top = heap.top();
+    heap.pop();
+    int v = top.second;
+    if (mIsFrozen[v] || top.first > mDistance[v])
+      continue;
+    if (top.first > bound)
+    {
+      isClipped = true;
+      break;
+    }
+    mIsFrozen[v] = 1;
+    if (std::find(targets.begin(), targets.end(), v) != targets.end())
+      remaining--;
+
+    for (int i = mVertexOffsets[v]; i < mVertexOffsets[v + 1]; i++)
+    {
+      const int* tri = &mTriangles[3 * mVertexTriangles[i]];
+      for (int k = 0; k < 3; k++)
+      {
+        int w = tri[k];
+        if (w == v)
+          continue;
+        const double* pw = &mPoints[3 * w];
+        if (mStamp[w] == mCurrentStamp && mIsFrozen[w])
+          continue;
+        if (distance(pw, start) + distance(pw, end) > bound)
+        {
+          isClipped = true;
+          continue;
+        }
+        touch(w);
+        int u = tri[0] + tri[1] + tri[2] - v - w;
+        double d = top.first + distance(pw, &mPoints[3 * v]);
+        if (mStamp[u] == mCurrentStamp && mIsFrozen[u])
+          d = std::min(d, updateTriangle(w, v, u));
+        if (d < mDistance[w])
+        {
+          mDistance[w] = d;
+          heap.push(HeapEntry(d, w));
+        }
+      }
+    }
+  }
+
+  double length = -1;
+  for (size_t k = 0; k < targets.size(); k++)
+  {
+    int v = targets[k];
+    if (mStamp[v] != mCurrentStamp || !mIsFrozen[v])
+      continue;
+    double d = mDistance[v] + distance(&mPoints[3 * v], end);
+    if (length < 0 || d < length)
+      length = d;
+  }
+  return length;
+}
+
+// Walks down the distance field of the last march, from the end point back to
+// the start cell. Every frozen vertex except the seeds has a frozen neighbour
+// closer to the start, so the walk always terminates.
+void MeshGeodesic::tracePath(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, vtkPoints* path)
+{
+  std::vector<int> seeds, targets;
+  cellVertices(startCell, seeds);
+  cellVertices(endCell, targets);
+
+  int v = -1;
+  double best = 0;
+  for (size_t k = 0; k < targets.size(); k++)
+  {
+    int t = targets[k];
+    if (mStamp[t] != mCurrentStamp || !mIsFrozen[t])
+      continue;
+    double d = mDistance[t] + distance(&mPoints[3 * t], end);
+    if (v == -1 || d < best)
+    {
+      v = t;
+      best = d;
+    }
+  }
+
+  std::vector<int> vertices;
+  while (v != -1)
+  {
+    vertices.push_back(v);
+    if (std::find(seeds.begin(), seeds.end(), v) != seeds.end())
+      break;
+    int next = v;
+    for (int i = mVertexOffsets[v]; i < mVertexOffsets[v + 1]; i++)
+    {
+      const int* tri = &mTriangles[3 * mVertexTriangles[i]];
+      for (int k = 0; k < 3; k++)
+      {
+        int w = tri[k];
+        if (mStamp[w] == mCurrentStamp && mIsFrozen[w] && mDistance[w] < mDistance[next])
+          next = w;
+      }
+    }
+    v = next == v ? -1 : next;
+  }
+
+  path->Reset();
+  path->InsertNextPoint(start);
+  for (int k = (int)vertices.size() - 1; k >= 0; k--)
+    path->InsertNextPoint(&mPoints[3 * vertices[k]]);
+  path->InsertNextPoint(end);
+}
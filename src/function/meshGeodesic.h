@@ -0,0 +1,86 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHGEODESIC_H
+#define MESHGEODESIC_H
+
+#include <vector>
+
+#include <QFuture>
+#include <QMutex>
+
+#include <vtkType.h>
+
+class vtkPolyData;
+class vtkPoints;
+
+// Distances along the surface of the loaded mesh, for the measuring tool.
+// The mesh is split into triangles and a vertex -> triangle table is built once in
+// a background thread. Each query then runs fast marching from the picked start
+// point, restricted to the ellipsoid around the two endpoints; the ellipsoid grows
+// until it is large enough to contain the shortest path that was found.
+class MeshGeodesic
+{
+public:
+  MeshGeodesic();
+  ~MeshGeodesic();
+
+  // starts building in the background (no-op if the mesh is already indexed)
+  void build(vtkPolyData* mesh);
+  void clear();
+  bool isReady();
+  vtkPolyData* getDataSet() const {return mMesh;}
+
+  // Surface distance between two picked points lying in startCell and endCell.
+  // path, if given, receives the points of the path from start to end.
+  // Blocks until the tables are built. Returns -1 if the points are not connected.
+  double computeDistance(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, vtkPoints* path = NULL);
+
+private:
+  void buildTables();
+  double march(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, double bound, bool& isClipped);
+  void cellVertices(vtkIdType cellId, std::vector<int>& vertices) const;
+  double updateTriangle(int c, int a, int b) const;
+  void touch(int v);
+  void tracePath(const double* start, vtkIdType startCell, const double* end, vtkIdType endCell, vtkPoints* path);
+
+  vtkPolyData* mMesh;
+  std::vector<double> mPoints;       // 3 per vertex
+  std::vector<int> mTriangles;       // 3 per triangle, polygons are fanned
+  std::vector<int> mCellTriangles;   // triangles of cell c are [mCellTriangles[c], mCellTriangles[c+1])
+  std::vector<int> mVertexOffsets;   // triangles around vertex v are
+  std::vector<int> mVertexTriangles; // mVertexTriangles[mVertexOffsets[v] .. mVertexOffsets[v+1])
+  bool mIsBuilt;
+
+  // marching state; entries are valid only where mStamp matches mCurrentStamp,
+  // so nothing has to be cleared between queries
+  std::vector<double> mDistance;
+  std::vector<unsigned int> mStamp;
+  std::vector<char> mIsFrozen;
+  unsigned int mCurrentStamp;
+
+  QFuture<void> mFuture;
+  QMutex mMutex;
+};
+
+#endif // MESHGEODESIC_H
@@ -0,0 +1,183 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkPoints.h>
+#include <vtkPointData.h>
+#include <vtkTriangleFilter.h>
+#include <vtkQuadricDecimation.h>
+
+#include "meshLOD.h"
+
+// triangle budgets of the levels; only the ones well below the input size are built
+static const int LEVEL_POLYS[] = {1000000, 250000, 60000};
+static const int NUM_LEVELS = sizeof(LEVEL_POLYS) / sizeof(LEVEL_POLYS[0]);
+
+MeshLOD::MeshLOD(QObject* parent)
+  : QObject(parent), mInput(NULL), mIsAborted(false), mDecimation(NULL)
+{
+  connect(&mWatcher, SIGNAL(finished()), this, SLOT(buildFinished()));
+}
+
+MeshLOD::~MeshLOD()
+{
+  abort();
+  mFuture.waitForFinished();
+}
+
+bool MeshLOD::isLarge(vtkPolyData* mesh)
+{
+  return mesh && mesh->GetNumberOfPolys() > MESHLOD_MIN_POLYS;
+}
+
+void MeshLOD::build(vtkPolyData* mesh)
+{
+  clear();
+  if (!isLarge(mesh))
+    return;
+  mInput = mesh;
+
+  // the worker gets its own copy of the arrays it needs; the widget keeps rendering and
+  // editing the live mesh meanwhile, so nothing may be shared with it
+  vtkSmartPointer<vtkPolyData> input = vtkSmartPointer<vtkPolyData>::New();
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->DeepCopy(mesh->GetPoints());
+  input->SetPoints(points);
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->DeepCopy(mesh->GetPolys());
+  input->SetPolys(polys);
+  if (vtkDataArray* tcoords = mesh->GetPointData()->GetTCoords())
+  {
+    vtkSmartPointer<vtkDataArray> copy = vtkSmartPointer<vtkDataArray>::Take(tcoords->NewInstance());
+    copy->DeepCopy(tcoords);
+    input->GetPointData()->SetTCoords(copy);
+  }
+  if (vtkDataArray* normals = mesh->GetPointData()->GetNormals())
+  {
+    vtkSmartPointer<vtkDataArray> copy = vtkSmartPointer<vtkDataArray>::Take(normals->NewInstance());
+    copy->DeepCopy(normals);
+    input->GetPointData()->SetNormals(copy);
+  }
+
+  mIsAborted = false;
+  mFuture = QtConcurrent::run(this, &MeshLOD::buildLevels, input);
+  mWatcher.setFuture(mFuture);
+}
+
+void MeshLOD::clear()
+{
+  abort();
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+  mInput = NULL;
+  mLevels.clear();
+}
+
+void MeshLOD::abort()
+{
+  QMutexLocker locker(&mMutex);
+  mIsAborted = true;
+  if (mDecimation)
+    mDecimation->SetAbortExecute(1);
+}
+
+int MeshLOD::getNumberOfLevels()
+{
+  QMutexLocker locker(&mMutex);
+  return mFuture.isRunning() ? 0 : (int)mLevels.size();
+}
+
+vtkPolyData* MeshLOD::getLevel(int level)
+{
+  QMutexLocker locker(&mMutex);
+  if (mFuture.isRunning() || level < 0 || level >= (int)mLevels.size())
+    return NULL;
+  return mLevels[level];
+}
+
+void MeshLOD::buildFinished()
+{
+  if (!mIsAborted && !mLevels.empty())
+    emit levelsReady();
+}
+
+void MeshLOD::buildLevels(vtkSmartPointer<vtkPolyData> input)
+{
+  // quadric decimation needs triangles
+  vtkSmartPointer<vtkPolyData> current = input;
+  if (input->GetPolys()->GetNumberOfConnectivityEntries() != 4 * input->GetNumberOfPolys())
+  {
+    vtkSmartPointer<vtkTriangleFilter> triangles = vtkSmartPointer<vtkTriangleFilter>::New();
+    triangles->SetInput(input);
+    triangles->Update();
+    current = vtkSmartPointer<vtkPolyData>::New();
+    current->ShallowCopy(triangles->GetOutput());
+  }
+
+  std::vector<vtkSmartPointer<vtkPolyData> > levels;
+  for (int k = 0; k < NUM_LEVELS; k++)
+  {
+    const vtkIdType numPolys = current->GetNumberOfPolys();
+    if (LEVEL_POLYS[k] * 2 > numPolys)
+      continue;
+
+    // each level is decimated from the previous one, which keeps the total cost
+    // close to that of the first level
+    vtkSmartPointer<vtkQuadricDecimation> decimation = vtkSmartPointer<vtkQuadricDecimation>::New();
+    decimation->SetInput(current);
+    decimation->SetTargetReduction(1.0 - (double)LEVEL_POLYS[k] / numPolys);
+    decimation->AttributeErrorMetricOn();
+    decimation->TCoordsAttributeOn();
+    decimation->NormalsAttributeOn();
+    decimation->ScalarsAttributeOff();
+    decimation->VectorsAttributeOff();
+    decimation->TensorsAttributeOff();
+    {
+      QMutexLocker locker(&mMutex);
+      if (mIsAborted)
+        return;
+      mDecimation = decimation;
+    }
+    decimation->Update();
+    {
+      QMutexLocker locker(&mMutex);
+      mDecimation = NULL;
+      if (mIsAborted)
+        return;
+    }
+
+    vtkSmartPointer<vtkPolyData> level = vtkSmartPointer<vtkPolyData>::New();
+    level->ShallowCopy(decimation->GetOutput());
+    if (level->GetNumberOfPolys() == 0)
+      break;
+    levels.push_back(level);
+    current = level;
+  }
+
+  QMutexLocker locker(&mMutex);
+  mLevels.swap(levels);
+}
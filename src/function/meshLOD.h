@@ -0,0 +1,84 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHLOD_H
+#define MESHLOD_H
+
+#include <vector>
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+
+class vtkQuadricDecimation;
+
+#define MESHLOD_MIN_POLYS (500000) // smaller meshes render fast enough at full resolution
+
+// Level-of-detail pyramid of a large mesh for interactive rendering. The levels are
+// quadric-decimated (texture coordinates preserved) in a background thread, finest first,
+// and are handed to a vtkLODActor by the widget once levelsReady() is emitted.
+// Picking and annotation keep using the full resolution mesh.
+class MeshLOD : public QObject
+{
+  Q_OBJECT
+
+public:
+  MeshLOD(QObject* parent = 0);
+  ~MeshLOD();
+
+  static bool isLarge(vtkPolyData* mesh);
+
+  // starts building the pyramid in the background; a running build is abandoned
+  void build(vtkPolyData* mesh);
+  void clear();
+
+  // the mesh the levels were built from
+  vtkPolyData* getInput() const {return mInput;}
+  int getNumberOfLevels();
+  // level 0 is the finest
+  vtkPolyData* getLevel(int level);
+
+signals:
+  void levelsReady();
+
+private slots:
+  void buildFinished();
+
+private:
+  void buildLevels(vtkSmartPointer<vtkPolyData> input);
+  void abort();
+
+  vtkPolyData* mInput;
+  std::vector<vtkSmartPointer<vtkPolyData> > mLevels;
+  bool mIsAborted;
+  vtkQuadricDecimation* mDecimation; // filter of the level being built, for aborting
+
+  QFuture<void> mFuture;
+  QFutureWatcher<void> mWatcher;
+  QMutex mMutex;
+};
+
+#endif // MESHLOD_H
@@ -0,0 +1,134 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkPolyData.h>
+#include <vtkCellPicker.h>
+
+#include "meshLocator.h"
+
+#define CELLS_PER_BUCKET (16) // octree leaf size; small leaves keep single ray casts cheap
+
+MeshLocator::MeshLocator()
+  : mMesh(NULL), mIsBuilt(false)
+{
+}
+
+MeshLocator::~MeshLocator()
+{
+  mFuture.waitForFinished();
+}
+
+void MeshLocator::build(vtkPolyData* mesh)
+{
+  QMutexLocker locker(&mMutex);
+  if (mesh == mMesh && (mIsBuilt || mBuiltCellLocator))
+    return;
+  locker.unlock();
+  clear();
+  if (!mesh || mesh->GetNumberOfCells() == 0)
+    return;
+
+  // the cell type table is built on demand by the first cell query; do it here so
+  // that the worker only reads the mesh (bounds and coordinates)
+  mesh->GetCellType(0);
+
+  // set up against the live mesh since vtkCellPicker only uses a locator whose data set
+  // is the picked prop's input; the worker only builds them
+  vtkSmartPointer<vtkCellLocator> cellLocator = vtkSmartPointer<vtkCellLocator>::New();
+  cellLocator->SetDataSet(mesh);
+  cellLocator->SetNumberOfCellsPerBucket(CELLS_PER_BUCKET);
+  cellLocator->CacheCellBoundsOn();
+  vtkSmartPointer<vtkKdTreePointLocator> pointLocator = vtkSmartPointer<vtkKdTreePointLocator>::New();
+  pointLocator->SetDataSet(mesh);
+
+  locker.relock();
+  mMesh = mesh;
+  mBuiltCellLocator = cellLocator;
+  mBuiltPointLocator = pointLocator;
+  mFuture = QtConcurrent::run(&MeshLocator::buildLocators, cellLocator.GetPointer(), pointLocator.GetPointer());
+}
+
+void MeshLocator::clear()
+{
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+  mMesh = NULL;
+  mCellLocator = NULL;
+  mPointLocator = NULL;
+  mBuiltCellLocator = NULL;
+  mBuiltPointLocator = NULL;
+  mIsBuilt = false;
+}
+
+bool MeshLocator::isReady()
+{
+  QMutexLocker locker(&mMutex);
+  publish();
+  return mIsBuilt;
+}
+
+void MeshLocator::addTo(vtkCellPicker* picker)
+{
+  QMutexLocker locker(&mMutex);
+  publish();
+  if (picker && mIsBuilt)
+    picker->AddLocator(mCellLocator);
+}
+
+vtkCellLocator* MeshLocator::getCellLocator()
+{
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+  publish();
+  return mIsBuilt ? mCellLocator.GetPointer() : NULL;
+}
+
+vtkKdTreePointLocator* MeshLocator::getPointLocator()
+{
+  mFuture.waitForFinished();
+  QMutexLocker locker(&mMutex);
+  publish();
+  return mIsBuilt ? mPointLocator.GetPointer() : NULL;
+}
+
+void MeshLocator::publish()
+{
+  if (mIsBuilt || !mBuiltCellLocator || !mBuiltPointLocator || !mFuture.isFinished())
+    return;
+  // only the pointers change hands, the locators' data set and build time are left alone
+  // so that nothing rebuilds them on the next query
+  mCellLocator = mBuiltCellLocator;
+  mPointLocator = mBuiltPointLocator;
+  mBuiltCellLocator = NULL;
+  mBuiltPointLocator = NULL;
+  mIsBuilt = true;
+}
+
+void MeshLocator::buildLocators(vtkCellLocator* cellLocator, vtkKdTreePointLocator* pointLocator)
+{
+  cellLocator->BuildLocator();
+  pointLocator->BuildLocator();
+}
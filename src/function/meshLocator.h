@@ -0,0 +1,77 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHLOCATOR_H
+#define MESHLOCATOR_H
+
+#include <QFuture>
+#include <QMutex>
+
+#include <vtkSmartPointer.h>
+#include <vtkCellLocator.h>
+#include <vtkKdTreePointLocator.h>
+
+class vtkPolyData;
+class vtkCellPicker;
+
+// Spatial search structures of the loaded mesh, shared by every 3D picker and the
+// surface walker camera: a cell octree for ray casts and a kd-tree over the points.
+// Both are built once per mesh in a background thread right after loading; the worker
+// only reads the mesh, and the locators are handed out only once they are finished.
+// Until then, pickers fall back to VTK's brute force ray test.
+class MeshLocator
+{
+public:
+  MeshLocator();
+  ~MeshLocator();
+
+  // starts building in the background (no-op if the mesh is already indexed)
+  void build(vtkPolyData* mesh);
+  void clear();
+  bool isReady();
+  vtkPolyData* getDataSet() const {return mMesh;}
+
+  // hands the cell locator to the picker if it is ready; never blocks
+  void addTo(vtkCellPicker* picker);
+
+  // these block until the structures are built
+  vtkCellLocator* getCellLocator();
+  vtkKdTreePointLocator* getPointLocator();
+
+private:
+  static void buildLocators(vtkCellLocator* cellLocator, vtkKdTreePointLocator* pointLocator);
+  // on the GUI thread with mMutex held: takes over what the worker finished
+  void publish();
+
+  vtkPolyData* mMesh;
+  vtkSmartPointer<vtkCellLocator> mCellLocator;
+  vtkSmartPointer<vtkKdTreePointLocator> mPointLocator;
+  vtkSmartPointer<vtkCellLocator> mBuiltCellLocator; // being built by the worker, not published yet
+  vtkSmartPointer<vtkKdTreePointLocator> mBuiltPointLocator;
+  bool mIsBuilt;
+
+  QFuture<void> mFuture;
+  QMutex mMutex;
+};
+
+#endif // MESHLOCATOR_H
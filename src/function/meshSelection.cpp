@@ -0,0 +1,441 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <algorithm>
+#include <climits>
+
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <vtkPlane.h>
+#include <vtkPlanes.h>
+#include <vtkIdTypeArray.h>
+#include <vtkAbstractArray.h>
+#include <vtkVariant.h>
+
+#include "meshSelection.h"
+
+#define MESHSELECTION_LEAF_SIZE (8)
+#define MESHSELECTION_MAX_PLANES (16)
+
+namespace
+{
+  // orders cell indices by the centroid coordinate along one axis
+  struct CenterLess
+  {
+    const float* centers;
+    int axis;
+    bool operator()(vtkIdType a, vtkIdType b) const {return centers[3*a + axis] < centers[3*b + axis];}
+  };
+
+  // Sutherland-Hodgman step: keeps the part of polygon in where plane < 0
+  void clipPolygon(const std::vector<double>& in, const double* plane, std::vector<double>& out)
+  {
+    out.clear();
+    const int n = (int)in.size() / 3;
+    for (int i = 0; i < n; i++)
+    {
+      const double* p = &in[3*i];
+      const double* q = &in[3*((i + 1) % n)];
+      double dp = plane[0]*p[0] + plane[1]*p[1] + plane[2]*p[2] + plane[3];
+      double dq = plane[0]*q[0] + plane[1]*q[1] + plane[2]*q[2] + plane[3];
+      if (dp <= 0)
+        out.insert(out.end(), p, p + 3);
+      if ((dp <= 0) != (dq <= 0))
+      {
+        double t = dp / (dp - dq);
+        for (int k = 0; k < 3; k++)
+          out.push_back(p[k] + t * (q[k] - p[k]));
+      }
+    }
+  }
+}
+
+MeshSelection::MeshSelection()
+  : mMesh(NULL), mBuiltMesh(NULL), mBuiltTime(0)
+{
+}
+
+void MeshSelection::setMesh(vtkPolyData* mesh)
+{
+  mMesh = mesh;
+}
+
+void MeshSelection::build()
+{
+  mNodes.clear();
+  mCells.clear();
+  mBuiltMesh = mMesh;
+  mBuiltTime = mMesh ? mMesh->GetMTime() : 0;
+  if (!mMesh || !mMesh->GetPoints())
+    return;
+  const vtkIdType numCells = mMesh->GetNumberOfCells();
+  if (numCells == 0 || numCells > INT_MAX)
+    return;
+
+  std::vector<float> bounds(6 * numCells);
+  std::vector<float> centers(3 * numCells);
+  vtkIdType npts, *pts;
+  double x[3];
+  for (vtkIdType c = 0; c < numCells; c++)
+  {
+    float* b = &bounds[6*c];
+    b[0] = b[1] = b[2] = VTK_FLOAT_MAX;
+    b[3] = b[4] = b[5] = -VTK_FLOAT_MAX;
+    mMesh->GetCellPoints(c, npts, pts);
+    for (vtkIdType k = 0; k < npts; k++)
+    {
+      mMesh->GetPoint(pts[k], x);
+      for (int a = 0; a < 3; a++)
+      {
+        b[a] = std::min(b[a], (float)x[a]);
+        b[3 + a] = std::max(b[3 + a], (float)x[a]);
+      }
+    }
+    for (int a = 0; a < 3; a++)
+      centers[3*c + a] = 0.5f * (b[a] + b[3 + a]);
+  }
+
+  mCells.resize(numCells);
+  for (vtkIdType c = 0; c < numCells; c++)
+    mCells[c] = c;
+  mNodes.reserve(2 * (numCells / MESHSELECTION_LEAF_SIZE + 1));
+  buildNode(0, (int)numCells, centers, bounds);
+}
+
+int MeshSelection::buildNode(int first, int count, std::vector<float>& centers, std::vector<float>& bounds)
+{
+  const int index = (int)mNodes.size();
+  mNodes.push_back(Node());
+  Node node;
+  node.first = first;
+  node.count = count;
+  node.right = 0;
+  float cmin[3], cmax[3];
+  for (int a = 0; a < 3; a++)
+  {
+    node.bmin[a] = cmin[a] = VTK_FLOAT_MAX;
+    node.bmax[a] = cmax[a] = -VTK_FLOAT_MAX;
+  }
+  for (int i = first; i < first + count; i++)
+  {
+    const vtkIdType c = mCells[i];
+    for (int a = 0; a < 3; a++)
+    {
+      node.bmin[a] = std::min(node.bmin[a], bounds[6*c + a]);
+      node.bmax[a] = std::max(node.bmax[a], bounds[6*c + 3 + a]);
+      cmin[a] = std::min(cmin[a], centers[3*c + a]);
+      cmax[a] = std::max(cmax[a], centers[3*c + a]);
+    }
+  }
+
+  if (count > MESHSELECTION_LEAF_SIZE)
+  {
+    // median split along the longest extent of the centroids
+    int axis = 0;
+    for (int a = 1; a < 3; a++)
+      if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis])
+        axis = a;
+    CenterLess less;
+    less.centers = &centers[0];
+    less.axis = axis;
+    const int half = count / 2;
+    std::nth_element(mCells.begin() + first, mCells.begin() + first + half, mCells.begin() + first + count, less);
+    buildNode(first, half, centers, bounds);
+    node.right = buildNode(first + half, count - half, centers, bounds);
+  }
+  mNodes[index] = node;
+  return index;
+}
+
+void MeshSelection::collect(int node, vtkIdTypeArray* cellIds)
+{
+  // the cells of a subtree are contiguous in mCells
+  const Node& n = mNodes[node];
+  for (int i = n.first; i < n.first + n.count; i++)
+    cellIds->InsertNextValue(mCells[i]);
+}
+
+bool MeshSelection::cellInFrustum(vtkIdType cellId, const double planes[][4], int numPlanes)
+{
+  vtkIdType npts, *pts;
+  mMesh->GetCellPoints(cellId, npts, pts);
+  if (npts == 0)
+    return false;
+  mPolygon.resize(3 * npts);
+  for (vtkIdType k = 0; k < npts; k++)
+    mMesh->GetPoint(pts[k], &mPolygon[3*k]);
+
+  // a vertex inside selects the cell, all vertices beyond one plane reject it
+  bool anyInside = false;
+  for (vtkIdType k = 0; k < npts && !anyInside; k++)
+  {
+    const double* x = &mPolygon[3*k];
+    bool inside = true;
+    for (int p = 0; p < numPlanes && inside; p++)
+      inside = planes[p][0]*x[0] + planes[p][1]*x[1] + planes[p][2]*x[2] + planes[p][3] <= 0;
+    anyInside = inside;
+  }
+  if (anyInside)
+    return true;
+  for (int p = 0; p < numPlanes; p++)
+  {
+    vtkIdType outside = 0;
+    for (vtkIdType k = 0; k < npts; k++)
+    {
+      const double* x = &mPolygon[3*k];
+      if (planes[p][0]*x[0] + planes[p][1]*x[1] + planes[p][2]*x[2] + planes[p][3] > 0)
+        outside++;
+    }
+    if (outside == npts)
+      return false;
+  }
+
+  // the cell crosses the region without a vertex in it (e.g. a large triangle
+  // under a small rubber band): clip it against every plane
+  for (int p = 0; p < numPlanes && !mPolygon.empty(); p++)
+  {
+    clipPolygon(mPolygon, planes[p], mClipped);
+    mPolygon.swap(mClipped);
+  }
+  return !mPolygon.empty();
+}
+
+int MeshSelection::selectFrustum(vtkPlanes* planes, vtkIdTypeArray* cellIds)
+{
+  if (!planes || !cellIds)
+    return 0;
+  if (mBuiltMesh != mMesh || (mMesh && mMesh->GetMTime() != mBuiltTime))
+    build();
+  if (mNodes.empty())
+    return 0;
+
+  const int numPlanes = std::min(planes->GetNumberOfPlanes(), MESHSELECTION_MAX_PLANES);
+  if (numPlanes == 0)
+    return 0;
+  double eq[MESHSELECTION_MAX_PLANES][4];
+  double center[3] = {0, 0, 0};
+  vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
+  for (int p = 0; p < numPlanes; p++)
+  {
+    planes->GetPlane(p, plane);
+    double* n = plane->GetNormal();
+    double* o = plane->GetOrigin();
+    eq[p][0] = n[0];
+    eq[p][1] = n[1];
+    eq[p][2] = n[2];
+    eq[p][3] = -(n[0]*o[0] + n[1]*o[1] + n[2]*o[2]);
+    for (int a = 0; a < 3; a++)
+      center[a] += o[a] / numPlanes;
+  }
+  // Orient every plane so that the inside is negative. The plane origins of a
+  // picking frustum are its corners, so their mean lies inside.
+  for (int p = 0; p < numPlanes; p++)
+  {
+    if (eq[p][0]*center[0] + eq[p][1]*center[1] + eq[p][2]*center[2] + eq[p][3] > 0)
+      for (int k = 0; k < 4; k++)
+        eq[p][k] = -eq[p][k];
+  }
+
+  const vtkIdType before = cellIds->GetNumberOfTuples();
+  std::vector<int> stack(1, 0);
+  while (!stack.empty())
+  {
+    const int index = stack.back();
+    stack.pop_back();
+    const Node& node = mNodes[index];
+    bool outside = false;
+    bool inside = true;
+    for (int p = 0; p < numPlanes && !outside; p++)
+    {
+      double vmin = eq[p][3], vmax = eq[p][3];
+      for (int a = 0; a < 3; a++)
+      {
+        if (eq[p][a] > 0)
+        {
+          vmin += eq[p][a] * node.bmin[a];
+          vmax += eq[p][a] * node.bmax[a];
+        }
+        else
+        {
+          vmin += eq[p][a] * node.bmax[a];
+          vmax += eq[p][a] * node.bmin[a];
+        }
+      }
+      outside = vmin > 0;
+      inside = inside && vmax <= 0;
+    }
+    if (outside)
+      continue;
+    if (inside)
+    {
+      collect(index, cellIds);
+    }
+    else if (node.right == 0)
+    {
+      for (int i = node.first; i < node.first + node.count; i++)
+        if (cellInFrustum(mCells[i], eq, numPlanes))
+          cellIds->InsertNextValue(mCells[i]);
+    }
+    else
+    {
+      stack.push_back(node.right);
+      stack.push_back(index + 1);
+    }
+  }
+  return (int)(cellIds->GetNumberOfTuples() - before);
+}
+
+int MeshSelection::selectBox(const double* bounds, vtkIdTypeArray* cellIds)
+{
+  if (!bounds || !cellIds)
+    return 0;
+  if (mBuiltMesh != mMesh || (mMesh && mMesh->GetMTime() != mBuiltTime))
+    build();
+  if (mNodes.empty())
+    return 0;
+
+  const vtkIdType before = cellIds->GetNumberOfTuples();
+  vtkIdType npts, *pts;
+  double x[3];
+  std::vector<int> stack(1, 0);
+  while (!stack.empty())
+  {
+    const int index = stack.back();
+    stack.pop_back();
+    const Node& node = mNodes[index];
+    bool overlaps = true;
+    bool contained = true;
+    for (int a = 0; a < 3; a++)
+    {
+      overlaps = overlaps && node.bmin[a] <= bounds[2*a + 1] && node.bmax[a] >= bounds[2*a];
+      contained = contained && node.bmin[a] >= bounds[2*a] && node.bmax[a] <= bounds[2*a + 1];
+    }
+    if (!overlaps)
+      continue;
+    if (contained)
+    {
+      collect(index, cellIds);
+    }
+    else if (node.right == 0)
+    {
+      for (int i = node.first; i < node.first + node.count; i++)
+      {
+        double cmin[3] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, VTK_DOUBLE_MAX};
+        double cmax[3] = {-VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+        mMesh->GetCellPoints(mCells[i], npts, pts);
+        for (vtkIdType k = 0; k < npts; k++)
+        {
+          mMesh->GetPoint(pts[k], x);
+          for (int a = 0; a < 3; a++)
+          {
+            cmin[a] = std::min(cmin[a], x[a]);
+            cmax[a] = std::max(cmax[a], x[a]);
+          }
+        }
+        bool hit = npts > 0;
+        for (int a = 0; a < 3; a++)
+          hit = hit && cmin[a] <= bounds[2*a + 1] && cmax[a] >= bounds[2*a];
+        if (hit)
+          cellIds->InsertNextValue(mCells[i]);
+      }
+    }
+    else
+    {
+      stack.push_back(node.right);
+      stack.push_back(index + 1);
+    }
+  }
+  return (int)(cellIds->GetNumberOfTuples() - before);
+}
+
+void MeshSelection::sortedIds(vtkAbstractArray* array, std::vector<vtkIdType>& ids)
+{
+  ids.clear();
+  if (!array)
+    return;
+  const vtkIdType n = array->GetNumberOfTuples() * array->GetNumberOfComponents();
+  ids.reserve(n);
+  vtkIdTypeArray* idArray = vtkIdTypeArray::SafeDownCast(array);
+  for (vtkIdType j = 0; j < n; j++)
+    ids.push_back(idArray ? idArray->GetValue(j) : (vtkIdType)array->GetVariantValue(j).ToInt());
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+void MeshSelection::addSurfaceNote(int key, vtkAbstractArray* cellIds)
+{
+  removeSurfaceNote(key);
+  std::vector<vtkIdType>& ids = mNoteCells[key];
+  sortedIds(cellIds, ids);
+  for (size_t j = 0; j < ids.size(); j++)
+    mNotesByCell[ids[j]].append(key);
+}
+
+void MeshSelection::removeSurfaceNote(int key)
+{
+  QHash<int, std::vector<vtkIdType> >::iterator it = mNoteCells.find(key);
+  if (it == mNoteCells.end())
+    return;
+  const std::vector<vtkIdType>& ids = it.value();
+  for (size_t j = 0; j < ids.size(); j++)
+  {
+    QHash<vtkIdType, QList<int> >::iterator cell = mNotesByCell.find(ids[j]);
+    if (cell == mNotesByCell.end())
+      continue;
+    cell.value().removeAll(key);
+    if (cell.value().isEmpty())
+      mNotesByCell.erase(cell);
+  }
+  mNoteCells.erase(it);
+}
+
+void MeshSelection::clearSurfaceNotes()
+{
+  mNotesByCell.clear();
+  mNoteCells.clear();
+}
+
+QList<int> MeshSelection::surfaceNotesAt(vtkIdType cellId) const
+{
+  return mNotesByCell.value(cellId);
+}
+
+int MeshSelection::findSurfaceNote(vtkAbstractArray* cellIds) const
+{
+  std::vector<vtkIdType> ids;
+  sortedIds(cellIds, ids);
+  if (ids.empty())
+    return -1;
+  // any note with the same cells also covers the first one
+  QHash<vtkIdType, QList<int> >::const_iterator cell = mNotesByCell.constFind(ids[0]);
+  if (cell == mNotesByCell.constEnd())
+    return -1;
+  const QList<int>& keys = cell.value();
+  for (int i = 0; i < keys.size(); i++)
+  {
+    QHash<int, std::vector<vtkIdType> >::const_iterator note = mNoteCells.constFind(keys[i]);
+    if (note != mNoteCells.constEnd() && note.value() == ids)
+      return keys[i];
+  }
+  return -1;
+}
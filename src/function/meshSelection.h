@@ -0,0 +1,94 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHSELECTION_H
+#define MESHSELECTION_H
+
+#include <vector>
+#include <QHash>
+#include <QList>
+
+#include <vtkType.h>
+
+class vtkPolyData;
+class vtkPlanes;
+class vtkIdTypeArray;
+class vtkAbstractArray;
+
+// Selection queries of the 3D annotation tools. A bounding volume hierarchy over
+// the cells of the mesh (built on the first query) answers frustum and box
+// queries by walking down only the branches that overlap the region, and a hash
+// from cell id to surface notes answers hit tests without scanning every note.
+class MeshSelection
+{
+public:
+  MeshSelection();
+
+  // the hierarchy is rebuilt lazily for a new mesh; the note index is kept
+  void setMesh(vtkPolyData* mesh);
+  vtkPolyData* getMesh() const {return mMesh;}
+
+  // appends the cells touching the convex region bounded by planes (e.g. the
+  // frustum of a vtkAreaPicker); returns the number of cells found
+  int selectFrustum(vtkPlanes* planes, vtkIdTypeArray* cellIds);
+  // appends the cells whose bounds overlap (xmin, xmax, ymin, ymax, zmin, zmax)
+  int selectBox(const double* bounds, vtkIdTypeArray* cellIds);
+
+  // surface note index; key identifies the note to the caller
+  void addSurfaceNote(int key, vtkAbstractArray* cellIds);
+  void removeSurfaceNote(int key);
+  void clearSurfaceNotes();
+  // keys of the notes covering cellId, oldest first
+  QList<int> surfaceNotesAt(vtkIdType cellId) const;
+  // key of the note made of exactly these cells, -1 if there is none
+  int findSurfaceNote(vtkAbstractArray* cellIds) const;
+
+private:
+  struct Node
+  {
+    float bmin[3];
+    float bmax[3];
+    int first; // cells of the subtree are mCells[first, first + count)
+    int count;
+    int right; // index of the right child (the left one follows the node), 0 for leaves
+  };
+
+  void build();
+  int buildNode(int first, int count, std::vector<float>& centers, std::vector<float>& bounds);
+  void collect(int node, vtkIdTypeArray* cellIds);
+  bool cellInFrustum(vtkIdType cellId, const double planes[][4], int numPlanes);
+  static void sortedIds(vtkAbstractArray* array, std::vector<vtkIdType>& ids);
+
+  vtkPolyData* mMesh;
+  vtkPolyData* mBuiltMesh;
+  unsigned long mBuiltTime;
+  std::vector<Node> mNodes;
+  std::vector<vtkIdType> mCells;
+  std::vector<double> mPolygon; // scratch of the cell clipping
+  std::vector<double> mClipped;
+
+  QHash<vtkIdType, QList<int> > mNotesByCell;
+  QHash<int, std::vector<vtkIdType> > mNoteCells; // sorted
+};
+
+#endif // MESHSELECTION_H
@@ -31,9 +31,14 @@
 #include <QMenu>
 
 #include "navigation.h"
+#include "../information/bookmarkStore.h"
 #include "../information/informationWidget.h"
 #include "../mainWindow.h"
 
+// folder items keep the object path and whether their children were read
+#define FOLDER_PATH_ROLE Qt::UserRole
+#define FOLDER_LOADED_ROLE (Qt::UserRole + 1)
+
 Navigation::Navigation()
 {
 	mTreeWidget = new QTreeWidget();
@@ -52,11 +57,13 @@ Navigation::Navigation()
 	connect(mw()->mBookmark, SIGNAL(editNavigationItem(const QString, const QString, const QString)),
 		this, SLOT(editBookmarkItem(const QString, const QString, const QString)));
 	connect(mTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(showTreeWidgetItem(QTreeWidgetItem*, int)));
+	connect(mTreeWidget, SIGNAL(itemExpanded(QTreeWidgetItem*)), this, SLOT(loadFolderItem(QTreeWidgetItem*)));
 	connect(mTreeWidget, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(showContextMenu(const QPoint&)));
 	mVBox = new QVBoxLayout();
 	mVBox->addWidget(mTreeWidget);
 	HtmlDelegate* delegation = new HtmlDelegate();
     mTreeWidget->setItemDelegate(delegation);
+	mTreeWidget->setUniformRowHeights(true);
 	this->setLayout(mVBox);
 	this->show();
 }
@@ -102,6 +109,7 @@ void Navigation::addObject(const QString path, const QString CHE)
 	object->setText(0, objectName);
 	QFileIconProvider iconProvider;
 	object->setIcon(0, iconProvider.icon(QFileIconProvider::Folder));
+	QTreeWidgetItem *parent = mItems[0];
 
 	if (CHE != QString() && isCurrentProject)
 	{
@@ -117,7 +125,7 @@ void Navigation::addObject(const QString path, const QString CHE)
 		}
 		if (isFound)
 		{
-			mItems[0]->child(i)->addChild(object);
+			parent = mItems[0]->child(i);
 		}
 		else
 		{
@@ -125,32 +133,64 @@ void Navigation::addObject(const QString path, const QString CHE)
 			cheItem->setText(0, QString("Cultural Heritage Entity: ").append(CHE));
 			cheItem->setIcon(0, iconProvider.icon(QFileIconProvider::Drive));
 			mItems[0]->addChild(cheItem);
-			cheItem->addChild(object);
+			parent = cheItem;
 		}
 	}
+	parent->addChild(object);
+	addFolderItem(object, QString("Note"), localPath);
+	addFolderItem(object, QString("BookMark"), localPath);
+	// only the project and CHE levels are expanded, objects are opened on demand
+	mItems[0]->setExpanded(true);
+	parent->setExpanded(true);
+}
+
+void Navigation::addFolderItem(QTreeWidgetItem *object, const QString name, const QString path)
+{
+	QFileIconProvider iconProvider;
+	QTreeWidgetItem *folder = new QTreeWidgetItem();
+	folder->setText(0, name);
+	folder->setIcon(0, iconProvider.icon(QFileIconProvider::Folder));
+	folder->setData(0, FOLDER_PATH_ROLE, path);
+	folder->setData(0, FOLDER_LOADED_ROLE, false);
+	folder->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+	object->addChild(folder);
+}
+
+bool Navigation::isFolderLoaded(QTreeWidgetItem *folder)
+{
+	return folder->data(0, FOLDER_LOADED_ROLE).toBool();
+}
+
+void Navigation::loadFolderItem(QTreeWidgetItem* item)
+{
+	QString path = item->data(0, FOLDER_PATH_ROLE).toString();
+	if (path.isEmpty() || isFolderLoaded(item))
+		return;
+	item->setData(0, FOLDER_LOADED_ROLE, true);
+	if (item->text(0) == QString("Note"))
+		loadObjectNote(item, path);
 	else
-	{
-		mItems[0]->addChild(object);
-	}
-	loadObjectNote(object, localPath);
-	loadObjectBookMark(object, localPath);
-	mTreeWidget->expandAll();
+		loadObjectBookMark(item, path);
+	item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
 }
 
-void Navigation::loadObjectNote(QTreeWidgetItem *object, const QString path)
+void Navigation::loadObjectNote(QTreeWidgetItem *noteLabel, const QString path)
 {
 	QFileIconProvider iconProvider;
-	QTreeWidgetItem *noteLabel = new QTreeWidgetItem();
-	noteLabel->setText(0, QString("Note"));
-	noteLabel->setIcon(0, iconProvider.icon(QFileIconProvider::Folder));
-	object->addChild(noteLabel);
-	QVector<int> noteCount = mw()->mInformation->getNoteNumber(path);	// no notes are marked as removed
+	QVector<int> noteCount = mw()->mInformation->getNoteNumber(path);
+	// notes removed before the folder was opened are listed in gray so the ids still line up
+	QVector<bool> removed = mw()->mInformation->getRemovedNotes(path);
+	int k = 0;
 	if (noteCount.size() == 7)
 	{
 		for (int i = 0; i < noteCount.size(); i++)
 		{
 			if (noteCount[i] == 0)
+			{
+				if (i == 0)
+					k++; // the annotation has a flag even without an annotation item
 				continue;
+			}
 			QString label;
 			switch(i)
 			{
@@ -163,90 +203,59 @@ void Navigation::loadObjectNote(QTreeWidgetItem *object, const QString path)
 				case 6: label = QString("PolygonNote2D_"); break;
 				//// TO BE TESTED
 			}
-			if (i == 0)
+			int number = (i == 0) ? 1 : noteCount[i];
+			for (int j = 0; j < number; j++)
 			{
 				// note item columns: note name, object path, valid (1 is valid, 0 is removed)
-				QTreeWidgetItem *note = new QTreeWidgetItem();	
+				QTreeWidgetItem *note = new QTreeWidgetItem();
 				QString text = label;
+				if (i != 0)
+					text.append(QString::number(j+1));
+				bool isRemoved = k < removed.size() && removed[k];
+				k++;
+				if (isRemoved)
+				{
+					text.append(QString("</font>"));
+					text.prepend(QString("<font color=\"gray\">"));
+				}
 				note->setText(0, text);
 				note->setText(1, path);
-				note->setText(2, QString::number(1));
+				note->setText(2, QString::number(isRemoved ? 0 : 1));
 				note->setIcon(0, iconProvider.icon(QFileIconProvider::File));
 				noteLabel->addChild(note);
 			}
-			else 
-			{
-				for (int j = 0; j < noteCount[i]; j++)
-				{
-					QTreeWidgetItem *note = new QTreeWidgetItem();
-					QString text = label;
-					note->setText(0, text.append(QString::number(j+1)));
-					note->setText(1, path);
-					note->setText(2, QString::number(1));
-					note->setIcon(0, iconProvider.icon(QFileIconProvider::File));
-					noteLabel->addChild(note);
-				}
-			}
 		}
 	}
 }
 
-void Navigation::loadObjectBookMark(QTreeWidgetItem *object, const QString path)
+void Navigation::loadObjectBookMark(QTreeWidgetItem *bookmark, const QString path)
 {
-	QTreeWidgetItem *bookmark = new QTreeWidgetItem();
-	bookmark->setText(0, QString("BookMark"));
 	QFileIconProvider iconProvider;
-	bookmark->setIcon(0, iconProvider.icon(QFileIconProvider::Folder));
-	object->addChild(bookmark);
 
 	QString bookmarkPath = path;
 	bookmarkPath.append(QDir::separator() + QString("BookMark"));
 	QString fn = bookmarkPath;
 	fn.append(QDir::separator() + QString("bookmarks.xml"));
-	QFile f(fn);
-    if(!f.exists()) return;
-    if(!f.open(QIODevice::ReadOnly | QIODevice::Text)) 
-	{
-		f.close();
+	if (!QFile(fn).exists())
+		return;
+	// read from the bookmark widget's copy, the file on disk may not have the latest edits yet
+	QDomElement root = BookmarkStore::instance(fn)->root();
+	if (root.isNull())
 		return;
-	}
-	QXmlStreamReader xml;
-    xml.setDevice(&f);
-	
-    if(xml.readNextStartElement()) 
-	{
-        if(xml.name() != BOOKMARK_XML_ROOT) 
-            return;
-    } else return;
-
-    Q_ASSERT(xml.isStartElement());
 
-	
-    while (xml.readNextStartElement()) 
+	for (QDomElement elt = root.firstChildElement(BOOKMARK_NAME); !elt.isNull(); elt = elt.nextSiblingElement(BOOKMARK_NAME))
 	{
-        if (xml.name() == "bookmark")    
+		if (elt.attribute("isHidden") != QString("True"))	// this bookmark is temporarily removed.
 		{
-			Q_ASSERT(xml.isStartElement() && xml.name() == "bookmark");
-
-			if (xml.attributes().value("isHidden").toString() != QString("True"))	// this bookmark is temporarily removed.
-			{
-				QTreeWidgetItem *bookmarkItem = new QTreeWidgetItem();
-				bookmarkItem->setText(0, xml.attributes().value("title").toString());
-				bookmarkItem->setText(1, xml.attributes().value("uuid").toString());
-				bookmarkItem->setText(2, path);
-				bookmarkItem->setText(3, QString::number(1));
-				bookmarkItem->setIcon(0, iconProvider.icon(QFileIconProvider::File));
-				bookmark->addChild(bookmarkItem);
-			}
-			while (xml.readNextStartElement()) 
-			{
-				xml.skipCurrentElement();
-			}
+			QTreeWidgetItem *bookmarkItem = new QTreeWidgetItem();
+			bookmarkItem->setText(0, elt.attribute("title"));
+			bookmarkItem->setText(1, elt.attribute("uuid"));
+			bookmarkItem->setText(2, path);
+			bookmarkItem->setText(3, QString::number(1));
+			bookmarkItem->setIcon(0, iconProvider.icon(QFileIconProvider::File));
+			bookmark->addChild(bookmarkItem);
 		}
-        else
-            xml.skipCurrentElement();
-    }
-	f.close();
+	}
 }
 
 void Navigation::removeObject(const QString path)
@@ -326,6 +335,8 @@ void Navigation::addNoteItem(const QString path, const NoteMode type, const Note
 	if (isFound)
 	{
 		object = object->child(0);
+		if (!isFolderLoaded(object))	// the folder reads the current notes when it is opened
+			return;
 		int point = 0, surface = 0, frustum = 0, point2D = 0, surface2D = 0, polygon2D = 0;
 		for (int k = 0; k < object->childCount(); k++)
 		{
@@ -447,6 +458,8 @@ void Navigation::removeNoteItem(const QString path, const NoteMode type, const i
 	if (isFound)
 	{
 		object = object->child(0);
+		if (!isFolderLoaded(object))	// the folder reads the current notes when it is opened
+			return;
 		int point = 0, surface = 0, frustum = 0, point2D = 0, surface2D = 0, polygon2D = 0;
 		for (int k = 0; k < object->childCount(); k++)
 		{
@@ -593,6 +606,8 @@ void Navigation::addBookmarkItem(const QString path, const QString bookmarkName,
 	if (isFound)
 	{
 		object = object->child(1);
+		if (!isFolderLoaded(object))	// the folder reads the bookmarks when it is opened
+			return;
 		QFileIconProvider iconProvider;
 		QTreeWidgetItem* newBookmark = new QTreeWidgetItem();
 		newBookmark->setIcon(0, iconProvider.icon(QFileIconProvider::File));
@@ -619,6 +634,8 @@ void Navigation::removeBookmarkItem(const QString path, const QString bookmarkNa
 	if (isFound)
 	{
 		object = object->child(1);
+		if (!isFolderLoaded(object))	// the folder reads the bookmarks when it is opened
+			return;
 		for (int i = 0; i < object->childCount(); i++)
 		{
 			//qDebug()<<"Delete item"<<object->child(i)->text(1)<<uuid;
@@ -648,6 +665,8 @@ void Navigation::editBookmarkItem(const QString path, const QString newBookmarkN
 	if (isFound)
 	{
 		object = object->child(1);
+		if (!isFolderLoaded(object))	// the folder reads the bookmarks when it is opened
+			return;
 		for (int i = 0; i < object->childCount(); i++)
 		{
 			if (object->child(i)->text(1) == uuid)
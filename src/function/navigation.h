@@ -61,6 +61,8 @@ class MainWindow;
  * For CHE, each object item is directly under the CHE parent item.
  * For each object, It has child items including note folder and bookmark folder items.
  * The specific file items are saved under the folder items respectively.
+ * Folder items are filled the first time they are expanded, so opening a project
+ * with many objects does not read every note list and bookmark file up front.
  */
 
 class Navigation: public QWidget
@@ -92,18 +94,18 @@ public:
 	void addObject(const QString path, const QString CHE = QString());
 
 	/**
-	 * @brief  Add the note item of specific object.
-	 * @param  object  The object that should be loaded.
-	 * @param  path    The note path.
+	 * @brief  Add the note items of specific object.
+	 * @param  folder  The note folder item of the object.
+	 * @param  path    The object path.
 	 */
-	void loadObjectNote(QTreeWidgetItem *object, const QString path);
+	void loadObjectNote(QTreeWidgetItem *folder, const QString path);
 
 	/**
-	 * @brief  Add the note item of specific object.
-	 * @param  object  The object that should be loaded.
-	 * @param  path    The note path.
+	 * @brief  Add the bookmark items of specific object.
+	 * @param  folder  The bookmark folder item of the object.
+	 * @param  path    The object path.
 	 */
-	void loadObjectBookMark(QTreeWidgetItem *object, const QString path);
+	void loadObjectBookMark(QTreeWidgetItem *folder, const QString path);
 
 	/**
 	 * @brief  Remove all the items under the object
@@ -123,6 +125,19 @@ private:
 	 */
 	bool findObjectItem(const QString fileName, QTreeWidgetItem* &object);
 
+	/**
+	 * @brief  Add an empty note or bookmark folder under the object, filled when it is expanded.
+	 * @param  object  The object item.
+	 * @param  name    "Note" or "BookMark".
+	 * @param  path    The object path.
+	 */
+	void addFolderItem(QTreeWidgetItem *object, const QString name, const QString path);
+
+	/**
+	 * @brief  Whether the children of a folder item have been loaded.
+	 */
+	bool isFolderLoaded(QTreeWidgetItem *folder);
+
 	/**
 	 * Added by Ying to copy annotations
 	 */
@@ -137,6 +152,12 @@ private slots:
 	 */
 	void showTreeWidgetItem(QTreeWidgetItem* item, int column);
 
+	/**
+	 * @brief  Load the notes or bookmarks of a folder item the first time it is expanded.
+	 * @param  item  The item that is expanded.
+	 */
+	void loadFolderItem(QTreeWidgetItem* item);
+
 	/**
 	 * @brief  Add a note item when a note is created.
 	 * @param  path  The full path of the note folder. It shoule be in the form of path/object/Note.
@@ -22,6 +22,7 @@
 
 *****************************************************************************/
 
+#include <cmath>
 #include <QLayout>
 
 #include "plotView.h"
@@ -29,10 +30,11 @@
 #include "spectralPlot.h"
 
 PlotView::PlotView( QWidget *parent )
-  : QWidget( parent )
+  : QWidget( parent ), mIsFalseColorPending( false )
 {
   mSpectralPlot = new SpectralPlot(this);
   connect(this, SIGNAL(currentHyperPixelsChanged(std::vector<float>, std::vector<float>, const int*, const std::string*)), mSpectralPlot, SLOT(updateSpectralPlot(std::vector<float>, std::vector<float>, const int*, const std::string*)) );
+  connect(this, SIGNAL(currentRegionSpectrumChanged(std::vector<float>, std::vector<float>, std::vector<float>, int)), mSpectralPlot, SLOT(updateRegionSpectralPlot(std::vector<float>, std::vector<float>, std::vector<float>, int)) );
 
   exportButton = new QPushButton(this);
   exportButton->setText(QString("Export"));
@@ -42,6 +44,46 @@ PlotView::PlotView( QWidget *parent )
   normalizeCheckBox->setText(QString("Normalized"));
   normalizeCheckBox->setCheckState(Qt::Unchecked);
   connect(normalizeCheckBox,SIGNAL(stateChanged(int)),mSpectralPlot,SLOT(set_normalized_plot(int)));
+
+  falseColorCheckBox = new QCheckBox(this);
+  falseColorCheckBox->setText(QString("False Colour"));
+  falseColorCheckBox->setCheckState(Qt::Unchecked);
+  connect(falseColorCheckBox,SIGNAL(stateChanged(int)),this,SLOT(updateFalseColor()));
+  modeCombo = new QComboBox(this);
+  modeCombo->addItem(QString("Band Composite"), BANDCOMPOSITE);
+  modeCombo->addItem(QString("Band Ratio R/G"), BANDRATIO);
+  modeCombo->addItem(QString("Normalized Difference (R-G)/(R+G)"), NORMALIZEDDIFFERENCE);
+  connect(modeCombo,SIGNAL(currentIndexChanged(int)),this,SLOT(updateFalseColor()));
+  const char* bandLabels[3] = {"R", "G", "B"};
+  for (int k = 0; k < 3; k++)
+  {
+    bandCombo[k] = new QComboBox(this);
+    bandCombo[k]->setToolTip(QString("Band shown as %1").arg(bandLabels[k]));
+    connect(bandCombo[k],SIGNAL(currentIndexChanged(int)),this,SLOT(updateFalseColor()));
+  }
+
+  pcaButton = new QPushButton(this);
+  pcaButton->setText(QString("Open PCs"));
+  pcaButton->setToolTip(QString("Open the principal components as images"));
+  connect(pcaButton, SIGNAL(clicked(bool)), this, SLOT(openPrincipalComponents()));
+  pcaSpinBox = new QSpinBox(this);
+  pcaSpinBox->setRange(1, 32);
+  pcaSpinBox->setValue(3);
+  pcaSpinBox->setToolTip(QString("Number of principal components"));
+
+  similarityCheckBox = new QCheckBox(this);
+  similarityCheckBox->setText(QString("Similar Pixels"));
+  similarityCheckBox->setCheckState(Qt::Unchecked);
+  connect(similarityCheckBox,SIGNAL(stateChanged(int)),this,SLOT(updateSimilarityMap()));
+  metricCombo = new QComboBox(this);
+  metricCombo->addItem(QString("Spectral Angle"), SPECTRALANGLE);
+  metricCombo->addItem(QString("Euclidean Distance"), EUCLIDEANDISTANCE);
+  connect(metricCombo,SIGNAL(currentIndexChanged(int)),this,SLOT(updateSimilarityMap()));
+  thresholdSlider = new QSlider(Qt::Horizontal, this);
+  thresholdSlider->setRange(0, 100);
+  thresholdSlider->setValue(10);
+  thresholdSlider->setToolTip(QString("Threshold (% of the largest difference)"));
+  connect(thresholdSlider,SIGNAL(valueChanged(int)),this,SLOT(updateSimilarityThreshold(int)));
   //  int width = this->frameGeometry().width();
   //  int height = this->frameGeometry().height();
   //  mSpectralPlot->resize(QSize(width, height));
@@ -55,6 +97,25 @@ PlotView::PlotView( QWidget *parent )
   hlayout->addWidget( exportButton );
   hlayout->addWidget( normalizeCheckBox );
   layout->addLayout( hlayout );
+
+  QHBoxLayout *flayout = new QHBoxLayout;
+  flayout->addWidget( falseColorCheckBox );
+  flayout->addWidget( modeCombo );
+  for (int k = 0; k < 3; k++)
+    flayout->addWidget( bandCombo[k] );
+  layout->addLayout( flayout );
+
+  QHBoxLayout *playout = new QHBoxLayout;
+  playout->addWidget( pcaButton );
+  playout->addWidget( pcaSpinBox );
+  playout->addStretch();
+  layout->addLayout( playout );
+
+  QHBoxLayout *slayout = new QHBoxLayout;
+  slayout->addWidget( similarityCheckBox );
+  slayout->addWidget( metricCombo );
+  slayout->addWidget( thresholdSlider );
+  layout->addLayout( slayout );
   
   this->setLayout(layout);
 }
@@ -67,6 +128,101 @@ void PlotView::updateSpectralPlot( std::vector<float> wavelengths,  std::vector<
   emit currentHyperPixelsChanged(wavelengths, hyperPixels, icoords, fname);
 }
 
+void PlotView::updateRegionSpectralPlot( std::vector<float> wavelengths,  std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels)
+{
+  mWavelengths = wavelengths;
+  mHyperPixels = meanPixels;
+
+  emit currentRegionSpectrumChanged(wavelengths, meanPixels, stdPixels, numPixels);
+}
+
+void PlotView::fillBandCombos(const std::vector<float>& wavelengths)
+{
+  // default composite: bands closest to red, green and blue
+  const float defaults[3] = {640.f, 550.f, 460.f};
+  for (int k = 0; k < 3; k++)
+  {
+    bandCombo[k]->blockSignals(true);
+    bandCombo[k]->clear();
+    int closest = 0;
+    for (int c = 0; c < (int)wavelengths.size(); c++)
+    {
+      bandCombo[k]->addItem(QString("%1 nm").arg(wavelengths[c]));
+      if (fabs(wavelengths[c] - defaults[k]) < fabs(wavelengths[closest] - defaults[k]))
+        closest = c;
+    }
+    bandCombo[k]->setCurrentIndex(closest);
+    bandCombo[k]->blockSignals(false);
+  }
+}
+
+void PlotView::updateFalseColor()
+{
+  VtkWidget* gla = mw() ? mw()->VTKA() : NULL;
+  if (!gla)
+    return;
+  if (!falseColorCheckBox->isChecked())
+  {
+    falseColorCheckBox->setText(QString("False Colour"));
+    gla->setTrueColor();
+    return;
+  }
+
+  std::vector<float> wavelengths = gla->getWavelengths();
+  if (!gla->getIsHyperspectral() || wavelengths.empty())
+    return;
+  if (bandCombo[0]->count() != (int)wavelengths.size())
+    fillBandCombos(wavelengths);
+
+  if (!gla->isSpectralImageReady())
+  {
+    // the band-sequential mirror is still being built in the background, try again shortly
+    falseColorCheckBox->setText(QString("False Colour (preparing...)"));
+    if (!mIsFalseColorPending)
+    {
+      mIsFalseColorPending = true;
+      QTimer::singleShot(250, this, SLOT(retryFalseColor()));
+    }
+    return;
+  }
+  falseColorCheckBox->setText(QString("False Colour"));
+
+  SpectralImageMode mode = (SpectralImageMode)modeCombo->itemData(modeCombo->currentIndex()).toInt();
+  gla->setSpectralImage(mode, bandCombo[0]->currentIndex(), bandCombo[1]->currentIndex(), bandCombo[2]->currentIndex());
+}
+
+void PlotView::openPrincipalComponents()
+{
+  VtkWidget* gla = mw() ? mw()->VTKA() : NULL;
+  if (!gla || !gla->getIsHyperspectral())
+    return;
+  // the components are opened as new images once the PCA is done in the background
+  gla->openPrincipalComponents(pcaSpinBox->value());
+}
+
+void PlotView::retryFalseColor()
+{
+  mIsFalseColorPending = false;
+  updateFalseColor();
+}
+
+void PlotView::updateSimilarityMap()
+{
+  VtkWidget* gla = mw() ? mw()->VTKA() : NULL;
+  if (!gla)
+    return;
+  gla->setSimilarityThreshold(thresholdSlider->value() / 100.0);
+  gla->setSimilarityMetric((SimilarityMetric)metricCombo->itemData(metricCombo->currentIndex()).toInt());
+  gla->setSimilarityMapOn(similarityCheckBox->isChecked());
+}
+
+void PlotView::updateSimilarityThreshold(int value)
+{
+  VtkWidget* gla = mw() ? mw()->VTKA() : NULL;
+  if (gla)
+    gla->setSimilarityThreshold(value / 100.0);
+}
+
 MainWindow * PlotView::mw()
 {
   foreach (QWidget *widget, QApplication::topLevelWidgets()) {
@@ -42,15 +42,34 @@ public:
 
 signals:
   void currentHyperPixelsChanged(std::vector<float> wavelengths, std::vector<float> hyperPixels, const int* icoords, const std::string* fname);
+  void currentRegionSpectrumChanged(std::vector<float> wavelengths, std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels);
 
 public slots:
   void updateSpectralPlot( std::vector<float> wavelengths,  std::vector<float> hyperPixels, const int* icoords, const std::string* fname);
+  void updateRegionSpectralPlot( std::vector<float> wavelengths,  std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels);
+  void updateFalseColor();
+  void updateSimilarityMap();
+  void updateSimilarityThreshold(int value);
+  void openPrincipalComponents();
+
+private slots:
+  void retryFalseColor();
 
 private:
   MainWindow* mw();
   SpectralPlot *mSpectralPlot;
   QPushButton  *exportButton;
   QCheckBox    *normalizeCheckBox;
+  QCheckBox    *falseColorCheckBox;
+  bool         mIsFalseColorPending; // a retry is scheduled while the band cube is being prepared
+  QComboBox    *modeCombo; // SpectralImageMode
+  QComboBox    *bandCombo[3]; // bands shown as R, G, B (R and G are also the ratio bands)
+  void fillBandCombos(const std::vector<float>& wavelengths);
+  QPushButton  *pcaButton;
+  QSpinBox     *pcaSpinBox; // number of principal components to open
+  QCheckBox    *similarityCheckBox;
+  QComboBox    *metricCombo;
+  QSlider      *thresholdSlider; // percent of the largest angle/distance in the image
   std::vector<float> mWavelengths;
   std::vector<float> mHyperPixels;
 };
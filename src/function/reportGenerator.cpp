@@ -28,6 +28,7 @@
 #include <vtkSelectVisiblePoints.h>
 #include <vtkInteractorObserver.h>
 #include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 #include <vtkCenterOfMass.h>
 #include <vtkCellLocator.h>
 #include <vtkCleanPolyData.h>
@@ -47,6 +48,7 @@
 #include "reportGenerator.h"
 #include "lightControl.h"
 #include "../information/searchWidget.h"
+#include "../information/cellIdCodec.h"
 #include "../mainWindow.h"
 #include "CTControl.h"
 
@@ -308,13 +310,16 @@ void ReportGenerator::generate()
 							if (signal == QString("Polygon Ids:"))
 								break;
 						}
-						QVector<int> ids;
-						for (int k = 0; k < cellNum; k++)
+						vtkSmartPointer<vtkIdTypeArray> cellIds = vtkSmartPointer<vtkIdTypeArray>::New();
+						if (cellNum > 0 && !CellIdCodec::readNoteIds(in, mObjects[i]->mNotesPath, cellIds))
 						{
-							int cellId;
-							in >> cellId;
-							ids.push_back(cellId);
+							qDebug() << "Cannot read the cell ids of a surface note in " << mObjects[i]->mNotesPath;
+							continue;
 						}
+						QVector<int> ids;
+						ids.reserve(cellIds->GetNumberOfTuples());
+						for (vtkIdType k = 0; k < cellIds->GetNumberOfTuples(); k++)
+							ids.push_back(cellIds->GetValue(k));
 						double *center = new double[3];
 						computeCenter(mObjects[i]->mGla, ids, center);
 						surfaceNote3D.push_back(center);
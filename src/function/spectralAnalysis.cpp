@@ -0,0 +1,332 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <algorithm>
+
+#include <omp.h>
+#include <armadillo>  // Beware Armadillo should not be in the header => conflict with ITK and VTK
+
+#include <QtConcurrentRun>
+
+#include "spectralAnalysis.h"
+#include "bandCube.h"
+
+#define PCA_BLOCK (256) // pixels per covariance update, keeps memory bounded on large cubes
+#define STRETCH_BINS (1024)
+
+SpectralAnalysis::SpectralAnalysis(QObject* parent)
+  : QObject(parent), mCube(NULL), mWidth(0), mHeight(0), mBands(0), mBandCube(NULL),
+    mPending(0), mGeneration(0)
+{
+  connect(&mWatcher, SIGNAL(finished()), this, SLOT(pcaFinished()));
+}
+
+SpectralAnalysis::~SpectralAnalysis()
+{
+  mFuture.waitForFinished();
+}
+
+void SpectralAnalysis::setCube(const float* cube, int width, int height, int bands, BandCube* bandCube)
+{
+  // the running PCA reads the old cube
+  mFuture.waitForFinished();
+  clear();
+  mBandCube = bandCube;
+  bool isValid = cube && width > 0 && height > 0 && bands > 0;
+  mCube = isValid ? cube : NULL;
+  mWidth = isValid ? width : 0;
+  mHeight = isValid ? height : 0;
+  mBands = isValid ? bands : 0;
+}
+
+void SpectralAnalysis::clear()
+{
+  mCache.clear();
+  mEigenvalues.clear();
+  mPending = 0;
+  mGeneration++;
+}
+
+QString SpectralAnalysis::componentKey(int component, int numComponents)
+{
+  return QString("pc%1_%2").arg(component).arg(numComponents);
+}
+
+void SpectralAnalysis::computePrincipalComponents(int numComponents)
+{
+  numComponents = std::min(numComponents, mBands);
+  if (!mCube || numComponents < 1 || mWidth * mHeight < 2)
+    return;
+  if (cached(componentKey(0, numComponents)))
+  {
+    emit principalComponentsReady(numComponents);
+    return;
+  }
+  if (mFuture.isRunning())
+  {
+    mPending = numComponents;
+    return;
+  }
+  start(numComponents);
+}
+
+void SpectralAnalysis::start(int numComponents)
+{
+  mFuture = QtConcurrent::run(&SpectralAnalysis::computePCA, mCube, mWidth * mHeight, mBands, numComponents, mGeneration);
+  mWatcher.setFuture(mFuture);
+}
+
+void SpectralAnalysis::pcaFinished()
+{
+  PCAResult result = mFuture.result();
+  if (result.generation == mGeneration && !result.components.empty())
+  {
+    for (int m = 0; m < (int)result.components.size(); m++)
+      mCache[componentKey(m, result.numComponents)].swap(result.components[m]);
+    mEigenvalues.swap(result.eigenvalues);
+    emit principalComponentsReady(result.numComponents);
+  }
+  if (mPending > 0)
+  {
+    int numComponents = mPending;
+    mPending = 0;
+    computePrincipalComponents(numComponents);
+  }
+}
+
+const float* SpectralAnalysis::getPrincipalComponent(int component, int numComponents) const
+{
+  numComponents = std::min(numComponents, mBands);
+  if (component < 0 || component >= numComponents)
+    return NULL;
+  return cached(componentKey(component, numComponents));
+}
+
+const float* SpectralAnalysis::cached(const QString& key) const
+{
+  QMap<QString, std::vector<float> >::const_iterator it = mCache.constFind(key);
+  if (it == mCache.constEnd() || it.value().empty())
+    return NULL;
+  return &it.value()[0];
+}
+
+// Covariance of all spectra accumulated block by block (each thread owns one bands x bands
+// accumulator), eigen-decomposed with armadillo, then every pixel is projected onto the
+// leading eigenvectors. Both passes read the interleaved cube PCA_BLOCK spectra at a time,
+// which is contiguous memory; runs in a worker thread and only touches its arguments.
+SpectralAnalysis::PCAResult SpectralAnalysis::computePCA(const float* cube, int numPixels, int bands, int numComponents, int generation)
+{
+  PCAResult result;
+  result.numComponents = numComponents;
+  result.generation = generation;
+  if (!cube || bands < 1 || numPixels < 2)
+    return result;
+
+  // shift by the first spectrum to keep the single pass sum of squares stable
+  arma::vec shift(bands);
+  for (int c = 0; c < bands; c++)
+    shift(c) = cube[c];
+
+  const int numBlocks = (numPixels + PCA_BLOCK - 1) / PCA_BLOCK;
+  arma::mat scatter = arma::zeros<arma::mat>(bands, bands);
+  arma::vec sum = arma::zeros<arma::vec>(bands);
+
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel
+  {
+    arma::mat localScatter = arma::zeros<arma::mat>(bands, bands);
+    arma::vec localSum = arma::zeros<arma::vec>(bands);
+    arma::mat block(bands, PCA_BLOCK);
+
+    int k = 0;
+    #pragma omp for schedule(static)
+    for (k = 0; k < numBlocks; k++)
+    {
+      int pBegin = k * PCA_BLOCK;
+      int n = std::min(PCA_BLOCK, numPixels - pBegin);
+      const float* spectra = cube + (size_t)pBegin * bands;
+      for (int p = 0; p < n; p++)
+        for (int c = 0; c < bands; c++)
+          block(c, p) = spectra[(size_t)p * bands + c] - shift(c);
+      arma::mat x = block.cols(0, n - 1);
+      localScatter += x * x.t();
+      localSum += arma::sum(x, 1);
+    }
+
+    #pragma omp critical
+    {
+      scatter += localScatter;
+      sum += localSum;
+    }
+  }
+
+  arma::vec mean = sum / numPixels;
+  arma::mat covariance = (scatter - numPixels * (mean * mean.t())) / (numPixels - 1);
+  mean += shift;
+
+  arma::vec eigval;
+  arma::mat eigvec;
+  if (!arma::eig_sym(eigval, eigvec, covariance))
+    return result;
+
+  // eig_sym sorts ascending; take the last numComponents columns in reverse
+  std::vector<std::vector<float> > weights(numComponents, std::vector<float>(bands));
+  std::vector<float> offsets(numComponents, 0.f);
+  result.eigenvalues.assign(numComponents, 0.);
+  for (int m = 0; m < numComponents; m++)
+  {
+    int col = bands - 1 - m;
+    result.eigenvalues[m] = eigval(col);
+    // fix the sign so that the dominant coefficient is positive (stable display across runs)
+    arma::uword dominant = 0;
+    arma::vec magnitude = arma::abs(eigvec.col(col));
+    magnitude.max(dominant);
+    double sign = (eigvec(dominant, col) < 0.) ? -1. : 1.;
+    for (int c = 0; c < bands; c++)
+    {
+      weights[m][c] = (float)(sign * eigvec(c, col));
+      offsets[m] += (float)(weights[m][c] * mean(c));
+    }
+  }
+
+  std::vector<std::vector<float> > components(numComponents, std::vector<float>(numPixels));
+  int k = 0;
+  #pragma omp parallel for private(k) schedule(static)
+  for (k = 0; k < numBlocks; k++)
+  {
+    int pBegin = k * PCA_BLOCK;
+    int pEnd = std::min(pBegin + PCA_BLOCK, numPixels);
+    for (int m = 0; m < numComponents; m++)
+    {
+      const float* w = &weights[m][0];
+      float* out = &components[m][0];
+      for (int p = pBegin; p < pEnd; p++)
+      {
+        const float* x = cube + (size_t)p * bands;
+        float value = -offsets[m];
+        for (int c = 0; c < bands; c++)
+          value += w[c] * x[c];
+        out[p] = value;
+      }
+    }
+  }
+  result.components.swap(components);
+  return result;
+}
+
+const float* SpectralAnalysis::getBandRatio(int a, int b)
+{
+  if (!mBandCube)
+    return NULL;
+  QString key = QString("ratio%1_%2").arg(a).arg(b);
+  if (!mCache.contains(key))
+  {
+    const float* pa = mBandCube->getBand(a);
+    const float* pb = mBandCube->getBand(b);
+    if (!pa || !pb)
+      return NULL;
+    const int numPixels = getWidth() * getHeight();
+    std::vector<float> ratio(numPixels);
+    int p = 0;
+    omp_set_num_threads(omp_get_num_procs());
+    #pragma omp parallel for private(p) schedule(static)
+    for (p = 0; p < numPixels; p++)
+      ratio[p] = (pb[p] != 0.f) ? pa[p] / pb[p] : 0.f;
+    mCache[key].swap(ratio);
+  }
+  return cached(key);
+}
+
+const float* SpectralAnalysis::getNormalizedDifference(int a, int b)
+{
+  if (!mBandCube)
+    return NULL;
+  QString key = QString("ndi%1_%2").arg(a).arg(b);
+  if (!mCache.contains(key))
+  {
+    const float* pa = mBandCube->getBand(a);
+    const float* pb = mBandCube->getBand(b);
+    if (!pa || !pb)
+      return NULL;
+    const int numPixels = getWidth() * getHeight();
+    std::vector<float> ndi(numPixels);
+    int p = 0;
+    omp_set_num_threads(omp_get_num_procs());
+    #pragma omp parallel for private(p) schedule(static)
+    for (p = 0; p < numPixels; p++)
+    {
+      float total = pa[p] + pb[p];
+      ndi[p] = (total != 0.f) ? (pa[p] - pb[p]) / total : 0.f;
+    }
+    mCache[key].swap(ndi);
+  }
+  return cached(key);
+}
+
+void SpectralAnalysis::stretchToBytes(const float* plane, int numPixels, unsigned char* out, int stride, double clipFraction)
+{
+  if (!plane || numPixels <= 0)
+    return;
+
+  float lo = plane[0], hi = plane[0];
+  for (int p = 1; p < numPixels; p++)
+  {
+    if (plane[p] < lo) lo = plane[p];
+    if (plane[p] > hi) hi = plane[p];
+  }
+  float binScale = (hi > lo) ? (STRETCH_BINS - 1) / (hi - lo) : 0.f;
+  std::vector<int> hist(STRETCH_BINS, 0);
+  for (int p = 0; p < numPixels; p++)
+  {
+    int bin = (int)((plane[p] - lo) * binScale);
+    if (bin >= 0 && bin < STRETCH_BINS) hist[bin]++; // skips NaN
+  }
+
+  int lowBin = 0, highBin = STRETCH_BINS - 1;
+  double count = 0;
+  for (int i = 0; i < STRETCH_BINS; i++)
+  {
+    count += hist[i];
+    if (count > clipFraction * numPixels) { lowBin = i; break; }
+  }
+  count = 0;
+  for (int i = STRETCH_BINS - 1; i >= 0; i--)
+  {
+    count += hist[i];
+    if (count > clipFraction * numPixels) { highBin = i; break; }
+  }
+  float binWidth = (hi - lo) / (STRETCH_BINS - 1);
+  float low = lo + lowBin * binWidth;
+  float high = std::min(hi, lo + (highBin + 1) * binWidth);
+  float scale = (high > low) ? 255.f / (high - low) : 0.f;
+
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    float value = (plane[p] - low) * scale;
+    out[p * stride] = (unsigned char)(value < 0.f ? 0.f : (value > 255.f ? 255.f : value));
+  }
+}
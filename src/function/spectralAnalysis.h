@@ -0,0 +1,115 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef SPECTRALANALYSIS_H
+#define SPECTRALANALYSIS_H
+
+#include <vector>
+#include <QObject>
+#include <QMap>
+#include <QString>
+#include <QFuture>
+#include <QFutureWatcher>
+
+class BandCube;
+
+// Principal component and band ratio images of a hyperspectral cube.
+// Every result is a float plane of getWidth() x getHeight() pixels and is cached
+// by name until the cube is replaced, so revisiting an analysis costs nothing.
+// The PCA runs in a background thread and streams the band-interleaved cube in
+// blocks of pixels, for the covariance and again for the projection, so it needs
+// no band-sequential copy; only the k component planes are allocated.
+// Band ratios read their two bands from the band-sequential mirror.
+// Armadillo is only used in the implementation (it conflicts with ITK/VTK headers).
+class SpectralAnalysis : public QObject
+{
+  Q_OBJECT
+
+public:
+  SpectralAnalysis(QObject* parent = 0);
+  ~SpectralAnalysis();
+
+  // cube (band-interleaved floats) is read in place by the PCA, bandCube serves the
+  // band ratios; the cached results are dropped
+  void setCube(const float* cube, int width, int height, int bands, BandCube* bandCube);
+  void clear();
+
+  int getWidth() const {return mWidth;}
+  int getHeight() const {return mHeight;}
+  int getNumberOfBands() const {return mBands;}
+
+  // starts the PCA of the numComponents largest components in the background and emits
+  // principalComponentsReady() when they are cached (right away if they already are);
+  // a request for another count waits until the running one is done
+  void computePrincipalComponents(int numComponents);
+  bool isBusy() const {return mFuture.isRunning();}
+  // component-th image of a finished PCA of numComponents components (0 is the largest
+  // variance), NULL if it has not been computed
+  const float* getPrincipalComponent(int component, int numComponents) const;
+  // eigenvalues of the components of the last PCA, in decreasing order
+  const std::vector<double>& getEigenvalues() const {return mEigenvalues;}
+  // a / b and (a - b) / (a + b) of two bands
+  const float* getBandRatio(int a, int b);
+  const float* getNormalizedDifference(int a, int b);
+
+  // linear stretch of a plane into 8 bits between the clipFraction percentiles;
+  // writes every stride-th byte of out so that planes can be interleaved into RGB
+  static void stretchToBytes(const float* plane, int numPixels, unsigned char* out, int stride, double clipFraction = 0.01);
+
+signals:
+  void principalComponentsReady(int numComponents);
+
+private slots:
+  void pcaFinished();
+
+private:
+  struct PCAResult
+  {
+    std::vector<std::vector<float> > components;
+    std::vector<double> eigenvalues;
+    int numComponents;
+    int generation;
+  };
+
+  void start(int numComponents);
+  static PCAResult computePCA(const float* cube, int numPixels, int bands, int numComponents, int generation);
+  static QString componentKey(int component, int numComponents);
+  // first value of a cached plane, NULL if it is missing or empty
+  const float* cached(const QString& key) const;
+
+  const float* mCube; // band-interleaved, mWidth * mHeight spectra of mBands floats
+  int mWidth;
+  int mHeight;
+  int mBands;
+  BandCube* mBandCube;
+  QMap<QString, std::vector<float> > mCache;
+  std::vector<double> mEigenvalues;
+
+  int mPending;    // component count requested while a PCA was running, 0 if none
+  int mGeneration; // bumped when the cube changes, results of older PCAs are dropped
+
+  QFuture<PCAResult> mFuture;
+  QFutureWatcher<PCAResult> mWatcher;
+};
+
+#endif // SPECTRALANALYSIS_H
@@ -24,6 +24,7 @@
 #include <vector>
 #include <fstream>
 #include <cmath>
+#include <algorithm>
 
 #include <QtGui>
 #include <QFileDialog>
@@ -47,6 +48,8 @@
 #include <qwt_plot_curve.h>
 #include <qwt_symbol.h>
 #include <qwt_column_symbol.h>
+#include <qwt_plot_intervalcurve.h>
+#include <qwt_interval_symbol.h>
 
 #include "spectralPlot.h"
 #include <stdio.h>
@@ -77,6 +80,8 @@ void SpectralPlot::updateSpectralPlot( std::vector<float> wavelengths,  std::vec
 
   mWavelengths = QVector<double>::fromStdVector(dwavelengths);
   mHyperPixels = QVector<double>::fromStdVector(dhyperPixels);
+  mStdPixels.clear();
+  mNumRegionPixels = 0;
   
   replot_curve();
 
@@ -89,6 +94,23 @@ void SpectralPlot::updateSpectralPlot( std::vector<float> wavelengths,  std::vec
   }
 }
 
+// mean spectrum of a region (e.g. a pigment area marked by a note) with its standard deviation
+void SpectralPlot::updateRegionSpectralPlot( std::vector<float> wavelengths,  std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels)
+{
+  std::vector<double> dwavelengths (wavelengths.begin(), wavelengths.end());
+  std::vector<double> dmeanPixels (meanPixels.begin(), meanPixels.end());
+  std::vector<double> dstdPixels (stdPixels.begin(), stdPixels.end());
+
+  mWavelengths = QVector<double>::fromStdVector(dwavelengths);
+  mHyperPixels = QVector<double>::fromStdVector(dmeanPixels);
+  mStdPixels = QVector<double>::fromStdVector(dstdPixels);
+  mNumRegionPixels = numPixels;
+
+  replot_curve();
+
+  isValidExport = false; // export is defined for a sample location only
+}
+
 void SpectralPlot::exportPlot() {
   if (!isValidExport) { return; }
   QString annotation_label = QInputDialog::getText(this, tr("Annotation Text Label"),
@@ -202,7 +224,7 @@ void SpectralPlot::initGradient()
     canvas()->setPalette( pal );
 }
 
-void SpectralPlot::normalize_vector_in(QVector<double>& vec) {
+double SpectralPlot::normalize_vector_in(QVector<double>& vec) {
   double length = 0.0;
   for (int i = 0; i < vec.size(); ++i) {
     double value = vec[i];
@@ -212,18 +234,36 @@ void SpectralPlot::normalize_vector_in(QVector<double>& vec) {
   for (int i = 0; i < vec.size(); ++i) {
     vec[i] /= length;
   }
+  return length;
 }
 
 void SpectralPlot::replot_curve() {
   QVector<double>  curr_mHyperPixels = mHyperPixels;
-  if (isNormalizedPlot) { normalize_vector_in(curr_mHyperPixels); }
+  double length = 1.0;
+  if (isNormalizedPlot) { length = normalize_vector_in(curr_mHyperPixels); }
   QVector<QPointF> spectralData;
-  int spectralData_size = mWavelengths.size();
+  int spectralData_size = std::min(mWavelengths.size(), curr_mHyperPixels.size());
   for (int i = 0; i < spectralData_size; ++i) {
     spectralData.push_back(QPointF(mWavelengths[i],curr_mHyperPixels[i]));
   }
   mCurve1->setSamples(spectralData);
 
+  // error bars of the region spectrum, scaled like the mean
+  QVector<QwtIntervalSample> stdData;
+  int stdData_size = std::min(spectralData_size, mStdPixels.size());
+  for (int i = 0; i < stdData_size; ++i) {
+    double dev = (length > 0.0) ? mStdPixels[i] / length : 0.0;
+    stdData.push_back(QwtIntervalSample(mWavelengths[i], curr_mHyperPixels[i] - dev, curr_mHyperPixels[i] + dev));
+  }
+  mStdCurve->setSamples(stdData);
+  mStdCurve->setVisible(stdData_size > 0);
+
+  QwtText title;
+  if (mNumRegionPixels > 0)
+    title.setText(QString("Region Mean (%1 pixels)").arg(mNumRegionPixels));
+  title.setFont( QFont( "Helvetica", 9) );
+  setTitle(title);
+
   this->replot();
 }
 
@@ -292,6 +332,17 @@ SpectralPlot::SpectralPlot( QWidget *parent ):
 
   showCurve( mCurve1, true );
 
+  mStdCurve = new QwtPlotIntervalCurve(tr("Std. Dev."));
+  mStdCurve->setStyle(QwtPlotIntervalCurve::NoCurve);
+  QwtIntervalSymbol* errorBar = new QwtIntervalSymbol(QwtIntervalSymbol::Bar);
+  errorBar->setWidth(5);
+  errorBar->setPen(QPen(QColor(255, 255, 255, 200), 1));
+  mStdCurve->setSymbol(errorBar);
+  mStdCurve->setRenderHint( QwtPlotItem::RenderAntialiased, true );
+  mStdCurve->setVisible(false);
+  mStdCurve->attach( this );
+  mNumRegionPixels = 0;
+
   mSpectralCoords[0] = 0;
   mSpectralCoords[1] = 0;
   mSpectralCoords[2] = 0;
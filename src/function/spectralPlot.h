@@ -35,6 +35,7 @@ class RectItem;
 
 //class QwtPlotCurve;
 class QwtPlotMarker;
+class QwtPlotIntervalCurve;
 
 #if 0
 class SpectralCurve: public QwtPlotCurve
@@ -69,23 +70,27 @@ public:
 
 public slots:
   void updateSpectralPlot( std::vector<float> wavelengths,  std::vector<float> hyperPixels, const int* icoords, const std::string* fname);
+  void updateRegionSpectralPlot( std::vector<float> wavelengths,  std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels);
   void exportPlot();
   void set_normalized_plot(int state);
   void showCurve( QwtPlotItem *item, bool on );
 
 private:
   QwtPlotBarChart *mCurve1;
+  QwtPlotIntervalCurve *mStdCurve; // +/- one standard deviation for region spectra
   int mSpectralCoords[3];
   std::string mSpectralFname;
   bool isValidExport;
   bool isNormalizedPlot;
 
   void initGradient();
-  void normalize_vector_in(QVector<double>& vec);
+  double normalize_vector_in(QVector<double>& vec);
   void replot_curve();
 
   QVector<double>  mWavelengths;
   QVector<double>  mHyperPixels;
+  QVector<double>  mStdPixels; // empty for single pixel spectra
+  int mNumRegionPixels;
 };
 
 
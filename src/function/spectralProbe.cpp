@@ -0,0 +1,422 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <emmintrin.h>
+#include <omp.h>
+
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkDataArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIdList.h>
+#include <vtkSmartPointer.h>
+
+#include "spectralProbe.h"
+
+#define GAMMA (2.2f)
+
+// sum += p, sumSq += p*p over all bands, four bands at a time
+static inline void accumulateSpectrum(const float* p, float* sum, float* sumSq, int bands)
+{
+  int b = 0;
+  for (; b + 4 <= bands; b += 4)
+  {
+    __m128 v = _mm_loadu_ps(p + b);
+    _mm_storeu_ps(sum + b, _mm_add_ps(_mm_loadu_ps(sum + b), v));
+    _mm_storeu_ps(sumSq + b, _mm_add_ps(_mm_loadu_ps(sumSq + b), _mm_mul_ps(v, v)));
+  }
+  for (; b < bands; ++b)
+  {
+    sum[b] += p[b];
+    sumSq[b] += p[b] * p[b];
+  }
+}
+
+SpectralProbe::SpectralProbe()
+{
+  setImageData(NULL);
+}
+
+SpectralProbe::SpectralProbe(vtkImageData* image)
+{
+  setImageData(image);
+}
+
+void SpectralProbe::setImageData(vtkImageData* image)
+{
+  mImage = image;
+  mCube = NULL;
+  mRgb = NULL;
+  mWidth = mHeight = mBands = mChannels = 0;
+  mIsRGB = false;
+  mOrigin[0] = mOrigin[1] = mOrigin[2] = 0.;
+  mSpacing[0] = mSpacing[1] = mSpacing[2] = 1.;
+  for (int v = 0; v < 256; v++)
+    mGammaLUT[v] = pow(v / 255.f, GAMMA);
+
+  if (!image)
+    return;
+
+  int dims[3];
+  image->GetDimensions(dims);
+  if (dims[0] <= 0 || dims[1] <= 0 || image->GetNumberOfScalarComponents() <= 0 || !image->GetScalarPointer())
+    return;
+
+  image->GetOrigin(mOrigin);
+  image->GetSpacing(mSpacing);
+  mChannels = image->GetNumberOfScalarComponents();
+
+  if (image->GetScalarType() == VTK_FLOAT)
+  {
+    mCube = static_cast<const float*>(image->GetScalarPointer());
+    mBands = mChannels;
+  }
+  else if (image->GetScalarType() == VTK_UNSIGNED_CHAR)
+  {
+    // put zero at both ends of the spectral range (only for RGB)
+    mRgb = static_cast<const unsigned char*>(image->GetScalarPointer());
+    mBands = mChannels + 2;
+    mIsRGB = true;
+  }
+  else
+    return;
+
+  mWidth = dims[0];
+  mHeight = dims[1];
+}
+
+bool SpectralProbe::getSpectrum(int i, int j, float* spectrum) const
+{
+  if (!isValid() || i < 0 || j < 0 || i >= mWidth || j >= mHeight)
+    return false;
+
+  size_t index = (size_t)j * mWidth + i;
+  if (mIsRGB)
+  {
+    const unsigned char* p = mRgb + index * mChannels;
+    spectrum[0] = 0;
+    for (int c = 0; c < mChannels; c++)
+      spectrum[c + 1] = mGammaLUT[p[mChannels - 1 - c]];
+    spectrum[mBands - 1] = 0;
+  }
+  else
+  {
+    memcpy(spectrum, mCube + index * mBands, sizeof(float) * mBands);
+  }
+  return true;
+}
+
+int SpectralProbe::getSpectra(const std::vector<std::pair<int, int> >& pixels, std::vector<float>& spectra) const
+{
+  spectra.assign(pixels.size() * mBands, 0.f);
+  if (!isValid() || pixels.empty())
+    return 0;
+
+  int numValid = 0;
+  int n = static_cast<int>(pixels.size());
+  int k;
+  omp_set_num_threads(omp_get_num_procs());
+  // a hover probe is a batch of one, threads only pay off for real batches
+  #pragma omp parallel for reduction(+:numValid) schedule(static) if(n > 256)
+  for (k = 0; k < n; k++)
+  {
+    if (getSpectrum(pixels[k].first, pixels[k].second, &spectra[(size_t)k * mBands]))
+      numValid++;
+  }
+  return numValid;
+}
+
+void SpectralProbe::worldToPixel(double x, double y, double& i, double& j) const
+{
+  i = (x - mOrigin[0]) / (mSpacing[0] != 0 ? mSpacing[0] : 1.);
+  j = (y - mOrigin[1]) / (mSpacing[1] != 0 ? mSpacing[1] : 1.);
+}
+
+int SpectralProbe::getRegionStatistics(const std::vector<std::pair<double, double> >& polygon, std::vector<float>& mean, std::vector<float>& stddev) const
+{
+  mean.assign(mBands, 0.f);
+  stddev.assign(mBands, 0.f);
+  if (!isValid() || polygon.size() < 3)
+    return 0;
+
+  std::vector<double> px(polygon.size()), py(polygon.size());
+  double ymin = 1e30, ymax = -1e30, xmin = 1e30, xmax = -1e30;
+  for (size_t k = 0; k < polygon.size(); k++)
+  {
+    worldToPixel(polygon[k].first, polygon[k].second, px[k], py[k]);
+    xmin = std::min(xmin, px[k]); xmax = std::max(xmax, px[k]);
+    ymin = std::min(ymin, py[k]); ymax = std::max(ymax, py[k]);
+  }
+
+  int bbox[4];
+  bbox[0] = std::max(0, (int)ceil(xmin));
+  bbox[1] = std::max(0, (int)ceil(ymin));
+  bbox[2] = std::min(mWidth - 1, (int)floor(xmax));
+  bbox[3] = std::min(mHeight - 1, (int)floor(ymax));
+  if (bbox[0] > bbox[2] || bbox[1] > bbox[3])
+    return 0;
+
+  // even-odd scanline fill at pixel centers; the closing edge is implicit
+  int w = bbox[2] - bbox[0] + 1;
+  std::vector<unsigned char> mask((size_t)w * (bbox[3] - bbox[1] + 1), 0);
+  std::vector<double> crossings;
+  size_t n = polygon.size();
+  for (int j = bbox[1]; j <= bbox[3]; j++)
+  {
+    crossings.clear();
+    for (size_t a = 0, b = n - 1; a < n; b = a++)
+    {
+      if ((py[a] > j) != (py[b] > j))
+        crossings.push_back(px[a] + (j - py[a]) * (px[b] - px[a]) / (py[b] - py[a]));
+    }
+    std::sort(crossings.begin(), crossings.end());
+    for (size_t c = 0; c + 1 < crossings.size(); c += 2)
+    {
+      int i0 = std::max(bbox[0], (int)ceil(crossings[c]));
+      int i1 = std::min(bbox[2], (int)floor(crossings[c + 1]));
+      if (i0 <= i1)
+        memset(&mask[(size_t)(j - bbox[1]) * w + (i0 - bbox[0])], 1, i1 - i0 + 1);
+    }
+  }
+  return getRegionStatistics(mask, bbox, mean, stddev);
+}
+
+int SpectralProbe::getRegionStatistics(const double* rect, std::vector<float>& mean, std::vector<float>& stddev) const
+{
+  mean.assign(mBands, 0.f);
+  stddev.assign(mBands, 0.f);
+  if (!isValid() || !rect)
+    return 0;
+
+  double i0, j0, i1, j1;
+  worldToPixel(rect[0], rect[1], i0, j0);
+  worldToPixel(rect[2], rect[3], i1, j1);
+
+  int bbox[4];
+  bbox[0] = std::max(0, (int)ceil(std::min(i0, i1)));
+  bbox[1] = std::max(0, (int)ceil(std::min(j0, j1)));
+  bbox[2] = std::min(mWidth - 1, (int)floor(std::max(i0, i1)));
+  bbox[3] = std::min(mHeight - 1, (int)floor(std::max(j0, j1)));
+  if (bbox[0] > bbox[2] || bbox[1] > bbox[3])
+    return 0;
+
+  std::vector<unsigned char> mask((size_t)(bbox[2] - bbox[0] + 1) * (bbox[3] - bbox[1] + 1), 1);
+  return getRegionStatistics(mask, bbox, mean, stddev);
+}
+
+void SpectralProbe::rasterizeTriangle(const double* u, const double* v, std::vector<unsigned char>& mask, const int* bbox) const
+{
+  int w = bbox[2] - bbox[0] + 1;
+  int i0 = std::max(bbox[0], (int)ceil(std::min(u[0], std::min(u[1], u[2]))));
+  int i1 = std::min(bbox[2], (int)floor(std::max(u[0], std::max(u[1], u[2]))));
+  int j0 = std::max(bbox[1], (int)ceil(std::min(v[0], std::min(v[1], v[2]))));
+  int j1 = std::min(bbox[3], (int)floor(std::max(v[0], std::max(v[1], v[2]))));
+
+  double area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+  bool covered = false;
+  if (fabs(area) > 1e-12)
+  {
+    for (int j = j0; j <= j1; j++)
+    {
+      for (int i = i0; i <= i1; i++)
+      {
+        double w0 = ((u[1] - i) * (v[2] - j) - (u[2] - i) * (v[1] - j)) / area;
+        double w1 = ((u[2] - i) * (v[0] - j) - (u[0] - i) * (v[2] - j)) / area;
+        double w2 = 1. - w0 - w1;
+        if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+        {
+          mask[(size_t)(j - bbox[1]) * w + (i - bbox[0])] = 1;
+          covered = true;
+        }
+      }
+    }
+  }
+  if (covered)
+    return;
+
+  // smaller than a texel: take the texel under the centroid
+  int ic = (int)floor((u[0] + u[1] + u[2]) / 3. + 0.5);
+  int jc = (int)floor((v[0] + v[1] + v[2]) / 3. + 0.5);
+  if (ic < bbox[0] || jc < bbox[1] || ic > bbox[2] || jc > bbox[3])
+    return;
+  mask[(size_t)(jc - bbox[1]) * w + (ic - bbox[0])] = 1;
+}
+
+int SpectralProbe::getRegionStatistics(vtkPolyData* mesh, vtkIdTypeArray* cellIds, std::vector<float>& mean, std::vector<float>& stddev) const
+{
+  mean.assign(mBands, 0.f);
+  stddev.assign(mBands, 0.f);
+  if (!isValid() || !mesh || !cellIds || !mesh->GetPointData())
+    return 0;
+
+  vtkDataArray* tcoords = mesh->GetPointData()->GetTCoords();
+  if (!tcoords || tcoords->GetNumberOfComponents() < 2)
+    return 0;
+
+  // first pass: the triangles in texture space and the box they cover
+  std::vector<double> triangles;
+  int bbox[4] = {mWidth, mHeight, -1, -1};
+  vtkSmartPointer<vtkIdList> pointIds = vtkSmartPointer<vtkIdList>::New();
+  double u[3], v[3], tc[3];
+
+  for (vtkIdType k = 0; k < cellIds->GetNumberOfTuples(); k++)
+  {
+    vtkIdType cellId = cellIds->GetValue(k);
+    if (cellId < 0 || cellId >= mesh->GetNumberOfCells())
+      continue;
+    mesh->GetCellPoints(cellId, pointIds);
+    vtkIdType npts = pointIds->GetNumberOfIds();
+    if (npts < 3)
+      continue;
+
+    // texture space, pixel centers on integer coordinates (fan triangulation)
+    tcoords->GetTuple(pointIds->GetId(0), tc);
+    u[0] = tc[0] * mWidth - 0.5; v[0] = tc[1] * mHeight - 0.5;
+    for (vtkIdType p = 1; p + 1 < npts; p++)
+    {
+      tcoords->GetTuple(pointIds->GetId(p), tc);
+      u[1] = tc[0] * mWidth - 0.5; v[1] = tc[1] * mHeight - 0.5;
+      tcoords->GetTuple(pointIds->GetId(p + 1), tc);
+      u[2] = tc[0] * mWidth - 0.5; v[2] = tc[1] * mHeight - 0.5;
+      for (int c = 0; c < 3; c++)
+      {
+        triangles.push_back(u[c]);
+        triangles.push_back(v[c]);
+      }
+      // floor/ceil also cover the centroid texel of triangles smaller than a texel
+      bbox[0] = std::min(bbox[0], std::max(0, (int)floor(std::min(u[0], std::min(u[1], u[2])))));
+      bbox[1] = std::min(bbox[1], std::max(0, (int)floor(std::min(v[0], std::min(v[1], v[2])))));
+      bbox[2] = std::max(bbox[2], std::min(mWidth - 1, (int)ceil(std::max(u[0], std::max(u[1], u[2])))));
+      bbox[3] = std::max(bbox[3], std::min(mHeight - 1, (int)ceil(std::max(v[0], std::max(v[1], v[2])))));
+    }
+  }
+  if (bbox[0] > bbox[2] || bbox[1] > bbox[3])
+    return 0;
+
+  // second pass: rasterize into a mask of that box only
+  std::vector<unsigned char> mask((size_t)(bbox[2] - bbox[0] + 1) * (bbox[3] - bbox[1] + 1), 0);
+  for (size_t t = 0; t + 6 <= triangles.size(); t += 6)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      u[c] = triangles[t + 2 * c];
+      v[c] = triangles[t + 2 * c + 1];
+    }
+    rasterizeTriangle(u, v, mask, bbox);
+  }
+  return getRegionStatistics(mask, bbox, mean, stddev);
+}
+
+int SpectralProbe::getRegionStatistics(const std::vector<unsigned char>& mask, const int* bbox, std::vector<float>& mean, std::vector<float>& stddev) const
+{
+  mean.assign(mBands, 0.f);
+  stddev.assign(mBands, 0.f);
+  if (!isValid())
+    return 0;
+
+  // the mask covers the box (the whole image without one), row by row
+  int ox = 0, oy = 0, stride = mWidth, rows = mHeight;
+  if (bbox)
+  {
+    ox = bbox[0]; oy = bbox[1];
+    stride = bbox[2] - bbox[0] + 1;
+    rows = bbox[3] - bbox[1] + 1;
+  }
+  if (stride <= 0 || rows <= 0 || mask.size() != (size_t)stride * rows)
+    return 0;
+  int x0 = std::max(0, ox), y0 = std::max(0, oy);
+  int x1 = std::min(mWidth - 1, ox + stride - 1), y1 = std::min(mHeight - 1, oy + rows - 1);
+
+  const int bands = mBands;
+  std::vector<double> sum(bands, 0.), sumSq(bands, 0.);
+  long count = 0;
+
+  int j;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel
+  {
+    // per-thread accumulators; each row is reduced in float then promoted to double
+    std::vector<double> lsum(bands, 0.), lsumSq(bands, 0.);
+    std::vector<float> rowSum(bands), rowSumSq(bands), pixel(bands);
+    long lcount = 0;
+
+    #pragma omp for schedule(dynamic, 16)
+    for (j = y0; j <= y1; j++)
+    {
+      std::fill(rowSum.begin(), rowSum.end(), 0.f);
+      std::fill(rowSumSq.begin(), rowSumSq.end(), 0.f);
+      int rowCount = 0;
+      const unsigned char* m = &mask[(size_t)(j - oy) * stride];
+      for (int i = x0; i <= x1; i++)
+      {
+        if (!m[i - ox])
+          continue;
+        const float* p;
+        if (mIsRGB)
+        {
+          getSpectrum(i, j, &pixel[0]);
+          p = &pixel[0];
+        }
+        else
+          p = mCube + ((size_t)j * mWidth + i) * bands;
+        accumulateSpectrum(p, &rowSum[0], &rowSumSq[0], bands);
+        rowCount++;
+      }
+      if (rowCount == 0)
+        continue;
+      for (int b = 0; b < bands; b++)
+      {
+        lsum[b] += rowSum[b];
+        lsumSq[b] += rowSumSq[b];
+      }
+      lcount += rowCount;
+    }
+
+    #pragma omp critical
+    {
+      for (int b = 0; b < bands; b++)
+      {
+        sum[b] += lsum[b];
+        sumSq[b] += lsumSq[b];
+      }
+      count += lcount;
+    }
+  }
+
+  if (count == 0)
+    return 0;
+
+  for (int b = 0; b < bands; b++)
+  {
+    double m = sum[b] / count;
+    double var = sumSq[b] / count - m * m;
+    mean[b] = static_cast<float>(m);
+    stddev[b] = static_cast<float>(var > 0. ? sqrt(var) : 0.);
+  }
+  return static_cast<int>(count);
+}
@@ -0,0 +1,86 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef SPECTRALPROBE_H
+#define SPECTRALPROBE_H
+
+#include <vector>
+#include <utility>
+
+class vtkImageData;
+class vtkPolyData;
+class vtkIdTypeArray;
+
+// Reads whole spectra out of the band-interleaved cube (mHyperImageData) or,
+// when there is no hyperspectral data, out of the 8-bit RGB image with the same
+// (0, b, g, r, 0) convention the spectral plot has always used for RGB.
+// Region statistics are reduced row by row with SSE and OpenMP.
+class SpectralProbe
+{
+public:
+  SpectralProbe();
+  SpectralProbe(vtkImageData* image);
+
+  void setImageData(vtkImageData* image);
+  bool isValid() const {return mWidth > 0 && mHeight > 0 && mBands > 0;}
+  bool isRGB() const {return mIsRGB;}
+  int getWidth() const {return mWidth;}
+  int getHeight() const {return mHeight;}
+  int getNumberOfBands() const {return mBands;}
+  // raw band-interleaved cube (NULL in RGB mode)
+  const float* getCube() const {return mCube;}
+
+  // one spectrum; spectrum must hold getNumberOfBands() values
+  bool getSpectrum(int i, int j, float* spectrum) const;
+  // many spectra at once; pixels holds (i,j) pairs, spectra is resized to
+  // pixels.size() * getNumberOfBands(). Returns the number of valid pixels.
+  int getSpectra(const std::vector<std::pair<int, int> >& pixels, std::vector<float>& spectra) const;
+
+  // mean/std spectra over a 2D polygon given in world coordinates of the image
+  int getRegionStatistics(const std::vector<std::pair<double, double> >& polygon, std::vector<float>& mean, std::vector<float>& stddev) const;
+  // mean/std spectra over an axis aligned rectangle (x0, y0, x1, y1) in world coordinates
+  int getRegionStatistics(const double* rect, std::vector<float>& mean, std::vector<float>& stddev) const;
+  // mean/std spectra over the texture footprint of a set of mesh cells (3D surface notes)
+  int getRegionStatistics(vtkPolyData* mesh, vtkIdTypeArray* cellIds, std::vector<float>& mean, std::vector<float>& stddev) const;
+  // mean/std spectra over a pixel mask covering bbox (x0, y0, x1, y1) row by row,
+  // or the whole getWidth() x getHeight() image when bbox is NULL
+  int getRegionStatistics(const std::vector<unsigned char>& mask, const int* bbox, std::vector<float>& mean, std::vector<float>& stddev) const;
+
+private:
+  void worldToPixel(double x, double y, double& i, double& j) const;
+  void rasterizeTriangle(const double* u, const double* v, std::vector<unsigned char>& mask, const int* bbox) const;
+
+  vtkImageData* mImage;
+  const float* mCube;
+  const unsigned char* mRgb;
+  int mWidth;
+  int mHeight;
+  int mBands;    // output bands
+  int mChannels; // channels stored per pixel
+  bool mIsRGB;
+  double mOrigin[3];
+  double mSpacing[3];
+  float mGammaLUT[256];
+};
+
+#endif // SPECTRALPROBE_H
@@ -0,0 +1,198 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <algorithm>
+
+#include <emmintrin.h>
+#include <omp.h>
+
+#include <vtkImageData.h>
+
+#include "spectralSimilarity.h"
+
+// four bands at a time
+static inline float dotProduct(const float* a, const float* b, int bands)
+{
+  __m128 acc = _mm_setzero_ps();
+  int c = 0;
+  for (; c + 4 <= bands; c += 4)
+    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + c), _mm_loadu_ps(b + c)));
+  float partial[4];
+  _mm_storeu_ps(partial, acc);
+  float sum = partial[0] + partial[1] + partial[2] + partial[3];
+  for (; c < bands; ++c)
+    sum += a[c] * b[c];
+  return sum;
+}
+
+// sum of (a - b)^2, accumulated directly: expanding it into norms and a dot product
+// cancels out for near-identical spectra, which are the matches that count
+static inline float squaredDistance(const float* a, const float* b, int bands)
+{
+  __m128 acc = _mm_setzero_ps();
+  int c = 0;
+  for (; c + 4 <= bands; c += 4)
+  {
+    __m128 d = _mm_sub_ps(_mm_loadu_ps(a + c), _mm_loadu_ps(b + c));
+    acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+  }
+  float partial[4];
+  _mm_storeu_ps(partial, acc);
+  float sum = partial[0] + partial[1] + partial[2] + partial[3];
+  for (; c < bands; ++c)
+    sum += (a[c] - b[c]) * (a[c] - b[c]);
+  return sum;
+}
+
+SpectralSimilarity::SpectralSimilarity()
+{
+  setImageData(NULL);
+}
+
+void SpectralSimilarity::setImageData(vtkImageData* hyperImage)
+{
+  mCube = NULL;
+  mWidth = mHeight = mBands = 0;
+  mNorms.clear();
+  mScores.clear();
+  mMaxScore = 0.f;
+  if (!hyperImage || hyperImage->GetScalarType() != VTK_FLOAT)
+    return;
+
+  int dims[3];
+  hyperImage->GetDimensions(dims);
+  if (dims[0] <= 0 || dims[1] <= 0 || hyperImage->GetNumberOfScalarComponents() <= 0)
+    return;
+  mCube = static_cast<const float*>(hyperImage->GetScalarPointer());
+  mWidth = dims[0];
+  mHeight = dims[1];
+  mBands = hyperImage->GetNumberOfScalarComponents();
+}
+
+void SpectralSimilarity::computeNorms()
+{
+  const int numPixels = mWidth * mHeight;
+  mNorms.resize(numPixels);
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    const float* x = mCube + (size_t)p * mBands;
+    mNorms[p] = std::sqrt(dotProduct(x, x, mBands));
+  }
+}
+
+bool SpectralSimilarity::setReference(const std::vector<float>& reference, SimilarityMetric metric)
+{
+  if (!mCube || (int)reference.size() != mBands)
+    return false;
+  if (metric == SPECTRALANGLE && mNorms.empty())
+    computeNorms();
+
+  const float* r = &reference[0];
+  const float rNorm = std::sqrt(dotProduct(r, r, mBands));
+  const int numPixels = mWidth * mHeight;
+  mScores.resize(numPixels);
+
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    const float* x = mCube + (size_t)p * mBands;
+    float score;
+    if (metric == SPECTRALANGLE)
+    {
+      float denom = mNorms[p] * rNorm;
+      float cosine = (denom > 0.f) ? dotProduct(x, r, mBands) / denom : 0.f;
+      score = std::acos(std::max(-1.f, std::min(1.f, cosine)));
+    }
+    else
+    {
+      score = std::sqrt(squaredDistance(x, r, mBands));
+    }
+    mScores[p] = score;
+  }
+
+  float maxScore = 0.f;
+  for (p = 0; p < numPixels; p++)
+    if (mScores[p] > maxScore) maxScore = mScores[p];
+  mMaxScore = maxScore;
+  return true;
+}
+
+void SpectralSimilarity::makeOverlay(float threshold, const unsigned char* rgba, vtkImageData* overlay) const
+{
+  if (!overlay || mScores.empty())
+    return;
+  overlay->SetDimensions(mWidth, mHeight, 1);
+  overlay->SetScalarTypeToUnsignedChar();
+  overlay->SetNumberOfScalarComponents(4);
+  overlay->AllocateScalars();
+  unsigned char* out = static_cast<unsigned char*>(overlay->GetScalarPointer());
+
+  const int numPixels = mWidth * mHeight;
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    bool match = mScores[p] <= threshold;
+    out[4 * p + 0] = rgba[0];
+    out[4 * p + 1] = rgba[1];
+    out[4 * p + 2] = rgba[2];
+    out[4 * p + 3] = match ? rgba[3] : 0;
+  }
+  overlay->Modified();
+}
+
+bool SpectralSimilarity::blendOverlay(float threshold, const unsigned char* rgba, vtkImageData* base, vtkImageData* output) const
+{
+  if (!base || !output || mScores.empty() || base->GetScalarType() != VTK_UNSIGNED_CHAR)
+    return false;
+  int dims[3];
+  base->GetDimensions(dims);
+  int channels = base->GetNumberOfScalarComponents();
+  if (dims[0] != mWidth || dims[1] != mHeight || channels < 3)
+    return false;
+
+  output->DeepCopy(base);
+  unsigned char* out = static_cast<unsigned char*>(output->GetScalarPointer());
+  const int alpha = rgba[3];
+  const int numPixels = mWidth * mHeight;
+  int p = 0;
+  omp_set_num_threads(omp_get_num_procs());
+  #pragma omp parallel for private(p) schedule(static)
+  for (p = 0; p < numPixels; p++)
+  {
+    if (mScores[p] > threshold)
+      continue;
+    unsigned char* pixel = out + (size_t)p * channels;
+    for (int k = 0; k < 3; k++)
+      pixel[k] = (unsigned char)((pixel[k] * (255 - alpha) + rgba[k] * alpha) / 255);
+  }
+  output->Modified();
+  return true;
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef SPECTRALSIMILARITY_H
+#define SPECTRALSIMILARITY_H
+
+#include <vector>
+#include "../vtkEnums.h"
+
+class vtkImageData;
+
+// Similarity of every spectrum in the band-interleaved cube to a reference spectrum
+// (spectral angle or Euclidean distance). Per-pixel norms for the angle are computed once
+// per cube, so a new reference costs one pass over the cube and a new threshold only a
+// compare. Distances are summed from the band differences, which stays exact for the
+// near-identical spectra that make the best matches.
+class SpectralSimilarity
+{
+public:
+  SpectralSimilarity();
+
+  void setImageData(vtkImageData* hyperImage);
+  bool isValid() const {return mCube != NULL;}
+  int getWidth() const {return mWidth;}
+  int getHeight() const {return mHeight;}
+
+  // scores all pixels against reference; angles are in radians
+  bool setReference(const std::vector<float>& reference, SimilarityMetric metric);
+  bool hasReference() const {return !mScores.empty();}
+  float getMaxScore() const {return mMaxScore;}
+
+  // RGBA image of the cube size: pixels scoring <= threshold get color/alpha, the rest are transparent
+  void makeOverlay(float threshold, const unsigned char* rgba, vtkImageData* overlay) const;
+  // the same mask alpha-blended into an RGB(A) image of the cube size (e.g. a 3D texture)
+  bool blendOverlay(float threshold, const unsigned char* rgba, vtkImageData* base, vtkImageData* output) const;
+
+private:
+  void computeNorms();
+
+  const float* mCube;
+  int mWidth;
+  int mHeight;
+  int mBands;
+  std::vector<float> mNorms;  // |x| of every spectrum
+  std::vector<float> mScores; // angle or distance to the reference
+  float mMaxScore;
+};
+
+#endif // SPECTRALSIMILARITY_H
@@ -24,7 +24,7 @@
 *****************************************************************************/
 #include "annotationFilterDialog.h"
 
-AnnotationFilterDialog::AnnotationFilterDialog(const QVector<QString> users)
+AnnotationFilterDialog::AnnotationFilterDialog(const QVector<QString> users, const QMap<QString, int> counts)
 {
 	mDialog = new QDialog();
 	mVbox = new QVBoxLayout();
@@ -36,11 +36,15 @@ AnnotationFilterDialog::AnnotationFilterDialog(const QVector<QString> users)
 	mTreeWidget = new QTreeWidget();
 	QStringList ColumnNames;
 	ColumnNames << "User Name";
+	if (!counts.isEmpty())
+		ColumnNames << "Notes";
 	mTreeWidget->setHeaderLabels(ColumnNames);
 	for (int i = 0; i < users.size(); i++)
 	{
 		QTreeWidgetItem *item = new QTreeWidgetItem();
 		item->setText(0, QString(users[i]));
+		if (!counts.isEmpty())
+			item->setText(1, QString::number(counts.value(users[i], 0)));
 		item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
 		item->setCheckState(0, Qt::Unchecked);
 		mItems.push_back(item);
@@ -53,9 +53,10 @@ public:
 	/**
 	 * @brief  Constructor with users' name list as input, so that different users'
 	 *         contribution can be filtered in report.
-	 * @param  users  All the users that appears in the notes.
+	 * @param  users   All the users that appears in the notes.
+	 * @param  counts  The number of notes of each user, shown next to the names if given.
 	 */
-	AnnotationFilterDialog(const QVector<QString> users);
+	AnnotationFilterDialog(const QVector<QString> users, const QMap<QString, int> counts = QMap<QString, int>());
 	
 	/**
 	 * @brief  Get selected users whoes contributions will be presented in the report.
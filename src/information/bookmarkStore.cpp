@@ -0,0 +1,405 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QTextStream>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include "bookmarkStore.h"
+#include "bookmarkWidget.h"
+
+#define BOOKMARK_JOURNAL_SUFFIX ".journal"
+#define BOOKMARK_TEMP_SUFFIX ".tmp"
+#define BOOKMARK_JOURNAL_ATTRIBUTE "journal"
+#define BOOKMARK_WRITE_DELAY 1000	// ms between the first change and the write
+
+QMap<QString, BookmarkStore*> BookmarkStore::stores;
+
+BookmarkStore* BookmarkStore::instance(const QString xmlPath)
+{
+    QString path = QDir::toNativeSeparators(QDir::cleanPath(xmlPath));
+    QMap<QString, BookmarkStore*>::iterator it = stores.find(path);
+    if(it == stores.end())
+        it = stores.insert(path, new BookmarkStore(path));
+    else {
+        BookmarkStore* store = it.value();
+        // only a store without unsaved changes can follow the file on disk
+        bool isSaved = store->mSequence == store->mSavedSequence
+            && !store->mTimer.isActive() && !store->mFuture.isRunning();
+        if(isSaved && store->isReplacedOnDisk())
+            store->reload();
+    }
+    return it.value();
+}
+
+void BookmarkStore::flushAll()
+{
+    foreach(BookmarkStore* store, stores)
+        store->flush();
+}
+
+BookmarkStore::BookmarkStore(const QString xmlPath)
+    : mPath(xmlPath), mIsValid(true), mIsReplaying(false), mFileSize(-1),
+      mSequence(0), mSavedSequence(0), mWriteSequence(0), mHasPending(false)
+{
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(BOOKMARK_WRITE_DELAY);
+    connect(&mTimer, SIGNAL(timeout()), this, SLOT(write()));
+    connect(&mWatcher, SIGNAL(finished()), this, SLOT(writeFinished()));
+    mJournal.setFileName(mPath + BOOKMARK_JOURNAL_SUFFIX);
+    read();
+    replayJournal();
+}
+
+void BookmarkStore::read()
+{
+    // the last write stopped between removing the old file and renaming the new one
+    QString temp = mPath + BOOKMARK_TEMP_SUFFIX;
+    if(!QFile::exists(mPath) && QFile::exists(temp))
+        QFile::rename(temp, mPath);
+
+    stamp();
+    QFile file(mPath);
+    if(!file.exists() || file.size() == 0) return;
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Open bookmark file" << mPath << "Failed";
+        mIsValid = false;
+        return;
+    }
+    mDocument.setContent(&file);
+    file.close();
+
+    QDomElement root = mDocument.documentElement();
+    if(root.tagName() != BOOKMARK_XML_ROOT) {
+        mIsValid = false;
+        return;
+    }
+    mRoot = root;
+    mSavedSequence = mRoot.attribute(BOOKMARK_JOURNAL_ATTRIBUTE).toUInt();
+    mSequence = mSavedSequence;
+    index(mRoot);
+}
+
+void BookmarkStore::reload()
+{
+    mDocument = QDomDocument();
+    mRoot = QDomElement();
+    mBookmarks.clear();
+    mFolders.clear();
+    mIsValid = true;
+    mSequence = mSavedSequence = mWriteSequence = 0;
+    read();
+    replayJournal();
+}
+
+void BookmarkStore::stamp()
+{
+    QFileInfo info(mPath);
+    mFileSize = info.exists() ? info.size() : -1;
+    mFileModified = info.exists() ? info.lastModified() : QDateTime();
+}
+
+bool BookmarkStore::isReplacedOnDisk() const
+{
+    QFileInfo info(mPath);
+    if(!info.exists()) return mFileSize != -1;
+    return info.size() != mFileSize || info.lastModified() != mFileModified;
+}
+
+void BookmarkStore::replayJournal()
+{
+    QFile file(mJournal.fileName());
+    if(!file.exists() || !file.open(QIODevice::ReadOnly)) return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    bool isChanged = false;
+    mIsReplaying = true;
+    while(!in.atEnd()) {
+        quint32 sequence;
+        quint8 op;
+        QString key, arg1, arg2;
+        in >> sequence >> op >> key >> arg1 >> arg2;
+        if(in.status() != QDataStream::Ok) break;	// the last entry was cut off
+        if(sequence <= mSavedSequence) continue;	// already in the file
+        if(!apply(op, key, arg1, arg2))
+            qDebug() << "Bookmark journal entry" << sequence << "of" << mPath << "cannot be applied";
+        mSequence = sequence;
+        isChanged = true;
+    }
+    mIsReplaying = false;
+    file.close();
+
+    if(isChanged) mTimer.start();
+    else truncateJournal();
+}
+
+bool BookmarkStore::apply(int op, const QString key, const QString arg1, const QString arg2)
+{
+    QDomElement elt = element(key);
+    switch(op)
+    {
+    case SET_ROOT:
+    {
+        if(!mRoot.isNull()) return false;
+        QDomElement root = fromXML(arg1);
+        if(root.isNull()) return false;
+        setRoot(root);
+        return true;
+    }
+    case SET_ATTRIBUTE:
+        if(elt.isNull()) return false;
+        setAttribute(elt, arg1, arg2);
+        return true;
+    case REMOVE_ATTRIBUTE:
+        if(elt.isNull()) return false;
+        removeAttribute(elt, arg1);
+        return true;
+    case APPEND:
+    {
+        QDomElement child = fromXML(arg1);
+        if(elt.isNull() || child.isNull()) return false;
+        append(elt, child);
+        return true;
+    }
+    case REMOVE:
+        if(elt.isNull() || elt == mRoot) return false;
+        remove(elt);
+        return true;
+    case MOVE:
+    {
+        QDomElement parent = element(arg1);
+        if(elt.isNull() || elt == mRoot || parent.isNull()) return false;
+        move(elt, parent, arg2.toInt());
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+QDomElement BookmarkStore::find(const QString uuid, int type) const
+{
+    if(type == BOOKMARK) return mBookmarks.value(uuid);
+    else if(type == FOLDER) return mFolders.value(uuid);
+    return QDomElement();
+}
+
+void BookmarkStore::setRoot(QDomElement root)
+{
+    if(!mRoot.isNull() || root.isNull()) return;
+    mDocument.appendChild(mDocument.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\""));
+    mDocument.appendChild(root);
+    mRoot = root;
+    mIsValid = true;
+    index(mRoot);
+    record(SET_ROOT, QString(), toXML(root));
+}
+
+void BookmarkStore::setAttribute(QDomElement elt, const QString name, const QString value)
+{
+    if(elt.isNull()) return;
+    elt.setAttribute(name, value);
+    record(SET_ATTRIBUTE, key(elt), name, value);
+}
+
+void BookmarkStore::removeAttribute(QDomElement elt, const QString name)
+{
+    if(elt.isNull() || !elt.hasAttribute(name)) return;
+    elt.removeAttribute(name);
+    record(REMOVE_ATTRIBUTE, key(elt), name);
+}
+
+void BookmarkStore::append(QDomElement parent, QDomElement child)
+{
+    if(parent.isNull() || child.isNull()) return;
+    parent.appendChild(child);
+    index(child);
+    record(APPEND, key(parent), toXML(child));
+}
+
+void BookmarkStore::remove(QDomElement elt)
+{
+    if(elt.isNull() || elt == mRoot) return;
+    QString k = key(elt);
+    unindex(elt);
+    elt.parentNode().removeChild(elt);
+    record(REMOVE, k);
+}
+
+void BookmarkStore::move(QDomElement elt, QDomElement parent, int index)
+{
+    if(elt.isNull() || parent.isNull() || elt == mRoot) return;
+    elt.parentNode().removeChild(elt);
+    QDomNodeList children = parent.childNodes();
+    if(index < 0 || index >= (int)children.length())
+        parent.appendChild(elt);
+    else
+        parent.insertBefore(elt, children.at(index));
+    record(MOVE, key(elt), key(parent), QString::number(index));
+}
+
+void BookmarkStore::record(int op, const QString key, const QString arg1, const QString arg2)
+{
+    if(mIsReplaying) return;
+    mSequence++;
+    if(!mJournal.isOpen() && !mJournal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Open bookmark journal" << mJournal.fileName() << "Failed";
+    } else {
+        QDataStream out(&mJournal);
+        out.setVersion(QDataStream::Qt_4_6);
+        out << mSequence << (quint8)op << key << arg1 << arg2;
+        mJournal.flush();
+    }
+    // the first change schedules the write, later ones ride along with it
+    if(!mTimer.isActive()) mTimer.start();
+}
+
+void BookmarkStore::truncateJournal()
+{
+    if(mJournal.isOpen()) mJournal.close();
+    if(mJournal.exists()) mJournal.remove();
+}
+
+QString BookmarkStore::key(const QDomElement& elt) const
+{
+    if(elt == mRoot) return QString();
+    return elt.attribute(UUID_NAME);
+}
+
+QDomElement BookmarkStore::element(const QString key) const
+{
+    if(key.isEmpty()) return mRoot;
+    QHash<QString, QDomElement>::const_iterator it = mFolders.find(key);
+    if(it != mFolders.end()) return it.value();
+    return mBookmarks.value(key);
+}
+
+void BookmarkStore::index(const QDomElement& elt)
+{
+    if(elt.tagName() == BOOKMARK_NAME) {
+        mBookmarks.insert(elt.attribute(UUID_NAME), elt);
+        return;
+    }
+    if(elt.tagName() == FOLDER_NAME)
+        mFolders.insert(elt.attribute(UUID_NAME), elt);
+    for(QDomElement child = elt.firstChildElement(); !child.isNull(); child = child.nextSiblingElement())
+        index(child);
+}
+
+void BookmarkStore::unindex(const QDomElement& elt)
+{
+    if(elt.tagName() == BOOKMARK_NAME) {
+        mBookmarks.remove(elt.attribute(UUID_NAME));
+        return;
+    }
+    if(elt.tagName() == FOLDER_NAME)
+        mFolders.remove(elt.attribute(UUID_NAME));
+    for(QDomElement child = elt.firstChildElement(); !child.isNull(); child = child.nextSiblingElement())
+        unindex(child);
+}
+
+QString BookmarkStore::toXML(const QDomElement& elt)
+{
+    QString xml;
+    QTextStream out(&xml);
+    elt.save(out, 0);
+    return xml;
+}
+
+QDomElement BookmarkStore::fromXML(const QString xml)
+{
+    QDomDocument fragment;
+    if(!fragment.setContent(xml)) return QDomElement();
+    return mDocument.importNode(fragment.documentElement(), true).toElement();
+}
+
+QByteArray BookmarkStore::snapshot()
+{
+    // not journaled: it only tells a later replay where the file stops
+    mRoot.setAttribute(BOOKMARK_JOURNAL_ATTRIBUTE, QString::number(mSequence));
+    return mDocument.toByteArray();
+}
+
+bool BookmarkStore::save(const QString path, const QByteArray data)
+{
+    QString temp = path + BOOKMARK_TEMP_SUFFIX;
+    QFile file(temp);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    if(file.write(data) != data.size()) {
+        file.close();
+        file.remove();
+        return false;
+    }
+    file.close();
+    // QFile::rename does not replace an existing file
+    if(QFile::exists(path) && !QFile::remove(path)) return false;
+    return QFile::rename(temp, path);
+}
+
+void BookmarkStore::write()
+{
+    if(mRoot.isNull() || mSequence == mSavedSequence) return;
+    if(mFuture.isRunning()) {
+        mHasPending = true;
+        return;
+    }
+    mWriteSequence = mSequence;
+    mFuture = QtConcurrent::run(&BookmarkStore::save, mPath, snapshot());
+    mWatcher.setFuture(mFuture);
+}
+
+void BookmarkStore::writeFinished()
+{
+    if(!mFuture.result()) {
+        qDebug() << "Write bookmark file" << mPath << "Failed";
+    } else if(mWriteSequence > mSavedSequence) {
+        stamp();
+        mSavedSequence = mWriteSequence;
+        if(mSavedSequence == mSequence) truncateJournal();
+    }
+    if(mHasPending) {
+        mHasPending = false;
+        write();
+    }
+}
+
+void BookmarkStore::flush()
+{
+    mTimer.stop();
+    mHasPending = false;
+    mFuture.waitForFinished();
+    if(mRoot.isNull() || mSequence == mSavedSequence) return;
+    if(!save(mPath, snapshot())) {
+        qDebug() << "Write bookmark file" << mPath << "Failed";
+        return;
+    }
+    stamp();
+    mSavedSequence = mSequence;
+    mWriteSequence = mSequence;
+    truncateJournal();
+}
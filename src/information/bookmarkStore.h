@@ -0,0 +1,173 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+
+#ifndef BOOKMARKSTORE_H
+#define BOOKMARKSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QMap>
+#include <QFile>
+#include <QDateTime>
+#include <QTimer>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QDomDocument>
+#include <QDomElement>
+
+/**
+ * This class keeps one parsed bookmarks.xml in memory, with the bookmarks and folders
+ * indexed by uuid. All changes go through it: each one is applied to the document and
+ * appended to a journal (bookmarks.xml.journal) right away, and the whole file is written
+ * by a background thread a moment later, so a burst of edits costs one write. The file is
+ * written to a temporary file first and then renamed over the old one. The root element
+ * records the last journal entry it contains, and entries after it are replayed when the
+ * file is opened again after a crash.
+ * The size and modification time of the file are recorded whenever it is read or written;
+ * if another copy replaces it (an imported project, a restored backup) while the store has
+ * nothing unsaved, the next instance() call reads it again.
+ * The store is only used from the GUI thread; the writer thread gets a serialized copy.
+ */
+class BookmarkStore : public QObject
+{
+  Q_OBJECT
+
+public:
+  /**
+   * @brief  Get the store of a bookmark file. It is read from disk on first use, and again
+   *         if the file was replaced on disk since while the store had no unsaved changes.
+   * @param  xmlPath  The full path of bookmarks.xml.
+   */
+  static BookmarkStore* instance(const QString xmlPath);
+
+  /**
+   * @brief  Write every store that has unsaved changes and wait for the writes.
+   */
+  static void flushAll();
+
+  QDomDocument& document() {return mDocument;}
+
+  /**
+   * @brief  The root element, null if the file is missing or empty.
+   */
+  QDomElement root() const {return mRoot;}
+
+  /**
+   * @brief  False if the file exists but is not a CHEROb bookmark file.
+   */
+  bool isValid() const {return mIsValid;}
+
+  /**
+   * @brief  Find a bookmark or folder.
+   * @param  uuid  The uuid attribute of the element.
+   * @param  type  BOOKMARK or FOLDER.
+   * @return A null element if it is not found.
+   */
+  QDomElement find(const QString uuid, int type) const;
+
+  QList<QDomElement> folders() const {return mFolders.values();}
+
+  /**
+   * @brief  Install the root element of a new bookmark file.
+   */
+  void setRoot(QDomElement root);
+
+  void setAttribute(QDomElement elt, const QString name, const QString value);
+  void removeAttribute(QDomElement elt, const QString name);
+
+  /**
+   * @brief  Append a new element (and its children) to the root or a folder.
+   */
+  void append(QDomElement parent, QDomElement child);
+
+  /**
+   * @brief  Remove a bookmark or folder from the document.
+   */
+  void remove(QDomElement elt);
+
+  /**
+   * @brief  Move a bookmark or folder under a new parent.
+   * @param  index  Position among the children of parent, or -1 to append.
+   */
+  void move(QDomElement elt, QDomElement parent, int index);
+
+  /**
+   * @brief  Write pending changes now and wait until they are on disk.
+   */
+  void flush();
+
+private slots:
+  void write();
+  void writeFinished();
+
+private:
+  enum Operation {SET_ROOT = 1, SET_ATTRIBUTE, REMOVE_ATTRIBUTE, APPEND, REMOVE, MOVE};
+
+  BookmarkStore(const QString xmlPath);
+
+  void read();
+  void reload();
+  void replayJournal();
+  // remember the size and modification time of the file as we last read or wrote it
+  void stamp();
+  bool isReplacedOnDisk() const;
+  bool apply(int op, const QString key, const QString arg1, const QString arg2);
+  void record(int op, const QString key, const QString arg1 = QString(), const QString arg2 = QString());
+  void truncateJournal();
+
+  QString key(const QDomElement& elt) const;
+  QDomElement element(const QString key) const;
+  void index(const QDomElement& elt);
+  void unindex(const QDomElement& elt);
+  static QString toXML(const QDomElement& elt);
+  QDomElement fromXML(const QString xml);
+  QByteArray snapshot();
+  static bool save(const QString path, const QByteArray data);
+
+  QString mPath;
+  QDomDocument mDocument;
+  QDomElement mRoot;
+  bool mIsValid;
+  bool mIsReplaying;
+  QHash<QString, QDomElement> mBookmarks;
+  QHash<QString, QDomElement> mFolders;
+
+  qint64 mFileSize;       // -1 if there was no file
+  QDateTime mFileModified;
+
+  QFile mJournal;
+  quint32 mSequence;      // of the latest change
+  quint32 mSavedSequence; // latest change that is in the file on disk
+  quint32 mWriteSequence; // latest change in the running write
+
+  QTimer mTimer;
+  QFuture<bool> mFuture;
+  QFutureWatcher<bool> mWatcher;
+  bool mHasPending;
+
+  static QMap<QString, BookmarkStore*> stores;
+};
+
+#endif // BOOKMARKSTORE_H
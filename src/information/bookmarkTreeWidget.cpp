@@ -37,6 +37,7 @@
 #include <QMessageBox>
 #include <QMouseEvent>
 
+#include "bookmarkStore.h"
 #include "bookmarkTreeWidget.h"
 #include "bookmarkWidget.h"
 #include "../mainWindow.h"
@@ -121,129 +122,38 @@ void BookmarkTreeWidget::dropEvent(QDropEvent* event)
 
     QTreeWidget::dropEvent(event);
 
-    QString filetype;
-    QIcon icon = item->icon(0);
-    if(icon.isNull()) {
-        filetype = "bookmark";
-    } else {
-        filetype = "folder";
-    }
-
-    QTreeWidgetItem* parent = item->parent();
-    QString parentText, parentFiletype;
-    if(parent) {
-        parentText = parent->text(0);
-        QIcon icon = parent->icon(0);
-        if(icon.isNull()) {
-            parentFiletype = "bookmark";
-        } else {
-            parentFiletype = "folder";
-        }
-    }
-
-    QFileInfo finfo(BookmarkWidget::mw()->VTKA()->mFilename);
-    QDir* dir = new QDir();
-    QString fn = QDir::toNativeSeparators(dir->relativeFilePath(finfo.absoluteFilePath()));
-	/*********** Modified by Weiqi Shi 1/19/2016*************/
-    QString path = BookmarkWidget::mw()->VTKA()->mProjectPath + QDir::separator() + finfo.fileName().replace(" ", "_")
-            + "_" + QString::number(qHash(fn)) + QDir::separator() + BOOKMARK_FN;
-	/*********** Modified by Weiqi Shi 1/19/2016*************/
-    QFile file(path);
-    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    BookmarkStore* store = BookmarkWidget::mw()->mBookmark->getBookmarkStore();
+    if(!store->isValid() || store->root().isNull()) {
         QMessageBox mb;
         mb.critical(this, tr("Bookmark Error"),
                     tr("The bookmark file for this object cannot be found."));
         return;
     }
 
-    QDomDocument doc;
-    doc.setContent(&file);
-    QDomNodeList rootList = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-    if(list.isEmpty()) {
-        QMessageBox mb;
-        mb.critical(this, tr("Bookmark Error"),
-                    tr("The bookmark file for this object is improperly structured because it lacks a root element."));
-        return;
-    }
-
-    QDomNode rootNode = rootList.at(0);
-    QDomElement root = rootNode.toElement();
-    QDomNodeList bmks = root.elementsByTagName(filetype);
-    QDomNode oldNode, newNode;
-    QDomElement elt;
-    QString value;
-    for(int i = 0; i < bmks.length(); i++) {
-        elt = bmks.at(i).toElement();
-        value = elt.attribute("title");
-        if(value == text) {
-            oldNode = bmks.at(i);
-            break;
-        }
-        value.clear();
-    }
-    if(value.isEmpty()) {
+    int type = item->data(TITLE_COLUMN, Qt::UserRole).toInt();
+    QDomElement elt = store->find(item->text(UUID_COLUMN), type);
+    if(elt.isNull()) {
+        BookmarkWidget::mw()->mBookmark->refreshBookmarkList();
         return;
     }
 
-    newNode = oldNode;
-    QDomNode oldParent = oldNode.parentNode();
-
-    QDomNode newParent;
+    QTreeWidgetItem* parent = item->parent();
+    QDomElement newParent = store->root();
+    int index = this->indexOfTopLevelItem(item);
     if(parent) {
-        bmks = root.elementsByTagName(parentFiletype);
-        for(int i = 0; i < bmks.length(); i++) {
-            elt = bmks.at(i).toElement();
-            value = elt.attribute("title");
-            if(value == parentText) {
-                newParent = bmks.at(i);
-                break;
-            }
-        }
-    }
-
-    oldParent.removeChild(oldNode);
-    if(!newParent.isNull()) {
-        int index = item->parent()->indexOfChild(item);
-        QDomNodeList children = newParent.childNodes();
-        int len = children.length();
-        if(index == len) {
-            newParent.appendChild(newNode);
-        } else {
-            newParent.insertBefore(newNode, children.at(index));
-        }
-    } else {
-        int index = this->indexOfTopLevelItem(item);
-        QDomNodeList children = rootNode.childNodes();
-        int len = children.length();
-        if(index == len) {
-            rootNode.appendChild(newNode);
-        } else {
-            rootNode.insertBefore(newNode, children.at(index));
-        }
+        newParent = store->find(parent->text(UUID_COLUMN), FOLDER);
+        index = parent->indexOfChild(item);
     }
+    if(!newParent.isNull())
+        store->move(elt, newParent, index);
 
-    QDomNodeList folders = root.elementsByTagName("folder");
-    for(int i = 0; i < folders.length(); i++) {
-        elt = folders.at(i).toElement();
-        value = elt.attribute("title");
-        QList<QTreeWidgetItem*> items = this->findItems(value, Qt::MatchExactly | Qt::MatchRecursive, 0);
-        QTreeWidgetItem* item = items.at(0);
-        if(!item) continue;
-        bool expanded = item->isExpanded();
-        elt.setAttribute("folded", expanded ? "no" : "yes");
-    }
-
-    QFile f(path);
-    if(!f.open(QFile::WriteOnly | QFile::Text)) {
-        QMessageBox mb;
-        mb.critical(this, tr("Bookmark Error"), tr("Failed to save changes."));
-        f.close();
-        return;
+    foreach(QDomElement folder, store->folders()) {
+        QList<QTreeWidgetItem*> items = this->findItems(folder.attribute(UUID_NAME), Qt::MatchExactly | Qt::MatchRecursive, UUID_COLUMN);
+        if(items.isEmpty()) continue;
+        QString folded = items.at(0)->isExpanded() ? "no" : "yes";
+        if(folder.attribute(FOLDED) != folded)
+            store->setAttribute(folder, FOLDED, folded);
     }
-    f.resize(0);
-    QTextStream out(&f);
-    out << doc.toString();
-    f.close();
 
     if(BookmarkWidget::mw()->mBookmark)
         BookmarkWidget::mw()->mBookmark->refreshBookmarkList();
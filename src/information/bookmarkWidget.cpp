@@ -30,6 +30,7 @@
 #include <QTreeWidgetItemIterator>
 
 #include "bookmark.h"
+#include "bookmarkStore.h"
 #include "bookmarkWidget.h"
 #include "bookmarkXMLReader.h"
 #include "../function/CTControl.h"
@@ -86,6 +87,7 @@ BookmarkWidget::~BookmarkWidget()
 {
     if(bTreeWidget)
         bTreeWidget->clear();
+    BookmarkStore::flushAll();
 }
 
 /*
@@ -170,63 +172,24 @@ void BookmarkWidget::showContextMenu(const QPoint &pos)
     }
 }
 
-QDomElement BookmarkWidget::findElementbyUUID(QDomDocument& doc, QString uuid, int type, const QString xmlPath)
+QDomElement BookmarkWidget::findElementbyUUID(QString uuid, int type, const QString xmlPath)
 {
-    QString path;
-	if (xmlPath == QString())
-		path = getBookmarkFilepath();
-	else
-		path = xmlPath;
-    QFile file(path);
-    if(!file.open(QIODevice::ReadWrite | QIODevice::Text)) {
-		qDebug()<<"File cannot be opened.";
-        showFileOpenError();
-        file.close();
-        return doc.createElement(QString());
-    }
-
-    doc.setContent(&file);
-    QDomNodeList list = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-    if(list.isEmpty()) {
+    BookmarkStore* store = getBookmarkStore(xmlPath);
+    if(!store->isValid() || store->root().isNull()) {
         showInvalidFileError();
-        file.close();
-        return doc.createElement(QString());
-    }
-
-    QDomElement root = list.at(0).toElement();
-    QDomNodeList nodes;
-    if(type == BOOKMARK) nodes = root.elementsByTagName(BOOKMARK_NAME);
-    else if(type == FOLDER) nodes = root.elementsByTagName(FOLDER_NAME);
-
-    QDomElement elt;
-    QString value;
-    for(int i = 0; i < nodes.length(); i++) {
-        elt = nodes.at(i).toElement();
-        value = elt.attribute(UUID_NAME);
-		
-        if(value == uuid) break;
-        value.clear();
+        return QDomElement();
     }
-	file.close();
-    if(!value.isEmpty()) return elt;
-    else return doc.createElement(QString());
+    return store->find(uuid, type);
 }
 
-void BookmarkWidget::saveDOMToFile(QDomDocument& doc, const QString xmlPath)
+/*
+ * Returns the in-memory bookmark file of the current object, or of xmlPath.
+ */
+BookmarkStore* BookmarkWidget::getBookmarkStore(const QString xmlPath)
 {
-	QString path;
-	if (xmlPath == QString())
-		path = getBookmarkFilepath();
-	else
-		path = xmlPath;
-    QFile file(path);
-    if(!file.open(QIODevice::WriteOnly)) {
-        showFileOpenError();
-        return;
-    }
-    QTextStream out(&file);
-    out << doc.toString();
-    file.close();
+    if(xmlPath == QString())
+        return BookmarkStore::instance(getBookmarkFilepath());
+    return BookmarkStore::instance(xmlPath);
 }
 
 void BookmarkWidget::displayItemInfo(QTreeWidgetItem* item)
@@ -241,8 +204,7 @@ void BookmarkWidget::displayItemInfo(QTreeWidgetItem* item)
     int type = item->data(TITLE_COLUMN, Qt::UserRole).toInt();
     QString uuid = item->text(UUID_COLUMN);
 
-    QDomDocument doc;
-    QDomElement elt = findElementbyUUID(doc, uuid, type);
+    QDomElement elt = findElementbyUUID(uuid, type);
 
     if(elt.isNull()) return;
 
@@ -407,6 +369,7 @@ void BookmarkWidget::deletePermanetly(const QString path)
 		deleteItemPermanently(objectPath, item);
         ++it;
     }
+    BookmarkStore::instance(objectPath)->flush();
 }
 
 void BookmarkWidget::undoRemoveBookmark(QTreeWidgetItem* item)
@@ -420,12 +383,10 @@ void BookmarkWidget::undoRemoveBookmark(QTreeWidgetItem* item)
 	item->setText(TITLE_COLUMN, caption);
 	item->setText(3, QString::number(1));
 
-	QDomDocument doc;
 	qDebug()<<"in undo"<<path;
-    QDomElement elt = findElementbyUUID(doc, uuid, BOOKMARK, path);
+    QDomElement elt = findElementbyUUID(uuid, BOOKMARK, path);
 	if(elt.isNull() || elt.attribute("isHidden") != QString("True")) return;
-    elt.removeAttribute("isHidden");
-    saveDOMToFile(doc, path);
+    getBookmarkStore(path)->removeAttribute(elt, "isHidden");
 	refreshBookmarkList();
 }
 
@@ -467,36 +428,21 @@ void BookmarkWidget::saveFolderState(QTreeWidgetItem* item)
 {
     if(!item || !mw()->VTKA() ) return;
 
-    QString path = getBookmarkFilepath();
-    QFile f(path);
-    if(!f.open(QIODevice::ReadWrite | QIODevice::Text)) {
-        showFileOpenError();
-        return;
-    }
-
-    QDomDocument doc;
-    doc.setContent(&f);
-    QDomNodeList list = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-    if(list.isEmpty()) {
+    BookmarkStore* store = getBookmarkStore();
+    if(!store->isValid() || store->root().isNull()) {
         showInvalidFileError();
         return;
     }
 
-    QDomElement root = list.at(0).toElement();
-    QString dt = QDateTime::currentDateTimeUtc().toString();
-    root.setAttribute(DATE_ACCESSED, dt);
-
-    QDomNodeList folders = root.elementsByTagName(FOLDER_NAME);
-    for(int i = 0; i < folders.length(); i++) {
-        QDomElement elt = folders.at(i).toElement();
-        QString value = elt.attribute(TITLE);
-        if(value == item->text(0)) {
-            elt.setAttribute(FOLDED, item->isExpanded() ? "no" : "yes");
-            elt.setAttribute(DATE_ACCESSED, dt);
-        }
-    }
+    // the list expands its folders again on every refresh, only real changes are saved
+    QDomElement elt = store->find(item->text(UUID_COLUMN), FOLDER);
+    QString folded = item->isExpanded() ? "no" : "yes";
+    if(elt.isNull() || elt.attribute(FOLDED) == folded) return;
 
-    saveDOMToFile(doc);
+    QString dt = QDateTime::currentDateTimeUtc().toString();
+    store->setAttribute(store->root(), DATE_ACCESSED, dt);
+    store->setAttribute(elt, FOLDED, folded);
+    store->setAttribute(elt, DATE_ACCESSED, dt);
 }
 
 void BookmarkWidget::refreshBookmarkList()
@@ -521,12 +467,9 @@ void BookmarkWidget::refreshBookmarkList()
     reader.readXML();
 }
 
-void BookmarkWidget::buildDOMDocument(QDomDocument& doc, QDomElement& root)
+void BookmarkWidget::buildDOMDocument(BookmarkStore* store)
 {
-    QDomProcessingInstruction instruct = doc.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\"");
-    doc.appendChild(instruct);
-
-    root = doc.createElement(BOOKMARK_XML_ROOT);
+    QDomElement root = store->document().createElement(BOOKMARK_XML_ROOT);
 
     QDir* dir = new QDir();
     QFileInfo finfo(bfn);
@@ -538,7 +481,7 @@ void BookmarkWidget::buildDOMDocument(QDomDocument& doc, QDomElement& root)
     root.setAttribute(DATE_CREATED, dt);
     root.setAttribute(DATE_MODIFIED, dt);
     root.setAttribute(DATE_ACCESSED, dt);
-    doc.appendChild(root);
+    store->setRoot(root);
 }
 
 bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
@@ -581,42 +524,19 @@ bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
 		path.append(QDir::separator() + QString("BookMark"));
 		path = path + QDir::separator() + BOOKMARK_FN;
 	}
-    QFile file(path);
-    if(!file.open(QIODevice::ReadWrite | QIODevice::Text))
-	{
-        showFileOpenError();
-        file.close();
-        return false;
-    }
-    QDomDocument doc;
-    doc.setContent(&file);
-    QDomNodeList list = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-    if(list.isEmpty())
+    BookmarkStore* store = BookmarkStore::instance(path);
+    if(!store->isValid() || store->root().isNull())
 	{
         showInvalidFileError();
-        file.close();
         return false;
     }
-    QDomElement root = list.at(0).toElement();
-    QDomNodeList bmks = root.elementsByTagName(BOOKMARK_NAME);
-    QDomElement elt;
-    QString value;
-    for(int i = 0; i < bmks.length(); i++)
-	{
-        elt = bmks.at(i).toElement();
-        value = elt.attribute(UUID_NAME);
-        if(value == uuid)
-		{
-            break;
-        }
-        value.clear();
-    }
-    if(value.isEmpty())
+    QDomNodeList list;
+    QDomElement elt = store->find(uuid, BOOKMARK);
+    if(elt.isNull())
 	{
         QMessageBox mb;
         mb.critical(this, tr("Bookmark Error"),
                     tr("The bookmark with the provided caption cannot be found."));
-        file.close();
         return false;
     }
 
@@ -625,7 +545,6 @@ bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
         QMessageBox mb;
         mb.critical(this, tr("Bookmark Error"),
                     tr("This bookmark cannot be loaded because it corresponds to an unrecognized file type."));
-        file.close();
         return false;
     } else {
         filetype = list.at(0).toElement().text().toInt();
@@ -633,14 +552,12 @@ bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
             QMessageBox mb;
             mb.critical(this, tr("Bookmark Error"),
                         tr("This bookmark cannot be loaded because it corresponds to an unrecognized file type."));
-            file.close();
             return false;
         } else if(filetype != mode && !(filetype == CTSTACK && mode == CTVOLUME)
                   && !(filetype == CTVOLUME && mode == CTSTACK)) {
             QMessageBox mb;
             mb.critical(this, tr("Bookmark Error"),
                         tr("This bookmark cannot be loaded because it corresponds to a file type different from the current file. Please switch to the correct object window."));
-            file.close();
             return false;
         }
     }
@@ -1057,7 +974,6 @@ bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
         QMessageBox mb;
         mb.critical(this, tr("Bookmark Error"),
                     tr("This bookmark cannot be loaded because it corresponds to an unrecognized file type."));
-        file.close();
         return false;
     }
 
@@ -1065,8 +981,7 @@ bool BookmarkWidget::viewBookmark(QTreeWidgetItem* item, QString objectPath)
     if (mw()->VTKA()->mQVTKWidget) mw()->VTKA()->mQVTKWidget->update();
 
     QString dt = QDateTime::currentDateTimeUtc().toString();
-    elt.setAttribute(DATE_ACCESSED, dt);
-    saveDOMToFile(doc);
+    store->setAttribute(elt, DATE_ACCESSED, dt);
     return true;
 }
 
@@ -1075,30 +990,12 @@ void BookmarkWidget::createFolder()
     if(!mw()->VTKA() ) return;
     bool ok = true;
 
-    QString path = getBookmarkFilepath();
-    QFile bf(path);
-    if(!bf.open(QFile::ReadWrite | QFile::Text)) {
-        showFileOpenError();
-        bf.close();
+    BookmarkStore* store = getBookmarkStore();
+    if(!store->isValid()) {
+        showInvalidFileError();
         return;
     }
 
-    QDomDocument doc;
-    QDomElement root;
-    QDomNodeList list;
-    if(bf.size() == 0) {
-        buildDOMDocument(doc, root);
-    } else {
-        qDebug() << bf.size();
-        doc.setContent(&bf);
-        list = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-        if(list.isEmpty()) {
-            showInvalidFileError();
-            return;
-        }
-        root = list.at(0).toElement();
-    }
-
     QInputDialog* titleBox = new QInputDialog(this);
     QString title;
     do
@@ -1109,7 +1006,8 @@ void BookmarkWidget::createFolder()
 
     if(!ok) return;
 
-    QDomElement fldr = doc.createElement(FOLDER_NAME);
+    if(store->root().isNull()) buildDOMDocument(store);
+    QDomElement fldr = store->document().createElement(FOLDER_NAME);
     fldr.setAttribute(TITLE, title);
     QString dt = QDateTime::currentDateTimeUtc().toString();
     fldr.setAttribute(DATE_CREATED, dt);
@@ -1117,9 +1015,8 @@ void BookmarkWidget::createFolder()
     fldr.setAttribute(DATE_ACCESSED, dt);
     fldr.setAttribute(UUID_NAME, QUuid::createUuid());
     fldr.setAttribute(FOLDED, "yes");
-    root.appendChild(fldr);
+    store->append(store->root(), fldr);
 
-    saveDOMToFile(doc);
     refreshBookmarkList();
 }
 
@@ -1128,30 +1025,12 @@ void BookmarkWidget::createBookmark()
 {
     if(!mw()->VTKA() ) return;
 
-    QString path = getBookmarkFilepath();
-    QFile bf(path);
-    if(!bf.open(QFile::ReadWrite | QFile::Text)) {
-        showFileOpenError();
-        bf.close();
+    BookmarkStore* store = getBookmarkStore();
+    if(!store->isValid()) {
+        showInvalidFileError();
         return;
     }
 
-    QDomDocument doc;
-    QDomElement root;
-    QDomNodeList list;
-
-    if(bf.size() == 0) {
-        buildDOMDocument(doc, root);
-    } else {   
-        doc.setContent(&bf);
-        list = doc.elementsByTagName(BOOKMARK_XML_ROOT);
-        if(list.isEmpty()) {
-            showInvalidFileError();
-            return;
-        }
-        root = list.at(0).toElement();
-    }
-
     QInputDialog* captionBox = new QInputDialog(this);
     QString caption;
     bool ok = true;
@@ -1163,11 +1042,11 @@ void BookmarkWidget::createBookmark()
 
     if(!ok) return;
 
+    if(store->root().isNull()) buildDOMDocument(store);
 	QUuid uuid = QUuid::createUuid();
-    createBookmarkSubclass(caption, doc, root, uuid);
+    createBookmarkSubclass(caption, store, uuid);
 
-    root.setAttribute(DATE_MODIFIED, QDateTime::currentDateTimeUtc().toString());
-    saveDOMToFile(doc);
+    store->setAttribute(store->root(), DATE_MODIFIED, QDateTime::currentDateTimeUtc().toString());
     if(mw()->VTKA()->mQVTKWidget) mw()->VTKA()->mQVTKWidget->update();
     refreshBookmarkList();
 	QString bookmarkFolder = mw()->VTKA()->mProjectPath;
@@ -1175,8 +1054,10 @@ void BookmarkWidget::createBookmark()
 	emit addNavigationItem(bookmarkFolder, caption, uuid.toString());
 }
 
-void BookmarkWidget::createBookmarkSubclass(QString caption, QDomDocument& doc, QDomElement& root, QUuid uuid)
+void BookmarkWidget::createBookmarkSubclass(QString caption, BookmarkStore* store, QUuid uuid)
 {
+    QDomDocument& doc = store->document();
+    QDomElement root = store->root();
     vtkSmartPointer<vtkAssembly> assembly = mw()->mLightControl->GetAssembly();
 
 	vcg::Point3f light = mw()->mLightControlRTI->getLight(); /*!< Light vector. */
@@ -1186,14 +1067,14 @@ void BookmarkWidget::createBookmarkSubclass(QString caption, QDomDocument& doc,
     case IMAGE2D:
     {
         BookmarkIMAGE2D bmk(caption, uuid, doc, camera, mode, interpOn);
-        root.appendChild(bmk.getBookmark());
+        store->append(root, bmk.getBookmark());
         break;
     }
 
 	case RTI2D:
     {
 		BookmarkRTI2D bmk(caption, uuid, doc, camera, mode, interpOn, light, renderModeRTI, renderingMode);
-        root.appendChild(bmk.getBookmark());
+        store->append(root, bmk.getBookmark());
 
         return;
     }
@@ -1203,7 +1084,7 @@ void BookmarkWidget::createBookmarkSubclass(QString caption, QDomDocument& doc,
         BookmarkMODEL3D bmk(caption, uuid, doc, camera, mode, interpOn, dirLightOn, assembly,
                             mw()->mLightControl->GetIntensityL1(), mw()->mLightControl->GetIntensityL2(),
                             renderMode, textureOn, tfn);
-        root.appendChild(bmk.getBookmark());
+        store->append(root, bmk.getBookmark());
         break;
     }
 
@@ -1211,14 +1092,14 @@ void BookmarkWidget::createBookmarkSubclass(QString caption, QDomDocument& doc,
     {
         BookmarkCTSTACK bmk(caption, uuid, doc, camera, mode, interpOn, mw()->mLightControl->GetIntensityL1(),
                             mw()->mLightControl->GetIntensityL2(), slice, orientation);
-        root.appendChild(bmk.getBookmark());
+        store->append(root, bmk.getBookmark());
         break;
     }
 
     case CTVOLUME:
     {
         BookmarkCTVOLUME bmk(caption, uuid, doc, camera, mode, assembly, vRenderMode, blend, resolution);
-        root.appendChild(bmk.getBookmark());
+        store->append(root, bmk.getBookmark());
         break;
     }
 
@@ -1261,15 +1142,14 @@ void BookmarkWidget::editItem(QTreeWidgetItem* item)
 
     if(!ok) return;
 
-    QDomDocument doc;
-    QDomElement elt = findElementbyUUID(doc, uuid, type);
+    QDomElement elt = findElementbyUUID(uuid, type);
     if(elt.isNull()) return;
-    elt.setAttribute(TITLE, title);
-    elt.setAttribute(DATE_MODIFIED, QDateTime::currentDateTimeUtc().toString());
+    BookmarkStore* store = getBookmarkStore();
+    store->setAttribute(elt, TITLE, title);
+    store->setAttribute(elt, DATE_MODIFIED, QDateTime::currentDateTimeUtc().toString());
 	QString bookmarkFolder = mw()->VTKA()->mProjectPath;
 	bookmarkFolder.append(QDir::separator() + QString("BookMark"));
 	emit editNavigationItem(bookmarkFolder, title, uuid);
-    saveDOMToFile(doc);
     refreshBookmarkList();
 }
 
@@ -1288,11 +1168,9 @@ void BookmarkWidget::deleteItem(QTreeWidgetItem* item)
 	//if(verifyDelete(caption, type) == QMessageBox::Cancel) return;
 	
 	item->setHidden(true);
-	QDomDocument doc;
-    QDomElement elt = findElementbyUUID(doc, uuid, type);
+    QDomElement elt = findElementbyUUID(uuid, type);
     if(elt.isNull()) return;
-    elt.setAttribute("isHidden", QString("True"));
-    saveDOMToFile(doc);
+    getBookmarkStore()->setAttribute(elt, "isHidden", QString("True"));
 
 	QString bookmarkFolder = mw()->VTKA()->mProjectPath;
 	bookmarkFolder.append(QDir::separator() + QString("BookMark"));
@@ -1310,8 +1188,7 @@ void BookmarkWidget::deleteItemPermanently(const QString xmlPath, QTreeWidgetIte
     // DT: don't move this!
     QString uuid = item->text(UUID_COLUMN);
 
-    QDomDocument doc;
-    QDomElement elt = findElementbyUUID(doc, uuid, BOOKMARK, xmlPath);
+    QDomElement elt = findElementbyUUID(uuid, BOOKMARK, xmlPath);
 
     QList<QTreeWidgetItem *> items = bTreeWidget->findItems(uuid, Qt::MatchExactly, UUID_COLUMN);
     item = items.at(0);
@@ -1319,9 +1196,7 @@ void BookmarkWidget::deleteItemPermanently(const QString xmlPath, QTreeWidgetIte
 
     if(elt.isNull()) return;
 
-    QDomNode parent = elt.parentNode();
-    parent.removeChild(elt);
-    saveDOMToFile(doc, xmlPath);
+    getBookmarkStore(xmlPath)->remove(elt);
     //refreshBookmarkList();
 }
 
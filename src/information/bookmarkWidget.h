@@ -77,6 +77,7 @@ static const QString FILENAME = "filename";
 enum BWContextMenu{ADD_FOLDER=1,ADD_BOOKMARK,EDIT_ITEM,DELETE_ITEM,GET_INFO};
 
 class MainWindow;
+class BookmarkStore;
 
 /**
  * This class provides the bookmarktreewidget function in main frame.
@@ -100,6 +101,8 @@ public:
 
   void undoRemoveBookmark(QTreeWidgetItem* item);
 
+  BookmarkStore* getBookmarkStore(const QString xmlPath = QString());
+
 public slots:
   void createBookmark();
   bool viewBookmark(QTreeWidgetItem* item, QString objectPath = QString());
@@ -114,13 +117,12 @@ private slots:
   void showContextMenu(const QPoint &pos);
 
 private:
-  void buildDOMDocument(QDomDocument& doc, QDomElement& root);
-  void createBookmarkSubclass(QString caption, QDomDocument& doc, QDomElement& root, QUuid uuid);
+  void buildDOMDocument(BookmarkStore* store);
+  void createBookmarkSubclass(QString caption, BookmarkStore* store, QUuid uuid);
   void displayItemInfo(QTreeWidgetItem* item);
-  QDomElement findElementbyUUID(QDomDocument& doc, QString uuid, int type, const QString xmlPath = QString());
+  QDomElement findElementbyUUID(QString uuid, int type, const QString xmlPath = QString());
   QString getBookmarkFilepath();
   void keyPressEvent(QKeyEvent* event);
-  void saveDOMToFile(QDomDocument& doc, const QString xmlPath = QString());
   void setupInfoDialogUI(const QDomElement& elt);
   int verifyDelete(const QString caption, int type);
 
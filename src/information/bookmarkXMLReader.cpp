@@ -72,6 +72,7 @@
 #include <QFile>
 #include <QMessageBox>
 
+#include "bookmarkStore.h"
 #include "bookmarkXMLReader.h"
 #include "../mainWindow.h"
 
@@ -97,85 +98,67 @@ QTreeWidgetItem* BookmarkXMLReader::createChildItem(QTreeWidgetItem *item)
     return childItem;
 }
 
-void BookmarkXMLReader::readFolder(QTreeWidgetItem *item)
+void BookmarkXMLReader::readFolder(const QDomElement& elt, QTreeWidgetItem *item)
 {
-    Q_ASSERT(xml.isStartElement() && xml.name() == "folder");
+    Q_ASSERT(elt.tagName() == "folder");
 
     QTreeWidgetItem* folder = createChildItem(item);
     folder->setData(TITLE_COLUMN, Qt::UserRole, FOLDER);
     QFileIconProvider provider;
     folder->setIcon(0, provider.icon(QFileIconProvider::Folder));
-    folder->setText(TITLE_COLUMN, xml.attributes().value("title").toString());
-    folder->setText(UUID_COLUMN, xml.attributes().value("uuid").toString());
-    folder->setText(DATE_CREATED_COLUMN, xml.attributes().value("created").toString());
-    folder->setText(DATE_MODIFIED_COLUMN, xml.attributes().value("modified").toString());
-    bool folded = (xml.attributes().value("folded") != "no");
+    folder->setText(TITLE_COLUMN, elt.attribute("title"));
+    folder->setText(UUID_COLUMN, elt.attribute("uuid"));
+    folder->setText(DATE_CREATED_COLUMN, elt.attribute("created"));
+    folder->setText(DATE_MODIFIED_COLUMN, elt.attribute("modified"));
+    bool folded = (elt.attribute("folded") != "no");
     btw->setItemExpanded(folder, !folded);
 
-    while (xml.readNextStartElement()) {
-        if (xml.name() == "folder")
-            readFolder(folder);
-        else if (xml.name() == "bookmark")
-            readBookmark(folder);
-        else
-            xml.skipCurrentElement();
+    for (QDomElement child = elt.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+        if (child.tagName() == "folder")
+            readFolder(child, folder);
+        else if (child.tagName() == "bookmark")
+            readBookmark(child, folder);
     }
 }
 
 /*
  * Reads a single bookmark and creates a QTreeWidgetItem to represent it.
  */
-void BookmarkXMLReader::readBookmark(QTreeWidgetItem *item)
+void BookmarkXMLReader::readBookmark(const QDomElement& elt, QTreeWidgetItem *item)
 {
-    Q_ASSERT(xml.isStartElement() && xml.name() == "bookmark");
+    Q_ASSERT(elt.tagName() == "bookmark");
 
     QTreeWidgetItem *bookmark = createChildItem(item);
     bookmark->setData(TITLE_COLUMN, Qt::UserRole, BOOKMARK);
     bookmark->setFlags(bookmark->flags() ^ (Qt::ItemIsDropEnabled));
-    bookmark->setText(TITLE_COLUMN, xml.attributes().value("title").toString());
-    bookmark->setText(UUID_COLUMN, xml.attributes().value("uuid").toString());
-    bookmark->setText(DATE_CREATED_COLUMN, xml.attributes().value("created").toString());
-    bookmark->setText(DATE_MODIFIED_COLUMN, xml.attributes().value("modified").toString());
+    bookmark->setText(TITLE_COLUMN, elt.attribute("title"));
+    bookmark->setText(UUID_COLUMN, elt.attribute("uuid"));
+    bookmark->setText(DATE_CREATED_COLUMN, elt.attribute("created"));
+    bookmark->setText(DATE_MODIFIED_COLUMN, elt.attribute("modified"));
 
-	if (xml.attributes().value("isHidden").toString() == QString("True"))	// this bookmark is temporarily removed.
+	if (elt.attribute("isHidden") == QString("True"))	// this bookmark is temporarily removed.
 	{
 		bookmark->setHidden(true);
 	}
-
-    while (xml.readNextStartElement()) {
-        xml.skipCurrentElement();
-    }
 }
 
 
 void BookmarkXMLReader::readXML()
 {
-    QFile f(fn);
-    if(!f.exists()) return;
-    if(!f.open(QIODevice::ReadOnly | QIODevice::Text))
-	{
-		f.close();
-		return;
-	}
-    xml.setDevice(&f);
-    if(xml.readNextStartElement()) {
-        if(xml.name() != BOOKMARK_XML_ROOT) {
-            QMessageBox mb;
-            mb.critical(btw, QObject::tr("Bookmark Error"),
-                        QObject::tr("Invalid CHEROb bookmark file."));
-            return;
-        }
-    } else return;
-
-    Q_ASSERT(xml.isStartElement());
-
-    while (xml.readNextStartElement()) {
-        if (xml.name() == "folder")
-            readFolder(0);
-        else if (xml.name() == "bookmark")
-            readBookmark(0);
-        else
-            xml.skipCurrentElement();
+    BookmarkStore* store = BookmarkStore::instance(fn);
+    if(!store->isValid()) {
+        QMessageBox mb;
+        mb.critical(btw, QObject::tr("Bookmark Error"),
+                    QObject::tr("Invalid CHEROb bookmark file."));
+        return;
+    }
+    QDomElement root = store->root();
+    if(root.isNull()) return;
+
+    for (QDomElement child = root.firstChildElement(); !child.isNull(); child = child.nextSiblingElement()) {
+        if (child.tagName() == "folder")
+            readFolder(child, 0);
+        else if (child.tagName() == "bookmark")
+            readBookmark(child, 0);
     }
 }
-
@@ -37,18 +37,17 @@ public:
   ~BookmarkXMLReader();
 
   /**
-	* @brief  Reads entire XML file and displays it within our BookmarkTreeWidget.
+	* @brief  Reads entire XML file (from its BookmarkStore) and displays it within our BookmarkTreeWidget.
 	*/
   void readXML();
 
 private:
   QTreeWidgetItem* createChildItem(QTreeWidgetItem* item);
-  void readFolder(QTreeWidgetItem* item);
-  void readBookmark(QTreeWidgetItem* item);
+  void readFolder(const QDomElement& elt, QTreeWidgetItem* item);
+  void readBookmark(const QDomElement& elt, QTreeWidgetItem* item);
 
   BookmarkTreeWidget* btw;
   QString fn;
-  QXmlStreamReader xml;
 };
 
 #endif // BOOKMARKXMLREADER_H
@@ -0,0 +1,259 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include "cellIdCodec.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <vtkAbstractArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkVariant.h>
+
+#define CELL_ID_MAGIC "CHID"
+#define CELL_ID_VERSION 2	// 1 checked the payload only
+#define CELL_ID_HEADER_SIZE 18	// magic, version, flags, count, payload size, crc
+#define CELL_ID_CRC_OFFSET 14	// the crc covers the header fields before it and the payload
+#define CELL_ID_RUNS 0x01	// payload holds (gap, length) runs instead of single deltas
+#define CELL_ID_MARKER "Binary: "
+
+// crc continues a previous checksum, so that separate blocks can be covered by one crc
+static quint32 crc32(const char* data, int size, quint32 crc = 0)
+{
+	static quint32 table[256];
+	static bool isTableReady = false;
+	if (!isTableReady)
+	{
+		for (quint32 i = 0; i < 256; i++)
+		{
+			quint32 c = i;
+			for (int k = 0; k < 8; k++)
+				c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+		isTableReady = true;
+	}
+	crc ^= 0xFFFFFFFF;
+	for (int i = 0; i < size; i++)
+		crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+	return crc ^ 0xFFFFFFFF;
+}
+
+static void putUInt32(QByteArray& out, quint32 value)
+{
+	for (int i = 0; i < 4; i++)
+		out.append(static_cast<char>((value >> (8*i)) & 0xFF));
+}
+
+static quint32 getUInt32(const char* data)
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<quint32>(p[3]) << 24);
+}
+
+static void putVarint(QByteArray& out, quint64 value)
+{
+	while (value >= 0x80)
+	{
+		out.append(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.append(static_cast<char>(value));
+}
+
+static bool getVarint(const unsigned char*& p, const unsigned char* end, quint64& value)
+{
+	value = 0;
+	for (int shift = 0; p < end && shift < 64; shift += 7)
+	{
+		unsigned char byte = *p++;
+		value |= static_cast<quint64>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+QByteArray CellIdCodec::encode(vtkAbstractArray* ids)
+{
+	std::vector<vtkIdType> sorted;
+	vtkIdTypeArray* idArray = vtkIdTypeArray::SafeDownCast(ids);
+	vtkIdType num = ids ? ids->GetNumberOfTuples() * ids->GetNumberOfComponents() : 0;
+	sorted.resize(num);
+	for (vtkIdType i = 0; i < num; i++)
+		sorted[i] = idArray ? idArray->GetValue(i) : ids->GetVariantValue(i).ToTypeInt64();
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+	sorted.erase(sorted.begin(), std::lower_bound(sorted.begin(), sorted.end(), 0));
+
+	int runs = 0;
+	for (size_t i = 0; i < sorted.size(); i++)
+		if (i == 0 || sorted[i] != sorted[i-1] + 1)
+			runs++;
+	// a run costs two varints, a single id one
+	unsigned char flags = 2 * runs < static_cast<int>(sorted.size()) ? CELL_ID_RUNS : 0;
+
+	QByteArray payload;
+	payload.reserve(static_cast<int>(flags & CELL_ID_RUNS ? 2 * runs : sorted.size()) + 16);
+	vtkIdType previous = -1;
+	if (flags & CELL_ID_RUNS)
+	{
+		size_t i = 0;
+		while (i < sorted.size())
+		{
+			size_t j = i + 1;
+			while (j < sorted.size() && sorted[j] == sorted[j-1] + 1)
+				j++;
+			putVarint(payload, sorted[i] - previous - 1);
+			putVarint(payload, j - i - 1);
+			previous = sorted[j-1];
+			i = j;
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i < sorted.size(); i++)
+		{
+			putVarint(payload, sorted[i] - previous - 1);
+			previous = sorted[i];
+		}
+	}
+
+	QByteArray out;
+	out.reserve(CELL_ID_HEADER_SIZE + payload.size());
+	out.append(CELL_ID_MAGIC, 4);
+	out.append(static_cast<char>(CELL_ID_VERSION));
+	out.append(static_cast<char>(flags));
+	putUInt32(out, static_cast<quint32>(sorted.size()));
+	putUInt32(out, static_cast<quint32>(payload.size()));
+	putUInt32(out, crc32(payload.constData(), payload.size(), crc32(out.constData(), CELL_ID_CRC_OFFSET)));
+	out.append(payload);
+	return out;
+}
+
+bool CellIdCodec::decode(const QByteArray& data, vtkIdTypeArray* ids)
+{
+	if (data.size() < CELL_ID_HEADER_SIZE || !data.startsWith(CELL_ID_MAGIC))
+		return false;
+	const char* header = data.constData();
+	if (header[4] != CELL_ID_VERSION)
+		return false;
+	unsigned char flags = static_cast<unsigned char>(header[5]);
+	quint32 count = getUInt32(header + 6);
+	quint32 payloadSize = getUInt32(header + 10);
+	if (payloadSize != static_cast<quint32>(data.size() - CELL_ID_HEADER_SIZE))
+		return false;
+	// the count is checked too before it sizes the array
+	if (crc32(header + CELL_ID_HEADER_SIZE, payloadSize, crc32(header, CELL_ID_CRC_OFFSET)) != getUInt32(header + CELL_ID_CRC_OFFSET))
+		return false;
+	// every single id takes at least one byte, only runs can be shorter than the ids they hold
+	if (!(flags & CELL_ID_RUNS) && count > payloadSize)
+		return false;
+
+	ids->SetNumberOfComponents(1);
+	ids->SetNumberOfValues(count);
+	vtkIdType* out = ids->GetPointer(0);
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(header + CELL_ID_HEADER_SIZE);
+	const unsigned char* end = p + payloadSize;
+	vtkIdType previous = -1;
+	quint32 n = 0;
+	quint64 gap, length;
+	while (n < count)
+	{
+		if (!getVarint(p, end, gap))
+			return false;
+		length = 0;
+		if ((flags & CELL_ID_RUNS) && !getVarint(p, end, length))
+			return false;
+		if (length >= count - n)
+			return false;
+		vtkIdType id = previous + 1 + static_cast<vtkIdType>(gap);
+		for (quint64 k = 0; k <= length; k++)
+			out[n++] = id++;
+		previous = id - 1;
+	}
+	return p == end;
+}
+
+bool CellIdCodec::write(const QString fileName, vtkAbstractArray* ids)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+	QByteArray data = encode(ids);
+	bool isWritten = file.write(data) == data.size();
+	file.close();
+	return isWritten;
+}
+
+bool CellIdCodec::read(const QString fileName, vtkIdTypeArray* ids)
+{
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	QByteArray data = file.readAll();
+	file.close();
+	return decode(data, ids);
+}
+
+QString CellIdCodec::idFileName(const QString noteFileName)
+{
+	QFileInfo info(noteFileName);
+	return QDir::toNativeSeparators(info.dir().absoluteFilePath(info.completeBaseName() + QString(".ids")));
+}
+
+QString CellIdCodec::marker(const QString idFile)
+{
+	return QString(CELL_ID_MARKER) + QFileInfo(idFile).fileName();
+}
+
+bool CellIdCodec::readNoteIds(QTextStream& in, const QString noteDir, vtkIdTypeArray* ids)
+{
+	QString line = in.readLine();
+	if (line.startsWith(CELL_ID_MARKER))
+		return read(QDir(noteDir).absoluteFilePath(line.mid(QString(CELL_ID_MARKER).size()).trimmed()), ids);
+
+	// legacy note: ids separated by spaces on one line
+	QByteArray text = line.toLatin1();
+	const char* p = text.constData();
+	const char* end = p + text.size();
+	ids->SetNumberOfComponents(1);
+	ids->Reset();
+	while (p < end)
+	{
+		while (p < end && (*p < '0' || *p > '9'))
+			p++;
+		if (p == end)
+			break;
+		vtkIdType id = 0;
+		while (p < end && *p >= '0' && *p <= '9')
+			id = 10 * id + (*p++ - '0');
+		ids->InsertNextValue(id);
+	}
+	return true;
+}
@@ -0,0 +1,84 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef CELL_ID_CODEC_H
+#define CELL_ID_CODEC_H
+
+#include <QString>
+#include <QByteArray>
+
+class QTextStream;
+class vtkAbstractArray;
+class vtkIdTypeArray;
+
+/**
+ * This class stores the cell ids of a 3D surface note in a binary file next to the note file.
+ * The ids are sorted and written as variable-length deltas; when the selection is made of long
+ * runs of consecutive ids, runs (gap, length) are written instead. A CRC-32 of the header and
+ * the payload is checked on reading, and the whole file is read in one go.
+ * Note files written before this format keep the ids as decimal text after "Polygon Ids:".
+ */
+class CellIdCodec
+{
+public:
+	/**
+	 * @brief  Encode a list of cell ids. The order and duplicates are not kept.
+	 * @param  ids  The selected cell ids.
+	 * @return The encoded bytes, header included.
+	 */
+	static QByteArray encode(vtkAbstractArray* ids);
+
+	/**
+	 * @brief  Decode the bytes produced by encode().
+	 * @param  data  The encoded bytes.
+	 * @param  ids   Receives the sorted cell ids.
+	 * @return false if the data is truncated, of an unknown version or fails the checksum.
+	 */
+	static bool decode(const QByteArray& data, vtkIdTypeArray* ids);
+
+	static bool write(const QString fileName, vtkAbstractArray* ids);
+	static bool read(const QString fileName, vtkIdTypeArray* ids);
+
+	/**
+	 * @brief  Name of the binary id file that belongs to a note file (SurfaceNote_x.txt -> SurfaceNote_x.ids).
+	 */
+	static QString idFileName(const QString noteFileName);
+
+	/**
+	 * @brief  The line written after "Polygon Ids:" in a note file whose ids are in idFile.
+	 */
+	static QString marker(const QString idFile);
+
+	/**
+	 * @brief  Read the ids that follow the "Polygon Ids:" line of a note file.
+	 *         Either the line names the binary id file (looked up in noteDir), or it is
+	 *         the legacy list of decimal ids.
+	 * @param  in       The note stream, positioned after "Polygon Ids:".
+	 * @param  noteDir  The directory of the note file.
+	 * @param  ids      Receives the cell ids.
+	 * @return false if the binary file is missing or broken.
+	 */
+	static bool readNoteIds(QTextStream& in, const QString noteDir, vtkIdTypeArray* ids);
+};
+
+#endif // CELL_ID_CODEC_H
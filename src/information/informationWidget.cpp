@@ -27,6 +27,8 @@
 #include <QMouseEvent>
 
 #include "informationWidget.h"
+#include "noteRegistry.h"
+#include "noteIndex.h"
 #include "../mainWindow.h"
 
 DTextEdit::DTextEdit(QWidget *parent)
@@ -230,6 +232,7 @@ void Information::init(const QString path, bool isDisplayNoteMark)
 	loadPointNote2D(objectPath, true, isDisplayNoteMark);
 	loadSurfaceNote2D(objectPath, true, isDisplayNoteMark);
 	loadPolygonNote2D(objectPath, true, isDisplayNoteMark);
+	NoteRegistry::instance(notePath)->flush();
 	//// TO BE TESTED
 	loadAnnotation(notePath);
 }
@@ -246,6 +249,7 @@ void Information::initCT2DRendering(const QString path, bool isDisplayNoteMark)
 	loadPointNote(objectPath, false);
 	loadSurfaceNote(objectPath, false);
 	loadFrustumNote(objectPath, false);
+	NoteRegistry::instance(notePath)->flush();
 	loadAnnotation(notePath);
 }
 
@@ -261,6 +265,7 @@ void Information::initCTVolumeRendering(const QString path, bool isDisplayNoteMa
 	loadPointNote(objectPath, true, isDisplayNoteMark);
 	loadSurfaceNote(objectPath, true, isDisplayNoteMark);
 	loadFrustumNote(objectPath, true, isDisplayNoteMark);
+	NoteRegistry::instance(notePath)->flush();
 	loadAnnotation(notePath);
 }
 
@@ -2636,6 +2641,37 @@ QVector<int> Information::getNoteNumber(const QString objectPath)
 	return notes;
 }
 
+template <class T>
+static void appendRemovedNotes(const QMap<QString, QVector<T*> >& notes, const QString& path, QVector<bool>& removed)
+{
+	typename QMap<QString, QVector<T*> >::const_iterator it = notes.find(path);
+	if (it == notes.end())
+		return;
+	for (int i = 0; i < it.value().size(); i++)
+		removed.push_back(it.value()[i]->checkRemoved());
+}
+
+QVector<bool> Information::getRemovedNotes(const QString objectPath)
+{
+	QString path = objectPath;
+	path = QDir::toNativeSeparators(path);
+	path.append(QDir::separator() + QString("Note"));
+	QVector<bool> removed;
+	if (content.find(path) == content.end())
+		return removed;
+	// the annotation always takes the first flag so that the note flags start at 1
+	QString fileName = path;
+	fileName.append(QDir::separator() + QString("Annotation.txt"));
+	removed.push_back(content[path].first != QString() && removedAnnotation.contains(fileName) && !QFile::exists(fileName));
+	appendRemovedNotes(mPointNotes, path, removed);
+	appendRemovedNotes(mSurfaceNotes, path, removed);
+	appendRemovedNotes(mFrustumNotes, path, removed);
+	appendRemovedNotes(mPointNotes2D, path, removed);
+	appendRemovedNotes(mSurfaceNotes2D, path, removed);
+	appendRemovedNotes(mPolygonNotes2D, path, removed);
+	return removed;
+}
+
 QVector<QString> Information::getAllUsers()
 {
 	QVector<QString> mUsers;
@@ -2688,6 +2724,13 @@ QVector<QString> Information::getAllUsers()
 	return mUsers;
 }
 
+QMap<QString, int> Information::getUserNoteCounts()
+{
+	if (!updateCurrentPath())
+		return QMap<QString, int>();
+	return NoteIndex::instance(notePath)->facets().users;
+}
+
 MainWindow* Information::mw()
 {
   foreach (QWidget *widget, QApplication::topLevelWidgets()) {
@@ -345,11 +345,25 @@ public:
 	 */
 	QVector<int> getNoteNumber(const QString objectPath);	
 
+	/**
+	 * @brief  Get the removed state of every note of an object for navigation.
+	 * @param  objectPath  Object full path.
+	 * @return One flag for the annotation (false when there is none), then one per note
+	 *         in the order of getNoteNumber; true if the note is removed.
+	 */
+	QVector<bool> getRemovedNotes(const QString objectPath);
+
 	/**
 	 * @brief  Get all users that appear in the notes.
 	 * @return The vector of all users.
 	 */
 	QVector<QString> getAllUsers();
+
+	/**
+	 * @brief  Get the number of saved notes of each user in the current object, from the note index.
+	 * @return The map of user names to note numbers.
+	 */
+	QMap<QString, int> getUserNoteCounts();
 	
 	/**
 	 * Added by Ying to copy annotations
@@ -30,6 +30,9 @@
 #include <time.h> 
 #include "../mainWindow.h"
 #include "../vtkEnums.h"
+#include "cellIdCodec.h"
+#include "noteRegistry.h"
+#include "noteIndex.h"
 #include <sstream>
 
 Note::Note(const int noteId, const ColorType type)
@@ -67,11 +70,13 @@ Note::Note(const int noteId, const ColorType type)
 	mDialog->adjustSize();
 	isSaved = false;
 	isRemoved = false;
+	mContentOffset = -1;
 	mDialog->hide();
 }
 
 QString Note::getContent()
 {
+	loadContent();
 	QString content(*mInfo + "\n" + mTextEdit->toPlainText());
 	content.append("\nLinked Images:\n");
 	for (int i = 0; i < mImageNotes.size(); i++)
@@ -100,6 +105,7 @@ void Note::save()
 {
 	if (isRemoved || isSaved)
 		return;
+	loadContent();
     if (!mFile->open(QIODevice::WriteOnly | QIODevice::Text))
 	{
 		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
@@ -128,6 +134,65 @@ void Note::save()
 	}
 	mFile->close();
 	isSaved = true;
+	NoteRegistry* registry = NoteRegistry::instance(*mPath);
+	registry->update(*mFileName);
+	registry->flush();
+	NoteIndex* index = NoteIndex::instance(*mPath);
+	index->update(*mFileName);
+	index->flush();
+}
+
+bool Note::readHeader(QString& header)
+{
+	NoteRegistry::Entry entry;
+	if (!NoteRegistry::instance(*mPath)->lookup(*mFileName, entry))
+		return false;
+	header = entry.header;
+	mContentOffset = entry.contentOffset;
+	return true;
+}
+
+void Note::showNote()
+{
+	loadContent();
+	mDialog->show();
+}
+
+void Note::loadContent()
+{
+	if (mContentOffset < 0)
+		return;
+	qint64 offset = mContentOffset;
+	mContentOffset = -1;
+	if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed";
+		return;
+	}
+	mFile->seek(offset);
+	QTextStream in(mFile);
+	QString content = in.readAll();
+	mFile->close();
+
+	bool saved = isSaved;
+	QStringList parts = content.split("\nLinked Images:\n");
+	QString text = parts[0];
+	QStringList imagePathList;
+	if (parts.size() > 1)
+		imagePathList = parts[1].split("\n");
+	QDir dir(*mPath);
+	for (int i = 0; i < imagePathList.size(); i++)
+	{
+		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
+		if (!finfo.exists())
+			continue;
+		QString extension = finfo.suffix().toLower();
+		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
+			continue;
+		addImage(finfo.absoluteFilePath());
+	}
+	this->setText(text);
+	isSaved = saved;
 }
 
 void Note::clearLayout(QLayout* layout, bool deleteWidgets)
@@ -230,9 +295,20 @@ void Note::replaceUserName(const QString newName, const QString oldName)
 	updateLabel();
 }
 
-void Note::remove()
+void Note::removeFiles()
 {
 	mFile->remove();
+	NoteRegistry* registry = NoteRegistry::instance(*mPath);
+	registry->remove(*mFileName);
+	registry->flush();
+	NoteIndex* index = NoteIndex::instance(*mPath);
+	index->remove(*mFileName);
+	index->flush();
+}
+
+void Note::remove()
+{
+	removeFiles();
 	mDialog->hide();
 	isRemoved = true;
 	emit removeNote(mNoteId, mPath);
@@ -324,13 +400,14 @@ PointNote::PointNote(QString path, QString fileName, const int noteId, bool& isS
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-    QTextStream in(mFile);
+    QTextStream in(&header);
     QString firstLine = in.readLine();
 	if (firstLine.split(" ").size() != 9)
 	{
@@ -383,34 +460,6 @@ PointNote::PointNote(QString path, QString fileName, const int noteId, bool& isS
 	QString colorType;
 	in >> colorType;
 	mColor = str2colortype(colorType.toStdString());
-    while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		//qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 	for (int i = 0; i < 3; i++)
 	{
 		mPosition[i] = pos[i];
@@ -443,7 +492,7 @@ PointNote::PointNote(QString path, QString fileName, const int noteId, bool& isS
 
 void PointNote::removePointNote()
 {
-	mFile->remove();
+	removeFiles();
 	this->hideNote(); 
 }
 
@@ -480,7 +529,12 @@ SurfaceNote::SurfaceNote(QString path, vtkSmartPointer<vtkSelectionNode> cellIds
 	mFile = new QFile(*mFileName);
 
 	if (!isCTVolume)
+	{
 		mCellIds->DeepCopy(cellIds);
+		mIdFileName = CellIdCodec::idFileName(*mFileName);
+		if (!CellIdCodec::write(mIdFileName, mCellIds->GetSelectionList()))
+			qDebug() << "Write cell id file " << mIdFileName << " Failed";
+	}
 	for (int i = 0; i < points.size(); i++)
 	{
 		double* point = new double[3];
@@ -504,16 +558,7 @@ SurfaceNote::SurfaceNote(QString path, vtkSmartPointer<vtkSelectionNode> cellIds
 	}
 	info.append(QString("Polygon Ids:\n"));
 	if (!isCTVolume)
-	{
-		for (int i = 0; i < mCellIds->GetSelectionList()->GetSize(); i++)
-		{
-			info.append(QString::number(mCellIds->GetSelectionList()->GetVariantValue(i).ToInt()));
-			if (i != mCellIds->GetSelectionList()->GetSize() - 1)
-				info.append(QString(' '));
-			else
-				info.append(QString("\n"));
-		}
-	}
+		info.append(CellIdCodec::marker(mIdFileName) + QString("\n"));
 	QString userLabel= QString("User: ");
 	QString userInfo;
 	for (int i = 0; i < mUsers.size(); i++)
@@ -547,14 +592,14 @@ SurfaceNote::SurfaceNote(QString path, QString fileName, const int noteId, bool&
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-	
-    QTextStream in(mFile);
+    QTextStream in(&header);
     QString firstLine = in.readLine();
 	if (firstLine.split(" ").size() != 9)
 	{
@@ -616,12 +661,18 @@ SurfaceNote::SurfaceNote(QString path, QString fileName, const int noteId, bool&
 		isSucceed = false;
 		return;
 	}
-	ids->Resize(cellNum);
-	for (int i = 0; i < cellNum; i++)
+	if (cellNum > 0)
 	{
-		int cellId;
-		in >> cellId;
-		ids->InsertNextValue(cellId);
+		mIdFileName = CellIdCodec::idFileName(*mFileName);
+		if (!CellIdCodec::readNoteIds(in, path, ids))
+		{
+			qDebug() << "Read cell id file " << mIdFileName << " Failed";
+			isSucceed = false;
+			return;
+		}
+		// notes from older versions list the ids as text; keep them in the binary file from now on
+		if (!QFile::exists(mIdFileName))
+			CellIdCodec::write(mIdFileName, ids);
 	}
 	mCellIds->SetSelectionList(ids);
 
@@ -656,35 +707,6 @@ SurfaceNote::SurfaceNote(QString path, QString fileName, const int noteId, bool&
 	in >> colorType;
 
 	mColor = str2colortype(colorType.toStdString());
-	while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 
 	QString label;
 	label.append(QString("Surface Note: Number of Selected Polygon ( ") + QString::number(cellNum) + QString(" )"));
@@ -694,16 +716,9 @@ SurfaceNote::SurfaceNote(QString path, QString fileName, const int noteId, bool&
 	{
 		info = info + "(" + QString::number(mPoints[i][0]) + ", " + QString::number(mPoints[0][1]) + ", " + QString::number(mPoints[0][2]) + ")\n";
 	}
-	info.append(QString("\nPolygon Ids:\n"));
-
-	for (int i = 0; i < cellNum; i++)
-	{
-		info.append(QString::number(mCellIds->GetSelectionList()->GetVariantValue(i).ToInt()));
-		if (i != mCellIds->GetSelectionList()->GetSize() - 1)
-			info.append(QString(' '));
-		else
-			info.append(QString("\n"));
-	}
+	info.append(QString("Polygon Ids:\n"));
+	if (cellNum > 0)
+		info.append(CellIdCodec::marker(mIdFileName) + QString("\n"));
 
 	QString userLabel= QString("User: ");
 	QString userInfo;
@@ -733,9 +748,16 @@ SurfaceNote::~SurfaceNote()
 	}
 }
 
+void SurfaceNote::removeFiles()
+{
+	Note::removeFiles();
+	if (!mIdFileName.isEmpty())
+		QFile::remove(mIdFileName);
+}
+
 void SurfaceNote::removeSurfaceNote()
 {
-	mFile->remove();
+	removeFiles();
 	this->hideNote(); 
 }
 
@@ -815,14 +837,14 @@ FrustumNote::FrustumNote(QString path, QString fileName, const int noteId, bool&
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-	
-    QTextStream in(mFile);
+    QTextStream in(&header);
     in.readLine();
 	for (int i = 0; i < 6; i++)
 	{
@@ -919,35 +941,6 @@ FrustumNote::FrustumNote(QString path, QString fileName, const int noteId, bool&
 	in >> colorType;
 
 	mColor = str2colortype(colorType.toStdString());
-	while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 
 	QString label;
 	label.append(QString("Frustum Note: Origin Point of Each Plane:\n"));
@@ -987,7 +980,7 @@ FrustumNote::FrustumNote(QString path, QString fileName, const int noteId, bool&
 
 void FrustumNote::removeFrustumNote()
 {
-	mFile->remove();
+	removeFiles();
 	this->hideNote(); 
 }
 
@@ -1059,14 +1052,14 @@ PointNote2D::PointNote2D(QString path, QString fileName, const int noteId, bool&
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-	
-    QTextStream in(mFile);
+    QTextStream in(&header);
     QString firstLine = in.readLine();
 	if (firstLine.split(" ").size() != 10)
 	{
@@ -1137,35 +1130,6 @@ PointNote2D::PointNote2D(QString path, QString fileName, const int noteId, bool&
 	in >> colorType;
 
 	mColor = str2colortype(colorType.toStdString());
-	while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 
 	QString label;
 	label.append(QString("Point Note: Center (") + QString::number(mPoint[0]) + QString(", ") + QString::number(mPoint[1]) + QString(")"));
@@ -1196,7 +1160,7 @@ PointNote2D::PointNote2D(QString path, QString fileName, const int noteId, bool&
 void PointNote2D::removePointNote2D()
 {
 	qDebug() << "Remove Point Note 2D" << mFile->fileName();
-	mFile->remove();
+	removeFiles();
 	this->hideNote(); 
 }
 
@@ -1270,14 +1234,14 @@ SurfaceNote2D::SurfaceNote2D(QString path, QString fileName, const int noteId, b
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-	
-    QTextStream in(mFile);
+    QTextStream in(&header);
     QString firstLine = in.readLine();
 	if (firstLine.split(" ").size() != 16)
 	{
@@ -1348,35 +1312,6 @@ SurfaceNote2D::SurfaceNote2D(QString path, QString fileName, const int noteId, b
 	in >> colorType;
 
 	mColor = str2colortype(colorType.toStdString());
-	while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 
 	QString label;
 	label.append(QString("Surface Note: Start (") + QString::number(mPoint[0]) + QString(", ") + QString::number(mPoint[1]) + QString(") End (") 
@@ -1410,7 +1345,7 @@ SurfaceNote2D::SurfaceNote2D(QString path, QString fileName, const int noteId, b
 void SurfaceNote2D::removeSurfaceNote2D()
 {
 	qDebug() << "Remove Surface Note 2D" << mFile->fileName();
-	mFile->remove();
+	removeFiles();
 	this->hideNote();
 }
 
@@ -1502,14 +1437,14 @@ PolygonNote2D::PolygonNote2D(QString path, QString fileName, const int noteId, b
 
 	qDebug(mFileName->toLatin1());
 	mFile = new QFile(*mFileName);
-    if (!mFile->open(QIODevice::ReadOnly | QIODevice::Text))
+	QString header;
+	if (!readHeader(header))
 	{
-		qDebug() << "Open Note file " << this->mNoteId << " " << mFileName << " Failed"; 
+		qDebug() << "Read Note file " << this->mNoteId << " " << mFileName << " Failed"; 
 		isSucceed = false;
 		return;
 	}
-
-    QTextStream in(mFile);
+    QTextStream in(&header);
     QString firstLine = in.readLine();
 	bool okSize;
 	int polygonSize = firstLine.split(" ")[4].toInt(&okSize);
@@ -1578,35 +1513,6 @@ PolygonNote2D::PolygonNote2D(QString path, QString fileName, const int noteId, b
 	in >> colorType;
 
 	mColor = str2colortype(colorType.toStdString());
-	while(!in.atEnd())
-	{
-		QString signal = in.readLine();
-		if (signal == QString("Note Start:"))
-			break;
-	}
-	if (in.atEnd())
-	{
-		isSucceed = false;
-		return;
-	}
-
-	QString content = in.readAll();
-	QString text = content.split("\nLinked Images:\n")[0];
-	QString imagePaths = content.split("\nLinked Images:\n")[1];
-	QStringList imagePathList = imagePaths.split("\n");
-	QDir dir(*mPath);
-	for (int i = 0; i < imagePathList.size(); i++)
-	{
-		qDebug()<<"Image Path"<<imagePathList[i];
-		QFileInfo finfo(dir.absoluteFilePath(imagePathList[i]));
-		if (!finfo.exists())
-			continue;
-		QString extension = finfo.suffix().toLower();
-		if (extension != tr("png") && extension != tr("jpg") && extension != tr("jpeg") && extension != tr("tif") && extension != tr("bmp"))
-			continue;
-		addImage(finfo.absoluteFilePath());
-	}
-	this->setText(text);
 
 	QString label;
 	label.append(QString("Polygon Note: World Coordinate ") + QString::number(mPolygon->size()));
@@ -1653,7 +1559,7 @@ PolygonNote2D::PolygonNote2D(QString path, QString fileName, const int noteId, b
 void PolygonNote2D::removePolygonNote2D()
 {
 	qDebug() << "Remove Polygon Note 2D" << mFile->fileName();
-	mFile->remove();
+	removeFiles();
 	this->hideNote();
 	//// TO BE TESTED
 }
\ No newline at end of file
@@ -86,9 +86,14 @@ public:
 	void hideNote() {mDialog->hide();}
 
 	/**
-	 * @brief  Show the Note dialog.
+	 * @brief  Show the Note dialog. The note text and linked images are loaded first if needed.
 	 */
-	void showNote() {mDialog->show();}
+	void showNote();
+
+	/**
+	 * @brief  Load the note text and linked images, which a note read from file leaves on disk until needed.
+	 */
+	void loadContent();
 
 	/**
 	 * @brief  Each note is saved as a .txt file. Get the note file.
@@ -152,6 +157,18 @@ protected:
 	 */
 	void setText(QString content){mTextEdit->setPlainText(content);}
 
+	/**
+	 * @brief  Delete the note file, and any file kept along with it, from disk.
+	 */
+	virtual void removeFiles();
+
+	/**
+	 * @brief  Get the note header (everything before the note text) from the note registry.
+	 * @param  header  Receives the header.
+	 * @return false if the note file cannot be read.
+	 */
+	bool readHeader(QString& header);
+
 public slots:
 
 	/**
@@ -251,6 +268,7 @@ private:
 	QLabel* mLabel;
 	QString* mInfo;
 	bool isSaved;
+	qint64 mContentOffset;	// where the note text starts in the note file, -1 once loaded
 	bool isRemoved;	// prepare for undo for the future
 };
 
@@ -368,8 +386,12 @@ public:
 	 */
 	bool checkCTVolume() {return isCTVolume;}
 
+protected:
+	void removeFiles();
+
 private:
 	vtkSmartPointer<vtkSelectionNode> mCellIds;
+	QString mIdFileName; // binary cell id file next to the note file, see CellIdCodec
 	QVector<double*> mPoints; // The four corner points that define the selected area. All points are in world coordinates with 3 elements (x, y, z)
 	bool isCTVolume; // If the surface note is appiled to CT Volume. If it is then mCellIds should be NULL.
 };
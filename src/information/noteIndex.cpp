@@ -0,0 +1,481 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include "noteIndex.h"
+#include "noteRegistry.h"
+#include "../vtkEnums.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QTextStream>
+#include <QSet>
+#include <QMutexLocker>
+#include <QDebug>
+
+#define NOTE_INDEX_FILE "NoteIndex.dat"
+#define NOTE_INDEX_MAGIC 0x43484e58	// "CHNX"
+#define NOTE_INDEX_VERSION 1
+
+// file scope rather than function statics: the search worker may ask for an index
+// first, and function statics are not initialized thread-safely before C++11
+static QMap<QString, NoteIndex*> indexes;
+static QMutex indexesMutex;
+
+NoteIndex* NoteIndex::instance(const QString notePath)
+{
+	QMutexLocker locker(&indexesMutex);
+	QString path = QDir::toNativeSeparators(QDir::cleanPath(notePath));
+	QMap<QString, NoteIndex*>::iterator it = indexes.find(path);
+	if (it == indexes.end())
+		it = indexes.insert(path, new NoteIndex(path));
+	return it.value();
+}
+
+NoteIndex::NoteIndex(const QString notePath)
+	: mMutex(QMutex::Recursive)
+{
+	mPath = notePath;
+	mIndexFile = QDir(mPath).absoluteFilePath(NOTE_INDEX_FILE);
+	mPostingsOffset = 0;
+	hasPostings = true;
+	isDirty = false;
+	read();
+}
+
+static void addCount(QMap<QString, int>& counts, const QString key, int delta)
+{
+	int& count = counts[key];
+	count += delta;
+	if (count <= 0)
+		counts.remove(key);
+}
+
+void NoteIndex::Facets::add(const Facets& other)
+{
+	total += other.total;
+	for (QMap<QString, int>::const_iterator it = other.types.constBegin(); it != other.types.constEnd(); ++it)
+		addCount(types, it.key(), it.value());
+	for (QMap<QString, int>::const_iterator it = other.colors.constBegin(); it != other.colors.constEnd(); ++it)
+		addCount(colors, it.key(), it.value());
+	for (QMap<QString, int>::const_iterator it = other.users.constBegin(); it != other.users.constEnd(); ++it)
+		addCount(users, it.key(), it.value());
+	for (QMap<QString, int>::const_iterator it = other.months.constBegin(); it != other.months.constEnd(); ++it)
+		addCount(months, it.key(), it.value());
+}
+
+int NoteIndex::Facets::categoryCount(int category) const
+{
+	return colors.value(QString(colortype2str(ColorType(category)).c_str()), 0);
+}
+
+void NoteIndex::count(const Document& doc, int delta)
+{
+	if (doc.type == QString("Annotation"))
+		return;
+	mFacets.total += delta;
+	addCount(mFacets.types, doc.type, delta);
+	addCount(mFacets.colors, doc.color, delta);
+	for (int i = 0; i < doc.users.size(); i++)
+		addCount(mFacets.users, doc.users[i], delta);
+	addCount(mFacets.months, QDateTime::fromTime_t(doc.modified).toString("yyyy-MM"), delta);
+}
+
+NoteIndex::Facets NoteIndex::facets()
+{
+	refresh();
+	QMutexLocker locker(&mMutex);
+	flush();
+	return mFacets;
+}
+
+NoteIndex::Facets NoteIndex::collect(const QStringList notePaths)
+{
+	Facets facets;
+	for (int i = 0; i < notePaths.size(); i++)
+		facets.add(instance(notePaths[i])->facets());
+	return facets;
+}
+
+// Words are runs of letters and digits, folded to lower case like the case-insensitive search.
+QStringList NoteIndex::tokenize(const QString& text)
+{
+	QStringList terms;
+	QString term;
+	for (int i = 0; i < text.size(); i++)
+	{
+		QChar c = text[i];
+		if (c.isLetterOrNumber())
+		{
+			term.append(c.toLower());
+		}
+		else if (!term.isEmpty())
+		{
+			terms.append(term);
+			term.clear();
+		}
+	}
+	if (!term.isEmpty())
+		terms.append(term);
+	return terms;
+}
+
+bool NoteIndex::find(const QString text, QStringList& fileNames, const QString type, const QString color, const QString user, const QAtomicInt* stop)
+{
+	fileNames.clear();
+	refresh(stop); // takes the lock file by file
+	QMutexLocker locker(&mMutex);
+	loadPostings();
+	flush();
+
+	const QString special("\\^$.|?*+()[]{}");
+	bool isIndexed = true;
+	for (int i = 0; i < text.size() && isIndexed; i++)
+	{
+		if (special.contains(text[i]))
+			isIndexed = false;
+	}
+	QStringList words = tokenize(text);
+	if (words.isEmpty())
+		isIndexed = false;
+
+	QSet<QString> matched;
+	if (!isIndexed)
+	{
+		matched = mDocuments.keys().toSet();
+	}
+	else if (words.size() == 1)
+	{
+		for (QHash<QString, QHash<QString, QVector<quint32> > >::const_iterator it = mPostings.constBegin(); it != mPostings.constEnd(); ++it)
+		{
+			if (!it.key().contains(words[0]))
+				continue;
+			for (QHash<QString, QVector<quint32> >::const_iterator doc = it->constBegin(); doc != it->constEnd(); ++doc)
+				matched.insert(doc.key());
+		}
+	}
+	else
+	{
+		// collect the positions of every query word, then keep the notes where they follow each other
+		int last = words.size() - 1;
+		QVector<QHash<QString, QSet<quint32> > > positions(words.size());
+		for (QHash<QString, QHash<QString, QVector<quint32> > >::const_iterator it = mPostings.constBegin(); it != mPostings.constEnd(); ++it)
+		{
+			for (int k = 0; k <= last; k++)
+			{
+				bool isMatched;
+				if (k == 0)
+					isMatched = it.key().endsWith(words[k]);
+				else if (k == last)
+					isMatched = it.key().startsWith(words[k]);
+				else
+					isMatched = it.key() == words[k];
+				if (!isMatched)
+					continue;
+				for (QHash<QString, QVector<quint32> >::const_iterator doc = it->constBegin(); doc != it->constEnd(); ++doc)
+				{
+					QSet<quint32>& set = positions[k][doc.key()];
+					for (int i = 0; i < doc->size(); i++)
+						set.insert(doc->at(i));
+				}
+			}
+		}
+		for (QHash<QString, QSet<quint32> >::const_iterator doc = positions[0].constBegin(); doc != positions[0].constEnd(); ++doc)
+		{
+			for (QSet<quint32>::const_iterator pos = doc->constBegin(); pos != doc->constEnd(); ++pos)
+			{
+				bool isPhrase = true;
+				for (int k = 1; k <= last && isPhrase; k++)
+				{
+					QHash<QString, QSet<quint32> >::const_iterator next = positions[k].constFind(doc.key());
+					isPhrase = next != positions[k].constEnd() && next->contains(*pos + k);
+				}
+				if (isPhrase)
+				{
+					matched.insert(doc.key());
+					break;
+				}
+			}
+		}
+	}
+
+	for (QMap<QString, Document>::const_iterator it = mDocuments.constBegin(); it != mDocuments.constEnd(); ++it)
+	{
+		if (!matched.contains(it.key()))
+			continue;
+		if (!type.isEmpty() && it->type != type)
+			continue;
+		if (!color.isEmpty() && it->color != color)
+			continue;
+		if (!user.isEmpty() && !it->users.contains(user))
+			continue;
+		fileNames.append(it.key());
+	}
+	return isIndexed;
+}
+
+bool NoteIndex::document(const QString fileName, Document& doc)
+{
+	QMutexLocker locker(&mMutex);
+	QMap<QString, Document>::const_iterator it = mDocuments.constFind(QFileInfo(fileName).fileName());
+	if (it == mDocuments.constEnd())
+		return false;
+	doc = it.value();
+	return true;
+}
+
+QString NoteIndex::readText(const QString fileName)
+{
+	QString name = QFileInfo(fileName).fileName();
+	qint64 offset = 0;
+	if (name != QString("Annotation.txt"))
+	{
+		NoteRegistry::Entry entry;
+		if (!NoteRegistry::instance(mPath)->lookup(name, entry))
+			return QString();
+		offset = entry.contentOffset;
+	}
+	QFile file(QDir(mPath).absoluteFilePath(name));
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return QString();
+	file.seek(offset);
+	QTextStream in(&file);
+	QString content = in.readAll();
+	file.close();
+	return content.split("\nLinked Images:\n")[0];
+}
+
+void NoteIndex::insert(const QString fileName)
+{
+	QFileInfo finfo(QDir(mPath).absoluteFilePath(fileName));
+	if (!finfo.exists())
+		return;
+	loadPostings();
+	Document doc;
+	doc.fileName = finfo.fileName();
+	doc.size = finfo.size();
+	doc.modified = finfo.lastModified().toTime_t();
+	if (doc.fileName == QString("Annotation.txt"))
+	{
+		doc.type = QString("Annotation");
+	}
+	else
+	{
+		NoteRegistry::Entry entry;
+		if (!NoteRegistry::instance(mPath)->lookup(doc.fileName, entry))
+			return;
+		doc.type = entry.type;
+		doc.color = entry.color;
+		doc.users = entry.users.split(";", QString::SkipEmptyParts);
+	}
+
+	QStringList terms = tokenize(readText(doc.fileName));
+	QSet<QString> distinct;
+	for (int i = 0; i < terms.size(); i++)
+	{
+		mPostings[terms[i]][doc.fileName].append(i);
+		distinct.insert(terms[i]);
+	}
+	mTerms.insert(doc.fileName, distinct.toList());
+	mDocuments.insert(doc.fileName, doc);
+	count(doc, 1);
+	isDirty = true;
+}
+
+void NoteIndex::update(const QString fileName)
+{
+	QMutexLocker locker(&mMutex);
+	remove(fileName);
+	insert(QFileInfo(fileName).fileName());
+}
+
+void NoteIndex::remove(const QString fileName)
+{
+	QMutexLocker locker(&mMutex);
+	QString name = QFileInfo(fileName).fileName();
+	if (!mDocuments.contains(name))
+		return;
+	loadPostings();
+	QMap<QString, Document>::iterator doc = mDocuments.find(name);
+	if (doc == mDocuments.end())
+		return;
+	count(doc.value(), -1);
+	QStringList terms = mTerms.take(name);
+	for (int i = 0; i < terms.size(); i++)
+	{
+		QHash<QString, QHash<QString, QVector<quint32> > >::iterator it = mPostings.find(terms[i]);
+		if (it == mPostings.end())
+			continue;
+		it->remove(name);
+		if (it->isEmpty())
+			mPostings.erase(it);
+	}
+	mDocuments.erase(doc);
+	isDirty = true;
+}
+
+void NoteIndex::refresh(const QAtomicInt* stop)
+{
+	QDir dir(mPath);
+	if (!dir.exists())
+		return;
+	QFileInfoList items = dir.entryInfoList(QStringList() << "*.txt", QDir::Files);
+	QSet<QString> present;
+	for (int i = 0; i < items.size(); i++)
+	{
+		if (stop && *stop)
+			return;
+		QString name = items[i].fileName();
+		present.insert(name);
+		// locked one file at a time, so a note saved meanwhile only waits for that file
+		QMutexLocker locker(&mMutex);
+		QMap<QString, Document>::const_iterator it = mDocuments.constFind(name);
+		if (it != mDocuments.constEnd() && it->size == items[i].size() && it->modified == items[i].lastModified().toTime_t())
+			continue;
+		update(name);
+	}
+	QMutexLocker locker(&mMutex);
+	QStringList names = mDocuments.keys();
+	for (int i = 0; i < names.size(); i++)
+	{
+		if (!present.contains(names[i]))
+			remove(names[i]);
+	}
+}
+
+void NoteIndex::read()
+{
+	QFile file(mIndexFile);
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+	QDataStream in(&file);
+	in.setVersion(QDataStream::Qt_4_6);
+	quint32 magic, version;
+	in >> magic >> version;
+	if (magic != NOTE_INDEX_MAGIC || version != NOTE_INDEX_VERSION)
+	{
+		file.close();
+		return;
+	}
+	quint32 docNum;
+	in >> docNum;
+	for (quint32 i = 0; i < docNum && in.status() == QDataStream::Ok; i++)
+	{
+		Document doc;
+		quint32 modified;
+		in >> doc.fileName >> doc.type >> doc.color >> doc.users >> doc.size >> modified;
+		doc.modified = modified;
+		mDocuments.insert(doc.fileName, doc);
+	}
+	if (in.status() != QDataStream::Ok)
+	{
+		qDebug() << "Note index " << mIndexFile << " is broken, the notes will be indexed again";
+		mDocuments.clear();
+	}
+	else
+	{
+		// the word positions follow and are read when they are needed
+		mPostingsOffset = file.pos();
+		hasPostings = false;
+		for (QMap<QString, Document>::const_iterator it = mDocuments.constBegin(); it != mDocuments.constEnd(); ++it)
+			count(it.value(), 1);
+	}
+	file.close();
+}
+
+void NoteIndex::loadPostings()
+{
+	if (hasPostings)
+		return;
+	hasPostings = true;
+	QFile file(mIndexFile);
+	bool isBroken = !file.open(QIODevice::ReadOnly);
+	if (!isBroken)
+	{
+		QDataStream in(&file);
+		in.setVersion(QDataStream::Qt_4_6);
+		file.seek(mPostingsOffset);
+		quint32 termNum;
+		in >> termNum;
+		for (quint32 i = 0; i < termNum && in.status() == QDataStream::Ok; i++)
+		{
+			QString term;
+			quint32 postingNum;
+			in >> term >> postingNum;
+			QHash<QString, QVector<quint32> >& postings = mPostings[term];
+			for (quint32 j = 0; j < postingNum && in.status() == QDataStream::Ok; j++)
+			{
+				QString fileName;
+				QVector<quint32> positions;
+				in >> fileName >> positions;
+				postings.insert(fileName, positions);
+				mTerms[fileName].append(term);
+			}
+		}
+		isBroken = in.status() != QDataStream::Ok;
+		file.close();
+	}
+	if (isBroken)
+	{
+		qDebug() << "Note index " << mIndexFile << " is broken, the notes will be indexed again";
+		QStringList names = mDocuments.keys();
+		mDocuments.clear();
+		mPostings.clear();
+		mTerms.clear();
+		mFacets = Facets();
+		for (int i = 0; i < names.size(); i++)
+			insert(names[i]);
+		isDirty = true;
+	}
+}
+
+void NoteIndex::flush()
+{
+	QMutexLocker locker(&mMutex);
+	if (!isDirty || !QDir(mPath).exists())
+		return;
+	loadPostings();
+	QFile file(mIndexFile);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qDebug() << "Open Note index " << mIndexFile << " Failed";
+		return;
+	}
+	QDataStream out(&file);
+	out.setVersion(QDataStream::Qt_4_6);
+	out << quint32(NOTE_INDEX_MAGIC) << quint32(NOTE_INDEX_VERSION);
+	out << quint32(mDocuments.size());
+	for (QMap<QString, Document>::const_iterator it = mDocuments.constBegin(); it != mDocuments.constEnd(); ++it)
+		out << it->fileName << it->type << it->color << it->users << it->size << quint32(it->modified);
+	out << quint32(mPostings.size());
+	for (QHash<QString, QHash<QString, QVector<quint32> > >::const_iterator it = mPostings.constBegin(); it != mPostings.constEnd(); ++it)
+	{
+		out << it.key() << quint32(it->size());
+		for (QHash<QString, QVector<quint32> >::const_iterator doc = it->constBegin(); doc != it->constEnd(); ++doc)
+			out << doc.key() << doc.value();
+	}
+	file.close();
+	isDirty = false;
+}
@@ -0,0 +1,165 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef NOTE_INDEX_H
+#define NOTE_INDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QAtomicInt>
+
+/**
+ * This class keeps an inverted index (NoteIndex.dat) of the note text in one Note folder.
+ * Each term maps to the notes it occurs in and its word positions there, so a query is
+ * answered from the index and only the matched notes are read to build the result snippets.
+ * Queries behave like the case-insensitive text search used before: a single word matches
+ * inside any word, and several words match as a phrase whose first word may end a word
+ * and whose last word may start one. Each note also records its type, color and users so
+ * the search can be narrowed without opening any file. The note counts per type, color, user
+ * and month are kept up to date along with the index, and the word positions are only read
+ * from disk when the index is searched or changed, so the counts of a project are cheap to get.
+ * The index is searched from a worker thread, so every public function is locked.
+ */
+class NoteIndex
+{
+public:
+	struct Document
+	{
+		QString fileName;	// the note file name inside the Note folder
+		QString type;		// PointNote, SurfaceNote, ..., or Annotation
+		QString color;		// empty for the annotation
+		QStringList users;
+		qint64 size;
+		uint modified;
+	};
+
+	/**
+	 * Note counts of a Note folder, or of several folders added together. The annotation is not counted.
+	 */
+	struct Facets
+	{
+		int total;
+		QMap<QString, int> types;
+		QMap<QString, int> colors;
+		QMap<QString, int> users;
+		QMap<QString, int> months;	// "yyyy-MM" of the last modification
+
+		Facets() : total(0) {}
+		void add(const Facets& other);
+		// the number of notes in a category numbered as in num2category
+		int categoryCount(int category) const;
+	};
+
+	/**
+	 * @brief  Get the index of a Note folder. It is read from disk on first use.
+	 * @param  notePath  The Note folder of an object.
+	 */
+	static NoteIndex* instance(const QString notePath);
+
+	/**
+	 * @brief  Find the notes whose text contains the query.
+	 *         Queries containing regular expression characters cannot be answered by the index,
+	 *         in which case every note is returned and the caller has to match the text itself.
+	 * @param  text       The query.
+	 * @param  fileNames  Receives the matched note files, sorted by name.
+	 * @param  type       Only return notes of this type if not empty.
+	 * @param  color      Only return notes of this color type if not empty.
+	 * @param  user       Only return notes of this user if not empty.
+	 * @param  stop       If given, indexing the changed notes stops as soon as it is set.
+	 * @return true if the index answered the query.
+	 */
+	bool find(const QString text, QStringList& fileNames, const QString type = QString(),
+		const QString color = QString(), const QString user = QString(), const QAtomicInt* stop = NULL);
+
+	/**
+	 * @brief  Get the indexed information of a note file.
+	 * @return false if the file is not indexed.
+	 */
+	bool document(const QString fileName, Document& doc);
+
+	/**
+	 * @brief  Get the note counts of the Note folder, after indexing the notes that changed.
+	 */
+	Facets facets();
+
+	/**
+	 * @brief  Add up the note counts of several Note folders.
+	 * @param  notePaths  The Note folders.
+	 */
+	static Facets collect(const QStringList notePaths);
+
+	/**
+	 * @brief  Read the text of a note file, without its header and linked images.
+	 */
+	QString readText(const QString fileName);
+
+	/**
+	 * @brief  Index a note file again after it was written.
+	 */
+	void update(const QString fileName);
+
+	/**
+	 * @brief  Drop a removed note file from the index.
+	 */
+	void remove(const QString fileName);
+
+	/**
+	 * @brief  Index the note files that were added or changed by other means (import, merge,
+	 *         annotation editing) and drop the ones that no longer exist. Only file sizes and
+	 *         modification times are checked for the files that are already indexed.
+	 *         The index is locked one file at a time, so call it without holding the lock.
+	 * @param  stop  If given, stop as soon as it is set; the remaining files are indexed next time.
+	 */
+	void refresh(const QAtomicInt* stop = NULL);
+
+	/**
+	 * @brief  Write the index file if anything changed.
+	 */
+	void flush();
+
+private:
+	NoteIndex(const QString notePath);
+
+	void insert(const QString fileName);
+	void count(const Document& doc, int delta);
+	void read();
+	void loadPostings();
+	static QStringList tokenize(const QString& text);
+
+	QString mPath;
+	QString mIndexFile;
+	QMap<QString, Document> mDocuments;
+	QHash<QString, QHash<QString, QVector<quint32> > > mPostings;	// term -> note file -> word positions
+	QHash<QString, QStringList> mTerms;	// note file -> its terms, for removal
+	Facets mFacets;
+	qint64 mPostingsOffset;	// where the word positions start in the index file
+	bool hasPostings;	// whether they have been read
+	bool isDirty;
+	QMutex mMutex;
+};
+
+#endif // NOTE_INDEX_H
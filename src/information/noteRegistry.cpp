@@ -0,0 +1,249 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include "noteRegistry.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStringList>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QMutexLocker>
+#include <QDebug>
+
+#define NOTE_REGISTRY_FILE "NoteRegistry.xml"
+#define NOTE_REGISTRY_ROOT "noteregistry"
+#define NOTE_REGISTRY_VERSION "1"
+
+// file scope: the search worker may be the first to ask for a registry, and function
+// statics are not initialized thread-safely before C++11
+static QMap<QString, NoteRegistry*> registries;
+static QMutex registriesMutex;
+
+NoteRegistry* NoteRegistry::instance(const QString notePath)
+{
+	QMutexLocker locker(&registriesMutex);
+	QString path = QDir::toNativeSeparators(QDir::cleanPath(notePath));
+	QMap<QString, NoteRegistry*>::iterator it = registries.find(path);
+	if (it == registries.end())
+		it = registries.insert(path, new NoteRegistry(path));
+	return it.value();
+}
+
+NoteRegistry::NoteRegistry(const QString notePath)
+	: mMutex(QMutex::Recursive)
+{
+	mPath = notePath;
+	mRegistryFile = QDir(mPath).absoluteFilePath(NOTE_REGISTRY_FILE);
+	isDirty = false;
+	read();
+}
+
+bool NoteRegistry::lookup(const QString fileName, Entry& entry)
+{
+	QMutexLocker locker(&mMutex);
+	QString name = QFileInfo(fileName).fileName();
+	QFileInfo finfo(QDir(mPath).absoluteFilePath(name));
+	if (!finfo.exists())
+		return false;
+	QMap<QString, Entry>::iterator it = mEntries.find(name);
+	if (it != mEntries.end() && it->size == finfo.size() && it->modified == finfo.lastModified().toTime_t())
+	{
+		entry = it.value();
+		return true;
+	}
+	Entry fresh;
+	if (!scan(name, fresh))
+		return false;
+	if (it != mEntries.end())
+		fresh.created = it->created;
+	mEntries.insert(name, fresh);
+	isDirty = true;
+	entry = fresh;
+	return true;
+}
+
+void NoteRegistry::update(const QString fileName)
+{
+	// the note was just written: size and second-resolution time may not have changed
+	QMutexLocker locker(&mMutex);
+	QString name = QFileInfo(fileName).fileName();
+	QMap<QString, Entry>::iterator it = mEntries.find(name);
+	Entry fresh;
+	if (!scan(name, fresh))
+	{
+		if (it != mEntries.end())
+		{
+			mEntries.erase(it);
+			isDirty = true;
+		}
+		return;
+	}
+	if (it != mEntries.end())
+		fresh.created = it->created;
+	mEntries.insert(name, fresh);
+	isDirty = true;
+}
+
+void NoteRegistry::remove(const QString fileName)
+{
+	QMutexLocker locker(&mMutex);
+	if (mEntries.remove(QFileInfo(fileName).fileName()) > 0)
+		isDirty = true;
+}
+
+// The header is read as raw lines so that the offset is a file position; it is decoded
+// with the local codec, which is what QTextStream uses when the notes are written.
+bool NoteRegistry::scan(const QString fileName, Entry& entry) const
+{
+	QFileInfo finfo(QDir(mPath).absoluteFilePath(fileName));
+	QFile file(finfo.absoluteFilePath());
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	QByteArray header;
+	bool isFound = false;
+	while (!file.atEnd())
+	{
+		QByteArray line = file.readLine();
+		header.append(line);
+		if (line.trimmed() == "Note Start:")
+		{
+			isFound = true;
+			break;
+		}
+	}
+	entry.contentOffset = file.pos();
+	file.close();
+	if (!isFound)
+		return false;
+
+	entry.fileName = finfo.fileName();
+	entry.type = entry.fileName.section('_', 0, 0);
+	entry.header = QString::fromLocal8Bit(header.constData(), header.size()).remove('\r');
+	entry.size = finfo.size();
+	entry.modified = finfo.lastModified().toTime_t();
+	entry.created = finfo.created().toTime_t();
+	QStringList lines = entry.header.split("\n");
+	int index = lines.indexOf(QString("User: "));
+	entry.users = index != -1 && index + 1 < lines.size() ? lines[index + 1].trimmed() : QString();
+	index = lines.indexOf(QString("Color Type:"));
+	entry.color = index != -1 && index + 1 < lines.size() ? lines[index + 1].trimmed() : QString();
+	return true;
+}
+
+void NoteRegistry::read()
+{
+	QFile file(mRegistryFile);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return;
+	QXmlStreamReader xml(&file);
+	if (!xml.readNextStartElement() || xml.name() != NOTE_REGISTRY_ROOT
+		|| xml.attributes().value("version") != NOTE_REGISTRY_VERSION)
+	{
+		file.close();
+		return;
+	}
+	while (xml.readNextStartElement())
+	{
+		if (xml.name() != "note")
+		{
+			xml.skipCurrentElement();
+			continue;
+		}
+		QXmlStreamAttributes attributes = xml.attributes();
+		Entry entry;
+		entry.fileName = attributes.value("file").toString();
+		entry.type = attributes.value("type").toString();
+		entry.color = attributes.value("color").toString();
+		entry.users = attributes.value("users").toString();
+		entry.size = attributes.value("size").toString().toLongLong();
+		entry.created = attributes.value("created").toString().toUInt();
+		entry.modified = attributes.value("modified").toString().toUInt();
+		entry.contentOffset = attributes.value("offset").toString().toLongLong();
+		entry.header = xml.readElementText();
+		if (!entry.fileName.isEmpty())
+			mEntries.insert(entry.fileName, entry);
+	}
+	if (xml.hasError())
+	{
+		qDebug() << "Note registry " << mRegistryFile << " is broken, the notes will be scanned again";
+		mEntries.clear();
+	}
+	file.close();
+}
+
+QList<NoteRegistry::Entry> NoteRegistry::entries()
+{
+	QMutexLocker locker(&mMutex);
+	return mEntries.values();
+}
+
+void NoteRegistry::flush()
+{
+	QMutexLocker locker(&mMutex);
+	QDir dir(mPath);
+	for (QMap<QString, Entry>::iterator it = mEntries.begin(); it != mEntries.end(); )
+	{
+		if (QFileInfo(dir.absoluteFilePath(it.key())).exists())
+		{
+			++it;
+			continue;
+		}
+		it = mEntries.erase(it);
+		isDirty = true;
+	}
+	if (!isDirty || !dir.exists())
+		return;
+
+	QFile file(mRegistryFile);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qDebug() << "Open Note registry " << mRegistryFile << " Failed";
+		return;
+	}
+	QXmlStreamWriter xml(&file);
+	xml.setAutoFormatting(true);
+	xml.writeStartDocument();
+	xml.writeStartElement(NOTE_REGISTRY_ROOT);
+	xml.writeAttribute("version", NOTE_REGISTRY_VERSION);
+	for (QMap<QString, Entry>::const_iterator it = mEntries.constBegin(); it != mEntries.constEnd(); ++it)
+	{
+		xml.writeStartElement("note");
+		xml.writeAttribute("file", it->fileName);
+		xml.writeAttribute("type", it->type);
+		xml.writeAttribute("color", it->color);
+		xml.writeAttribute("users", it->users);
+		xml.writeAttribute("size", QString::number(it->size));
+		xml.writeAttribute("created", QString::number(it->created));
+		xml.writeAttribute("modified", QString::number(it->modified));
+		xml.writeAttribute("offset", QString::number(it->contentOffset));
+		xml.writeCharacters(it->header);
+		xml.writeEndElement();
+	}
+	xml.writeEndElement();
+	xml.writeEndDocument();
+	file.close();
+	isDirty = false;
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef NOTE_REGISTRY_H
+#define NOTE_REGISTRY_H
+
+#include <QString>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+
+/**
+ * This class keeps a registry (NoteRegistry.xml) of the note files in one Note folder.
+ * For each note file it stores the note type, color, users, timestamps, the header of the
+ * note (everything up to "Note Start:", which holds the location of the note) and the
+ * byte offset where the note text starts. Notes are built from the header alone, and
+ * their text and linked images are read from the offset only when they are needed.
+ * An entry is trusted only while the size and modification time of its file match, so
+ * note files changed or copied by other means are simply scanned again.
+ * The registry may be used from the search thread, so every public function is locked.
+ */
+class NoteRegistry
+{
+public:
+	struct Entry
+	{
+		QString fileName;	// the note file name inside the Note folder
+		QString type;		// PointNote, SurfaceNote, ... (the file name prefix)
+		QString color;
+		QString users;
+		qint64 size;
+		uint created;
+		uint modified;
+		qint64 contentOffset;
+		QString header;
+	};
+
+	/**
+	 * @brief  Get the registry of a Note folder. It is read from disk on first use.
+	 * @param  notePath  The Note folder of an object.
+	 */
+	static NoteRegistry* instance(const QString notePath);
+
+	/**
+	 * @brief  Get the entry of a note file, scanning the file if the entry is missing or out of date.
+	 * @param  fileName  The note file, either its name or its full path.
+	 * @param  entry     Receives the entry.
+	 * @return false if the file cannot be read or has no "Note Start:" line.
+	 */
+	bool lookup(const QString fileName, Entry& entry);
+
+	/**
+	 * @brief  Scan a note file again after it was written, whatever its size and time say.
+	 */
+	void update(const QString fileName);
+
+	/**
+	 * @brief  Forget a removed note file.
+	 */
+	void remove(const QString fileName);
+
+	QList<Entry> entries();
+
+	/**
+	 * @brief  Write the registry file if anything changed. Entries of files that no longer exist are dropped.
+	 */
+	void flush();
+
+private:
+	NoteRegistry(const QString notePath);
+
+	bool scan(const QString fileName, Entry& entry) const;
+	void read();
+
+	QString mPath;
+	QString mRegistryFile;
+	QMap<QString, Entry> mEntries;
+	bool isDirty;
+	QMutex mMutex;
+};
+
+#endif // NOTE_REGISTRY_H
@@ -0,0 +1,231 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include "noteSearcher.h"
+#include "noteIndex.h"
+
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QMetaObject>
+#include <cmath>
+
+#define MATCHSIZE 40
+#define HIT_BATCH 20
+
+NoteSearcher::NoteSearcher(QObject* parent)
+	: QObject(parent), mHasPending(false), mGeneration(0), mStop(0), mHitGeneration(0), mPercent(0)
+{
+	connect(&mWatcher, SIGNAL(finished()), this, SLOT(jobFinished()));
+}
+
+NoteSearcher::~NoteSearcher()
+{
+	cancel();
+	mFuture.waitForFinished();
+}
+
+void NoteSearcher::search(const QStringList paths, const QStringList objects, const QString text)
+{
+	Job job;
+	job.paths = paths;
+	job.objects = objects;
+	job.text = text;
+	job.generation = ++mGeneration;
+	{
+		QMutexLocker locker(&mMutex);
+		mHits.clear();
+		mHitGeneration = job.generation;
+		mPercent = 0;
+	}
+	if (mFuture.isRunning())
+	{
+		mStop = 1;
+		mPending = job;
+		mHasPending = true;
+		return;
+	}
+	start(job);
+}
+
+void NoteSearcher::cancel()
+{
+	mStop = 1;
+	mHasPending = false;
+	++mGeneration;
+	QMutexLocker locker(&mMutex);
+	mHits.clear();
+	mHitGeneration = mGeneration;
+	mPercent = 0;
+}
+
+QList<NoteSearcher::Hit> NoteSearcher::takeHits()
+{
+	QMutexLocker locker(&mMutex);
+	QList<Hit> hits = mHits;
+	mHits.clear();
+	return hits;
+}
+
+void NoteSearcher::start(const Job& job)
+{
+	mStop = 0;
+	mFuture = QtConcurrent::run(this, &NoteSearcher::run, job);
+	mWatcher.setFuture(mFuture);
+}
+
+void NoteSearcher::jobFinished()
+{
+	if (mHasPending)
+	{
+		Job job = mPending;
+		mHasPending = false;
+		start(job);
+		return;
+	}
+	deliver();
+	if (!mStop)
+		emit finished();
+}
+
+// runs on the GUI thread, queued by publish()
+void NoteSearcher::deliver()
+{
+	bool hasHits;
+	int percent;
+	{
+		QMutexLocker locker(&mMutex);
+		if (mHitGeneration != mGeneration)
+			return;
+		hasHits = !mHits.isEmpty();
+		percent = mPercent;
+	}
+	emit progress(percent);
+	if (hasHits)
+		emit found();
+}
+
+void NoteSearcher::publish(QList<Hit>& hits, int generation, int percent)
+{
+	{
+		QMutexLocker locker(&mMutex);
+		if (generation != mHitGeneration)
+		{
+			hits.clear();
+			return;
+		}
+		mHits.append(hits);
+		mPercent = percent;
+	}
+	hits.clear();
+	QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void NoteSearcher::run(Job job)
+{
+	int total = job.paths.size();
+	for (int k = 0; k < total; k++)
+	{
+		if (mStop)
+			return;
+		NoteIndex* index = NoteIndex::instance(job.paths[k]);
+		QStringList fileList;
+		index->find(job.text, fileList, QString(), QString(), QString(), &mStop);
+		QList<Hit> hits;
+		for (int i = 0; i < fileList.size(); i++)
+		{
+			if (mStop)
+				return;
+			NoteIndex::Document doc;
+			if (!index->document(fileList[i], doc))
+				continue;
+			QString content = index->readText(fileList[i]);
+			QStringList matches = matchString(content, job.text);
+			if (matches.isEmpty())
+				continue;
+			Hit hit;
+			hit.object = job.objects[k];
+			hit.type = doc.type;
+			hit.color = doc.color;
+			hit.path = job.paths[k];
+			hit.fileName = fileList[i];
+			hit.matches = matches;
+			hit.relevance = relevance(matches.size(), content.size());
+			hits.append(hit);
+			if (hits.size() >= HIT_BATCH)
+				publish(hits, job.generation, (100 * k + 100 * (i + 1) / fileList.size()) / total);
+		}
+		publish(hits, job.generation, 100 * (k + 1) / total);
+	}
+}
+
+double NoteSearcher::relevance(int matchNum, int size)
+{
+	return matchNum / std::sqrt(1.0 + size);
+}
+
+QStringList NoteSearcher::matchString(QString content, QString matchStr)
+{
+	QRegExp text(matchStr);
+	text.setCaseSensitivity(Qt::CaseInsensitive);
+	int inputSize = matchStr.size();
+	int spareSize = (MATCHSIZE - inputSize) / 2;
+	if (spareSize < 0) spareSize = 0;
+	int size = content.size();
+	int cur = 0;
+	QStringList matchList;
+	while (cur < size)
+	{	
+		int pos = content.indexOf(text, cur);
+		if (pos == -1)
+			break;
+		cur = pos + inputSize;
+		QString match;
+		if (pos < spareSize)
+		{
+			match = content.left(MATCHSIZE);
+			match.insert(pos+inputSize, QString("</span>"));
+			match.insert(pos, QString("<span style=\"background-color: #FFFF00\">"));
+			if (size > MATCHSIZE)
+				match.append("...");
+		}
+		else if (pos > size - spareSize)
+		{
+			match = content.right(MATCHSIZE);
+			match.insert(MATCHSIZE-size+pos+inputSize, QString("</span>"));
+			match.insert(MATCHSIZE-size+pos, QString("<span style=\"background-color: #FFFF00\">"));
+			if (size > MATCHSIZE)
+				match.prepend("...");
+		}
+		else
+		{
+			match = content.mid(pos - spareSize, MATCHSIZE);
+			match.insert(spareSize+inputSize, QString("</span>"));
+			match.insert(spareSize, QString("<span style=\"background-color: #FFFF00\">"));
+			match.append("...");
+			match.prepend("...");
+		}
+		matchList.append(match);
+	}
+	return matchList;
+}
@@ -0,0 +1,145 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef NOTE_SEARCHER_H
+#define NOTE_SEARCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QAtomicInt>
+
+/**
+ * This class runs note searches on a worker thread for the search tabs.
+ * The Note folders are searched one after another through their NoteIndex, which is brought
+ * up to date on the way, and matched notes are delivered in batches through found() while the
+ * search goes on. A new search cancels the running one; it starts as soon as the worker notices.
+ */
+class NoteSearcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	/**
+	 * One matched note with its highlighted snippets.
+	 */
+	struct Hit
+	{
+		QString object;		// the object name shown in the result tree
+		QString type;		// PointNote, SurfaceNote, ..., or Annotation
+		QString color;
+		QString path;		// the Note folder
+		QString fileName;
+		QStringList matches;
+		double relevance;
+	};
+
+	NoteSearcher(QObject* parent = 0);
+	~NoteSearcher();
+
+	/**
+	 * @brief  Search the notes of some objects.
+	 * @param  paths    The Note folders to search.
+	 * @param  objects  The object name of each Note folder.
+	 * @param  text     The query.
+	 */
+	void search(const QStringList paths, const QStringList objects, const QString text);
+
+	/**
+	 * @brief  Stop the running search and drop its results.
+	 */
+	void cancel();
+
+	bool isBusy() const {return mFuture.isRunning();}
+
+	/**
+	 * @brief  Take the hits delivered since the last call.
+	 */
+	QList<Hit> takeHits();
+
+	/**
+	 * @brief  Match string for searching.
+	 * @param  content   The input content for searching.
+	 * @param  matchStr  The string to search.
+	 * @return The list of matched strings in certain length.
+	 */
+	static QStringList matchString(QString content, QString matchStr);
+
+	/**
+	 * @brief  Relevance of a text with a number of matches: matches per square root of the text length,
+	 *         so short notes about the query rank above long notes that mention it in passing.
+	 */
+	static double relevance(int matchNum, int size);
+
+signals:
+	/**
+	 * @brief  New hits are ready to be taken.
+	 */
+	void found();
+
+	/**
+	 * @brief  Progress of the running search in percent.
+	 */
+	void progress(int percent);
+
+	/**
+	 * @brief  The latest search has completed.
+	 */
+	void finished();
+
+private slots:
+	void deliver();
+	void jobFinished();
+
+private:
+	struct Job
+	{
+		QStringList paths;
+		QStringList objects;
+		QString text;
+		int generation;
+	};
+
+	void start(const Job& job);
+	void run(Job job);
+	void publish(QList<Hit>& hits, int generation, int percent);
+
+	Job mPending;
+	bool mHasPending;
+	int mGeneration;	// of the latest search
+	QAtomicInt mStop;	// set to make the running job return
+
+	QList<Hit> mHits;	// delivered by the worker, not taken yet
+	int mHitGeneration;
+	int mPercent;
+	QMutex mMutex;
+
+	QFuture<void> mFuture;
+	QFutureWatcher<void> mWatcher;
+};
+
+#endif // NOTE_SEARCHER_H
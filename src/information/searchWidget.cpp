@@ -25,9 +25,10 @@
 
 #include "../information/searchWidget.h"
 #include "../information/informationWidget.h"
+#include "../information/noteSearcher.h"
 #include "../mainWindow.h"
 
-#define MATCHSIZE 40
+#define SEARCH_DELAY 300	// ms after the last keystroke
 
 std::string category2str(int mode)
 {
@@ -109,24 +110,42 @@ SearchWidget::SearchWidget(QWidget *parent)
 	connect(mFilter, SIGNAL(currentIndexChanged(int)), this, SLOT(setFilterMode(int)) );
 
 	mTreeWidget = new QTreeWidget();
-	mTreeWidget->setColumnCount(5);
+	mTreeWidget->setColumnCount(6);
 	mTreeWidget->setColumnWidth(0, 200);
 	mTreeWidget->setColumnWidth(1, 80);
 	mTreeWidget->setColumnWidth(2, 70);
 	mTreeWidget->setColumnWidth(3, 150);
 	mTreeWidget->setColumnWidth(4, 100);
+	mTreeWidget->setColumnWidth(5, 70);
 	QStringList ColumnNames;
-	ColumnNames << "Result" << "Object" << "Category" << "Path" << "File";
+	ColumnNames << "Result" << "Object" << "Category" << "Path" << "File" << "Relevance";
 	mTreeWidget->setHeaderLabels(ColumnNames);
 	mTreeWidget->setSortingEnabled(true);
+	mTreeWidget->sortByColumn(5, Qt::DescendingOrder);
 	connect(mButton, SIGNAL(clicked()), this, SLOT(search()));
 	connect(mTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(showTreeWidgetItem(QTreeWidgetItem*, int)));
+
+	// search as you type: each keystroke restarts the timer and a new search cancels the running one
+	mTimer = new QTimer(this);
+	mTimer->setSingleShot(true);
+	mTimer->setInterval(SEARCH_DELAY);
+	connect(mInput, SIGNAL(textEdited(const QString&)), mTimer, SLOT(start()));
+	connect(mTimer, SIGNAL(timeout()), this, SLOT(search()));
+	mProgress = new QProgressBar();
+	mProgress->setRange(0, 100);
+	mProgress->setFixedWidth(120);
+	mProgress->hide();
+	mSearcher = new NoteSearcher(this);
+	connect(mSearcher, SIGNAL(found()), this, SLOT(addResults()));
+	connect(mSearcher, SIGNAL(progress(int)), mProgress, SLOT(setValue(int)));
+	connect(mSearcher, SIGNAL(finished()), mProgress, SLOT(hide()));
 	
 	hlay = new QHBoxLayout();
 	vlay = new QVBoxLayout();
 	hlay->addWidget(mInput, 0 , Qt::AlignLeft);
 	hlay->addWidget(mFilter, 0 , Qt::AlignLeft);
 	hlay->addWidget(mButton, 0 , Qt::AlignLeft);
+	hlay->addWidget(mProgress, 0 , Qt::AlignLeft);
 	vlay->addWidget(mLabel);
 	vlay->addLayout(hlay);
 	vlay->addWidget(mTreeWidget);
@@ -164,7 +183,6 @@ void SearchWidget::setFilter(int mode)
 			mFilteredItems.append(item);
 		}
 		mTreeWidget->insertTopLevelItems(0, mFilteredItems);
-		mTreeWidget->sortByColumn(4, Qt::AscendingOrder);
 		return;
 	}
 	for (int i = 0; i < mItems.size(); i++)
@@ -177,113 +195,95 @@ void SearchWidget::setFilter(int mode)
 		}
 	}
 	mTreeWidget->insertTopLevelItems(0, mFilteredItems);
-	mTreeWidget->sortByColumn(4, Qt::AscendingOrder);
 }
 
 void SearchWidget::search()
 {
-	if (!updateCurrentPath() || !mInput->isModified() || mInput->text() == QString())
+	mTimer->stop();
+	if (!updateCurrentPath() || !mInput->isModified())
 		return;
 	mTreeWidget->clear();
 	mItems.clear();
-	QRegExp text(mInput->text());
-	text.setCaseSensitivity(Qt::CaseInsensitive);
-	int inputSize = mInput->text().size();
-	int spareSize = (MATCHSIZE - inputSize) / 2;
-	if (spareSize < 0) spareSize = 0;
-	QString category = "Annocation";	// for annotation
-	
-	QDir dir(mPath);
-	dir.setNameFilters(QStringList()<<"*.txt");
-	dir.setSorting(QDir::Name|QDir::LocaleAware);
-	QStringList fileList = dir.entryList();
+	mFilteredItems.clear();
+	mCategoryCounts.clear();
+	updateFilterCounts();
+	if (mInput->text() == QString())
+	{
+		mSearcher->cancel();
+		mProgress->hide();
+		return;
+	}
+	mProgress->setValue(0);
+	mProgress->show();
+	mSearcher->search(QStringList() << mPath, QStringList() << mFile, mInput->text());
+}
 
-	for (int i = 0; i < fileList.size(); ++i)
+void SearchWidget::addResults()
+{
+	QList<QTreeWidgetItem*> shownItems;
+	QList<NoteSearcher::Hit> hits = mSearcher->takeHits();
+	for (int i = 0; i < hits.size(); i++)
 	{
-		QString fileName = mPath;
-		fileName.append(QDir::separator() + fileList[i]);
-		qDebug() << fileName;
-		QFile* file = new QFile(fileName);
-		if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
-		{
-			continue;
-		}
-		QTextStream in(file);
-		if (fileList[i] != QString("Annotation.txt"))
+		QString category;
+		if (hits[i].type == QString("Annotation"))
+			category = QString("Annotation");
+		else
+			category = QString(color2category(hits[i].color.toStdString()).c_str());
+		for (int j = 0; j < hits[i].matches.size(); j++)
 		{
-			while(1)
-			{
-				QString signal = in.readLine();
-				if (signal == QString("Color Type:"))
-					break;
-			}
-			QString color;
-			in >> color;
-			category = QString(color2category(color.toStdString()).c_str());
-			while(1)
-			{
-				QString signal = in.readLine();
-				if (signal == QString("Note Start:"))
-					break;
-			}
-		}
-		QString content = in.readAll();
-		content = content.split("\nLinked Images:\n")[0];
-		int size = content.size();
-		int cur = 0;
-		while (cur < size)
-		{	
-			int pos = content.indexOf(text, cur);
-			if (pos == -1)
-				break;
-			cur = pos + inputSize;
-			QString match;
-			if (pos < spareSize)
-			{
-				match = content.left(MATCHSIZE);
-				match.insert(pos+inputSize, QString("</span>"));
-				match.insert(pos, QString("<span style=\"background-color: #FFFF00\">"));
-				if (size > MATCHSIZE)
-					match.append("...");
-			}
-			else if (pos > size - spareSize)
-			{
-				match = content.right(MATCHSIZE);
-				match.insert(MATCHSIZE-size+pos+inputSize, QString("</span>"));
-				match.insert(MATCHSIZE-size+pos, QString("<span style=\"background-color: #FFFF00\">"));
-				if (size > MATCHSIZE)
-					match.prepend("...");
-			}
-			else
-			{
-				match = content.mid(pos - spareSize, MATCHSIZE);
-				match.insert(spareSize+inputSize, QString("</span>"));
-				match.insert(spareSize, QString("<span style=\"background-color: #FFFF00\">"));
-				match.append("...");
-				match.prepend("...");
-			}
-
 			QStringList list;
-			list.append(match);
-			list.append(mFile);
+			list.append(hits[i].matches[j]);
+			list.append(hits[i].object);
 			list.append(category);
-			list.append(mPath);
-			list.append(fileList[i]);
-			QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-			mItems.append(item);
+			list.append(hits[i].path);
+			list.append(hits[i].fileName);
+			addItem(list, hits[i].relevance, shownItems);
 		}
-		file->close();
-		delete file; //// Modified by Zeyu Wang on Nov 3, 2016 to fix crash
 	}
-	setFilter(mMode);
+	mTreeWidget->addTopLevelItems(shownItems);
+	updateFilterCounts();
+}
+
+void SearchWidget::addItem(const QStringList& list, double relevance, QList<QTreeWidgetItem*>& shownItems)
+{
+	QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
+	item->setData(5, Qt::DisplayRole, qRound(relevance * 1000) / 1000.0);
+	mItems.append(item);
+	mCategoryCounts[list[2]]++;
+	if (mMode != 0 && list[2] != QString(category2str(mMode).c_str()))
+		return;
+	QTreeWidgetItem* shownItem = new QTreeWidgetItem(*item);
+	mFilteredItems.append(shownItem);
+	shownItems.append(shownItem);
+}
+
+void SearchWidget::updateFilterCounts()
+{
+	int total = 0;
+	for (QMap<QString, int>::const_iterator it = mCategoryCounts.constBegin(); it != mCategoryCounts.constEnd(); ++it)
+		total += it.value();
+	for (int i = 0; i < mFilter->count(); i++)
+	{
+		int mode = i > 1 ? i + 1 : i;	// skip project info category
+		QString category(category2str(mode).c_str());
+		if (mCategoryCounts.isEmpty())
+			mFilter->setItemText(i, category);
+		else
+			mFilter->setItemText(i, category + QString(" (") + QString::number(i == 0 ? total : mCategoryCounts.value(category, 0)) + QString(")"));
+	}
 }
 
 void SearchWidget::refreshSearchTab(bool activeWindow)
 {
 	if(!activeWindow)
 	{
+		mTimer->stop();
+		mSearcher->cancel();
+		mProgress->hide();
 		mTreeWidget->clear();
 		mItems.clear();
+		mCategoryCounts.clear();
+		updateFilterCounts();
 		mPath = QString("");
 		mFile = QString("");
 		mInput->clear();
@@ -359,24 +359,42 @@ SearchAllWidget::SearchAllWidget(QWidget *parent)
 	mFilter->setCurrentIndex(0);
 	connect(mFilter, SIGNAL(currentIndexChanged(int)), this, SLOT(setFilterMode(int)) );
 	mTreeWidget = new QTreeWidget();
-	mTreeWidget->setColumnCount(5);
+	mTreeWidget->setColumnCount(6);
 	mTreeWidget->setColumnWidth(0, 200);
 	mTreeWidget->setColumnWidth(1, 80);
 	mTreeWidget->setColumnWidth(2, 70);
 	mTreeWidget->setColumnWidth(3, 150);
 	mTreeWidget->setColumnWidth(4, 100);
+	mTreeWidget->setColumnWidth(5, 70);
 	QStringList ColumnNames;
-	ColumnNames << "Result" << "Object" << "Category" << "Path" << "File";
+	ColumnNames << "Result" << "Object" << "Category" << "Path" << "File" << "Relevance";
 	mTreeWidget->setHeaderLabels(ColumnNames);
 	mTreeWidget->setSortingEnabled(true);
+	mTreeWidget->sortByColumn(5, Qt::DescendingOrder);
 	connect(mButton, SIGNAL(clicked()), this, SLOT(search()));
 	connect(mTreeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(showTreeWidgetItem(QTreeWidgetItem*, int)));
+
+	// search as you type: each keystroke restarts the timer and a new search cancels the running one
+	mTimer = new QTimer(this);
+	mTimer->setSingleShot(true);
+	mTimer->setInterval(SEARCH_DELAY);
+	connect(mInput, SIGNAL(textEdited(const QString&)), mTimer, SLOT(start()));
+	connect(mTimer, SIGNAL(timeout()), this, SLOT(search()));
+	mProgress = new QProgressBar();
+	mProgress->setRange(0, 100);
+	mProgress->setFixedWidth(120);
+	mProgress->hide();
+	mSearcher = new NoteSearcher(this);
+	connect(mSearcher, SIGNAL(found()), this, SLOT(addResults()));
+	connect(mSearcher, SIGNAL(progress(int)), mProgress, SLOT(setValue(int)));
+	connect(mSearcher, SIGNAL(finished()), mProgress, SLOT(hide()));
 	
 	hlay = new QHBoxLayout();
 	vlay = new QVBoxLayout();
 	hlay->addWidget(mInput, 0 , Qt::AlignLeft);
 	hlay->addWidget(mFilter, 0 , Qt::AlignLeft);
 	hlay->addWidget(mButton, 0 , Qt::AlignLeft);
+	hlay->addWidget(mProgress, 0 , Qt::AlignLeft);
 	vlay->addWidget(mLabel);
 	vlay->addLayout(hlay);
 	vlay->addWidget(mTreeWidget);
@@ -413,7 +431,6 @@ void SearchAllWidget::setFilter(int mode)
 			mFilteredItems.append(item);
 		}
 		mTreeWidget->insertTopLevelItems(0, mFilteredItems);
-		mTreeWidget->sortByColumn(4, Qt::AscendingOrder);
 		return;
 	}
 	for (int i = 0; i < mItems.size(); i++)
@@ -426,135 +443,48 @@ void SearchAllWidget::setFilter(int mode)
 		}
 	}
 	mTreeWidget->insertTopLevelItems(0, mFilteredItems);
-	mTreeWidget->sortByColumn(4, Qt::AscendingOrder);
 }
 
 
-QStringList SearchAllWidget::matchString(QString content, QString matchStr)
-{
-	QRegExp text(matchStr);
-	text.setCaseSensitivity(Qt::CaseInsensitive);
-	int inputSize = matchStr.size();
-	int spareSize = (MATCHSIZE - inputSize) / 2;
-	int size = content.size();
-	int cur = 0;
-	QStringList matchList;
-	while (cur < size)
-	{	
-		int pos = content.indexOf(text, cur);
-		if (pos == -1)
-			break;
-		cur = pos + inputSize;
-		QString match;
-		if (pos < spareSize)
-		{
-			match = content.left(MATCHSIZE);
-			match.insert(pos+inputSize, QString("</span>"));
-			match.insert(pos, QString("<span style=\"background-color: #FFFF00\">"));
-			if (size > MATCHSIZE)
-				match.append("...");
-		}
-		else if (pos > size - spareSize)
-		{
-			match = content.right(MATCHSIZE);
-			match.insert(MATCHSIZE-size+pos+inputSize, QString("</span>"));
-			match.insert(MATCHSIZE-size+pos, QString("<span style=\"background-color: #FFFF00\">"));
-			if (size > MATCHSIZE)
-				match.prepend("...");
-		}
-		else
-		{
-			match = content.mid(pos - spareSize, MATCHSIZE);
-			match.insert(spareSize+inputSize, QString("</span>"));
-			match.insert(spareSize, QString("<span style=\"background-color: #FFFF00\">"));
-			match.append("...");
-			match.prepend("...");
-		}
-		matchList.append(match);
-	}
-	return matchList;
-}
-
 void SearchAllWidget::search()
 {
-	if (!updateCurrentPath() || !mInput->isModified() || mInput->text() == QString())
+	mTimer->stop();
+	if (!updateCurrentPath() || !mInput->isModified())
 		return;
 	mTreeWidget->clear();
 	mItems.clear();
+	mFilteredItems.clear();
+	mCategoryCounts.clear();
+	updateFilterCounts();
 	QString text = mInput->text();
-	// search in annotation and notes
+	if (text == QString())
+	{
+		mSearcher->cancel();
+		mProgress->hide();
+		return;
+	}
+	// search in annotation and notes on the worker thread
+	QStringList paths, objects;
 	QDir dir(mPath);
-	QStringList subDirName = dir.entryList();
+	QStringList subDirName = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
 	for (int k = 0; k < subDirName.size(); k++)
 	{
-		QString category = QString("Annotation");
-		if (subDirName[k] == QString(".") || subDirName[k] == QString(".."))
-			continue;
-		QDir subDir(subDirName[k]);
-		if (!subDir.exists())
-			continue;
-		QDir projectDir(subDir.absolutePath());
-		mFile = projectDir.dirName();
-		qDebug()<<"sub dir"<<projectDir.absolutePath();
+		QDir projectDir(dir.absoluteFilePath(subDirName[k]));
 		if (!projectDir.cd("Note"))
 			continue;
-
-		projectDir.setNameFilters(QStringList()<<"*.txt");
-		projectDir.setSorting(QDir::Name|QDir::LocaleAware);
-		QStringList fileList = projectDir.entryList();
-		mPath = QDir::toNativeSeparators(projectDir.absolutePath());
-		for (int i = 0; i < fileList.size(); ++i)
-		{
-			QString fileName = mPath;
-			fileName.append(QDir::separator() + fileList[i]);
-			qDebug() << fileName;
-			QFile* file = new QFile(fileName);
-			if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
-			{
-				continue;
-			}
-			QTextStream in(file);
-			if (fileList[i] != QString("Annotation.txt"))
-			{
-				while(1)
-				{
-					QString signal = in.readLine();
-					if (signal == QString("Color Type:"))
-						break;
-				}
-				QString color;
-				in >> color;
-				category = QString(color2category(color.toStdString()).c_str());
-				while(1)
-				{
-					QString signal = in.readLine();
-					if (signal == QString("Note Start:"))
-						break;
-				}
-			}
-			QString content = in.readAll();
-			content = content.split("\nLinked Images:\n")[0];
-			QStringList match = matchString(content, text);
-			for (int j = 0; j < match.size(); j++)
-			{
-				QStringList list;
-				list.append(match[j]);
-				list.append(mFile);
-				list.append(category);
-				list.append(mPath);
-				list.append(fileList[i]);
-				QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-				mItems.append(item);
-			}
-			file->close();
-			delete file; //// Modified by Zeyu Wang on Nov 3, 2016 to fix crash
-		}
+		paths.append(QDir::toNativeSeparators(projectDir.absolutePath()));
+		objects.append(subDirName[k]);
 	}
+	mProgress->setValue(0);
+	mProgress->show();
+	mSearcher->search(paths, objects, text);
+
 	//search in project info
+	QList<QTreeWidgetItem*> shownItems;
 	QString projectName, location, keyword, affiliation, userName, description;
 	mw()->getProjectInfo(projectName, location, keyword, affiliation, userName, description);
 
-	QStringList match = matchString(projectName, text);
+	QStringList match = NoteSearcher::matchString(projectName, text);
 	for (int i = 0; i < match.size(); i++)
 	{
 		QStringList list;
@@ -562,11 +492,10 @@ void SearchAllWidget::search()
 		list.append(QString("Project Name"));
 		list.append(QString("Project Info"));
 		list.append(QString("Project Info"));
-		QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-		mItems.append(item);
+		addItem(list, NoteSearcher::relevance(match.size(), projectName.size()), shownItems);
 	}
 
-	match = matchString(keyword, text);
+	match = NoteSearcher::matchString(keyword, text);
 	for (int i = 0; i < match.size(); i++)
 	{
 		QStringList list;
@@ -574,11 +503,10 @@ void SearchAllWidget::search()
 		list.append(QString("Keyword"));
 		list.append(QString("Project Info"));
 		list.append(QString("Project Info"));
-		QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-		mItems.append(item);
+		addItem(list, NoteSearcher::relevance(match.size(), keyword.size()), shownItems);
 	}
 
-	match = matchString(affiliation, text);
+	match = NoteSearcher::matchString(affiliation, text);
 	for (int i = 0; i < match.size(); i++)
 	{
 		QStringList list;
@@ -586,11 +514,10 @@ void SearchAllWidget::search()
 		list.append(QString("Affiliation"));
 		list.append(QString("Project Info"));
 		list.append(QString("Project Info"));
-		QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-		mItems.append(item);
+		addItem(list, NoteSearcher::relevance(match.size(), affiliation.size()), shownItems);
 	}
 
-	match = matchString(userName, text);
+	match = NoteSearcher::matchString(userName, text);
 	for (int i = 0; i < match.size(); i++)
 	{
 		QStringList list;
@@ -598,11 +525,10 @@ void SearchAllWidget::search()
 		list.append(QString("User Name"));
 		list.append(QString("Project Info"));
 		list.append(QString("Project Info"));
-		QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-		mItems.append(item);
+		addItem(list, NoteSearcher::relevance(match.size(), userName.size()), shownItems);
 	}
 
-	match = matchString(description, text);
+	match = NoteSearcher::matchString(description, text);
 	for (int i = 0; i < match.size(); i++)
 	{
 		QStringList list;
@@ -610,19 +536,78 @@ void SearchAllWidget::search()
 		list.append(QString("Description"));
 		list.append(QString("Project Info"));
 		list.append(QString("Project Info"));
-		QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
-		mItems.append(item);
+		addItem(list, NoteSearcher::relevance(match.size(), description.size()), shownItems);
+	}
+	mTreeWidget->addTopLevelItems(shownItems);
+	updateFilterCounts();
+}
+
+void SearchAllWidget::addResults()
+{
+	QList<QTreeWidgetItem*> shownItems;
+	QList<NoteSearcher::Hit> hits = mSearcher->takeHits();
+	for (int i = 0; i < hits.size(); i++)
+	{
+		QString category;
+		if (hits[i].type == QString("Annotation"))
+			category = QString("Annotation");
+		else
+			category = QString(color2category(hits[i].color.toStdString()).c_str());
+		for (int j = 0; j < hits[i].matches.size(); j++)
+		{
+			QStringList list;
+			list.append(hits[i].matches[j]);
+			list.append(hits[i].object);
+			list.append(category);
+			list.append(hits[i].path);
+			list.append(hits[i].fileName);
+			addItem(list, hits[i].relevance, shownItems);
+		}
+	}
+	mTreeWidget->addTopLevelItems(shownItems);
+	updateFilterCounts();
+}
+
+void SearchAllWidget::addItem(const QStringList& list, double relevance, QList<QTreeWidgetItem*>& shownItems)
+{
+	QTreeWidgetItem* item = new QTreeWidgetItem((QTreeWidget*)0, list);
+	item->setData(5, Qt::DisplayRole, qRound(relevance * 1000) / 1000.0);
+	mItems.append(item);
+	mCategoryCounts[list[2]]++;
+	if (mMode != 0 && list[2] != QString(category2str(mMode).c_str()))
+		return;
+	QTreeWidgetItem* shownItem = new QTreeWidgetItem(*item);
+	mFilteredItems.append(shownItem);
+	shownItems.append(shownItem);
+}
+
+void SearchAllWidget::updateFilterCounts()
+{
+	int total = 0;
+	for (QMap<QString, int>::const_iterator it = mCategoryCounts.constBegin(); it != mCategoryCounts.constEnd(); ++it)
+		total += it.value();
+	for (int i = 0; i < mFilter->count(); i++)
+	{
+		int mode = i;
+		QString category(category2str(mode).c_str());
+		if (mCategoryCounts.isEmpty())
+			mFilter->setItemText(i, category);
+		else
+			mFilter->setItemText(i, category + QString(" (") + QString::number(i == 0 ? total : mCategoryCounts.value(category, 0)) + QString(")"));
 	}
-	setFilter(mMode);
-	
 }
 
 void SearchAllWidget::refreshSearchTab(bool activeWindow)
 {
 	if(!activeWindow)
 	{
+		mTimer->stop();
+		mSearcher->cancel();
+		mProgress->hide();
 		mTreeWidget->clear();
 		mItems.clear();
+		mCategoryCounts.clear();
+		updateFilterCounts();
 		mPath = QString("");
 		mFile = QString("");
 		mInput->clear();
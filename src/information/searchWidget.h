@@ -49,19 +49,23 @@
 #include <QTreeView>
 #include <QTreeWidget>
 #include <QTreeWidgetItem>
+#include <QTimer>
+#include <QProgressBar>
 #include "../vtkEnums.h"
 #include "vtkImageData.h"
 #include "vtkImageViewer2.h"
 #include "vtkSmartPointer.h"
 #include "vtkTexture.h"
 #include "../function/htmlDelegate.h"
+#include "noteSearcher.h"
 
 class MainWindow;
 
 /**
  * This class implement the search widget tab on bottom of right doc.
  * It provides the search function for all the notes, annotation in the 
- * object of current window.
+ * object of current window. The search runs on a worker thread while the user
+ * types, and the results stream in ranked by relevance.
  */
 class SearchWidget : public QWidget
 {
@@ -99,12 +103,30 @@ private:
 	 */
 	void setFilter(int mode);
 
+	/**
+	 * @brief  Add a result item, and show it if it passes the category filter.
+	 * @param  list        The column texts.
+	 * @param  relevance   The relevance of the note the result comes from.
+	 * @param  shownItems  Receives the copy of the item shown in the tree.
+	 */
+	void addItem(const QStringList& list, double relevance, QList<QTreeWidgetItem*>& shownItems);
+
+	/**
+	 * @brief  Show the number of results of each category in the category filter.
+	 */
+	void updateFilterCounts();
+
 private slots:
 	/**
-	 * Start to search.
+	 * Start to search. A running search is cancelled.
 	 */
 	void search();
 
+	/**
+	 * @brief  Add the results the searcher has delivered so far.
+	 */
+	void addResults();
+
 	/**
 	 * @brief  If the item is note item, then open the note.
 	 * @param  item  The item that is double clicked.
@@ -131,12 +153,17 @@ private:
 	QString mPath;
 	QString mFile;
 	int mMode;
+	QTimer* mTimer;
+	QProgressBar* mProgress;
+	NoteSearcher* mSearcher;
+	QMap<QString, int> mCategoryCounts;	// result numbers of each category
 };
 
 /**
  * This class implement the SearchAll widget tab on bottom of right doc.
  * It provides the search function for all the notes, annotation and
- * project info in the all the objects in project/CHE.
+ * project info in the all the objects in project/CHE. The notes are searched
+ * on a worker thread while the user types, and the results stream in ranked by relevance.
  */
 class SearchAllWidget : public QWidget
 {
@@ -168,26 +195,36 @@ private:
 	 */
 	bool updateCurrentPath();
 
-	/**
-	 * @brief  Match string for searching.
-	 * @param  content   The input content for searching.
-	 * @param  matchStr  The string to search.
-	 * @return The list of matched strings in certain length.
-	 */
-	QStringList matchString(QString content, QString matchStr);
-
 	/**
 	 * @brief  Set the filter for search. User can choose to search in certain categories.
 	 * @param  mode  The int value of selected item.
 	 */
 	void setFilter(int mode);
 
+	/**
+	 * @brief  Add a result item, and show it if it passes the category filter.
+	 * @param  list        The column texts.
+	 * @param  relevance   The relevance of the note the result comes from.
+	 * @param  shownItems  Receives the copy of the item shown in the tree.
+	 */
+	void addItem(const QStringList& list, double relevance, QList<QTreeWidgetItem*>& shownItems);
+
+	/**
+	 * @brief  Show the number of results of each category in the category filter.
+	 */
+	void updateFilterCounts();
+
 private slots:
 	/**
-	 * Start to search.
+	 * Start to search. A running search is cancelled.
 	 */
 	void search();
 
+	/**
+	 * @brief  Add the results the searcher has delivered so far.
+	 */
+	void addResults();
+
 	/**
 	 * @brief  If the item is note item, then open the note.
 	 * @param  item  The item that is double clicked.
@@ -214,6 +251,10 @@ private:
 	QString mPath;
 	QString mFile;
 	int mMode;
+	QTimer* mTimer;
+	QProgressBar* mProgress;
+	NoteSearcher* mSearcher;
+	QMap<QString, int> mCategoryCounts;	// result numbers of each category
 };
 
 #endif // SEARCH_H
\ No newline at end of file
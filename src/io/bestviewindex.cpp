@@ -0,0 +1,322 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+#include <QtConcurrentRun>
+#include <QMutexLocker>
+
+#include <vtkPolyData.h>
+#include <vtkMath.h>
+
+#include "bestviewindex.h"
+
+#define MAX_SAMPLES (50000)     // surface samples seen by every camera
+#define VOXELS_PER_AXIS (32)    // along the longest side of the mesh bounds
+#define DEPTH_MAP_SIZE (160)    // longest side of the per-camera depth maps, in pixels
+#define VIEW_CANDIDATES (4)     // cameras kept per voxel and per direction bin
+#define DIRECTION_BINS_THETA (32)
+#define DIRECTION_BINS_PHI (64)
+
+BestViewIndex::BestViewIndex()
+    : mVoxelSize(0), mIsBuilt(false)
+{
+}
+
+BestViewIndex::~BestViewIndex()
+{
+    mFuture.waitForFinished();
+}
+
+void BestViewIndex::build(vtkPolyData* mesh, const QVector<InputImage*>& images)
+{
+    clear();
+    if (!mesh || mesh->GetNumberOfCells() == 0 || images.isEmpty())
+        return;
+
+    QMutexLocker locker(&mMutex);
+    for (int k = 0; k < images.size(); k++)
+        mImages.push_back(*images[k]);
+
+    // the samples are copied here so that the worker never touches the mesh
+    vtkIdType numCells = mesh->GetNumberOfCells();
+    vtkIdType stride = std::max((vtkIdType)1, numCells / MAX_SAMPLES);
+    for (vtkIdType c = 0; c < numCells; c += stride)
+    {
+        vtkIdType npts, *pts;
+        mesh->GetCellPoints(c, npts, pts);
+        if (npts < 3)
+            continue;
+        double p0[3], p1[3], p2[3], e1[3], e2[3], normal[3];
+        mesh->GetPoint(pts[0], p0);
+        mesh->GetPoint(pts[1], p1);
+        mesh->GetPoint(pts[2], p2);
+        vtkMath::Subtract(p1, p0, e1);
+        vtkMath::Subtract(p2, p0, e2);
+        vtkMath::Cross(e1, e2, normal);
+        if (vtkMath::Normalize(normal) == 0)
+            continue;
+        double centroid[3] = {0, 0, 0};
+        for (vtkIdType j = 0; j < npts; j++)
+        {
+            double p[3];
+            mesh->GetPoint(pts[j], p);
+            for (int k = 0; k < 3; k++)
+                centroid[k] += p[k] / npts;
+        }
+        mSamples.insert(mSamples.end(), centroid, centroid + 3);
+        mNormals.insert(mNormals.end(), normal, normal + 3);
+    }
+    if (mSamples.empty())
+        return;
+
+    int numSamples = (int)mSamples.size() / 3;
+    for (int k = 0; k < 3; k++)
+    {
+        mBounds[2*k] = mBounds[2*k + 1] = mSamples[k];
+        for (int i = 1; i < numSamples; i++)
+        {
+            mBounds[2*k] = std::min(mBounds[2*k], mSamples[3*i + k]);
+            mBounds[2*k + 1] = std::max(mBounds[2*k + 1], mSamples[3*i + k]);
+        }
+    }
+    double extent = std::max(mBounds[1] - mBounds[0], std::max(mBounds[3] - mBounds[2], mBounds[5] - mBounds[4]));
+    mVoxelSize = extent > 0 ? extent / VOXELS_PER_AXIS : 1;
+
+    mSampleVoxels.resize(numSamples);
+    for (int i = 0; i < numSamples; i++)
+    {
+        int key = voxelKey(&mSamples[3 * i]);
+        QHash<int, int>::iterator it = mVoxels.find(key);
+        if (it == mVoxels.end())
+            it = mVoxels.insert(key, mVoxels.size());
+        mSampleVoxels[i] = it.value();
+    }
+
+    mFuture = QtConcurrent::run(this, &BestViewIndex::buildTables);
+}
+
+void BestViewIndex::clear()
+{
+    mFuture.waitForFinished();
+    QMutexLocker locker(&mMutex);
+    mIsBuilt = false;
+    mImages.clear();
+    mSamples.clear();
+    mNormals.clear();
+    mSampleVoxels.clear();
+    mVoxels.clear();
+    mVoxelCandidates.clear();
+    mDirectionCandidates.clear();
+}
+
+bool BestViewIndex::isReady()
+{
+    QMutexLocker locker(&mMutex);
+    return mIsBuilt;
+}
+
+int BestViewIndex::voxelKey(const double* p) const
+{
+    int index[3];
+    for (int k = 0; k < 3; k++)
+    {
+        double x = (p[k] - mBounds[2*k]) / mVoxelSize;
+        if (x < -1 || x > VOXELS_PER_AXIS + 1)
+            return -1;
+        index[k] = std::max(0, std::min(VOXELS_PER_AXIS, (int)x));
+    }
+    // the far boundary gets its own slab, hence VOXELS_PER_AXIS + 1
+    return (index[0] * (VOXELS_PER_AXIS + 1) + index[1]) * (VOXELS_PER_AXIS + 1) + index[2];
+}
+
+int BestViewIndex::directionBin(const double* v) const
+{
+    double d[3] = {v[0], v[1], v[2]};
+    if (vtkMath::Normalize(d) == 0)
+        return 0;
+    double theta = acos(std::max(-1.0, std::min(1.0, d[2])));
+    double phi = atan2(d[1], d[0]) + vtkMath::Pi();
+    int i = std::min(DIRECTION_BINS_THETA - 1, (int)(theta / vtkMath::Pi() * DIRECTION_BINS_THETA));
+    int j = std::min(DIRECTION_BINS_PHI - 1, (int)(phi / (2 * vtkMath::Pi()) * DIRECTION_BINS_PHI));
+    return i * DIRECTION_BINS_PHI + j;
+}
+
+void BestViewIndex::insertCandidate(Candidate* candidates, int image, float score)
+{
+    int j = VIEW_CANDIDATES;
+    while (j > 0 && (candidates[j - 1].image == -1 || candidates[j - 1].score < score))
+        j--;
+    if (j == VIEW_CANDIDATES)
+        return;
+    for (int k = VIEW_CANDIDATES - 1; k > j; k--)
+        candidates[k] = candidates[k - 1];
+    candidates[j].image = image;
+    candidates[j].score = score;
+}
+
+void BestViewIndex::buildTables()
+{
+    int numImages = (int)mImages.size();
+    int numSamples = (int)mSamples.size() / 3;
+    int numVoxels = mVoxels.size();
+    Candidate none = {-1, 0};
+    mVoxelCandidates.assign(numVoxels * VIEW_CANDIDATES, none);
+    mDirectionCandidates.assign(DIRECTION_BINS_THETA * DIRECTION_BINS_PHI * VIEW_CANDIDATES, none);
+    int c;
+
+#pragma omp parallel private(c)
+    {
+        std::vector<float> depthMap;
+        std::vector<int> pixels(numSamples);
+        std::vector<float> depths(numSamples);
+        std::vector<float> voxelScores(numVoxels, 0);
+        std::vector<int> touched;
+
+#pragma omp for schedule(dynamic)
+        for (c = 0; c < numImages; c++)
+        {
+            InputImage& image = mImages[c];
+            // cameras that bundler could not register have no focal length
+            if (image.f <= 0 || image.imW <= 0 || image.imH <= 0)
+                continue;
+            double scale = (double)DEPTH_MAP_SIZE / std::max(image.imW, image.imH);
+            int width = std::max(1, (int)(image.imW * scale));
+            int height = std::max(1, (int)(image.imH * scale));
+            depthMap.assign(width * height, FLT_MAX);
+
+            // splat the samples in front of the camera and facing it
+            for (int i = 0; i < numSamples; i++)
+            {
+                const double* p = &mSamples[3 * i];
+                const double* n = &mNormals[3 * i];
+                pixels[i] = -1;
+                double zc = image.R[6]*p[0] + image.R[7]*p[1] + image.R[8]*p[2] + image.t[2];
+                double toCamera[3];
+                vtkMath::Subtract(image.mCamPos, p, toCamera);
+                if (zc >= 0 || vtkMath::Dot(n, toCamera) <= 0)
+                    continue;
+                double ptIm[3];
+                image.projectWorldToImage(p[0], p[1], p[2], ptIm);
+                if (ptIm[0] < 0 || ptIm[1] < 0 || ptIm[0] >= image.imW || ptIm[1] >= image.imH)
+                    continue;
+                int x = std::min(width - 1, (int)(ptIm[0] * scale));
+                int y = std::min(height - 1, (int)(ptIm[1] * scale));
+                pixels[i] = y * width + x;
+                depths[i] = -zc;
+                depthMap[pixels[i]] = std::min(depthMap[pixels[i]], depths[i]);
+            }
+
+            // a sample is seen if nothing in its depth map pixel is more than
+            // about two pixel footprints in front of it
+            for (int i = 0; i < numSamples; i++)
+            {
+                if (pixels[i] == -1)
+                    continue;
+                double footprint = depths[i] / (image.f * scale);
+                if (depths[i] > depthMap[pixels[i]] + 2 * footprint)
+                    continue;
+                const double* p = &mSamples[3 * i];
+                double toCamera[3];
+                vtkMath::Subtract(image.mCamPos, p, toCamera);
+                double incidence = vtkMath::Dot(&mNormals[3 * i], toCamera) / vtkMath::Norm(toCamera);
+                int v = mSampleVoxels[i];
+                if (voxelScores[v] == 0)
+                    touched.push_back(v);
+                voxelScores[v] += (float)(image.f / depths[i] * incidence);
+            }
+
+#pragma omp critical
+            {
+                for (size_t k = 0; k < touched.size(); k++)
+                    insertCandidate(&mVoxelCandidates[touched[k] * VIEW_CANDIDATES], c, voxelScores[touched[k]]);
+            }
+            for (size_t k = 0; k < touched.size(); k++)
+                voxelScores[touched[k]] = 0;
+            touched.clear();
+        }
+    }
+
+    int b;
+#pragma omp parallel for private(b)
+    for (b = 0; b < DIRECTION_BINS_THETA * DIRECTION_BINS_PHI; b++)
+    {
+        double theta = (b / DIRECTION_BINS_PHI + 0.5) * vtkMath::Pi() / DIRECTION_BINS_THETA;
+        double phi = (b % DIRECTION_BINS_PHI + 0.5) * 2 * vtkMath::Pi() / DIRECTION_BINS_PHI - vtkMath::Pi();
+        double direction[3] = {sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta)};
+        for (int k = 0; k < numImages; k++)
+            if (mImages[k].f > 0)
+                insertCandidate(&mDirectionCandidates[b * VIEW_CANDIDATES], k, (float)vtkMath::Dot(direction, mImages[k].mViewVec));
+    }
+
+    QMutexLocker locker(&mMutex);
+    mIsBuilt = true;
+}
+
+int BestViewIndex::getBestImage(const double* viewVec, const double* surfacePoint)
+{
+    if (!isReady())
+        return -1;
+    double view[3] = {viewVec[0], viewVec[1], viewVec[2]};
+    vtkMath::Normalize(view);
+
+    // among the cameras that see this part of the surface best, take the one
+    // closest to the current view; photos from the side do not overlay well
+    QHash<int, int>::const_iterator it = surfacePoint ? mVoxels.constFind(voxelKey(surfacePoint)) : mVoxels.constEnd();
+    if (it != mVoxels.constEnd() && mVoxelCandidates[it.value() * VIEW_CANDIDATES].score > 0)
+    {
+        const Candidate* candidates = &mVoxelCandidates[it.value() * VIEW_CANDIDATES];
+        int best = -1;
+        double bestScore = 0;
+        for (int j = 0; j < VIEW_CANDIDATES && candidates[j].image != -1; j++)
+        {
+            double dot = vtkMath::Dot(view, mImages[candidates[j].image].mViewVec);
+            if (dot <= 0)
+                continue;
+            double score = candidates[j].score / candidates[0].score * dot * dot * dot * dot;
+            if (score > bestScore)
+            {
+                best = candidates[j].image;
+                bestScore = score;
+            }
+        }
+        if (best != -1)
+            return best;
+    }
+
+    const Candidate* candidates = &mDirectionCandidates[directionBin(view) * VIEW_CANDIDATES];
+    int best = -1;
+    double bestDot = -2;
+    for (int j = 0; j < VIEW_CANDIDATES && candidates[j].image != -1; j++)
+    {
+        double dot = vtkMath::Dot(view, mImages[candidates[j].image].mViewVec);
+        if (dot > bestDot)
+        {
+            best = candidates[j].image;
+            bestDot = dot;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,89 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef BESTVIEWINDEX_H
+#define BESTVIEWINDEX_H
+
+#include <vector>
+
+#include <QHash>
+#include <QFuture>
+#include <QMutex>
+
+#include "inputimageset.h"
+
+class vtkPolyData;
+
+// Precomputed best input images for the image overlay, built in a background
+// thread once the mesh and the PMVS cameras are loaded.
+//  - Surface: the mesh is sampled (face centroids) and every camera splats the
+//    samples into a small depth map, which tells which samples it sees. Each
+//    sample then scores the cameras seeing it by resolution (pixels per unit
+//    length) and incidence. Scores are summed in a coarse voxel grid that keeps
+//    the best few cameras per voxel.
+//  - Directions: a latitude/longitude table of the cameras whose view direction
+//    is closest to each bin, for when no surface point is at hand.
+// Both lookups cost the same whatever the number of photos.
+class BestViewIndex
+{
+public:
+    BestViewIndex();
+    ~BestViewIndex();
+
+    // starts building in the background; the cameras are copied
+    void build(vtkPolyData* mesh, const QVector<InputImage*>& images);
+    void clear();
+    bool isReady();
+
+    // best camera for a view looking along viewVec at surfacePoint (may be NULL);
+    // -1 if the index is not ready
+    int getBestImage(const double* viewVec, const double* surfacePoint);
+
+private:
+    struct Candidate
+    {
+        int image;
+        float score;
+    };
+
+    void buildTables();
+    int directionBin(const double* v) const;
+    int voxelKey(const double* p) const;
+    static void insertCandidate(Candidate* candidates, int image, float score);
+
+    std::vector<InputImage> mImages;
+    std::vector<double> mSamples;       // 3 per sample, face centroids
+    std::vector<double> mNormals;       // 3 per sample
+    std::vector<int> mSampleVoxels;     // dense voxel index of each sample
+    QHash<int, int> mVoxels;            // voxel key -> dense index
+    double mBounds[6];
+    double mVoxelSize;
+    std::vector<Candidate> mVoxelCandidates;     // VIEW_CANDIDATES per voxel, best first
+    std::vector<Candidate> mDirectionCandidates; // VIEW_CANDIDATES per direction bin
+    bool mIsBuilt;
+
+    QFuture<void> mFuture;
+    QMutex mMutex;
+};
+
+#endif // BESTVIEWINDEX_H
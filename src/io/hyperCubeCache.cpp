@@ -0,0 +1,222 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cstring>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QByteArray>
+#include <QStringList>
+
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkFloatArray.h>
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+
+#include "hyperCubeCache.h"
+
+#define CUBECACHE_MAGIC (0x43484331) // "CHC1"
+#define CUBECACHE_VERSION (1)
+#define CUBECACHE_PAGE (4096)
+
+static qint64 alignToPage(qint64 offset)
+{
+  return (offset + CUBECACHE_PAGE - 1) / CUBECACHE_PAGE * CUBECACHE_PAGE;
+}
+
+// DeleteEvent of the scalar array: unmap and close the cache file
+static void releaseMapping(vtkObject*, unsigned long, void* clientData, void*)
+{
+  QFile* file = static_cast<QFile*>(clientData);
+  file->close(); // also unmaps
+  delete file;
+}
+
+QString HyperCubeCache::cacheFileName(const QString& folder, const QString& sourceFile)
+{
+  return folder + "/" + QFileInfo(sourceFile).fileName() + ".cube";
+}
+
+bool HyperCubeCache::write(const QString& cacheFile, const QString& sourceFile, vtkImageData* hyperImage, vtkImageData* rgbImage,
+                           const std::vector<float>& wavelengths, const std::vector<std::string>& channelNames)
+{
+  if (!hyperImage || !rgbImage || hyperImage->GetScalarType() != VTK_FLOAT || rgbImage->GetScalarType() != VTK_UNSIGNED_CHAR)
+    return false;
+  int dims[3], rgbDims[3];
+  hyperImage->GetDimensions(dims);
+  rgbImage->GetDimensions(rgbDims);
+  int bands = hyperImage->GetNumberOfScalarComponents();
+  int rgbChannels = rgbImage->GetNumberOfScalarComponents();
+  if (dims[0] <= 0 || dims[1] <= 0 || bands <= 0 || rgbDims[0] != dims[0] || rgbDims[1] != dims[1])
+    return false;
+
+  QFileInfo source(sourceFile);
+  qint64 cubeBytes = (qint64)dims[0] * dims[1] * bands * sizeof(float);
+  qint64 rgbBytes = (qint64)dims[0] * dims[1] * rgbChannels;
+
+  QStringList names;
+  for (unsigned int k = 0; k < channelNames.size(); k++)
+    names << QString::fromStdString(channelNames[k]);
+
+  // metadata block; the offsets depend on its size, so it is written twice
+  QByteArray meta;
+  qint64 cubeOffset = 0, rgbOffset = 0;
+  for (int pass = 0; pass < 2; pass++)
+  {
+    meta.clear();
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_8);
+    out << (quint32)CUBECACHE_MAGIC << (quint32)CUBECACHE_VERSION;
+    out << (qint64)source.size() << (quint32)source.lastModified().toTime_t();
+    out << (qint32)dims[0] << (qint32)dims[1] << (qint32)bands << (qint32)rgbChannels;
+    out << cubeOffset << rgbOffset;
+    out << (qint32)wavelengths.size();
+    for (unsigned int k = 0; k < wavelengths.size(); k++)
+      out << (double)wavelengths[k];
+    out << names;
+    cubeOffset = alignToPage(meta.size());
+    rgbOffset = alignToPage(cubeOffset + cubeBytes);
+  }
+
+  QFile file(cacheFile + ".tmp");
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  bool ok = file.write(meta) == meta.size();
+  ok = ok && file.seek(cubeOffset) && file.write(static_cast<const char*>(hyperImage->GetScalarPointer()), cubeBytes) == cubeBytes;
+  ok = ok && file.seek(rgbOffset) && file.write(static_cast<const char*>(rgbImage->GetScalarPointer()), rgbBytes) == rgbBytes;
+  file.close();
+  if (!ok)
+  {
+    file.remove();
+    return false;
+  }
+  // replace the old cache only when the new one is complete
+  QFile::remove(cacheFile);
+  return file.rename(cacheFile);
+}
+
+bool HyperCubeCache::read(const QString& cacheFile, const QString& sourceFile, vtkImageData* (&hyperImage), vtkImageData* (&rgbImage),
+                          std::vector<float>& wavelengths, std::vector<std::string>& channelNames)
+{
+  QFileInfo source(sourceFile);
+  if (!source.exists() || !QFileInfo(cacheFile).isFile())
+    return false;
+
+  QFile* file = new QFile(cacheFile);
+  if (!file->open(QIODevice::ReadOnly))
+  {
+    delete file;
+    return false;
+  }
+
+  QByteArray head = file->read(CUBECACHE_PAGE);
+  QDataStream in(head);
+  in.setVersion(QDataStream::Qt_4_8);
+  quint32 magic = 0, version = 0, mtime = 0;
+  qint64 sourceSize = 0, cubeOffset = 0, rgbOffset = 0;
+  qint32 width = 0, height = 0, bands = 0, rgbChannels = 0, numWavelengths = 0;
+  in >> magic >> version >> sourceSize >> mtime;
+  in >> width >> height >> bands >> rgbChannels;
+  in >> cubeOffset >> rgbOffset;
+  in >> numWavelengths;
+
+  bool valid = in.status() == QDataStream::Ok && magic == CUBECACHE_MAGIC && version == CUBECACHE_VERSION
+    && sourceSize == source.size() && mtime == source.lastModified().toTime_t()
+    && width > 0 && height > 0 && bands > 0 && rgbChannels > 0 && numWavelengths >= 0;
+  qint64 cubeBytes = (qint64)width * height * bands * sizeof(float);
+  qint64 rgbBytes = (qint64)width * height * rgbChannels;
+  valid = valid && rgbOffset + rgbBytes <= file->size();
+  if (!valid)
+  {
+    delete file;
+    return false;
+  }
+
+  // the metadata may be longer than the first page if there are many channels
+  if (cubeOffset > head.size())
+  {
+    file->seek(0);
+    head = file->read(cubeOffset);
+  }
+  QDataStream tables(head);
+  tables.setVersion(QDataStream::Qt_4_8);
+  tables.skipRawData(4 + 4 + 8 + 4 + 4 * 4 + 8 + 8 + 4);
+  std::vector<float> lwavelengths(numWavelengths);
+  for (int k = 0; k < numWavelengths; k++)
+  {
+    double value;
+    tables >> value;
+    lwavelengths[k] = (float)value;
+  }
+  QStringList names;
+  tables >> names;
+
+  uchar* cube = file->map(cubeOffset, cubeBytes);
+  if (tables.status() != QDataStream::Ok || !cube)
+  {
+    delete file;
+    return false;
+  }
+
+  // cube: no copy, the float array points into the mapping and does not free it
+  vtkSmartPointer<vtkFloatArray> scalars = vtkSmartPointer<vtkFloatArray>::New();
+  scalars->SetNumberOfComponents(bands);
+  scalars->SetArray(reinterpret_cast<float*>(cube), cubeBytes / sizeof(float), 1);
+  vtkSmartPointer<vtkCallbackCommand> release = vtkSmartPointer<vtkCallbackCommand>::New();
+  release->SetCallback(releaseMapping);
+  release->SetClientData(file);
+  scalars->AddObserver(vtkCommand::DeleteEvent, release);
+
+  hyperImage = vtkImageData::New();
+  hyperImage->SetDimensions(width, height, 1);
+  hyperImage->SetScalarTypeToFloat();
+  hyperImage->SetNumberOfScalarComponents(bands);
+  hyperImage->GetPointData()->SetScalars(scalars);
+
+  // rgb: small, copied so that it can be modified (flipped, re-coloured)
+  rgbImage = vtkImageData::New();
+  rgbImage->SetDimensions(width, height, 1);
+  rgbImage->SetScalarTypeToUnsignedChar();
+  rgbImage->SetNumberOfScalarComponents(rgbChannels);
+  rgbImage->AllocateScalars();
+  uchar* rgb = file->map(rgbOffset, rgbBytes);
+  if (rgb)
+  {
+    memcpy(rgbImage->GetScalarPointer(), rgb, rgbBytes);
+    file->unmap(rgb);
+  }
+  else
+  {
+    file->seek(rgbOffset);
+    file->read(static_cast<char*>(rgbImage->GetScalarPointer()), rgbBytes);
+  }
+
+  wavelengths.swap(lwavelengths);
+  channelNames.clear();
+  for (int k = 0; k < names.size(); k++)
+    channelNames.push_back(names[k].toStdString());
+  return true;
+}
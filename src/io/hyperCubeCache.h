@@ -0,0 +1,52 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef HYPERCUBECACHE_H
+#define HYPERCUBECACHE_H
+
+#include <vector>
+#include <string>
+#include <QString>
+
+class vtkImageData;
+
+// Uncompressed sidecar of a decoded multispectral EXR, kept in the object's project folder.
+// Layout: one metadata block (source size/mtime, dimensions, wavelengths, channel names)
+// padded to a page, the float band-interleaved cube, then the 8-bit RGB image, each page-aligned.
+// On reopen the cube is memory-mapped and handed to vtkImageData without a copy; the mapping
+// is released when the scalar array is deleted.
+class HyperCubeCache
+{
+public:
+  // <folder>/<source file name>.cube
+  static QString cacheFileName(const QString& folder, const QString& sourceFile);
+
+  static bool write(const QString& cacheFile, const QString& sourceFile, vtkImageData* hyperImage, vtkImageData* rgbImage,
+                    const std::vector<float>& wavelengths, const std::vector<std::string>& channelNames);
+
+  // returns false (and leaves the outputs untouched) if the cache is missing or does not match sourceFile
+  static bool read(const QString& cacheFile, const QString& sourceFile, vtkImageData* (&hyperImage), vtkImageData* (&rgbImage),
+                   std::vector<float>& wavelengths, std::vector<std::string>& channelNames);
+};
+
+#endif // HYPERCUBECACHE_H
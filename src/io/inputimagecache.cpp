@@ -0,0 +1,164 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <QtConcurrentRun>
+#include <QDebug>
+
+#include <algorithm>
+
+#include <vtkJPEGReader.h>
+#include <vtkImageShrink3D.h>
+
+#include "inputimagecache.h"
+#include "inputimageset.h"
+
+#define CACHED_IMAGES (8)
+#define MAX_TEXTURE_SIZE (4096) // larger photos are shrunk, the overlay never fills more than the window
+
+InputImageCache::InputImageCache(QObject* parent)
+  : QObject(parent), mImageSet(NULL), mRunning(-1)
+{
+  connect(&mWatcher, SIGNAL(finished()), this, SLOT(jobFinished()));
+}
+
+InputImageCache::~InputImageCache()
+{
+  mFuture.waitForFinished();
+}
+
+void InputImageCache::setImageSet(InputImageSet* imageSet)
+{
+  if (imageSet == mImageSet)
+    return;
+  clear();
+  mImageSet = imageSet;
+}
+
+void InputImageCache::clear()
+{
+  mFuture.waitForFinished();
+  mRunning = -1;
+  mQueue.clear();
+  mImages.clear();
+  mRecent.clear();
+}
+
+vtkImageData* InputImageCache::getImage(int k)
+{
+  if (!mImageSet || k < 0 || k >= mImageSet->imageSet.size())
+    return NULL;
+  if (mImages.contains(k))
+  {
+    touch(k);
+    return mImages[k];
+  }
+  if (k != mRunning)
+  {
+    mQueue.removeAll(k);
+    mQueue.prepend(k);
+    startNext();
+  }
+  return NULL;
+}
+
+void InputImageCache::prefetch(const QList<int>& images)
+{
+  mQueue.clear();
+  for (int i = 0; i < images.size() && i < CACHED_IMAGES; i++)
+  {
+    if (mImages.contains(images[i]))
+      touch(images[i]);
+    else if (images[i] != mRunning)
+      mQueue.append(images[i]);
+  }
+  startNext();
+}
+
+void InputImageCache::touch(int k)
+{
+  mRecent.removeAll(k);
+  mRecent.prepend(k);
+}
+
+void InputImageCache::startNext()
+{
+  if (mFuture.isRunning() || mQueue.isEmpty() || !mImageSet)
+    return;
+  mRunning = mQueue.takeFirst();
+  mFuture = QtConcurrent::run(&InputImageCache::decode, mImageSet->imageSet[mRunning]->mFileName);
+  mWatcher.setFuture(mFuture);
+}
+
+void InputImageCache::jobFinished()
+{
+  int k = mRunning;
+  mRunning = -1;
+  // cleared while decoding
+  if (k == -1)
+  {
+    startNext();
+    return;
+  }
+
+  vtkSmartPointer<vtkImageData> image = mFuture.result();
+  if (image)
+  {
+    mImages[k] = image;
+    touch(k);
+    while (mRecent.size() > CACHED_IMAGES)
+      mImages.remove(mRecent.takeLast());
+  }
+  startNext();
+  if (image)
+    emit imageReady(k);
+}
+
+vtkSmartPointer<vtkImageData> InputImageCache::decode(QString filename)
+{
+  vtkSmartPointer<vtkJPEGReader> jPEGReader = vtkSmartPointer<vtkJPEGReader>::New();
+  jPEGReader->SetFileName(filename.toStdString().c_str());
+  jPEGReader->Update();
+  int* dims = jPEGReader->GetOutput()->GetDimensions();
+  if (dims[0] <= 0 || dims[1] <= 0)
+  {
+    qDebug() << "Cannot decode input image " << filename;
+    return NULL;
+  }
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  int factor = (std::max(dims[0], dims[1]) + MAX_TEXTURE_SIZE - 1) / MAX_TEXTURE_SIZE;
+  if (factor > 1)
+  {
+    vtkSmartPointer<vtkImageShrink3D> shrink = vtkSmartPointer<vtkImageShrink3D>::New();
+    shrink->SetInputConnection(jPEGReader->GetOutputPort());
+    shrink->SetShrinkFactors(factor, factor, 1);
+    shrink->AveragingOn();
+    shrink->Update();
+    image->ShallowCopy(shrink->GetOutput());
+  }
+  else
+  {
+    image->ShallowCopy(jPEGReader->GetOutput());
+  }
+  return image;
+}
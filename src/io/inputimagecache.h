@@ -0,0 +1,81 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef INPUTIMAGECACHE_H
+#define INPUTIMAGECACHE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QFuture>
+#include <QFutureWatcher>
+
+#include <vtkSmartPointer.h>
+#include <vtkImageData.h>
+
+class InputImageSet;
+
+// Decoded photos of the PMVS input image set for the image overlay.
+// Photos are decoded one at a time in a background thread, in the order of the
+// latest prefetch() (the views closest to the camera), and downscaled to a size
+// a texture can hold. The cache keeps the most recently used few; getImage()
+// never decodes in the caller's thread, imageReady() tells when to look again.
+class InputImageCache : public QObject
+{
+  Q_OBJECT
+
+public:
+  InputImageCache(QObject* parent = 0);
+  ~InputImageCache();
+
+  void setImageSet(InputImageSet* imageSet);
+  void clear();
+
+  // the decoded image k, or NULL after moving k to the front of the queue
+  vtkImageData* getImage(int k);
+  // replaces the queue; images are decoded in the given order
+  void prefetch(const QList<int>& images);
+
+signals:
+  void imageReady(int k);
+
+private slots:
+  void jobFinished();
+
+private:
+  void startNext();
+  void touch(int k);
+  static vtkSmartPointer<vtkImageData> decode(QString filename);
+
+  InputImageSet* mImageSet;
+  QHash<int, vtkSmartPointer<vtkImageData> > mImages;
+  QList<int> mRecent; // cached images, most recently used first
+  QList<int> mQueue;
+  int mRunning;       // image being decoded, -1 if none
+
+  QFuture<vtkSmartPointer<vtkImageData> > mFuture;
+  QFutureWatcher<vtkSmartPointer<vtkImageData> > mWatcher;
+};
+
+#endif // INPUTIMAGECACHE_H
@@ -26,6 +26,7 @@
 *****************************************************************************/
 
 #include "inputimageset.h"
+#include "bestviewindex.h"
 #include <vtkMath.h>
 #include <QVector>
 #include <QFile>
@@ -34,6 +35,9 @@
 #include <QString>
 #include <QStringList>
 #include <QDebug>
+#include <QPair>
+#include <QtConcurrentMap>
+#include <algorithm>
 #include <vtkImageData.h>
 #include <vtkSmartPointer.h>
 #include <vtkJPEGReader.h>
@@ -98,14 +102,25 @@ void InputImage::setParameters(double _f, double R11, double R12, double R13, do
 void InputImage::setFilename(QString filename)
 {
     mFileName = filename;
+    readImageSize();
+}
+
+void InputImage::readImageSize()
+{
+    // only the JPEG header is read; the pixels are decoded on demand by InputImageCache
     vtkSmartPointer<vtkJPEGReader> jPEGReader = vtkSmartPointer<vtkJPEGReader>::New();
-    jPEGReader->SetFileName(filename.toStdString().c_str());
-    jPEGReader->Update();
-    imW = jPEGReader->GetOutput()->GetDimensions()[0];
-    imH = jPEGReader->GetOutput()->GetDimensions()[1];
+    jPEGReader->SetFileName(mFileName.toStdString().c_str());
+    jPEGReader->UpdateInformation();
+    int* extent = jPEGReader->GetDataExtent();
+    imW = extent[1] - extent[0] + 1;
+    imH = extent[3] - extent[2] + 1;
     ox = imW / 2;
     oy = imH / 2;
-    qDebug() << "loading image " << filename << " width " << imW;
+}
+
+static void probeImageSize(InputImage*& image)
+{
+    image->readImageSize();
 }
 
 double InputImage::proximityToCamera(double otherCamPos[], double otherViewVec[])
@@ -137,14 +152,21 @@ void InputImage::projectWorldToImage(double xw, double yw, double zw, double ptI
 InputImageSet::InputImageSet()
 {
     mIsValid = false;
+    mViewIndex = new BestViewIndex();
 }
 
 InputImageSet::InputImageSet(QString directory)
 {
     mIsValid = false;
+    mViewIndex = new BestViewIndex();
     loadImageSetFromPMVSOutput(directory);
 }
 
+InputImageSet::~InputImageSet()
+{
+    delete mViewIndex;
+}
+
 bool InputImageSet::loadImageSetFromPMVSOutput(QString directory)
 {
     QString filename = directory;
@@ -200,9 +222,12 @@ bool InputImageSet::loadImageSetFromPMVSOutput(QString directory)
         sprintf(buffer,"%08d.jpg",k);
         QString foo(buffer);
         imagename.append(foo);
-        newImage->setFilename(imagename);
+        newImage->mFileName = imagename;
         imageSet.push_back(newImage);
     }
+    // the headers are independent, probe them all at once
+    QtConcurrent::blockingMap(imageSet, probeImageSize);
+    qDebug() << "loaded the sizes of " << imageSet.size() << " images";
     mIsValid = true;
     return true;
 }
@@ -223,3 +248,31 @@ int InputImageSet::getClosestImage(double otherCamPos[], double otherViewVec[])
     qDebug() << "The best image is " << bestImage;
     return bestImage;
 }
+
+void InputImageSet::buildViewIndex(vtkPolyData* mesh)
+{
+    if (mIsValid)
+        mViewIndex->build(mesh, imageSet);
+}
+
+int InputImageSet::getBestImage(double otherCamPos[], double otherViewVec[], const double* surfacePoint)
+{
+    int bestImage = mViewIndex->getBestImage(otherViewVec, surfacePoint);
+    if (bestImage == -1)
+        return getClosestImage(otherCamPos, otherViewVec);
+    return bestImage;
+}
+
+QList<int> InputImageSet::getClosestImages(double otherCamPos[], double otherViewVec[], int n)
+{
+    QVector<QPair<double, int> > scores(imageSet.size());
+    for(int k = 0; k < imageSet.size(); ++k)
+        scores[k] = qMakePair(-imageSet[k]->proximityToCamera(otherCamPos, otherViewVec), k);
+    n = std::min(n, scores.size());
+    std::partial_sort(scores.begin(), scores.begin() + n, scores.end());
+
+    QList<int> images;
+    for(int k = 0; k < n; ++k)
+        images.append(scores[k].second);
+    return images;
+}
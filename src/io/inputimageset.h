@@ -29,6 +29,10 @@
 #define INPUTIMAGESET_H
 #include <QString>
 #include <QVector>
+#include <QList>
+
+class vtkPolyData;
+class BestViewIndex;
 
 class InputImage
 {
@@ -42,6 +46,7 @@ public:
                        double R31, double R32, double R33,
                        double tx, double ty, double tz);
     void setFilename(QString filename);
+    void readImageSize();
     double proximityToCamera(double otherCamPos[], double otherViewVec[]);
     void projectWorldToImage(double x, double y, double z, double ptIm[]);
 
@@ -60,14 +65,23 @@ class InputImageSet
 public:
     InputImageSet();
     InputImageSet(QString directory);
+    ~InputImageSet();
     bool loadImageSetFromPMVSOutput(QString directory);
     int getClosestImage(double otherCamPos[], double otherViewVec[]);
+    // precomputes the best views of the mesh surface in the background
+    void buildViewIndex(vtkPolyData* mesh);
+    // best image for a camera looking at surfacePoint (NULL if none is picked);
+    // scans all images with getClosestImage until the index is built
+    int getBestImage(double otherCamPos[], double otherViewVec[], const double* surfacePoint);
+    // up to n images, best first
+    QList<int> getClosestImages(double otherCamPos[], double otherViewVec[], int n);
 
     QVector<InputImage*> imageSet;
     bool isValid() { return mIsValid; }
 
 private:
     bool mIsValid;
+    BestViewIndex* mViewIndex;
 };
 
 #endif // INPUTIMAGESET_H
@@ -0,0 +1,385 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cstring>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QByteArray>
+
+#include <vtkPolyData.h>
+#include <vtkImageData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+
+#include "readCHEROb.h"
+#include "meshCache.h"
+
+#define MESHCACHE_MAGIC (0x43484d31) // "CHM1"
+#define MESHCACHE_VERSION (1)
+#define MESHCACHE_PAGE (4096)
+
+enum MeshCacheBlock {POINTS = 0, POLYS, TCOORDS, NORMALS, COLORS, TEXTURE, NUMBLOCKS};
+
+static qint64 alignToPage(qint64 offset)
+{
+  return (offset + MESHCACHE_PAGE - 1) / MESHCACHE_PAGE * MESHCACHE_PAGE;
+}
+
+// one mapping shared by several arrays; the file is closed with the last of them
+struct MeshCacheMapping
+{
+  QFile* file;
+  int refs;
+};
+
+static void releaseMapping(vtkObject*, unsigned long, void* clientData, void*)
+{
+  MeshCacheMapping* mapping = static_cast<MeshCacheMapping*>(clientData);
+  if (--mapping->refs > 0)
+    return;
+  mapping->file->close(); // also unmaps
+  delete mapping->file;
+  delete mapping;
+}
+
+static void attachMapping(vtkDataArray* array, MeshCacheMapping* mapping)
+{
+  vtkSmartPointer<vtkCallbackCommand> release = vtkSmartPointer<vtkCallbackCommand>::New();
+  release->SetCallback(releaseMapping);
+  release->SetClientData(mapping);
+  array->AddObserver(vtkCommand::DeleteEvent, release);
+  mapping->refs++;
+}
+
+// float array of the given width, or NULL if the array does not have that layout
+static vtkFloatArray* floatArray(vtkDataArray* array, int components, vtkIdType tuples)
+{
+  vtkFloatArray* values = vtkFloatArray::SafeDownCast(array);
+  if (!values || values->GetNumberOfComponents() != components || values->GetNumberOfTuples() != tuples)
+    return NULL;
+  return values;
+}
+
+QString MeshCache::cacheFileName(const QString& folder, const QString& sourceFile)
+{
+  return folder + "/" + QFileInfo(sourceFile).fileName() + ".mesh";
+}
+
+bool MeshCache::write(const QString& cacheFile, const QString& sourceFile, const QString& textureFile,
+                      const std::vector<Material>& materials, vtkPolyData* polyData, vtkImageData* textureImage)
+{
+  if (!polyData || !polyData->GetPoints() || polyData->GetNumberOfPoints() == 0)
+    return false;
+  if (polyData->GetNumberOfVerts() || polyData->GetNumberOfLines() || polyData->GetNumberOfStrips()
+      || polyData->GetCellData()->GetNumberOfArrays())
+    return false;
+
+  vtkPointData* pointData = polyData->GetPointData();
+  const vtkIdType numPoints = polyData->GetNumberOfPoints();
+  vtkFloatArray* points = floatArray(polyData->GetPoints()->GetData(), 3, numPoints);
+  vtkFloatArray* tcoords = pointData->GetTCoords() ? floatArray(pointData->GetTCoords(), 2, numPoints) : NULL;
+  vtkFloatArray* normals = pointData->GetNormals() ? floatArray(pointData->GetNormals(), 3, numPoints) : NULL;
+  vtkUnsignedCharArray* colors = vtkUnsignedCharArray::SafeDownCast(pointData->GetScalars());
+  if (colors && (colors->GetNumberOfComponents() != 3 || colors->GetNumberOfTuples() != numPoints))
+    colors = NULL;
+  // anything we could not store would silently disappear on reopen
+  int numStored = (tcoords ? 1 : 0) + (normals ? 1 : 0) + (colors ? 1 : 0);
+  if (!points || pointData->GetNumberOfArrays() != numStored
+      || (pointData->GetTCoords() && !tcoords) || (pointData->GetNormals() && !normals))
+    return false;
+
+  int texDims[3] = {0, 0, 0};
+  int texChannels = 0;
+  if (textureImage && textureImage->GetScalarType() == VTK_UNSIGNED_CHAR)
+  {
+    textureImage->GetDimensions(texDims);
+    texChannels = textureImage->GetNumberOfScalarComponents();
+    if (texDims[2] != 1)
+      texChannels = 0;
+  }
+
+  vtkIdTypeArray* connectivity = polyData->GetPolys()->GetData();
+  const qint64 numPolys = polyData->GetNumberOfPolys();
+  qint64 bytes[NUMBLOCKS];
+  bytes[POINTS] = (qint64)numPoints * 3 * sizeof(float);
+  bytes[POLYS] = (qint64)connectivity->GetNumberOfTuples() * sizeof(qint64);
+  bytes[TCOORDS] = tcoords ? (qint64)numPoints * 2 * sizeof(float) : 0;
+  bytes[NORMALS] = normals ? (qint64)numPoints * 3 * sizeof(float) : 0;
+  bytes[COLORS] = colors ? (qint64)numPoints * 3 : 0;
+  bytes[TEXTURE] = (qint64)texDims[0] * texDims[1] * texChannels;
+
+  QFileInfo source(sourceFile);
+  QFileInfo texture(textureFile);
+  QByteArray materialBytes(reinterpret_cast<const char*>(materials.empty() ? NULL : &materials[0]),
+                           (int)(materials.size() * sizeof(Material)));
+
+  // metadata block; the offsets depend on its size, so it is written twice
+  QByteArray meta;
+  qint64 offsets[NUMBLOCKS] = {0, 0, 0, 0, 0, 0};
+  for (int pass = 0; pass < 2; pass++)
+  {
+    meta.clear();
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_8);
+    out << (quint32)MESHCACHE_MAGIC << (quint32)MESHCACHE_VERSION;
+    out << (qint64)source.size() << (quint32)source.lastModified().toTime_t();
+    out << textureFile << (qint64)(texture.exists() ? texture.size() : -1) << (quint32)(texture.exists() ? texture.lastModified().toTime_t() : 0);
+    out << (qint64)numPoints << numPolys;
+    out << (qint32)texDims[0] << (qint32)texDims[1] << (qint32)texChannels;
+    for (int b = 0; b < NUMBLOCKS; b++)
+      out << offsets[b] << bytes[b];
+    out << (qint32)sizeof(Material) << materialBytes;
+    qint64 offset = alignToPage(meta.size());
+    for (int b = 0; b < NUMBLOCKS; b++)
+    {
+      offsets[b] = offset;
+      offset = alignToPage(offset + bytes[b]);
+    }
+  }
+
+  QFile file(cacheFile + ".tmp");
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  bool ok = file.write(meta) == meta.size();
+  ok = ok && file.seek(offsets[POINTS]) && file.write(reinterpret_cast<const char*>(points->GetPointer(0)), bytes[POINTS]) == bytes[POINTS];
+  if (ok && bytes[POLYS] > 0)
+  {
+    ok = file.seek(offsets[POLYS]);
+    if (sizeof(vtkIdType) == sizeof(qint64))
+      ok = ok && file.write(reinterpret_cast<const char*>(connectivity->GetPointer(0)), bytes[POLYS]) == bytes[POLYS];
+    else
+    {
+      std::vector<qint64> ids(connectivity->GetPointer(0), connectivity->GetPointer(0) + connectivity->GetNumberOfTuples());
+      ok = ok && file.write(reinterpret_cast<const char*>(&ids[0]), bytes[POLYS]) == bytes[POLYS];
+    }
+  }
+  if (ok && tcoords)
+    ok = file.seek(offsets[TCOORDS]) && file.write(reinterpret_cast<const char*>(tcoords->GetPointer(0)), bytes[TCOORDS]) == bytes[TCOORDS];
+  if (ok && normals)
+    ok = file.seek(offsets[NORMALS]) && file.write(reinterpret_cast<const char*>(normals->GetPointer(0)), bytes[NORMALS]) == bytes[NORMALS];
+  if (ok && colors)
+    ok = file.seek(offsets[COLORS]) && file.write(reinterpret_cast<const char*>(colors->GetPointer(0)), bytes[COLORS]) == bytes[COLORS];
+  if (ok && bytes[TEXTURE] > 0)
+    ok = file.seek(offsets[TEXTURE]) && file.write(static_cast<const char*>(textureImage->GetScalarPointer()), bytes[TEXTURE]) == bytes[TEXTURE];
+  // pad the last block so that every mapped range lies inside the file
+  ok = ok && file.resize(offsets[TEXTURE] + bytes[TEXTURE]);
+  file.close();
+  if (!ok)
+  {
+    file.remove();
+    return false;
+  }
+  // replace the old cache only when the new one is complete
+  QFile::remove(cacheFile);
+  return file.rename(cacheFile);
+}
+
+bool MeshCache::read(const QString& cacheFile, const QString& sourceFile, QString& textureFile,
+                     std::vector<Material>& materials, vtkPolyData* (&polyData), vtkImageData* (&textureImage))
+{
+  QFileInfo source(sourceFile);
+  if (!source.exists() || !QFileInfo(cacheFile).isFile())
+    return false;
+
+  QFile* file = new QFile(cacheFile);
+  if (!file->open(QIODevice::ReadOnly))
+  {
+    delete file;
+    return false;
+  }
+
+  QByteArray head = file->read(MESHCACHE_PAGE);
+  QDataStream in(head);
+  in.setVersion(QDataStream::Qt_4_8);
+  quint32 magic = 0, version = 0, mtime = 0, textureMtime = 0;
+  qint64 sourceSize = 0, textureSize = 0, numPoints = 0, numPolys = 0;
+  qint32 texWidth = 0, texHeight = 0, texChannels = 0;
+  QString ltextureFile;
+  in >> magic >> version >> sourceSize >> mtime;
+  in >> ltextureFile >> textureSize >> textureMtime;
+  in >> numPoints >> numPolys;
+  in >> texWidth >> texHeight >> texChannels;
+  qint64 offsets[NUMBLOCKS], bytes[NUMBLOCKS];
+  for (int b = 0; b < NUMBLOCKS; b++)
+    in >> offsets[b] >> bytes[b];
+
+  // a changed mesh or texture file invalidates the cache
+  QFileInfo texture(ltextureFile);
+  bool valid = in.status() == QDataStream::Ok && magic == MESHCACHE_MAGIC && version == MESHCACHE_VERSION
+    && sourceSize == source.size() && mtime == source.lastModified().toTime_t()
+    && textureSize == (texture.exists() ? texture.size() : -1)
+    && textureMtime == (texture.exists() ? texture.lastModified().toTime_t() : 0)
+    && numPoints > 0 && numPolys >= 0
+    && bytes[POINTS] == numPoints * 3 * (qint64)sizeof(float)
+    && offsets[TEXTURE] + bytes[TEXTURE] <= file->size();
+  if (!valid)
+  {
+    delete file;
+    return false;
+  }
+
+  // the metadata may be longer than the first page if there are many materials
+  if (offsets[POINTS] > head.size())
+  {
+    file->seek(0);
+    head = file->read(offsets[POINTS]);
+  }
+  QDataStream tables(head);
+  tables.setVersion(QDataStream::Qt_4_8);
+  {
+    // skip to the material table by re-reading the fixed fields
+    quint32 u32;
+    qint64 i64;
+    qint32 i32;
+    QString str;
+    tables >> u32 >> u32 >> i64 >> u32 >> str >> i64 >> u32 >> i64 >> i64 >> i32 >> i32 >> i32;
+    for (int b = 0; b < 2 * NUMBLOCKS; b++)
+      tables >> i64;
+  }
+  qint32 materialSize = 0;
+  QByteArray materialBytes;
+  tables >> materialSize >> materialBytes;
+  if (tables.status() != QDataStream::Ok || materialSize != (qint32)sizeof(Material) || materialBytes.size() % sizeof(Material) != 0)
+  {
+    delete file;
+    return false;
+  }
+
+  uchar* blocks[NUMBLOCKS];
+  bool mapped = true;
+  for (int b = 0; b < NUMBLOCKS; b++)
+  {
+    blocks[b] = NULL;
+    if (bytes[b] > 0 && b != TEXTURE)
+    {
+      blocks[b] = file->map(offsets[b], bytes[b]);
+      mapped = mapped && blocks[b];
+    }
+  }
+  if (!mapped)
+  {
+    delete file; // also unmaps
+    return false;
+  }
+
+  MeshCacheMapping* mapping = new MeshCacheMapping;
+  mapping->file = file;
+  mapping->refs = 1; // held by this function until the arrays are attached
+
+  polyData = vtkPolyData::New();
+
+  // geometry: no copy, the arrays point into the mapping and do not free it
+  vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+  pointArray->SetNumberOfComponents(3);
+  pointArray->SetArray(reinterpret_cast<float*>(blocks[POINTS]), numPoints * 3, 1);
+  attachMapping(pointArray, mapping);
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetData(pointArray);
+  polyData->SetPoints(points);
+
+  vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  const vtkIdType numIds = bytes[POLYS] / sizeof(qint64);
+  if (sizeof(vtkIdType) == sizeof(qint64) && numIds > 0)
+  {
+    connectivity->SetArray(reinterpret_cast<vtkIdType*>(blocks[POLYS]), numIds, 1);
+    attachMapping(connectivity, mapping);
+  }
+  else if (numIds > 0)
+  {
+    connectivity->SetNumberOfValues(numIds);
+    const qint64* ids = reinterpret_cast<const qint64*>(blocks[POLYS]);
+    for (vtkIdType k = 0; k < numIds; k++)
+      connectivity->SetValue(k, static_cast<vtkIdType>(ids[k]));
+  }
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->SetCells(numPolys, connectivity);
+  polyData->SetPolys(polys);
+
+  if (blocks[TCOORDS])
+  {
+    vtkSmartPointer<vtkFloatArray> tcoords = vtkSmartPointer<vtkFloatArray>::New();
+    tcoords->SetNumberOfComponents(2);
+    tcoords->SetArray(reinterpret_cast<float*>(blocks[TCOORDS]), numPoints * 2, 1);
+    tcoords->SetName("TCoords");
+    attachMapping(tcoords, mapping);
+    polyData->GetPointData()->SetTCoords(tcoords);
+  }
+  if (blocks[NORMALS])
+  {
+    vtkSmartPointer<vtkFloatArray> normals = vtkSmartPointer<vtkFloatArray>::New();
+    normals->SetNumberOfComponents(3);
+    normals->SetArray(reinterpret_cast<float*>(blocks[NORMALS]), numPoints * 3, 1);
+    normals->SetName("Normals");
+    attachMapping(normals, mapping);
+    polyData->GetPointData()->SetNormals(normals);
+  }
+  if (blocks[COLORS])
+  {
+    vtkSmartPointer<vtkUnsignedCharArray> colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetNumberOfComponents(3);
+    colors->SetArray(blocks[COLORS], numPoints * 3, 1);
+    colors->SetName("RGB");
+    attachMapping(colors, mapping);
+    polyData->GetPointData()->SetScalars(colors);
+  }
+
+  // texture: copied so that it can be modified (flipped, blended)
+  textureImage = NULL;
+  if (bytes[TEXTURE] > 0 && bytes[TEXTURE] == (qint64)texWidth * texHeight * texChannels)
+  {
+    textureImage = vtkImageData::New();
+    textureImage->SetDimensions(texWidth, texHeight, 1);
+    textureImage->SetScalarTypeToUnsignedChar();
+    textureImage->SetNumberOfScalarComponents(texChannels);
+    textureImage->AllocateScalars();
+    uchar* pixels = file->map(offsets[TEXTURE], bytes[TEXTURE]);
+    if (pixels)
+    {
+      memcpy(textureImage->GetScalarPointer(), pixels, bytes[TEXTURE]);
+      file->unmap(pixels);
+    }
+    else
+    {
+      file->seek(offsets[TEXTURE]);
+      file->read(static_cast<char*>(textureImage->GetScalarPointer()), bytes[TEXTURE]);
+    }
+  }
+
+  // drop this function's reference; the file stays open while any mapped array is alive
+  releaseMapping(NULL, 0, mapping, NULL);
+
+  textureFile = ltextureFile;
+  const Material* material = reinterpret_cast<const Material*>(materialBytes.constData());
+  materials.assign(material, material + materialBytes.size() / sizeof(Material));
+  return true;
+}
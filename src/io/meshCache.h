@@ -0,0 +1,57 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <vector>
+#include <QString>
+
+class vtkPolyData;
+class vtkImageData;
+struct Material;
+
+// Binary sidecar of a loaded 3D object, kept in the object's project folder.
+// Layout: one metadata block (source and texture size/mtime, materials, counts) followed by
+// page-aligned blocks for the points, the polygon connectivity, the texture coordinates,
+// the point normals, the point colours and the decoded 8-bit texture.
+// On reopen the geometry arrays point straight into a read-only mapping of the file, which is
+// released when the last of them is deleted. Meshes with data the cache does not describe
+// (lines, strips, cell attributes, ...) are not cached.
+class MeshCache
+{
+public:
+  // <folder>/<source file name>.mesh
+  static QString cacheFileName(const QString& folder, const QString& sourceFile);
+
+  // textureImage may be NULL (no texture, or an EXR texture that has its own cube cache)
+  static bool write(const QString& cacheFile, const QString& sourceFile, const QString& textureFile,
+                    const std::vector<Material>& materials, vtkPolyData* polyData, vtkImageData* textureImage);
+
+  // returns false (and leaves the outputs untouched) if the cache is missing or does not match
+  // the source or texture file; textureImage is NULL if no texture was cached
+  static bool read(const QString& cacheFile, const QString& sourceFile, QString& textureFile,
+                   std::vector<Material>& materials, vtkPolyData* (&polyData), vtkImageData* (&textureImage));
+};
+
+#endif // MESHCACHE_H
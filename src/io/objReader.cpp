@@ -0,0 +1,513 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#include <QFile>
+#include <omp.h>
+
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+#include "objReader.h"
+
+#define OBJ_MISSING (INT_MIN)        // corner without vt/vn
+#define OBJ_CHUNK_BYTES (1 << 22)     // 4 MB per parallel chunk at least
+#define OBJ_RELATIVE_V (1)           // corner flags for negative (relative) indices
+#define OBJ_RELATIVE_VT (2)
+#define OBJ_RELATIVE_VN (4)
+
+namespace {
+
+// everything one chunk of the file contributes; indices are 0-based, global unless flagged relative
+struct ObjChunk
+{
+  std::vector<float> v, vt, vn;
+  std::vector<int> faceSizes, faceV, faceT, faceN;
+  std::vector<int> lineSizes, lineV;
+  std::vector<unsigned char> relative; // per face corner, allocated on the first negative index
+  std::vector<unsigned char> lineRelative; // per line vertex
+  std::vector<std::string> materialLibraries, materialNames;
+  bool hasT, hasN;
+
+  ObjChunk() : hasT(false), hasN(false) {}
+
+  void markRelative(int flag)
+  {
+    if (relative.empty())
+      relative.assign(faceV.size(), 0);
+    relative.back() |= flag;
+  }
+};
+
+static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool isBlank(char c) {return c == ' ' || c == '\t' || c == '\r';}
+inline bool isDigit(char c) {return c >= '0' && c <= '9';}
+
+// strtod without locale and without the generality; NULL if there is no number
+inline const char* parseFloat(const char* p, const char* end, float& value)
+{
+  while (p < end && isBlank(*p)) p++;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+  double mantissa = 0.;
+  int exponent = 0, digits = 0;
+  for (; p < end && isDigit(*p); p++, digits++)
+    mantissa = mantissa * 10. + (*p - '0');
+  if (p < end && *p == '.')
+    for (p++; p < end && isDigit(*p); p++, digits++, exponent--)
+      mantissa = mantissa * 10. + (*p - '0');
+  if (digits == 0)
+    return NULL;
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    const char* q = p + 1;
+    bool negativeExp = false;
+    if (q < end && (*q == '-' || *q == '+')) negativeExp = (*q++ == '-');
+    if (q < end && isDigit(*q))
+    {
+      int e = 0;
+      for (; q < end && isDigit(*q); q++)
+        e = std::min(e * 10 + (*q - '0'), 1000);
+      exponent += negativeExp ? -e : e;
+      p = q;
+    }
+  }
+  if (exponent != 0)
+  {
+    int magnitude = exponent < 0 ? -exponent : exponent;
+    double scale = magnitude <= 22 ? kPow10[magnitude] : std::pow(10., magnitude);
+    mantissa = exponent < 0 ? mantissa / scale : mantissa * scale;
+  }
+  value = (float)(negative ? -mantissa : mantissa);
+  return p;
+}
+
+inline const char* parseInt(const char* p, const char* end, int& value)
+{
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+  if (p >= end || !isDigit(*p))
+    return NULL;
+  int n = 0;
+  for (; p < end && isDigit(*p); p++)
+    n = n * 10 + (*p - '0');
+  value = negative ? -n : n;
+  return p;
+}
+
+// 1-based or negative OBJ index -> 0-based; negative ones are relative to the count so far
+inline int resolveIndex(int index, int localCount, bool& isRelative)
+{
+  isRelative = index < 0;
+  return isRelative ? localCount + index : index - 1;
+}
+
+inline std::string restOfLine(const char* p, const char* end)
+{
+  while (p < end && isBlank(*p)) p++;
+  while (end > p && isBlank(end[-1])) end--;
+  return std::string(p, end);
+}
+
+void parseChunk(const char* p, const char* end, ObjChunk& chunk)
+{
+  while (p < end)
+  {
+    const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (!lineEnd) lineEnd = end;
+    while (p < lineEnd && isBlank(*p)) p++;
+
+    if (p + 1 < lineEnd && p[0] == 'v')
+    {
+      float x[3] = {0.f, 0.f, 0.f};
+      if (isBlank(p[1]))
+      {
+        const char* q = p + 1;
+        for (int k = 0; k < 3 && q; k++) q = parseFloat(q, lineEnd, x[k]);
+        chunk.v.insert(chunk.v.end(), x, x + 3);
+      }
+      else if (p[1] == 't')
+      {
+        const char* q = p + 2;
+        for (int k = 0; k < 2 && q; k++) q = parseFloat(q, lineEnd, x[k]);
+        chunk.vt.insert(chunk.vt.end(), x, x + 2);
+      }
+      else if (p[1] == 'n')
+      {
+        const char* q = p + 2;
+        for (int k = 0; k < 3 && q; k++) q = parseFloat(q, lineEnd, x[k]);
+        chunk.vn.insert(chunk.vn.end(), x, x + 3);
+      }
+    }
+    else if (p + 1 < lineEnd && (p[0] == 'f' || p[0] == 'l') && isBlank(p[1]))
+    {
+      bool isFace = p[0] == 'f';
+      const char* q = p + 1;
+      int corners = 0;
+      const int localV = (int)chunk.v.size() / 3;
+      const int localT = (int)chunk.vt.size() / 2;
+      const int localN = (int)chunk.vn.size() / 3;
+      while (true)
+      {
+        while (q < lineEnd && isBlank(*q)) q++;
+        int index;
+        const char* r = parseInt(q, lineEnd, index);
+        if (!r) break;
+        bool isRelative;
+        int iv = resolveIndex(index, localV, isRelative), it = OBJ_MISSING, in = OBJ_MISSING;
+        bool relT = false, relN = false;
+        if (r < lineEnd && *r == '/')
+        {
+          r++;
+          const char* s = parseInt(r, lineEnd, index);
+          if (s) { it = resolveIndex(index, localT, relT); r = s; }
+          if (r < lineEnd && *r == '/')
+          {
+            r++;
+            s = parseInt(r, lineEnd, index);
+            if (s) { in = resolveIndex(index, localN, relN); r = s; }
+          }
+        }
+        while (r < lineEnd && !isBlank(*r)) r++; // tolerate anything else glued to the token
+        q = r;
+
+        if (isFace)
+        {
+          chunk.faceV.push_back(iv);
+          chunk.faceT.push_back(it);
+          chunk.faceN.push_back(in);
+          if (!chunk.relative.empty()) chunk.relative.push_back(0);
+          if (isRelative) chunk.markRelative(OBJ_RELATIVE_V);
+          if (relT) chunk.markRelative(OBJ_RELATIVE_VT);
+          if (relN) chunk.markRelative(OBJ_RELATIVE_VN);
+          chunk.hasT = chunk.hasT || it != OBJ_MISSING;
+          chunk.hasN = chunk.hasN || in != OBJ_MISSING;
+        }
+        else
+        {
+          chunk.lineV.push_back(iv);
+          chunk.lineRelative.push_back(isRelative ? 1 : 0);
+        }
+        corners++;
+      }
+      if (isFace && corners > 0)
+        chunk.faceSizes.push_back(corners);
+      else if (!isFace && corners > 0)
+        chunk.lineSizes.push_back(corners);
+    }
+    else if (lineEnd - p > 7 && strncmp(p, "usemtl", 6) == 0 && isBlank(p[6]))
+    {
+      chunk.materialNames.push_back(restOfLine(p + 7, lineEnd));
+    }
+    else if (lineEnd - p > 7 && strncmp(p, "mtllib", 6) == 0 && isBlank(p[6]))
+    {
+      chunk.materialLibraries.push_back(restOfLine(p + 7, lineEnd));
+    }
+    p = lineEnd + 1;
+  }
+}
+
+} // namespace
+
+ObjReader::ObjReader()
+{
+  mOutput = NULL;
+}
+
+ObjReader::~ObjReader()
+{
+  if (mOutput)
+    mOutput->Delete();
+}
+
+vtkPolyData* ObjReader::getOutput()
+{
+  vtkPolyData* output = mOutput;
+  mOutput = NULL;
+  return output;
+}
+
+bool ObjReader::read(const QString& filename)
+{
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly) || file.size() <= 0)
+    return false;
+  const qint64 size = file.size();
+  const char* data = reinterpret_cast<const char*>(file.map(0, size));
+  if (!data)
+    return false;
+  const char* dataEnd = data + size;
+
+  //------------------------------------------------------------------
+  // cut the file into line aligned chunks and parse them in parallel
+  const int numProcs = omp_get_num_procs();
+  int numChunks = (int)std::min<qint64>(std::max<qint64>(size / OBJ_CHUNK_BYTES, 1), numProcs * 8);
+  std::vector<const char*> bounds(numChunks + 1);
+  bounds[0] = data;
+  for (int c = 1; c < numChunks; c++)
+  {
+    const char* cut = std::max(data + size * c / numChunks, bounds[c - 1]);
+    const char* eol = static_cast<const char*>(memchr(cut, '\n', dataEnd - cut));
+    bounds[c] = eol ? eol + 1 : dataEnd;
+  }
+  bounds[numChunks] = dataEnd;
+
+  std::vector<ObjChunk> chunks(numChunks);
+  int c = 0;
+  omp_set_num_threads(numProcs);
+  #pragma omp parallel for private(c) schedule(dynamic, 1)
+  for (c = 0; c < numChunks; c++)
+    parseChunk(bounds[c], bounds[c + 1], chunks[c]);
+
+  file.unmap(const_cast<uchar*>(reinterpret_cast<const uchar*>(data)));
+  file.close();
+
+  //------------------------------------------------------------------
+  // chunk offsets
+  std::vector<int> offV(numChunks + 1, 0), offT(numChunks + 1, 0), offN(numChunks + 1, 0);
+  std::vector<vtkIdType> offFace(numChunks + 1, 0), offCorner(numChunks + 1, 0), offLine(numChunks + 1, 0), offLineV(numChunks + 1, 0);
+  bool hasT = false, hasN = false;
+  mMaterialLibrary.clear();
+  mMaterialNames.clear();
+  for (c = 0; c < numChunks; c++)
+  {
+    const ObjChunk& chunk = chunks[c];
+    offV[c + 1] = offV[c] + (int)chunk.v.size() / 3;
+    offT[c + 1] = offT[c] + (int)chunk.vt.size() / 2;
+    offN[c + 1] = offN[c] + (int)chunk.vn.size() / 3;
+    offFace[c + 1] = offFace[c] + (vtkIdType)chunk.faceSizes.size();
+    offCorner[c + 1] = offCorner[c] + (vtkIdType)chunk.faceV.size();
+    offLine[c + 1] = offLine[c] + (vtkIdType)chunk.lineSizes.size();
+    offLineV[c + 1] = offLineV[c] + (vtkIdType)chunk.lineV.size();
+    hasT = hasT || chunk.hasT;
+    hasN = hasN || chunk.hasN;
+    if (mMaterialLibrary.empty() && !chunk.materialLibraries.empty())
+      mMaterialLibrary = chunk.materialLibraries[0];
+    mMaterialNames.insert(mMaterialNames.end(), chunk.materialNames.begin(), chunk.materialNames.end());
+  }
+  const int numV = offV[numChunks], numT = offT[numChunks], numN = offN[numChunks];
+  const vtkIdType numFaces = offFace[numChunks], numCorners = offCorner[numChunks];
+  const vtkIdType numLines = offLine[numChunks], numLineV = offLineV[numChunks];
+  if (numV == 0 || (numFaces == 0 && numLines == 0))
+    return false;
+
+  //------------------------------------------------------------------
+  // make the indices global, validate them and compare vt/vn with v indices
+  int numInvalid = 0, numTDiffer = 0, numNDiffer = 0;
+  #pragma omp parallel for private(c) schedule(dynamic, 1) reduction(+:numInvalid,numTDiffer,numNDiffer)
+  for (c = 0; c < numChunks; c++)
+  {
+    ObjChunk& chunk = chunks[c];
+    const int n = (int)chunk.faceV.size();
+    for (int i = 0; i < n; i++)
+    {
+      int flags = chunk.relative.empty() ? 0 : chunk.relative[i];
+      int& iv = chunk.faceV[i];
+      int& it = chunk.faceT[i];
+      int& in = chunk.faceN[i];
+      iv += (flags & OBJ_RELATIVE_V) ? offV[c] : 0;
+      if (it != OBJ_MISSING && (flags & OBJ_RELATIVE_VT)) it += offT[c];
+      if (in != OBJ_MISSING && (flags & OBJ_RELATIVE_VN)) in += offN[c];
+      if (iv < 0 || iv >= numV || (it != OBJ_MISSING && (it < 0 || it >= numT)) || (in != OBJ_MISSING && (in < 0 || in >= numN)))
+        numInvalid++;
+      if (hasT && it != iv) numTDiffer++;
+      if (hasN && in != iv) numNDiffer++;
+    }
+    for (unsigned int i = 0; i < chunk.lineV.size(); i++)
+    {
+      int& iv = chunk.lineV[i];
+      if (chunk.lineRelative[i]) iv += offV[c];
+      if (iv < 0 || iv >= numV)
+        numInvalid++;
+    }
+  }
+  if (numInvalid > 0)
+    return false;
+
+  //------------------------------------------------------------------
+  // VTK arrays, filled chunk by chunk without intermediate copies
+  const bool shared = (!hasT || (numTDiffer == 0 && numT >= numV)) && (!hasN || (numNDiffer == 0 && numN >= numV));
+  const vtkIdType numPoints = shared ? numV : numCorners + numLineV;
+
+  vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+  pointArray->SetNumberOfComponents(3);
+  pointArray->SetNumberOfTuples(numPoints);
+  float* pts = pointArray->GetPointer(0);
+
+  vtkSmartPointer<vtkFloatArray> tcoords;
+  vtkSmartPointer<vtkFloatArray> normals;
+  float* tc = NULL;
+  float* nm = NULL;
+  if (hasT)
+  {
+    tcoords = vtkSmartPointer<vtkFloatArray>::New();
+    tcoords->SetNumberOfComponents(2);
+    tcoords->SetNumberOfTuples(numPoints);
+    tcoords->SetName("TCoords");
+    tc = tcoords->GetPointer(0);
+    std::fill(tc, tc + 2 * numPoints, 0.f);
+  }
+  if (hasN)
+  {
+    normals = vtkSmartPointer<vtkFloatArray>::New();
+    normals->SetNumberOfComponents(3);
+    normals->SetNumberOfTuples(numPoints);
+    normals->SetName("Normals");
+    nm = normals->GetPointer(0);
+    std::fill(nm, nm + 3 * numPoints, 0.f);
+  }
+
+  vtkSmartPointer<vtkIdTypeArray> polyIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  polyIds->SetNumberOfValues(numFaces + numCorners);
+  vtkIdType* polyPtr = polyIds->GetPointer(0);
+  vtkSmartPointer<vtkIdTypeArray> lineIds = vtkSmartPointer<vtkIdTypeArray>::New();
+  lineIds->SetNumberOfValues(numLines + numLineV);
+  vtkIdType* linePtr = numLines > 0 ? lineIds->GetPointer(0) : NULL;
+
+  // in the shared case vt/vn are gathered by vertex index, which needs all chunks; collect them here
+  std::vector<float> allT, allN;
+  if (shared && hasT)
+  {
+    allT.reserve(2 * numT);
+    for (c = 0; c < numChunks; c++) allT.insert(allT.end(), chunks[c].vt.begin(), chunks[c].vt.end());
+  }
+  if (shared && hasN)
+  {
+    allN.reserve(3 * numN);
+    for (c = 0; c < numChunks; c++) allN.insert(allN.end(), chunks[c].vn.begin(), chunks[c].vn.end());
+  }
+  std::vector<float> allV;
+  if (!shared)
+  {
+    allV.reserve(3 * (size_t)numV);
+    allT.reserve(2 * (size_t)numT);
+    allN.reserve(3 * (size_t)numN);
+    for (c = 0; c < numChunks; c++)
+    {
+      allV.insert(allV.end(), chunks[c].v.begin(), chunks[c].v.end());
+      allT.insert(allT.end(), chunks[c].vt.begin(), chunks[c].vt.end());
+      allN.insert(allN.end(), chunks[c].vn.begin(), chunks[c].vn.end());
+    }
+  }
+
+  #pragma omp parallel for private(c) schedule(dynamic, 1)
+  for (c = 0; c < numChunks; c++)
+  {
+    ObjChunk& chunk = chunks[c];
+
+    // cells
+    vtkIdType* cell = polyPtr + offFace[c] + offCorner[c];
+    vtkIdType corner = offCorner[c];
+    for (unsigned int f = 0, i = 0; f < chunk.faceSizes.size(); f++)
+    {
+      *cell++ = chunk.faceSizes[f];
+      for (int k = 0; k < chunk.faceSizes[f]; k++, i++, corner++)
+        *cell++ = shared ? chunk.faceV[i] : corner;
+    }
+    if (linePtr)
+    {
+      vtkIdType* line = linePtr + offLine[c] + offLineV[c];
+      vtkIdType lineCorner = numCorners + offLineV[c];
+      for (unsigned int l = 0, i = 0; l < chunk.lineSizes.size(); l++)
+      {
+        *line++ = chunk.lineSizes[l];
+        for (int k = 0; k < chunk.lineSizes[l]; k++, i++, lineCorner++)
+          *line++ = shared ? chunk.lineV[i] : lineCorner;
+      }
+    }
+
+    if (shared)
+    {
+      if (!chunk.v.empty())
+        memcpy(pts + 3 * (size_t)offV[c], &chunk.v[0], chunk.v.size() * sizeof(float));
+      if (tc && !allT.empty())
+      {
+        int vEnd = std::min(offV[c + 1], numT);
+        for (int i = offV[c]; i < vEnd; i++) { tc[2 * i] = allT[2 * i]; tc[2 * i + 1] = allT[2 * i + 1]; }
+      }
+      if (nm && !allN.empty())
+      {
+        int vEnd = std::min(offV[c + 1], numN);
+        for (int i = offV[c]; i < vEnd; i++) for (int k = 0; k < 3; k++) nm[3 * i + k] = allN[3 * i + k];
+      }
+    }
+    else
+    {
+      // every face corner (and line vertex) is a point of its own
+      for (unsigned int i = 0; i < chunk.faceV.size(); i++)
+      {
+        size_t p = offCorner[c] + i;
+        for (int k = 0; k < 3; k++) pts[3 * p + k] = allV[3 * (size_t)chunk.faceV[i] + k];
+        if (tc && chunk.faceT[i] != OBJ_MISSING) { tc[2 * p] = allT[2 * (size_t)chunk.faceT[i]]; tc[2 * p + 1] = allT[2 * (size_t)chunk.faceT[i] + 1]; }
+        if (nm && chunk.faceN[i] != OBJ_MISSING) for (int k = 0; k < 3; k++) nm[3 * p + k] = allN[3 * (size_t)chunk.faceN[i] + k];
+      }
+      for (unsigned int i = 0; i < chunk.lineV.size(); i++)
+      {
+        size_t p = numCorners + offLineV[c] + i;
+        for (int k = 0; k < 3; k++) pts[3 * p + k] = allV[3 * (size_t)chunk.lineV[i] + k];
+      }
+    }
+    // release the chunk as soon as it has been copied
+    std::vector<float>().swap(chunk.v);
+    std::vector<int>().swap(chunk.faceV);
+    std::vector<int>().swap(chunk.faceT);
+    std::vector<int>().swap(chunk.faceN);
+  }
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetData(pointArray);
+
+  if (mOutput)
+    mOutput->Delete();
+  mOutput = vtkPolyData::New();
+  mOutput->SetPoints(points);
+  if (numFaces > 0)
+  {
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells(numFaces, polyIds);
+    mOutput->SetPolys(polys);
+  }
+  if (numLines > 0)
+  {
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells(numLines, lineIds);
+    mOutput->SetLines(lines);
+  }
+  if (tcoords)
+    mOutput->GetPointData()->SetTCoords(tcoords);
+  if (normals)
+    mOutput->GetPointData()->SetNormals(normals);
+  return true;
+}
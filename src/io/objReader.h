@@ -0,0 +1,61 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <vector>
+#include <string>
+#include <QString>
+
+class vtkPolyData;
+
+// Single-pass Wavefront OBJ reader for very large (multi GB) photogrammetry meshes.
+// The file is memory-mapped and cut into line-aligned chunks that are parsed in parallel
+// (v, vt, vn, f, l and the mtllib/usemtl material references); the chunk results are then
+// concatenated straight into the VTK arrays. Like vtkOBJReader, if the texture coordinate or
+// normal indices of the faces differ from the vertex indices, every face corner becomes its
+// own point.
+class ObjReader
+{
+public:
+  ObjReader();
+  ~ObjReader();
+
+  // false if the file cannot be mapped (e.g. 32 bit address space) or has no geometry
+  bool read(const QString& filename);
+
+  // the caller takes ownership
+  vtkPolyData* getOutput();
+  // first mtllib of the file, empty if none
+  std::string getMaterialLibrary() const {return mMaterialLibrary;}
+  // usemtl names in order of appearance
+  const std::vector<std::string>& getMaterialNames() const {return mMaterialNames;}
+
+private:
+  vtkPolyData* mOutput;
+  std::string mMaterialLibrary;
+  std::vector<std::string> mMaterialNames;
+};
+
+#endif // OBJREADER_H
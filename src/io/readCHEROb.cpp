@@ -58,6 +58,9 @@
 #include <vtkRenderer.h>
 #include <vtkMapper.h>
 #include "vtkOpenEXR.h"
+#include "hyperCubeCache.h"
+#include "meshCache.h"
+#include "objReader.h"
 
 #include "../mainWindow.h"
 
@@ -91,6 +94,38 @@ bool ReadCHEROb::read3D(QString filename, std::vector<std::string> &channelnames
 
   //qDebug() << "file name: " << filename;
 
+  // decoded mesh and texture from a previous open, memory-mapped
+  QString cacheFile;
+  if (!mCacheFolder.isEmpty())
+  {
+    cacheFile = MeshCache::cacheFileName(mCacheFolder, filename);
+    QString texturefilename;
+    vtkImageData* textureImage = NULL;
+    if (MeshCache::read(cacheFile, filename, texturefilename, materials, polyData, textureImage))
+    {
+      if (textureImage)
+      {
+        rgbTexture = vtkTexture::New();
+        rgbTexture->SetInputConnection(textureImage->GetProducerPort());
+        textureImage->Delete(); // held by the texture pipeline
+        hyperImageData = vtkImageData::New();
+        isTextureOn = true;
+      }
+      else if (!texturefilename.isEmpty())
+      {
+        // EXR textures come from their own cube cache
+        readATexture(texturefilename, channelnames, wavelengths, rgbTexture, hyperImageData, isTextureOn);
+      }
+      else
+      {
+        isTextureOn = false;
+      }
+      if (isTextureOn)
+        texturefilenameout = texturefilename;
+      return true;
+    }
+  }
+
   if (extension==tr("obj")) {
     if (!readOBJ(filename, channelnames, wavelengths, texturefilenameout, materials, polyData, rgbTexture, hyperImageData, isTextureOn)) return false;
   }
@@ -105,6 +140,14 @@ bool ReadCHEROb::read3D(QString filename, std::vector<std::string> &channelnames
     return false;
   }
 
+  if (!cacheFile.isEmpty() && QDir().mkpath(mCacheFolder))
+  {
+    vtkImageData* textureImage = NULL;
+    if (isTextureOn && rgbTexture && QFileInfo(texturefilenameout).suffix().toLower() != tr("exr"))
+      textureImage = rgbTexture->GetInput();
+    MeshCache::write(cacheFile, filename, isTextureOn ? texturefilenameout : QString(), materials, polyData, textureImage);
+  }
+
 //#define _DEBUG // not oK
 //#ifdef _DEBUG
 //vtkSmartPointer<vtkImageData> outputrgb = vtkImageData::SafeDownCast(rgbTexture->GetInput());
@@ -216,21 +259,34 @@ bool ReadCHEROb::readOBJ(QString objfilename, std::vector<std::string> &channeln
   std::string fnstr = objfilename.toLocal8Bit().constData(); // QString -> Std. String
 //  const char *filenamesc = fnstr.c_str();
 
-  // read the obj file (only for vertex and index) - default support from Vtk
-  vtkSmartPointer<vtkOBJReader> reader = vtkSmartPointer<vtkOBJReader>::New();
-  reader->SetFileName(fnstr.c_str());
-  reader->Update();
-
-  // sending vertex and face to the polydata
-  polyData = vtkPolyData::New();
-  polyData->DeepCopy(reader->GetOutput());
-
   // making mtl path
   // parse filename
   QString path =  fi.dir().path() + "/";
   QString mtlfilenamein;
+  bool hasMtllib = false;
+
+  // native reader: one parallel pass over the memory-mapped file, including the mtllib line
+  ObjReader objReader;
+  if (objReader.read(objfilename))
+  {
+    polyData = objReader.getOutput();
+    mtlfilenamein = QString::fromLocal8Bit(objReader.getMaterialLibrary().c_str());
+    hasMtllib = !mtlfilenamein.isEmpty();
+  }
+  else
+  {
+    // read the obj file (only for vertex and index) - default support from Vtk
+    vtkSmartPointer<vtkOBJReader> reader = vtkSmartPointer<vtkOBJReader>::New();
+    reader->SetFileName(fnstr.c_str());
+    reader->Update();
+
+    // sending vertex and face to the polydata
+    polyData = vtkPolyData::New();
+    polyData->DeepCopy(reader->GetOutput());
+    hasMtllib = parseOBJ(objfilename, mtlfilenamein);
+  }
 
-  if (parseOBJ(objfilename, mtlfilenamein))
+  if (hasMtllib)
   {
     QFileInfo mtlfn1(mtlfilenamein);
     QString mtlfilename = path + mtlfn1.fileName();
@@ -496,6 +552,19 @@ bool ReadCHEROb::readEXR(QString filename, std::vector<std::string> &channelname
     return false;
   }
 
+  // decoded cube from a previous open, memory-mapped
+  QString cacheFile;
+  if (!mCacheFolder.isEmpty())
+  {
+    cacheFile = HyperCubeCache::cacheFileName(mCacheFolder, filename);
+    if (HyperCubeCache::read(cacheFile, filename, hyperImageData, rgbImageData, wavelengths, channelnames))
+    {
+      rgbTexture = vtkTexture::New();
+      rgbTexture->SetInputConnection(rgbImageData->GetProducerPort());
+      return true;
+    }
+  }
+
   std::string fnstr = filename.toLocal8Bit().constData(); // QString -> Std. String
 //  const char *filenamesc = fnstr.c_str();
 
@@ -857,6 +926,9 @@ bool ReadCHEROb::readEXR(QString filename, std::vector<std::string> &channelname
 
     rgbTexture = vtkTexture::New();
     rgbTexture->SetInputConnection(rgbImageData->GetProducerPort());
+
+    if (!cacheFile.isEmpty() && QDir().mkpath(mCacheFolder))
+      HyperCubeCache::write(cacheFile, filename, hyperImageData, rgbImageData, wavelengths, channelnames);
     //  rgbTexture->SetInput(rgbImageData);
     //  rgbTexture->Update(); //vtkOpenGLTexture (0x10a3710c0): Definition of Execute() method should be in subclass and you should really use the ExecuteData(vtkInformation *request,...) signature instead
 
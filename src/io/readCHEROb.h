@@ -25,6 +25,7 @@
 #define READCHEROb_H
 
 #include <QObject>
+#include <QString>
 
 #include <vtkPolyData.h>
 #include <vtkTexture.h>
@@ -80,6 +81,9 @@ public:
 
   bool readEXR(QString filename, std::vector<std::string> &channelnames, std::vector<float> &wavelengths, vtkTexture *(&rgbTexture), vtkImageData* (&rgbImageData), vtkImageData *(&hyperImageData) );
 
+  // folder for the mesh and decoded EXR cube caches (the object's project folder); empty disables the caches
+  void setCacheFolder(QString folder) {mCacheFolder = folder;}
+
 protected:
   // for VRML parser
   int readNextToken(FILE *f, char *s);
@@ -116,6 +120,7 @@ protected:
 
 private:  
 //  std::vector<std::string> mChannelNames;
+  QString mCacheFolder;
 };
 
 
@@ -57,8 +57,20 @@
 #include <vtkSmartPointer.h>
 #include <vtkSortDataArray.h>
 
+#include <vtkIdTypeArray.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <QFile>
+#include <omp.h>
+
 #include <ctype.h>
+#include <limits.h>
 #include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
 
 vtkStandardNewMacro(vtkPLYReader2)
 
@@ -97,6 +109,153 @@ typedef struct _plyFace {
   float *tcoords; //MK: texture coordinates (number of tcoords (two column vectors) is same as number of vertexes)
 } plyFace;
 
+//----------------------------------------------------------------------------
+// Binary fast path
+//----------------------------------------------------------------------------
+namespace
+{
+enum PlyBinaryType {PLYB_INVALID = 0, PLYB_INT8, PLYB_UINT8, PLYB_INT16, PLYB_UINT16,
+                    PLYB_INT32, PLYB_UINT32, PLYB_FLOAT32, PLYB_FLOAT64};
+
+struct PlyBinaryProperty
+{
+  std::string name;
+  int type;       // item type
+  int size;       // item size in bytes
+  bool isList;
+  int countType;  // list count type
+  int countSize;
+  int offset;     // byte offset within the record (scalars before the first list only)
+};
+
+struct PlyBinaryElement
+{
+  std::string name;
+  vtkIdType count;
+  std::vector<PlyBinaryProperty> props;
+};
+
+int plyBinaryType(const std::string& name, int& size)
+{
+  if (name == "char" || name == "int8") {size = 1; return PLYB_INT8;}
+  if (name == "uchar" || name == "uint8") {size = 1; return PLYB_UINT8;}
+  if (name == "short" || name == "int16") {size = 2; return PLYB_INT16;}
+  if (name == "ushort" || name == "uint16") {size = 2; return PLYB_UINT16;}
+  if (name == "int" || name == "int32") {size = 4; return PLYB_INT32;}
+  if (name == "uint" || name == "uint32") {size = 4; return PLYB_UINT32;}
+  if (name == "float" || name == "float32") {size = 4; return PLYB_FLOAT32;}
+  if (name == "double" || name == "float64") {size = 8; return PLYB_FLOAT64;}
+  size = 0;
+  return PLYB_INVALID;
+}
+
+// unaligned little-endian reads (the host byte order is checked before use)
+inline vtkIdType plyReadInteger(const char* p, int type)
+{
+  switch (type)
+    {
+    case PLYB_INT8: return *reinterpret_cast<const signed char*>(p);
+    case PLYB_UINT8: return *reinterpret_cast<const unsigned char*>(p);
+    case PLYB_INT16: {short v; memcpy(&v, p, 2); return v;}
+    case PLYB_UINT16: {unsigned short v; memcpy(&v, p, 2); return v;}
+    case PLYB_INT32: {int v; memcpy(&v, p, 4); return v;}
+    case PLYB_UINT32: {unsigned int v; memcpy(&v, p, 4); return static_cast<vtkIdType>(v);}
+    case PLYB_FLOAT32: {float v; memcpy(&v, p, 4); return static_cast<vtkIdType>(v);}
+    case PLYB_FLOAT64: {double v; memcpy(&v, p, 8); return static_cast<vtkIdType>(v);}
+    }
+  return 0;
+}
+
+inline float plyReadFloat(const char* p, int type)
+{
+  switch (type)
+    {
+    case PLYB_FLOAT32: {float v; memcpy(&v, p, 4); return v;}
+    case PLYB_FLOAT64: {double v; memcpy(&v, p, 8); return static_cast<float>(v);}
+    }
+  return static_cast<float>(plyReadInteger(p, type));
+}
+
+// Parses the ASCII header; false if it is not a binary little-endian file.
+bool plyParseBinaryHeader(const char* data, qint64 size, qint64& headerSize, std::vector<PlyBinaryElement>& elements)
+{
+  const char* end = data + std::min(size, (qint64)65536);
+  const char* line = data;
+  bool binaryLittleEndian = false;
+  while (line < end)
+    {
+    const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!eol)
+      return false;
+    std::string text(line, eol);
+    if (!text.empty() && text[text.size() - 1] == '\r')
+      text.erase(text.size() - 1);
+    line = eol + 1;
+
+    std::istringstream in(text);
+    std::string keyword;
+    in >> keyword;
+    if (keyword == "format")
+      {
+      std::string format;
+      in >> format;
+      binaryLittleEndian = (format == "binary_little_endian");
+      }
+    else if (keyword == "element")
+      {
+      PlyBinaryElement element;
+      long long count = -1;
+      in >> element.name >> count;
+      if (in.fail() || count < 0)
+        return false;
+      element.count = static_cast<vtkIdType>(count);
+      elements.push_back(element);
+      }
+    else if (keyword == "property")
+      {
+      if (elements.empty())
+        return false;
+      PlyBinaryProperty prop;
+      std::string type;
+      in >> type;
+      prop.isList = (type == "list");
+      prop.countType = PLYB_INVALID;
+      prop.countSize = 0;
+      prop.offset = -1;
+      if (prop.isList)
+        {
+        std::string countType;
+        in >> countType >> type;
+        prop.countType = plyBinaryType(countType, prop.countSize);
+        if (prop.countType == PLYB_INVALID || prop.countType == PLYB_FLOAT32 || prop.countType == PLYB_FLOAT64)
+          return false;
+        }
+      prop.type = plyBinaryType(type, prop.size);
+      in >> prop.name;
+      if (prop.type == PLYB_INVALID || in.fail())
+        return false;
+      elements.back().props.push_back(prop);
+      }
+    else if (keyword == "end_header")
+      {
+      headerSize = line - data;
+      return binaryLittleEndian;
+      }
+    }
+  return false;
+}
+
+const PlyBinaryProperty* plyFindProperty(const PlyBinaryElement& element, const char* name)
+{
+  for (size_t i = 0; i < element.props.size(); i++)
+    {
+    if (element.props[i].name == name)
+      return &element.props[i];
+    }
+  return NULL;
+}
+}
+
 int vtkPLYReader2::RequestData(
   vtkInformation *vtkNotUsed(request),
   vtkInformationVector **vtkNotUsed(inputVector),
@@ -150,6 +309,12 @@ int vtkPLYReader2::RequestData(
     return 0;
     }
 
+  // binary little-endian scans are decoded in bulk from a file mapping
+  if (this->RequestDataBinary(output))
+    {
+    return 1;
+    }
+
   // open a PLY file for reading
   PlyFile *ply;
   int nelems, fileType, numElems, nprops;
@@ -424,6 +589,367 @@ int vtkPLYReader2::RequestData(
   return 1;
 }
 
+int vtkPLYReader2::RequestDataBinary(vtkPolyData *output)
+{
+  const int one = 1;
+  if (*reinterpret_cast<const char*>(&one) != 1)
+    return 0;
+
+  QFile file(QString::fromLocal8Bit(this->FileName));
+  if (!file.open(QIODevice::ReadOnly))
+    return 0;
+  const qint64 size = file.size();
+  const char* data = reinterpret_cast<const char*>(file.map(0, size));
+  if (!data)
+    return 0;
+
+  // Only a vertex element followed by a face element is handled here; the
+  // vertex record must have fixed size and the face lists must be indices
+  // and (optionally) texcoord pairs.
+  qint64 headerSize = 0;
+  std::vector<PlyBinaryElement> elements;
+  if (!plyParseBinaryHeader(data, size, headerSize, elements) || elements.size() != 2 ||
+      elements[0].name != "vertex" || elements[1].name != "face")
+    return 0;
+  PlyBinaryElement& vertexElem = elements[0];
+  PlyBinaryElement& faceElem = elements[1];
+  const vtkIdType numPts = vertexElem.count;
+  const vtkIdType numPolys = faceElem.count;
+  if (numPts == 0 || numPts > INT_MAX || numPolys > INT_MAX)
+    return 0;
+
+  int stride = 0;
+  for (size_t p = 0; p < vertexElem.props.size(); p++)
+    {
+    if (vertexElem.props[p].isList)
+      return 0;
+    vertexElem.props[p].offset = stride;
+    stride += vertexElem.props[p].size;
+    }
+  int faceFixed = 0; // byte offsets of face scalars up to the first list
+  bool hasIndices = false;
+  for (size_t p = 0; p < faceElem.props.size(); p++)
+    {
+    PlyBinaryProperty& prop = faceElem.props[p];
+    if (prop.isList)
+      {
+      if (prop.name == "vertex_indices")
+        hasIndices = (prop.type != PLYB_FLOAT32 && prop.type != PLYB_FLOAT64);
+      else if (prop.name != "texcoord")
+        return 0;
+      faceFixed = -1;
+      }
+    else if (faceFixed >= 0)
+      {
+      prop.offset = faceFixed;
+      faceFixed += prop.size;
+      }
+    }
+  const PlyBinaryProperty* px = plyFindProperty(vertexElem, "x");
+  const PlyBinaryProperty* py = plyFindProperty(vertexElem, "y");
+  const PlyBinaryProperty* pz = plyFindProperty(vertexElem, "z");
+  if (!px || !py || !pz || !hasIndices)
+    return 0;
+  const PlyBinaryProperty* pred = plyFindProperty(vertexElem, "red");
+  const PlyBinaryProperty* pgreen = plyFindProperty(vertexElem, "green");
+  const PlyBinaryProperty* pblue = plyFindProperty(vertexElem, "blue");
+  const bool RGBPointsAvailable = (pred && pgreen && pblue);
+  const bool intensityAvailable = (plyFindProperty(faceElem, "intensity") != NULL);
+  const bool RGBCellsAvailable = (plyFindProperty(faceElem, "red") && plyFindProperty(faceElem, "green") && plyFindProperty(faceElem, "blue"));
+  const bool texcoordAvailable = (plyFindProperty(faceElem, "texcoord") != NULL);
+
+  const char* vertexData = data + headerSize;
+  const char* faceData = vertexData + (qint64)numPts * stride;
+  const char* dataEnd = data + size;
+  if (faceData > dataEnd)
+    return 0;
+
+  // Locate the face records. The common case is a file where every face
+  // has the same corner count: the record stride is taken from the first
+  // face and checked in parallel against the count fields of all others.
+  // Otherwise a serial pass over the counts records where each face starts.
+  const size_t numFaceProps = faceElem.props.size();
+  std::vector<int> listCount(numFaceProps, 0);
+  qint64 faceStride = 0;
+  if (numPolys > 0)
+    {
+    const char* p = faceData;
+    for (size_t q = 0; q < numFaceProps; q++)
+      {
+      const PlyBinaryProperty& prop = faceElem.props[q];
+      vtkIdType n = 1;
+      if (prop.isList)
+        {
+        if (p + prop.countSize > dataEnd)
+          return 0;
+        n = plyReadInteger(p, prop.countType);
+        p += prop.countSize;
+        if (n < 0 || n > INT_MAX)
+          return 0;
+        listCount[q] = static_cast<int>(n);
+        }
+      if (n > (dataEnd - p) / prop.size)
+        return 0;
+      p += n * prop.size;
+      }
+    faceStride = p - faceData;
+    }
+
+  int i;
+  bool uniform = (numPolys * faceStride <= dataEnd - faceData);
+  if (uniform && numPolys > 0)
+    {
+    int numMismatch = 0;
+    omp_set_num_threads(omp_get_num_procs());
+    #pragma omp parallel for private(i) schedule(static) reduction(+:numMismatch)
+    for (i = 0; i < numPolys; i++)
+      {
+      const char* p = faceData + i * faceStride;
+      for (size_t q = 0; q < numFaceProps; q++)
+        {
+        const PlyBinaryProperty& prop = faceElem.props[q];
+        if (prop.isList)
+          {
+          if (plyReadInteger(p, prop.countType) != listCount[q])
+            numMismatch++;
+          p += prop.countSize + listCount[q] * prop.size;
+          }
+        else
+          p += prop.size;
+        }
+      }
+    uniform = (numMismatch == 0);
+    }
+
+  std::vector<qint64> faceOffsets;  // file offset of each face (non-uniform only)
+  std::vector<vtkIdType> cellOffsets(1, 0);  // location of each cell in the connectivity
+  vtkIdType connectivitySize = 0;
+  int cornersPerFace = 0;
+  for (size_t q = 0; q < numFaceProps; q++)
+    {
+    if (faceElem.props[q].name == "vertex_indices")
+      cornersPerFace = listCount[q];
+    }
+  if (uniform)
+    {
+    connectivitySize = numPolys * (cornersPerFace + 1);
+    }
+  else
+    {
+    faceOffsets.resize(numPolys);
+    cellOffsets.resize(numPolys + 1);
+    const char* p = faceData;
+    for (i = 0; i < numPolys; i++)
+      {
+      faceOffsets[i] = p - data;
+      for (size_t q = 0; q < numFaceProps; q++)
+        {
+        const PlyBinaryProperty& prop = faceElem.props[q];
+        vtkIdType n = 1;
+        if (prop.isList)
+          {
+          if (p + prop.countSize > dataEnd)
+            return 0;
+          n = plyReadInteger(p, prop.countType);
+          p += prop.countSize;
+          // the counts come from the file, a broken one must not move p backwards or
+          // past the end of the mapping
+          if (n < 0)
+            return 0;
+          if (prop.name == "vertex_indices")
+            cellOffsets[i + 1] = cellOffsets[i] + n + 1;
+          }
+        if (n > (dataEnd - p) / prop.size)
+          return 0;
+        p += n * prop.size;
+        }
+      }
+    connectivitySize = cellOffsets[numPolys];
+    }
+
+  // vertices: straight into the point and colour arrays
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(numPts);
+  float* xyz = static_cast<vtkFloatArray*>(points->GetData())->GetPointer(0);
+  vtkSmartPointer<vtkUnsignedCharArray> RGBPoints = NULL;
+  unsigned char* rgb = NULL;
+  if (RGBPointsAvailable)
+    {
+    RGBPoints = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    RGBPoints->SetName("RGB");
+    RGBPoints->SetNumberOfComponents(3);
+    RGBPoints->SetNumberOfTuples(numPts);
+    rgb = RGBPoints->GetPointer(0);
+    }
+  const bool packedXYZ = (px->type == PLYB_FLOAT32 && py->type == PLYB_FLOAT32 && pz->type == PLYB_FLOAT32 &&
+                          py->offset == px->offset + 4 && pz->offset == px->offset + 8);
+  if (packedXYZ && stride == 12 && !RGBPointsAvailable)
+    {
+    memcpy(xyz, vertexData, (size_t)numPts * 12);
+    }
+  else
+    {
+    #pragma omp parallel for private(i) schedule(static)
+    for (i = 0; i < numPts; i++)
+      {
+      const char* v = vertexData + (qint64)i * stride;
+      if (packedXYZ)
+        memcpy(xyz + 3 * i, v + px->offset, 12);
+      else
+        {
+        xyz[3 * i] = plyReadFloat(v + px->offset, px->type);
+        xyz[3 * i + 1] = plyReadFloat(v + py->offset, py->type);
+        xyz[3 * i + 2] = plyReadFloat(v + pz->offset, pz->type);
+        }
+      if (rgb)
+        {
+        rgb[3 * i] = static_cast<unsigned char>(plyReadInteger(v + pred->offset, pred->type));
+        rgb[3 * i + 1] = static_cast<unsigned char>(plyReadInteger(v + pgreen->offset, pgreen->type));
+        rgb[3 * i + 2] = static_cast<unsigned char>(plyReadInteger(v + pblue->offset, pblue->type));
+        }
+      }
+    }
+
+  // faces: every record decodes independently into the connectivity array
+  vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+  connectivity->SetNumberOfValues(connectivitySize);
+  vtkIdType* conn = connectivity->GetPointer(0);
+  vtkSmartPointer<vtkUnsignedCharArray> intensity = NULL;
+  vtkSmartPointer<vtkUnsignedCharArray> RGBCells = NULL;
+  unsigned char* intensityPtr = NULL;
+  unsigned char* RGBCellsPtr = NULL;
+  if (intensityAvailable)
+    {
+    intensity = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    intensity->SetName("intensity");
+    intensity->SetNumberOfTuples(numPolys);
+    intensityPtr = intensity->GetPointer(0);
+    }
+  if (RGBCellsAvailable)
+    {
+    RGBCells = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    RGBCells->SetName("RGB");
+    RGBCells->SetNumberOfComponents(3);
+    RGBCells->SetNumberOfTuples(numPolys);
+    RGBCellsPtr = RGBCells->GetPointer(0);
+    }
+
+  int numInvalid = 0;
+  #pragma omp parallel for private(i) schedule(static) reduction(+:numInvalid)
+  for (i = 0; i < numPolys; i++)
+    {
+    const char* p = uniform ? faceData + i * faceStride : data + faceOffsets[i];
+    vtkIdType* cell = conn + (uniform ? i * (cornersPerFace + 1) : cellOffsets[i]);
+    for (size_t q = 0; q < numFaceProps; q++)
+      {
+      const PlyBinaryProperty& prop = faceElem.props[q];
+      if (!prop.isList)
+        {
+        if (intensityPtr && prop.name == "intensity")
+          intensityPtr[i] = static_cast<unsigned char>(plyReadInteger(p, prop.type));
+        else if (RGBCellsPtr && prop.name == "red")
+          RGBCellsPtr[3 * i] = static_cast<unsigned char>(plyReadInteger(p, prop.type));
+        else if (RGBCellsPtr && prop.name == "green")
+          RGBCellsPtr[3 * i + 1] = static_cast<unsigned char>(plyReadInteger(p, prop.type));
+        else if (RGBCellsPtr && prop.name == "blue")
+          RGBCellsPtr[3 * i + 2] = static_cast<unsigned char>(plyReadInteger(p, prop.type));
+        p += prop.size;
+        continue;
+        }
+      const vtkIdType n = plyReadInteger(p, prop.countType);
+      p += prop.countSize;
+      if (prop.name == "vertex_indices")
+        {
+        cell[0] = n;
+        for (vtkIdType k = 0; k < n; k++)
+          {
+          vtkIdType id;
+          if (prop.type == PLYB_INT32)
+            {
+            int v;
+            memcpy(&v, p + 4 * k, 4);
+            id = v;
+            }
+          else
+            id = plyReadInteger(p + k * prop.size, prop.type);
+          if (id < 0 || id >= numPts)
+            numInvalid++;
+          cell[k + 1] = id;
+          }
+        }
+      p += n * prop.size;
+      }
+    }
+  if (numInvalid > 0)
+    {
+    vtkWarningMacro(<< numInvalid << " face indices out of range, using the generic PLY reader");
+    return 0;
+    }
+
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  polys->SetCells(numPolys, connectivity);
+
+  // Per-vertex texture coordinates are scattered in face order so that a
+  // vertex shared by faces with different uv keeps the last one, exactly as
+  // the generic path does. This pass is serial but only touches memory.
+  vtkSmartPointer<vtkFloatArray> texcoord = NULL;
+  if (texcoordAvailable)
+    {
+    texcoord = vtkSmartPointer<vtkFloatArray>::New();
+    texcoord->SetName("texcoord");
+    texcoord->SetNumberOfComponents(2);
+    texcoord->SetNumberOfTuples(numPts);
+    float* uv = texcoord->GetPointer(0);
+    memset(uv, 0, sizeof(float) * 2 * numPts);
+    for (i = 0; i < numPolys; i++)
+      {
+      const char* p = uniform ? faceData + i * faceStride : data + faceOffsets[i];
+      const vtkIdType* cell = conn + (uniform ? i * (cornersPerFace + 1) : cellOffsets[i]);
+      for (size_t q = 0; q < numFaceProps; q++)
+        {
+        const PlyBinaryProperty& prop = faceElem.props[q];
+        vtkIdType n = 1;
+        if (prop.isList)
+          {
+          n = plyReadInteger(p, prop.countType);
+          p += prop.countSize;
+          if (prop.name == "texcoord")
+            {
+            const vtkIdType corners = std::min(cell[0], n / 2);
+            for (vtkIdType k = 0; k < corners; k++)
+              {
+              uv[2 * cell[k + 1]] = plyReadFloat(p + 2 * k * prop.size, prop.type);
+              uv[2 * cell[k + 1] + 1] = plyReadFloat(p + (2 * k + 1) * prop.size, prop.type);
+              }
+            }
+          }
+        p += n * prop.size;
+        }
+      }
+    }
+
+  output->SetPoints(points);
+  output->SetPolys(polys);
+  if (intensityAvailable)
+    {
+    output->GetCellData()->AddArray(intensity);
+    output->GetCellData()->SetActiveScalars("intensity");
+    }
+  if (RGBCellsAvailable)
+    {
+    output->GetCellData()->AddArray(RGBCells);
+    output->GetCellData()->SetActiveScalars("RGB");
+    }
+  if (RGBPointsAvailable)
+    output->GetPointData()->SetScalars(RGBPoints);
+  if (texcoordAvailable)
+    output->GetPointData()->SetTCoords(texcoord);
+  output->Squeeze();
+
+  return 1;
+}
+
 int vtkPLYReader2::CanReadFile(const char *filename)
 {
   FILE *fd = fopen(filename, "rb");
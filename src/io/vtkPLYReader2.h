@@ -48,6 +48,9 @@
 // element has the properties "intensity" and/or the triplet "red",
 // "green", and "blue"; these are read and added as scalars to the
 // output data.
+// Binary little-endian files with the usual fixed-size vertex layout are
+// memory-mapped and decoded in bulk; every other file goes through the
+// generic vtkPLY property callbacks.
 
 // .SECTION See Also
 // vtkPLYWriter
@@ -83,6 +86,11 @@ protected:
   char *FileName;
 
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+  // Description:
+  // Bulk decoder for binary little-endian files. Returns 0 when the layout
+  // is not supported so that RequestData falls back to the generic path.
+  int RequestDataBinary(vtkPolyData *output);
 private:
   vtkPLYReader2(const vtkPLYReader2&);  // Not implemented.
   void operator=(const vtkPLYReader2&);  // Not implemented.
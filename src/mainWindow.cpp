@@ -45,8 +45,10 @@
 
 #include "information/informationWidget.h"
 #include "information/bookmarkWidget.h"
+#include "information/bookmarkStore.h"
 #include "information/searchWidget.h"
 #include "information/annotationFilterDialog.h"
+#include "information/cellIdCodec.h"
 
 #include "function/lightControl.h"
 #include "function/plotView.h"
@@ -1793,7 +1795,7 @@ void MainWindow::importCHE()
 	QDomElement root = list.at(0).toElement();
 	QString CHEName = root.attribute("name");
 	QDomNodeList items = root.elementsByTagName("item");
-	QVector<QString> CHEObjectList;
+	QVector<QString> CHEObjectList, CHENotePaths;
 	for(int i = 0; i < items.length(); i++) 
 	{
 		QDomElement elt = items.at(i).toElement();
@@ -1802,8 +1804,10 @@ void MainWindow::importCHE()
 		QStringList nameElement = fn.split(QDir::separator());
 		QString fileNameElement = nameElement[nameElement.size() - 1];
 		CHEObjectList.push_back(fileNameElement);
+		QFileInfo objectInfo(fi.absoluteDir().absoluteFilePath(fn));
+		CHENotePaths.push_back(QDir::toNativeSeparators(objectInfo.absolutePath() + QString("/Note")));
 	}
-	ImportFromCHEDialog *dialog = new ImportFromCHEDialog(CHEObjectList);
+	ImportFromCHEDialog *dialog = new ImportFromCHEDialog(CHEObjectList, CHENotePaths);
 	dialog->exec();
 	if (!dialog->isImport())
 		return;
@@ -1866,6 +1870,9 @@ void MainWindow::importCHE()
 				{
 					if (items[j].fileName() == QString("Annotation.txt"))
 						continue;
+					// binary cell ids of surface notes go with their note file, the note registry is rebuilt on demand
+					if (items[j].suffix() != QString("txt"))
+						continue;
 					QFile *file = new QFile(items[j].absoluteFilePath());
 					if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
 					{
@@ -1886,6 +1893,7 @@ void MainWindow::importCHE()
 					if (categories.indexOf(type) == -1)
 					{
 						file->remove();
+						QFile::remove(CellIdCodec::idFileName(items[j].absoluteFilePath()));
 					}
 				}
 				if (objectType[i] == CTSTACK)
@@ -1988,6 +1996,9 @@ void MainWindow::mergeProjectToCHE()
 				QFile::copy(projectNote, CHENote);
 				continue;
 			}
+			// binary cell ids of surface notes are copied with their note file below, the note registry is rebuilt on demand
+			if (newItems[j].suffix() != QString("txt"))
+				continue;
 			QFile *file = new QFile(newItems[j].absoluteFilePath());
 			if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
 			{
@@ -2014,6 +2025,14 @@ void MainWindow::mergeProjectToCHE()
 				if (QFile::exists(CHENote))
 					QFile::remove(CHENote);
 				QFile::copy(projectNote, CHENote);
+				QString projectIds = CellIdCodec::idFileName(projectNote);
+				if (QFile::exists(projectIds))
+				{
+					QString CHEIds = CellIdCodec::idFileName(CHENote);
+					if (QFile::exists(CHEIds))
+						QFile::remove(CHEIds);
+					QFile::copy(projectIds, CHEIds);
+				}
 			}
 		}
 	}
@@ -2167,6 +2186,8 @@ bool MainWindow::cpDir(const QString &srcPath, const QString &dstPath)
     }
 
     foreach (QString f, dir.entryList(QDir::Files)) {
+        if (f == BOOKMARK_FN)	// bookmark edits are written behind, put them on disk first
+            BookmarkStore::instance(srcPath + QDir::separator() + f)->flush();
         QFile::copy(srcPath + QDir::separator() + f, dstPath + QDir::separator() + f);
     }
 	return true;
@@ -2553,7 +2574,8 @@ OPENRESULT MainWindow::openImages(const QString& fileNameStart, const QString& C
 
 		newImage();
 		qDebug()<<fileName;
-		bool open = VTKA()->ReadData(fileName);
+		QString cacheFolder = currentProjectFullName.isEmpty() ? QString() : currentWindowPath; // decoded data may be cached in the object folder
+		bool open = VTKA()->ReadData(fileName, cacheFolder);
 		
 		if(open && saveRecent)
 		{
@@ -2960,6 +2982,7 @@ void MainWindow::updateMenus()
 	showPolyIndicateAct->setEnabled(activeDoc);
 	generateReportAct->setEnabled(projectOpen);
 	measureDistanceAct->setEnabled(activeDoc);
+	measureGeodesicAct->setEnabled(activeDoc);
 	removeDistanceAct->setEnabled(activeDoc);
 
 	writeAnnotationAct->setEnabled(activeDoc);
@@ -3032,6 +3055,7 @@ void MainWindow::updateMenus()
 
 		measureDistanceAct->setIcon(VTKA()->getUseRubberband() ? QIcon(":/images/ruler_on.png") : QIcon(":/images/ruler_off.png") );
 		measureDistanceAct->setChecked(VTKA()->getUseRubberband() );
+		measureGeodesicAct->setChecked(VTKA()->getMeasureGeodesic() );
 
 		//    removeDistanceAct->setIcon( VTKA()->getIsRubberbandVisible() ? QIcon(":/images/remove_ruler_on.png") : QIcon(":/images/remove_ruler_off.png") );
 		//    removeDistanceAct->setChecked( VTKA()->getIsRubberbandVisible() );
@@ -3069,6 +3093,7 @@ void MainWindow::updateMenus()
 				frustumNote->setChecked(false);
 				showPolyIndicateAct->setEnabled(false);
 				measureDistanceAct->setEnabled(false);
+				measureGeodesicAct->setEnabled(false);
 				removeDistanceAct->setEnabled(false);
 				viewToolBar->setEnabled(false);
 				break;
@@ -3103,6 +3128,7 @@ void MainWindow::updateMenus()
 				annotationModeMenu->setEnabled(true);
 				toolsMenu->setEnabled(true);
 				measureDistanceAct->setEnabled(false);
+				measureGeodesicAct->setEnabled(false);
 				removeDistanceAct->setEnabled(false);
 				viewToolBar->setEnabled(false);
 				polygonNote->setEnabled(false);
@@ -3114,6 +3140,7 @@ void MainWindow::updateMenus()
 				viewFromMenu->setEnabled(false);
 				renderToolBar->setEnabled(false);
 				measureToolBar->setEnabled(true); // bug
+				measureGeodesicAct->setEnabled(false);
 				annotationToolBar->setEnabled(true);
 				annotationModeMenu->setEnabled(true);
 				toolsMenu->setEnabled(true);
@@ -3140,6 +3167,7 @@ void MainWindow::updateMenus()
 				annotationModeMenu->setEnabled(true);
 				frustumNote->setEnabled(false);
 				measureDistanceAct->setEnabled(false);
+				measureGeodesicAct->setEnabled(false);
 				removeDistanceAct->setEnabled(false);
 				viewToolBar->setEnabled(false);
 				break;
@@ -3578,6 +3606,9 @@ void MainWindow::exportCHEToProject()
 			{
 				if (items[j].fileName() == QString("Annotation.txt"))
 					continue;
+				// binary cell ids of surface notes go with their note file, the note registry is rebuilt on demand
+				if (items[j].suffix() != QString("txt"))
+					continue;
 				QFile *file = new QFile(items[j].absoluteFilePath());
 				if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
 				{
@@ -3598,6 +3629,7 @@ void MainWindow::exportCHEToProject()
 				if (categories.indexOf(type) == -1)
 				{
 					file->remove();
+					QFile::remove(CellIdCodec::idFileName(items[j].absoluteFilePath()));
 				}
 			}
 		}
@@ -4113,6 +4145,11 @@ void MainWindow::createActions()
     measureDistanceAct->setCheckable(true);
     connect(measureDistanceAct, SIGNAL(triggered()), this, SLOT(measureDistance()));
 
+    measureGeodesicAct = new QAction(tr("Measure Along Surface"), this);
+    measureGeodesicAct->setCheckable(true);
+    measureGeodesicAct->setStatusTip(tr("Measure the shortest distance on the surface of the 3D model"));
+    connect(measureGeodesicAct, SIGNAL(triggered()), this, SLOT(measureGeodesic()));
+
     removeDistanceAct = new QAction(QIcon(":/images/remove_ruler_on.png"), tr("Clear Measuring Tool"), this);
     removeDistanceAct->setCheckable(false);
     connect(removeDistanceAct, SIGNAL(triggered()), this, SLOT(removeMeasureDistance()));
@@ -4288,6 +4325,7 @@ void MainWindow::createMenus()
 	toolsMenu->addAction(generateReportAct);
 	toolsMenu->addSeparator();
 	toolsMenu->addAction(measureDistanceAct);
+	toolsMenu->addAction(measureGeodesicAct);
 	toolsMenu->addAction(removeDistanceAct);
 	toolsMenu->addSeparator();
 	annotationModeMenu = toolsMenu->addMenu(tr("Write Annotation"));
@@ -4833,7 +4871,7 @@ void MainWindow::removeAnnotation()
 void MainWindow::filterAnnotation()
 {
 	QVector<QString> users = mInformation->getAllUsers();
-	AnnotationFilterDialog* filter = new AnnotationFilterDialog(users);
+	AnnotationFilterDialog* filter = new AnnotationFilterDialog(users, mInformation->getUserNoteCounts());
 	filter->exec();
 	if (!filter->isFilter())
 		return;
@@ -4963,6 +5001,17 @@ void MainWindow::measureDistance()
 	updateMenus();
 }
 
+void MainWindow::measureGeodesic()
+{
+	QAction *a = qobject_cast<QAction* >(sender());
+	bool answer = a->isChecked() ? true : false;
+
+	if (VTKA())
+	VTKA()->setMeasureGeodesic( answer );
+
+	updateMenus();
+}
+
 void MainWindow::removeMeasureDistance()
 {
 	QAction *a = qobject_cast<QAction* >(sender());
@@ -715,6 +715,11 @@ private slots:
 	 */
 	void measureDistance();
 
+	/**
+	 * @brief  Measure along the surface of the 3D object instead of in a straight line.
+	 */
+	void measureGeodesic();
+
 	/**
 	 * @brief  Remove the measurement.
 	 */
@@ -939,6 +944,7 @@ private:
 	QAction *viewSpinAct;
 	QAction *generateReportAct;
 	QAction *measureDistanceAct;
+	QAction *measureGeodesicAct;
 	QAction *removeDistanceAct;
 	QAction *writeAnnotationAct;
 	QActionGroup *annotationModeGroupAct;
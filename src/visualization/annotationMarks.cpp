@@ -0,0 +1,318 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#include "annotationMarks.h"
+
+#include <vector>
+
+#include <vtkPolyData.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkThreshold.h>
+#include <vtkDataSetMapper.h>
+#include <vtkDataObject.h>
+#include <vtkActor.h>
+#include <vtkProperty.h>
+#include <vtkRenderer.h>
+
+// compaction is not worth it for a handful of removed notes
+#define MIN_DEAD_CELLS (256)
+
+AnnotationMarks::AnnotationMarks(CellType type)
+{
+  mCellType = type;
+  mNextKey = 0;
+  mDeadCells = 0;
+
+  mPoints = vtkSmartPointer<vtkPoints>::New();
+  mCells = vtkSmartPointer<vtkCellArray>::New();
+  mColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  mColors->SetName("Colors");
+  mColors->SetNumberOfComponents(3);
+  mVisible = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  mVisible->SetName("Visible");
+  mVisible->SetNumberOfComponents(1);
+
+  mPolyData = vtkSmartPointer<vtkPolyData>::New();
+  mPolyData->SetPoints(mPoints);
+  if (mCellType == LINES)
+    mPolyData->SetLines(mCells);
+  else
+    mPolyData->SetPolys(mCells);
+  mPolyData->GetCellData()->AddArray(mColors);
+  mPolyData->GetCellData()->AddArray(mVisible);
+
+  mThreshold = vtkSmartPointer<vtkThreshold>::New();
+  mThreshold->SetInput(mPolyData);
+  mThreshold->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_CELLS, "Visible");
+  mThreshold->ThresholdByUpper(1);
+
+  mMapper = vtkSmartPointer<vtkDataSetMapper>::New();
+  mMapper->SetInputConnection(mThreshold->GetOutputPort());
+  mMapper->ScalarVisibilityOn();
+  mMapper->SetScalarModeToUseCellFieldData();
+  mMapper->SelectColorArray("Colors");
+
+  mActor = vtkSmartPointer<vtkActor>::New();
+  mActor->SetMapper(mMapper);
+  mActor->PickableOff();
+  mActor->GetProperty()->LightingOn();
+  mActor->GetProperty()->SetLineWidth(2);
+}
+
+void AnnotationMarks::setCellType(CellType type)
+{
+  if (type == mCellType || mCells->GetNumberOfCells() > 0)
+    return;
+  mCellType = type;
+  if (mCellType == LINES)
+  {
+    mPolyData->SetPolys(NULL);
+    mPolyData->SetLines(mCells);
+  }
+  else
+  {
+    mPolyData->SetLines(NULL);
+    mPolyData->SetPolys(mCells);
+  }
+}
+
+void AnnotationMarks::setLineWidth(double width)
+{
+  mActor->GetProperty()->SetLineWidth(width);
+}
+
+void AnnotationMarks::setRenderer(vtkRenderer* renderer)
+{
+  if (renderer && !renderer->HasViewProp(mActor))
+    renderer->AddActor(mActor);
+}
+
+int AnnotationMarks::add(vtkPolyData* mark, const double* color, bool isVisible)
+{
+  Range range;
+  range.firstPoint = mPoints->GetNumberOfPoints();
+  range.numPoints = 0;
+  range.firstCell = mCells->GetNumberOfCells();
+  range.numCells = 0;
+  range.isVisible = isVisible;
+  for (int i = 0; i < 3; i++)
+    range.color[i] = static_cast<unsigned char>(255 * color[i] + 0.5);
+
+  if (mark && mark->GetPoints())
+  {
+    // marks extracted from a mesh (surface notes) carry every mesh point; only the
+    // points their cells use are copied, renumbered in order of first use
+    QHash<vtkIdType, vtkIdType> pointMap;
+    vtkIdType npts, *pts;
+    std::vector<vtkIdType> ids;
+    vtkCellArray* cells = mCellType == LINES ? mark->GetLines() : mark->GetPolys();
+    for (cells->InitTraversal(); cells->GetNextCell(npts, pts); )
+    {
+      ids.resize(npts);
+      for (vtkIdType j = 0; j < npts; j++)
+        ids[j] = markPoint(mark, pts[j], pointMap);
+      mCells->InsertNextCell(npts, npts > 0 ? &ids[0] : NULL);
+      range.numCells++;
+    }
+    if (mCellType == POLYGONS)
+    {
+      // strips are split into triangles, every other one flipped to keep the winding
+      vtkCellArray* strips = mark->GetStrips();
+      for (strips->InitTraversal(); strips->GetNextCell(npts, pts); )
+      {
+        for (vtkIdType j = 0; j + 2 < npts; j++)
+        {
+          vtkIdType triangle[3];
+          triangle[0] = markPoint(mark, pts[j], pointMap);
+          triangle[1] = markPoint(mark, pts[j % 2 ? j + 2 : j + 1], pointMap);
+          triangle[2] = markPoint(mark, pts[j % 2 ? j + 1 : j + 2], pointMap);
+          mCells->InsertNextCell(3, triangle);
+          range.numCells++;
+        }
+      }
+    }
+    range.numPoints = pointMap.size();
+  }
+
+  for (vtkIdType i = 0; i < range.numCells; i++)
+  {
+    mColors->InsertNextTupleValue(range.color);
+    mVisible->InsertNextValue(isVisible ? 1 : 0);
+  }
+
+  int key = mNextKey++;
+  mMarks.insert(key, range);
+  modified();
+  return key;
+}
+
+vtkIdType AnnotationMarks::markPoint(vtkPolyData* mark, vtkIdType id, QHash<vtkIdType, vtkIdType>& pointMap)
+{
+  QHash<vtkIdType, vtkIdType>::const_iterator it = pointMap.constFind(id);
+  if (it != pointMap.constEnd())
+    return it.value();
+  vtkIdType newId = mPoints->InsertNextPoint(mark->GetPoint(id));
+  pointMap.insert(id, newId);
+  return newId;
+}
+
+void AnnotationMarks::remove(int key)
+{
+  QHash<int, Range>::iterator it = mMarks.find(key);
+  if (it == mMarks.end())
+    return;
+  it->isVisible = false;
+  fillCells(*it);
+  mDeadCells += it->numCells;
+  mMarks.erase(it);
+  if (mDeadCells > MIN_DEAD_CELLS && mDeadCells > mCells->GetNumberOfCells() - mDeadCells)
+    compact();
+  modified();
+}
+
+void AnnotationMarks::clear()
+{
+  mMarks.clear();
+  mDeadCells = 0;
+  mPoints->Reset();
+  mCells->Reset();
+  mColors->Reset();
+  mVisible->Reset();
+  modified();
+}
+
+void AnnotationMarks::setVisible(int key, bool isVisible)
+{
+  QHash<int, Range>::iterator it = mMarks.find(key);
+  if (it == mMarks.end() || it->isVisible == isVisible)
+    return;
+  it->isVisible = isVisible;
+  fillCells(*it);
+  modified();
+}
+
+bool AnnotationMarks::isVisible(int key) const
+{
+  QHash<int, Range>::const_iterator it = mMarks.find(key);
+  return it != mMarks.end() && it->isVisible;
+}
+
+void AnnotationMarks::setAllVisible(bool isVisible)
+{
+  for (QHash<int, Range>::iterator it = mMarks.begin(); it != mMarks.end(); ++it)
+  {
+    if (it->isVisible == isVisible)
+      continue;
+    it->isVisible = isVisible;
+    fillCells(*it);
+  }
+  modified();
+}
+
+void AnnotationMarks::setColor(int key, const double* color)
+{
+  QHash<int, Range>::iterator it = mMarks.find(key);
+  if (it == mMarks.end())
+    return;
+  for (int i = 0; i < 3; i++)
+    it->color[i] = static_cast<unsigned char>(255 * color[i] + 0.5);
+  fillCells(*it);
+  modified();
+}
+
+void AnnotationMarks::getColor(int key, double* color) const
+{
+  QHash<int, Range>::const_iterator it = mMarks.find(key);
+  for (int i = 0; i < 3; i++)
+    color[i] = it != mMarks.end() ? it->color[i] / 255.0 : 0;
+}
+
+void AnnotationMarks::fillCells(const Range& range)
+{
+  unsigned char* colors = mColors->GetPointer(0);
+  unsigned char* visible = mVisible->GetPointer(0);
+  unsigned char isVisible = range.isVisible ? 1 : 0;
+  for (vtkIdType i = range.firstCell; i < range.firstCell + range.numCells; i++)
+  {
+    colors[3*i] = range.color[0];
+    colors[3*i+1] = range.color[1];
+    colors[3*i+2] = range.color[2];
+    visible[i] = isVisible;
+  }
+}
+
+// rebuilds the arrays from the live marks only; keys stay the same
+void AnnotationMarks::compact()
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  points->Allocate(mPoints->GetNumberOfPoints());
+
+  // cell k of the old array starts at offsets[k] in its connectivity list
+  std::vector<vtkIdType> offsets(mCells->GetNumberOfCells());
+  vtkIdType npts, *pts;
+  vtkIdType k = 0;
+  for (mCells->InitTraversal(); mCells->GetNextCell(npts, pts); k++)
+    offsets[k] = mCells->GetTraversalLocation(npts);
+
+  std::vector<vtkIdType> ids;
+  for (QHash<int, Range>::iterator it = mMarks.begin(); it != mMarks.end(); ++it)
+  {
+    vtkIdType firstPoint = points->GetNumberOfPoints();
+    vtkIdType firstCell = cells->GetNumberOfCells();
+    for (vtkIdType i = 0; i < it->numPoints; i++)
+      points->InsertNextPoint(mPoints->GetPoint(it->firstPoint + i));
+    for (vtkIdType c = it->firstCell; c < it->firstCell + it->numCells; c++)
+    {
+      mCells->GetCell(offsets[c], npts, pts);
+      ids.resize(npts);
+      for (vtkIdType j = 0; j < npts; j++)
+        ids[j] = pts[j] - it->firstPoint + firstPoint;
+      cells->InsertNextCell(npts, npts > 0 ? &ids[0] : NULL);
+    }
+    it->firstPoint = firstPoint;
+    it->firstCell = firstCell;
+  }
+
+  mPoints->DeepCopy(points);
+  mCells->DeepCopy(cells);
+  mColors->Reset();
+  mVisible->Reset();
+  mColors->SetNumberOfTuples(mCells->GetNumberOfCells());
+  mVisible->SetNumberOfTuples(mCells->GetNumberOfCells());
+  for (QHash<int, Range>::iterator it = mMarks.begin(); it != mMarks.end(); ++it)
+    fillCells(*it);
+  mDeadCells = 0;
+}
+
+void AnnotationMarks::modified()
+{
+  mPoints->Modified();
+  mCells->Modified();
+  mColors->Modified();
+  mVisible->Modified();
+  mPolyData->Modified();
+}
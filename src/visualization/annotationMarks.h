@@ -0,0 +1,110 @@
+/****************************************************************************
+
+ - Codename: CHER-Ob (Yale Computer Graphics Group)
+
+ - Writers:  Zeyu Wang (zeyu.wang@yale.edu)
+
+ - License:  GNU General Public License Usage
+   Alternatively, this file may be used under the terms of the GNU General
+   Public License version 3.0 as published by the Free Software Foundation
+   and appearing in the file LICENSE.GPL included in the packaging of this
+   file. Please review the following information to ensure the GNU General
+   Public License version 3.0 requirements will be met:
+   http://www.gnu.org/copyleft/gpl.html.
+
+ - Warranty: This software is distributed WITHOUT ANY WARRANTY; without even
+   the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+   PURPOSE.
+
+ - Acknowledgments: Some portions of this file are based on the example codes
+   of ITK/VTK library from Kitware, QT API from Nokia. I would like to thank
+   annonymous help by various software engineering communities.
+
+*****************************************************************************/
+#ifndef ANNOTATIONMARKS_H
+#define ANNOTATIONMARKS_H
+
+#include <QHash>
+
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+class vtkPolyData;
+class vtkPoints;
+class vtkCellArray;
+class vtkUnsignedCharArray;
+class vtkThreshold;
+class vtkDataSetMapper;
+class vtkActor;
+class vtkRenderer;
+
+// All marks of one kind (point, surface or polygon notes) drawn by a single actor.
+// The marks are appended into one polydata that carries a colour and a visibility
+// value per cell; a threshold on the visibility array sits in front of the mapper,
+// so showing, hiding and recolouring a note only rewrites its cell values.
+// Every mark gets a key when it is added; the key finds its cell range in O(1).
+// Removed marks stay in the arrays as hidden cells until they outnumber the live
+// ones, then the batch is compacted.
+class AnnotationMarks
+{
+public:
+  // a batch holds either lines or polygons, never both, so that the cells of a
+  // mark stay contiguous in the polydata
+  enum CellType {LINES, POLYGONS};
+
+  AnnotationMarks(CellType type = LINES);
+
+  // only allowed while the batch is empty
+  void setCellType(CellType type);
+  void setLineWidth(double width);
+  // adds the batch actor to renderer (once)
+  void setRenderer(vtkRenderer* renderer);
+  vtkActor* getActor() const {return mActor;}
+
+  // copies the lines (or polygons and strips, as triangles) of mark and only the points
+  // they use; color is rgb in [0, 1]
+  int add(vtkPolyData* mark, const double* color, bool isVisible = true);
+  void remove(int key);
+  void clear();
+  bool contains(int key) const {return mMarks.contains(key);}
+  int size() const {return mMarks.size();}
+
+  void setVisible(int key, bool isVisible);
+  bool isVisible(int key) const;
+  void setAllVisible(bool isVisible);
+  void setColor(int key, const double* color);
+  void getColor(int key, double* color) const;
+
+private:
+  struct Range
+  {
+    vtkIdType firstPoint;
+    vtkIdType numPoints;
+    vtkIdType firstCell;
+    vtkIdType numCells;
+    bool isVisible;
+    unsigned char color[3];
+  };
+
+  // id in mPoints of point id of mark, copied there on first use
+  vtkIdType markPoint(vtkPolyData* mark, vtkIdType id, QHash<vtkIdType, vtkIdType>& pointMap);
+  void fillCells(const Range& range);
+  void compact();
+  void modified();
+
+  CellType mCellType;
+  QHash<int, Range> mMarks;
+  int mNextKey;
+  vtkIdType mDeadCells;
+
+  vtkSmartPointer<vtkPolyData> mPolyData;
+  vtkSmartPointer<vtkPoints> mPoints;
+  vtkSmartPointer<vtkCellArray> mCells;
+  vtkSmartPointer<vtkUnsignedCharArray> mColors;
+  vtkSmartPointer<vtkUnsignedCharArray> mVisible;
+  vtkSmartPointer<vtkThreshold> mThreshold;
+  vtkSmartPointer<vtkDataSetMapper> mMapper;
+  vtkSmartPointer<vtkActor> mActor;
+};
+
+#endif // ANNOTATIONMARKS_H
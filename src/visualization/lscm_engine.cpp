@@ -25,12 +25,15 @@
 #include <vtkPolyData.h>
 #include <vtkPointData.h>
 #include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
 //#include <time.h>
 #include <qdatetime.h>
 #include <qdebug.h>
 
 
 #define MAX_ITERATIONS 2000
+#define WARM_START_MIN_OVERLAP 0.5
+#define FRONTIER_RINGS 3 // width of the band re-solved around new vertices in a warm start
 
 // I/O
 
@@ -88,9 +91,20 @@ void IndexedMesh::clear() {
 LSCM::LSCM()
 {
     //type_solver = "SUPERLU";
-    type_solver = "BICGSTAB";
+    // LSCM is solved in the least squares sense, so the normal equations are
+    // symmetric: CG with SSOR converges in far fewer iterations than Jacobi
+    // preconditioned BICGSTAB, and the row + column storage that SSOR needs
+    // lets OpenNL run the matrix-vector products on all cores.
+    type_solver = "CG_SSOR";
     mesh = 0;
     vtkMesh = 0;
+    used_iterations = 0;
+    solve_time = 0;
+}
+
+void LSCM::resetWarmStart()
+{
+    previous_uv.clear();
 }
 
 
@@ -98,12 +112,31 @@ void LSCM::apply()
 {
     int nb_vertices = mesh->vertex.size() ;
     project() ;
+    bool warm = warm_start() ;
+
+    int nb_free = 0 ;
+    for(int i=0; i<nb_vertices; i++) {
+        if(!mesh->vertex[i].locked)
+            nb_free++ ;
+    }
+    if(nb_free == 0) {
+        // nothing new under the camera, the previous flattening still holds
+        used_iterations = 0 ;
+        solve_time = 0 ;
+        store_solution() ;
+        return ;
+    }
+
     nlNewContext() ;
 
     if (!strcmp(type_solver,"CG")) {
             nlSolverParameteri(NL_SOLVER, NL_CG) ;
             nlSolverParameteri(NL_PRECONDITIONER, NL_PRECOND_JACOBI) ;
         }
+    else if (!strcmp(type_solver,"CG_SSOR")) {
+            nlSolverParameteri(NL_SOLVER, NL_CG) ;
+            nlSolverParameteri(NL_PRECONDITIONER, NL_PRECOND_SSOR) ;
+        }
     else if (!strcmp(type_solver,"BICGSTAB")) {
             nlSolverParameteri(NL_SOLVER, NL_BICGSTAB) ;
             nlSolverParameteri(NL_PRECONDITIONER, NL_PRECOND_JACOBI) ;
@@ -167,7 +200,7 @@ void LSCM::apply()
             exit(-1);
         }
     } else {
-        std::cerr << "type_solver must belong to { CG | BICGSTAB | GMRES | "
+        std::cerr << "type_solver must belong to { CG | CG_SSOR | BICGSTAB | GMRES | "
                     << "SUPERLU | FLOAT_CRS | FLOAT_BCRS2 | DOUBLE_CRS | "
                     << "DOUBLE_BCRS2 | FLOAT_ELL | DOUBLE_ELL | FLOAT_HYB |"
                     << "DOUBLE_HYB } "
@@ -192,10 +225,15 @@ void LSCM::apply()
     if(nl_result)
     {
         solver_to_mesh() ;
+        store_solution() ;
         double time ;
         NLint iterations;
         nlGetDoublev(NL_ELAPSED_TIME, &time) ;
         nlGetIntergerv(NL_USED_ITERATIONS, &iterations);
+        used_iterations = iterations;
+        solve_time = time;
+        qDebug() << "LSCM solved" << 2*nb_vertices << "variables in" << iterations
+                 << "iterations," << time << "s" << (warm ? "(warm start)" : "(cold start)");
         std::cout << "flattening succeeded" << std::endl ;
     }
     else
@@ -393,6 +431,117 @@ void LSCM::project()
     vxmax->locked = true ;
 }
 
+bool LSCM::warm_start()
+{
+    int nb_vertices = mesh->vertex.size() ;
+    if(previous_uv.empty() || (int)global_id.size() != nb_vertices)
+        return false ;
+
+    // pair up the projected and the previous coordinates of the known vertices
+    std::vector<int> known ;
+    std::vector<Vector2> uv ;
+    std::vector<int> ring(nb_vertices, -1) ; // distance in rings to the closest new vertex
+    std::vector<int> queue ;
+    known.reserve(nb_vertices) ;
+    uv.reserve(nb_vertices) ;
+    for(int i=0; i<nb_vertices; i++) {
+        std::map<int, Vector2>::const_iterator it = previous_uv.find(global_id[i]) ;
+        if(it != previous_uv.end()) {
+            known.push_back(i) ;
+            uv.push_back(it->second) ;
+        } else {
+            ring[i] = 0 ;
+            queue.push_back(i) ;
+        }
+    }
+    if(known.size() < 2 || known.size() < WARM_START_MIN_OVERLAP * nb_vertices)
+        return false ;
+
+    // least squares similarity (complex a, b) with previous = a * projected + b
+    Vector2 pm, qm ;
+    for(unsigned int k=0; k<known.size(); k++) {
+        pm = pm + mesh->vertex[known[k]].tex_coord ;
+        qm = qm + uv[k] ;
+    }
+    pm.x /= known.size() ; pm.y /= known.size() ;
+    qm.x /= known.size() ; qm.y /= known.size() ;
+    double re = 0, im = 0, den = 0 ;
+    for(unsigned int k=0; k<known.size(); k++) {
+        Vector2 p = mesh->vertex[known[k]].tex_coord - pm ;
+        Vector2 q = uv[k] - qm ;
+        re  += p.x * q.x + p.y * q.y ;
+        im  += p.x * q.y - p.y * q.x ;
+        den += p.x * p.x + p.y * p.y ;
+    }
+    if(den <= 0)
+        return false ;
+    re /= den ;
+    im /= den ;
+
+    for(int i=0; i<nb_vertices; i++) {
+        Vector2 p = mesh->vertex[i].tex_coord - pm ;
+        mesh->vertex[i].tex_coord = Vector2(re*p.x - im*p.y + qm.x, im*p.x + re*p.y + qm.y) ;
+    }
+    for(unsigned int k=0; k<known.size(); k++)
+        mesh->vertex[known[k]].tex_coord = uv[k] ;
+
+    // Only a band around the new vertices is solved for: everything further
+    // than FRONTIER_RINGS rings keeps its previous (u,v) and is locked, so the
+    // flat region grows at its frontier instead of being re-solved as a whole.
+    std::vector<int> offsets(nb_vertices + 1, 0) ;
+    for(unsigned int f=0; f<mesh->facet.size(); f++) {
+        const Facet& F = mesh->facet[f] ;
+        for(unsigned int k=0; k<F.size(); k++)
+            offsets[F[k] + 1]++ ;
+    }
+    for(int i=0; i<nb_vertices; i++)
+        offsets[i + 1] += offsets[i] ;
+    std::vector<int> vertex_facets(offsets[nb_vertices]) ;
+    std::vector<int> next(offsets.begin(), offsets.end() - 1) ;
+    for(unsigned int f=0; f<mesh->facet.size(); f++) {
+        const Facet& F = mesh->facet[f] ;
+        for(unsigned int k=0; k<F.size(); k++)
+            vertex_facets[next[F[k]]++] = f ;
+    }
+    for(unsigned int head=0; head<queue.size(); head++) {
+        int v = queue[head] ;
+        if(ring[v] == FRONTIER_RINGS)
+            continue ;
+        for(int j=offsets[v]; j<offsets[v + 1]; j++) {
+            const Facet& F = mesh->facet[vertex_facets[j]] ;
+            for(unsigned int k=0; k<F.size(); k++) {
+                if(ring[F[k]] < 0) {
+                    ring[F[k]] = ring[v] + 1 ;
+                    queue.push_back(F[k]) ;
+                }
+            }
+        }
+    }
+    int nb_pinned = 0 ;
+    for(int i=0; i<nb_vertices; i++) {
+        if(ring[i] < 0)
+            nb_pinned++ ;
+    }
+    if(nb_pinned >= 2) {
+        // the pinned interior fixes the frame, the two projected extrema are not needed
+        for(int i=0; i<nb_vertices; i++)
+            mesh->vertex[i].locked = (ring[i] < 0) ;
+    }
+    return true ;
+}
+
+void LSCM::store_solution()
+{
+    // only the last subset is kept, the walker never jumps back further
+    previous_uv.clear() ;
+    if(global_id.size() != mesh->vertex.size())
+        return ;
+    for(unsigned int i=0; i<mesh->vertex.size(); i++) {
+        if(global_id[i] >= 0)
+            previous_uv[global_id[i]] = mesh->vertex[i].tex_coord ;
+    }
+}
+
 IndexedMesh* LSCM::QMesh2IndMesh(vtkPolyData *qm)
 {
     if(mesh != NULL)
@@ -413,6 +562,15 @@ IndexedMesh* LSCM::QMesh2IndMesh(vtkPolyData *qm)
         mesh->add_vertex(Vector3(pi[0],pi[1],pi[2]),Vector2(0,0));
     }
 
+    global_id.clear();
+    vtkIdTypeArray *originalPointIDs = vtkIdTypeArray::SafeDownCast(qm->GetPointData()->GetArray("originalPointIDs"));
+    if(originalPointIDs && originalPointIDs->GetNumberOfTuples() == numberOfPoints)
+    {
+        global_id.resize(numberOfPoints);
+        for(int i = 0; i < numberOfPoints; ++i)
+            global_id[i] = (int)originalPointIDs->GetValue(i);
+    }
+
     for(int k = 0; k < numberOfCells; ++k)
     {
         vtkSmartPointer<vtkIdList> vertexList = vtkSmartPointer<vtkIdList>::New();
@@ -26,6 +26,7 @@
 #include "../NL/nl.h"
 #include <vector>
 #include <set>
+#include <map>
 #include <string>
 #include <iostream>
 #include <sstream>
@@ -161,6 +162,13 @@ public:
     void apply();
     void SwapUVtoGeometry();
 
+    // Forget the previous flattening (e.g. when the walker switches to another mesh).
+    void resetWarmStart();
+
+    // Statistics of the last solve, as reported by OpenNL.
+    int getUsedIterations() const { return used_iterations; }
+    double getSolveTime() const { return solve_time; }
+
 protected:
 
     void setup_lscm();
@@ -214,6 +222,15 @@ protected:
     // Chooses an initial solution, and locks two vertices
     void project();
 
+    // Replaces the projected initial solution by the previous flattening when
+    // enough of the vertices were flattened last time. Vertices that are new to
+    // the subset get their projection mapped into the previous (u,v) frame, and
+    // the vertices away from them are locked so that only the frontier is solved.
+    bool warm_start();
+
+    // keeps the (u,v) of the vertices just solved for the next warm start
+    void store_solution();
+
     // Convert between MyQMesh and IndexedMesh
     IndexedMesh* QMesh2IndMesh(vtkPolyData *qm);
     //MyQMesh* IndMesh2QMesh(IndexedMesh *im);
@@ -222,6 +239,12 @@ protected:
     const char *type_solver;
     IndexedMesh *mesh;
     vtkPolyData *vtkMesh;
+
+    // id of each vertex in the whole mesh ("originalPointIDs"), -1 if unknown
+    std::vector<int> global_id;
+    std::map<int, Vector2> previous_uv;
+    int used_iterations;
+    double solve_time;
 } ;
 
 #endif // LSCM_ENGINE_H
@@ -66,6 +66,8 @@
 #include <vtkSeedWidget.h>
 #include "../mainWindow.h"
 #include "../information/informationWidget.h"
+#include "../function/spectralProbe.h"
+#include "annotationMarks.h"
 #include "myVTKInteractorStyle.h"
 
 #include <vtkImageActor.h>
@@ -150,6 +152,7 @@ public:
   void SetHyperImageData(vtkImageData* hypertexture)
   {
     this->mHyperImageData = hypertexture;
+    this->mHyperProbe.setImageData(hypertexture);
   }
 
   void SetDisplayInfoOn(bool displayon)
@@ -221,18 +224,9 @@ public:
 		  initNote();
 		  if (visibilityOn)
 		  {
-			  for (int i = 0; i < mSelectedPoint.size(); i++)
-			  {
-				 mSelectedPoint[i].second->VisibilityOn();
-			  }
-			  for (int i = 0; i < mSelectedSurface.size(); i++)
-			  {
-				 mSelectedSurface[i].second->VisibilityOn();
-			  }
-			  for (int i = 0; i < mSelectedPolygon.size(); i++)
-			  {
-				 mSelectedPolygon[i].second->VisibilityOn();
-			  }
+			  mPointMarks.setAllVisible(true);
+			  mSurfaceMarks.setAllVisible(true);
+			  mPolygonMarks.setAllVisible(true);
 			  //// TO BE TESTED
 		  }
 		  mw()->mInformation->startAnnotation();
@@ -240,18 +234,9 @@ public:
 	  }
 	  else
 	  {
-		  for (int i = 0; i <  mSelectedPoint.size(); i++)
-		  {
-			  mSelectedPoint[i].second->VisibilityOff();
-		  }
-		  for (int i = 0; i <  mSelectedSurface.size(); i++)
-		  {
-			  mSelectedSurface[i].second->VisibilityOff();
-		  }
-		  for (int i = 0; i < mSelectedPolygon.size(); i++)
-		  {
-			  mSelectedPolygon[i].second->VisibilityOff();
-		  }
+		  mPointMarks.setAllVisible(false);
+		  mSurfaceMarks.setAllVisible(false);
+		  mPolygonMarks.setAllVisible(false);
 		  //// TO BE TESTED
 		  mw()->mInformation->finishAnnotation();
 		  finishNote();
@@ -366,19 +351,7 @@ public:
 			  }	
 		  }
 		  qDebug() << "Draw Point Note";
-		  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-
-		  vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-		  actor->SetMapper(mapper);
-		  actor->PickableOff();
-		  actor->GetProperty()->LightingOn();
-		  actor->GetProperty()->SetColor(ColorPixel[mColor][0], ColorPixel[mColor][1], ColorPixel[mColor][2]);
-		  actor->GetProperty()->SetLineWidth(2);
-		  actor->VisibilityOn();
-      
-		  renderer->AddActor(actor);
-		  mSelectedPoint.push_back(std::make_pair(point, actor));
-		  displayPointNote(mapper, point);
+		  mSelectedPoint.push_back(std::make_pair(point, displayPointNote(point, mColor, true)));
 		  mw()->mInformation->createPointNote2D(point, pointImageCoordinate, mColor);
 	  }
 
@@ -426,21 +399,7 @@ public:
 	  imageCoordinate[2] = endPointImageCoordinate[0];
 	  imageCoordinate[3] = endPointImageCoordinate[1];
 
-	  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-
-	  vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-	  actor->GetProperty()->SetColor(ColorPixel[mColor][0], ColorPixel[mColor][1], ColorPixel[mColor][2]);
-	  actor->GetProperty()->SetLineWidth(2);
-	  actor->VisibilityOn();
-
-	  renderer->AddActor(actor);
-
-	  mSelectedSurface.push_back(std::make_pair(point, actor));
-
-	  displaySurfaceNote(mapper, point);
+	  mSelectedSurface.push_back(std::make_pair(point, displaySurfaceNote(point, mColor, true)));
 
 	  mw()->mInformation->createSurfaceNote2D(point, imageCoordinate, mColor);
 
@@ -467,10 +426,6 @@ public:
 
 	  std::vector<std::pair<double, double> >* polygonPointer;
 	  std::vector<std::pair<int, int> >* polygonImagePointer;
-	  vtkPolyDataMapper* polygonPolyDataMapper;
-	  vtkActor* polygonActor;
-	  vtkSmartPointer<vtkPolyDataMapper> polygonPolyDataMapperSmart;
-	  vtkSmartPointer<vtkActor> polygonActorSmart;
 	  bool isSuccess = false;
 
 	  int currPos[2];
@@ -503,27 +458,13 @@ public:
 			  PolyLine.back()->GetPointIds()->SetId(polygonPoints.size()-1, 0);
 			  polygonPointer = new std::vector<std::pair<double, double> >;
 			  polygonImagePointer = new std::vector<std::pair<int, int> >;
-			  polygonPolyDataMapper = vtkPolyDataMapper::New();
-			  polygonActor = vtkActor::New();
 			  *polygonPointer = polygonPoints;
 			  *polygonImagePointer = polygonImagePoints;
-			  PolyDataMapper.back()->ShallowCopy(polygonPolyDataMapper);
-			  Actor.back()->ShallowCopy(polygonActor);
-			  polygonPolyDataMapperSmart.TakeReference(polygonPolyDataMapper);
-			  polygonActorSmart.TakeReference(polygonActor);
-			  mSelectedPolygon.push_back(std::make_pair(polygonPointer, polygonActorSmart));
 
 			  std::vector<vtkActor*>::iterator itActorUpdateRenderer;
 			  for (itActorUpdateRenderer = Actor.begin(); itActorUpdateRenderer != Actor.end(); itActorUpdateRenderer++)
 				  renderer->RemoveActor(*itActorUpdateRenderer);
-			  displayPolygonNote(polygonPolyDataMapperSmart, polygonPointer);
-			  polygonActorSmart->SetMapper(polygonPolyDataMapperSmart);
-			  polygonActorSmart->PickableOff();
-			  polygonActorSmart->GetProperty()->LightingOn();
-			  polygonActorSmart->GetProperty()->SetColor(ColorPixel[mColor][0], ColorPixel[mColor][1], ColorPixel[mColor][2]);
-			  polygonActorSmart->GetProperty()->SetLineWidth(2);
-			  polygonActorSmart->VisibilityOn();
-			  renderer->AddActor(polygonActorSmart);
+			  mSelectedPolygon.push_back(std::make_pair(polygonPointer, displayPolygonNote(polygonPointer, mColor, true)));
 			  mw()->mInformation->createPolygonNote2D(polygonPointer, polygonImagePointer, mColor);
 
 			  // Clear tmp drawings, non smart pointers should release memory manually
@@ -580,12 +521,9 @@ public:
 	  }
 	  //// TO BE TESTED
   }
-  void displayPointNote(vtkSmartPointer<vtkPolyDataMapper> mapper, double* select)
+  // adds the cross of a point note to the point note batch, returns its key there
+  int displayPointNote(double* select, const ColorType color, bool isDisplay)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-
 	  double p0[3] = {select[0], select[1], 0.0};
 	  double p1[3] = {select[0] - mRadius, select[1], 0.0};
 	  double p2[3] = {select[0] + mRadius, select[1], 0.0};
@@ -618,14 +556,11 @@ public:
 	  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
 	  polyData->SetPoints(points);
 	  polyData->SetLines(cells);
-	  mapper->SetInput(polyData);
+	  return addMark(mPointMarks, polyData, color, isDisplay);
   }
 
-  void displaySurfaceNote(vtkSmartPointer<vtkPolyDataMapper> mapper, double* select)
+  int displaySurfaceNote(double* select, const ColorType color, bool isDisplay)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
- 
 	  double p0[3] = {select[0], select[1], 0.0};
 	  double p1[3] = {select[2], select[1], 0.0};
 	  double p2[3] = {select[0], select[3], 0.0};
@@ -653,14 +588,11 @@ public:
       vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
       polyData->SetPoints(points);
       polyData->SetLines(cells);
-	  mapper->SetInput(polyData);
+	  return addMark(mSurfaceMarks, polyData, color, isDisplay);
   }
 
-  void displayPolygonNote(vtkSmartPointer<vtkPolyDataMapper> mapper, std::vector<std::pair<double, double> >* select)
+  int displayPolygonNote(std::vector<std::pair<double, double> >* select, const ColorType color, bool isDisplay)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-
 	  vtkSmartPointer<vtkPoints> Points = vtkSmartPointer<vtkPoints>::New();
 	  vtkSmartPointer<vtkPolyLine> PolyLine = vtkSmartPointer<vtkPolyLine>::New();
 	  vtkSmartPointer<vtkCellArray> CellArray = vtkSmartPointer<vtkCellArray>::New();
@@ -678,66 +610,71 @@ public:
 	  CellArray->InsertNextCell(PolyLine);
 	  PolyData->SetPoints(Points);
 	  PolyData->SetLines(CellArray);
-	  mapper->SetInput(PolyData);
-	  //// TO BE TESTED
+	  return addMark(mPolygonMarks, PolyData, color, isDisplay);
+  }
+
+  int addMark(AnnotationMarks& marks, vtkPolyData* polyData, const ColorType color, bool isDisplay)
+  {
+	  marks.setRenderer(this->GetInteractor()->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
+	  return marks.add(polyData, ColorPixel[color], isDisplay);
+  }
+
+  void invertMarkColor(AnnotationMarks& marks, int key)
+  {
+	  double color[3];
+	  marks.getColor(key, color);
+	  color[0] = 1 - color[0];
+	  color[1] = 1 - color[1];
+	  color[2] = 1 - color[2];
+	  marks.setColor(key, color);
   }
 
   void highlightPointNote(int id)
   {
-	  double* color = new double[3];
 	  if (mPointNoteHighlight != -1 || mSurfaceNoteHighlight != -1 || mPolygonNoteHighlight != -1)
 	  {
 		  //turnoffHighlight();
 	  }
 	  mPointNoteHighlight = id;
-	  mSelectedPoint[mPointNoteHighlight].second->GetProperty()->GetColor(color);
-	  mSelectedPoint[mPointNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);
+	  invertMarkColor(mPointMarks, mSelectedPoint[mPointNoteHighlight].second);
   }
 
   void highlightSurfaceNote(int id)
   {
-	  double* color = new double[3];
 	  if (mPointNoteHighlight != -1 || mSurfaceNoteHighlight != -1 || mPolygonNoteHighlight != -1)
 	  {
 		  //turnoffHighlight();
 	  }
 	  mSurfaceNoteHighlight = id;
-	  mSelectedSurface[mSurfaceNoteHighlight].second->GetProperty()->GetColor(color);
-	  mSelectedSurface[mSurfaceNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);
+	  invertMarkColor(mSurfaceMarks, mSelectedSurface[mSurfaceNoteHighlight].second);
   }
 
   void highlightPolygonNote(int id)
   {
-	  double* color = new double[3];
 	  if (mPointNoteHighlight != -1 || mSurfaceNoteHighlight != -1 || mPolygonNoteHighlight != -1)
 	  {
 		  //turnoffHighlight();
 	  }
 	  mPolygonNoteHighlight = id;
-	  mSelectedPolygon[mPolygonNoteHighlight].second->GetProperty()->GetColor(color);
-	  mSelectedPolygon[mPolygonNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);
+	  invertMarkColor(mPolygonMarks, mSelectedPolygon[mPolygonNoteHighlight].second);
 	  //// TO BE TESTED
   }
 
   void turnoffHighlight()
   {
-	   double* color = new double[3];
 	   if (mPointNoteHighlight != -1 && mPointNoteHighlight < mSelectedPoint.size())
 	   {
-		   mSelectedPoint[mPointNoteHighlight].second->GetProperty()->GetColor(color);
-		   mSelectedPoint[mPointNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);
+		   invertMarkColor(mPointMarks, mSelectedPoint[mPointNoteHighlight].second);
 		   mPointNoteHighlight = -1;
 	   }
 	   if (mSurfaceNoteHighlight != -1 && mSurfaceNoteHighlight < mSelectedSurface.size()) 
 	   {
-		   mSelectedSurface[mSurfaceNoteHighlight].second->GetProperty()->GetColor(color);		 
-		   mSelectedSurface[mSurfaceNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);		  
+		   invertMarkColor(mSurfaceMarks, mSelectedSurface[mSurfaceNoteHighlight].second);
 		   mSurfaceNoteHighlight = -1;		  
 	   }
-	   if (mPolygonNoteHighlight != -1 && mPolygonNoteHighlight < mSelectedSurface.size()) 
+	   if (mPolygonNoteHighlight != -1 && mPolygonNoteHighlight < mSelectedPolygon.size()) 
 	   {
-		   mSelectedPolygon[mPolygonNoteHighlight].second->GetProperty()->GetColor(color);		 
-		   mSelectedPolygon[mPolygonNoteHighlight].second->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);		  
+		   invertMarkColor(mPolygonMarks, mSelectedPolygon[mPolygonNoteHighlight].second);
 		   mPolygonNoteHighlight = -1;		  
 	   } //// TO BE TESTED
   }
@@ -761,7 +698,7 @@ public:
 		  if(!mw()->mInformation) return false;
 		  for (int i = 0; i < mSelectedPoint.size(); i++)
 		  {
-			  if (!mSelectedPoint[i].second->GetVisibility())
+			  if (!mPointMarks.isVisible(mSelectedPoint[i].second))
 				  continue;
 			  const double* center = mSelectedPoint[i].first;
 			  double distant = sqrt(pow(center[0] - pos[0], 2) + pow(center[1] - pos[1],2));
@@ -798,7 +735,7 @@ public:
 
 		  for (int i = 0; i < mSelectedSurface.size(); i++)
 		  {
-			  if (!mSelectedSurface[i].second->GetVisibility())
+			  if (!mSurfaceMarks.isVisible(mSelectedSurface[i].second))
 				  continue;
 			  const double* edge = mSelectedSurface[i].first;
 			  double maxX = std::max(edge[0], edge[2]);
@@ -840,7 +777,7 @@ public:
 		  if(!mw()->mInformation) return false;
 		  for (int i = 0; i < mSelectedPolygon.size(); i++)
 		  {
-			  if (!mSelectedPolygon[i].second->GetVisibility())
+			  if (!mPolygonMarks.isVisible(mSelectedPolygon[i].second))
 				  continue;
 			  std::vector<std::pair<double, double> >* select = mSelectedPolygon[i].first;
 			  double maxX = 0, maxY = 0, minX = 0xFFFF, minY = 0xFFFF;
@@ -883,7 +820,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedPoint[i].second->VisibilityOff();
+			  mPointMarks.remove(mSelectedPoint[i].second);
 			  mSelectedPoint.erase(mSelectedPoint.begin() + i);
 			  erase = true;
 			  break;
@@ -910,7 +847,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedSurface[i].second->VisibilityOff();
+			  mSurfaceMarks.remove(mSelectedSurface[i].second);
 			  mSelectedSurface.erase(mSelectedSurface.begin() + i);
 			  erase = true;
 			  break;
@@ -937,7 +874,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedPolygon[i].second->VisibilityOff();
+			  mPolygonMarks.remove(mSelectedPolygon[i].second);
 			  mSelectedPolygon.erase(mSelectedPolygon.begin() + i);
 			  erase = true;
 			  break;
@@ -963,7 +900,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedPoint[i].second->VisibilityOn();
+			  mPointMarks.setVisible(mSelectedPoint[i].second, true);
 			  break;
 		  }
 	  }
@@ -985,7 +922,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedSurface[i].second->VisibilityOn();
+			  mSurfaceMarks.setVisible(mSelectedSurface[i].second, true);
 			  break;
 		  }
 	  }
@@ -1008,7 +945,7 @@ public:
 		  }
 		  if (isSame)
 		  {
-			  mSelectedPolygon[i].second->VisibilityOn();
+			  mPolygonMarks.setVisible(mSelectedPolygon[i].second, true);
 			  break;
 		  }
 	  }
@@ -1017,70 +954,17 @@ public:
 
   void displayLoadPointNote(double* point, const ColorType color, bool isDisplay = false)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-	  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-      vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-      actor->GetProperty()->SetColor(ColorPixel[color][0], ColorPixel[color][1], ColorPixel[color][2]);
-      actor->GetProperty()->SetLineWidth(2);
-	  if (isDisplay)
-		  actor->VisibilityOn();
-	  else
-		  actor->VisibilityOff();
-
-      renderer->AddActor(actor);
-	  mSelectedPoint.push_back(std::make_pair(point, actor));
-
-	  displayPointNote(mapper, point);
+	  mSelectedPoint.push_back(std::make_pair(point, displayPointNote(point, color, isDisplay)));
   }
 
   void displayLoadSurfaceNote(double* point, const ColorType color, bool isDisplay = false)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-	  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-      vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-      actor->GetProperty()->SetColor(ColorPixel[color][0], ColorPixel[color][1], ColorPixel[color][2]);
-      actor->GetProperty()->SetLineWidth(2);
-	  if (isDisplay)
-		  actor->VisibilityOn();
-	  else
-		  actor->VisibilityOff();
-
-      renderer->AddActor(actor);
-	  mSelectedSurface.push_back(std::make_pair(point, actor));
-
-	  displaySurfaceNote(mapper, point);
+	  mSelectedSurface.push_back(std::make_pair(point, displaySurfaceNote(point, color, isDisplay)));
   }
 
   void displayLoadPolygonNote(std::vector<std::pair<double, double> >* polygon, const ColorType color, bool isDisplay = false)
   {
-	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
-	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-	  vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-      vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-      actor->GetProperty()->SetColor(ColorPixel[color][0], ColorPixel[color][1], ColorPixel[color][2]);
-      actor->GetProperty()->SetLineWidth(2);
-	  if (isDisplay)
-		  actor->VisibilityOn();
-	  else
-		  actor->VisibilityOff();
-
-      renderer->AddActor(actor);
-	  mSelectedPolygon.push_back(std::make_pair(polygon, actor));
-
-	  displayPolygonNote(mapper, polygon);
-
-	  //// TO BE TESTED
+	  mSelectedPolygon.push_back(std::make_pair(polygon, displayPolygonNote(polygon, color, isDisplay)));
   }
 
   void updateLightingPosition() {
@@ -1282,33 +1166,26 @@ public:
               mHyperImageData->GetDimensions(hdims);
           int components2 = 0;
           shvalue += "( ";
-          if (hdims[0] != 0 || hdims[1] != 0 ) // if there is hyperspectral data
+          if (mHyperProbe.isValid()) // if there is hyperspectral data
           {
-              components2 = mHyperImageData->GetNumberOfScalarComponents();
-              std::vector<float> hyperPixels;
-//              hyperPixels.push_back(0);
-              for(int i=0 ;i<components2;++i) // start from 3 (RGB excluded)
+              // read the whole spectrum at once from the interleaved cube
+              components2 = mHyperProbe.getNumberOfBands();
+              std::vector<std::pair<int, int> > pixels(1, std::make_pair(icoords[0], icoords[1]));
+              mHyperProbe.getSpectra(pixels, mHyperPixels);
+              char number[32];
+              for(int i=0 ;i<components2;++i)
               {
-                float value = mHyperImageData->GetScalarComponentAsFloat( icoords[0], icoords[1], icoords[2], i);
-                hyperPixels.push_back(value);
-                shvalue += vtkVariant(value).ToString();
+                sprintf( number, "%g", mHyperPixels[i] );
+                shvalue += number;
                 // remove comma at the end
                 if (i != (components2 - 1))
                 {
                   shvalue += ", ";
                 }
               }
-//              hyperPixels.push_back(0);
               shvalue += " )";
               sprintf( text, " [Num Ch.: %i ]", components2 );
               shvalue += text;
-
-              // vector copy
-              if (hyperPixels.size() > 0)
-              {
-                mHyperPixels.resize(hyperPixels.size());
-                std::copy(hyperPixels.begin(), hyperPixels.end(), mHyperPixels.begin());
-              }
           } else { // in case only RGB
             components2 = image->GetNumberOfScalarComponents();
             std::vector<float> hyperPixels;
@@ -1531,6 +1408,7 @@ private:
 
   // texture data
   vtkSmartPointer<vtkImageData> mHyperImageData; // for hyperspectral data
+  SpectralProbe mHyperProbe;
 
   QString mGLversion;
   QString mNumCore;
@@ -1539,11 +1417,15 @@ private:
   bool mDisplayInfoOn;
   bool mUserIsAnnotating;
   NoteMode mNoteMode;
-  std::vector<std::pair<double*, vtkSmartPointer<vtkActor> > > mSelectedSurface;
-  std::vector<std::pair<double*, vtkSmartPointer<vtkActor> > > mSelectedPoint;
+  // notes and their keys in the mark batches below
+  std::vector<std::pair<double*, int> > mSelectedSurface;
+  std::vector<std::pair<double*, int> > mSelectedPoint;
   std::vector<std::pair<double, double> > polygonPoints;
   std::vector<std::pair<int, int> > polygonImagePoints;
-  std::vector<std::pair<std::vector<std::pair<double,double> >*, vtkSmartPointer<vtkActor> > > mSelectedPolygon;
+  std::vector<std::pair<std::vector<std::pair<double,double> >*, int> > mSelectedPolygon;
+  AnnotationMarks mPointMarks;
+  AnnotationMarks mSurfaceMarks;
+  AnnotationMarks mPolygonMarks;
   int mPointNoteHighlight;
   int mSurfaceNoteHighlight;
   int mPolygonNoteHighlight;
@@ -65,9 +65,11 @@
 #include <vtkVertexGlyphFilter.h>
 #include <vtkPolygon.h>
 #include <vtkCellArray.h>
+#include <vtkPolyLine.h>
 #include <vtkInteractorObserver.h>
 #include <vtkLandmarkTransform.h>
 #include <vtkPlaneCollection.h>
+#include <vtkPlane.h>
 #include <vtkFrustumSource.h>
 #include <vtkSelectEnclosedPoints.h>
 #include <vtkInteractorStyleRubberBandPick.h>
@@ -89,10 +91,17 @@
 #include "../information/informationWidget.h"
 #include "../mainWindow.h"
 #include "../function/mkTools.hpp"
+#include "../function/spectralProbe.h"
+#include "../function/meshLocator.h"
+#include "../function/meshSelection.h"
+#include "../function/meshGeodesic.h"
 #include "../io/inputimageset.h"
+#include "../io/inputimagecache.h"
+#include "annotationMarks.h"
 
 
 #define GAMMA (2.2f)
+#define PREFETCH_IMAGES (4) // input images decoded ahead around the best one
 
 
 //#define SHOWCAMERALIGHT
@@ -124,7 +133,8 @@ struct SurfaceMark
 {
 	vtkSmartPointer<vtkSelectionNode> cellIds;
 	std::vector<double*> cornerPoints;
-	vtkSmartPointer<vtkActor> actor;
+	int mark; // of the note in mSurfaceMarks
+	int key; // of the note in the cell index
 };
 
 // for 3D interaction callback.
@@ -195,13 +205,15 @@ public:
     //mBestImageActor = vtkSmartPointer<vtkActor2D>::New();
     mBestImageActor = vtkSmartPointer<vtkActor>::New();
     quad = vtkSmartPointer<vtkPolyData>::New();
-    jPEGReader = vtkSmartPointer<vtkJPEGReader>::New();
     mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
     polygons = vtkSmartPointer<vtkCellArray>::New();
     polygon = vtkSmartPointer<vtkPolygon>::New();
 	//mSelectedPoints = vtkSmartPointer<vtkIdTypeArray>::New();
     newTextureLoaded = false;
     currentBestImage = 0;
+    requestedBestImage = 0;
+    currentImageWidth = currentImageHeight = 0;
+    mInputImageCache = NULL;
     imageadded = false;
     checkBestImageRequested = true;
     imageOverlayOn = false; 
@@ -212,6 +224,10 @@ public:
 
     mLightTransform = vtkSmartPointer<vtkTransform>::New();
     mTransform = vtkSmartPointer<vtkTransform>::New();
+    mMeshLocator = NULL;
+    mMeshGeodesic = NULL;
+    mUseGeodesic = false;
+    mNextSurfaceKey = 0;
   }
 
   NoteMode GetNoteMode() {
@@ -220,6 +236,38 @@ public:
 
   void SetPolyData(vtkPolyData *polyData) {
     this->mPolyData = polyData;
+    mMeshSelection.setMesh(polyData);
+  }
+
+  // shared octree of the mesh; pickers use it once it has been built
+  void SetMeshLocator(MeshLocator *locator) {
+    this->mMeshLocator = locator;
+  }
+
+  void SetMeshGeodesic(MeshGeodesic *geodesic) {
+    this->mMeshGeodesic = geodesic;
+  }
+
+  // measure along the surface instead of straight through space
+  void SetUseGeodesic(bool status) {
+    this->mUseGeodesic = status;
+  }
+
+  // position of a surface note in mSelectedSurface, -1 if it is gone
+  int surfaceMarkIndex(int key) {
+    if (key == -1)
+      return -1;
+    for (int i = 0; i < mSelectedSurface.size(); i++)
+      if (mSelectedSurface[i].key == key)
+        return i;
+    return -1;
+  }
+
+  vtkSmartPointer<vtkCellPicker> NewCellPicker() {
+    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+    if (mMeshLocator && mMeshLocator->getDataSet() == mPolyData)
+      mMeshLocator->addTo(picker);
+    return picker;
   }
 
   vtkPolyData *GetImageReslice() {
@@ -252,26 +300,38 @@ public:
 	  }
   }
 
+  void SetInputImageCache(InputImageCache *cache) {
+    this->mInputImageCache = cache;
+  }
+
+  // switches the overlay to image k once it is decoded; until then the previous
+  // image stays on screen (the cache decodes k in the background)
   void LoadNewBestImage(int k)
   {
-	  qDebug() << "k = " << k << "currentBestImage" << currentBestImage;
-      if(k == currentBestImage && k != 0)
+      requestedBestImage = k;
+      if((k == currentBestImage && bestImage) || !mInputImageCache)
+          return;
+
+      vtkImageData *image = mInputImageCache->getImage(k);
+      if(!image)
           return;
 
       currentBestImage = k;
-	  qDebug() << "Before RERENDER";
-      char *myname = (char*)inputImageSet->imageSet[k]->mFileName.toStdString().c_str();
-      qDebug() << "after";
-      jPEGReader->SetFileName(myname);
-      jPEGReader->Update();
-	  
-      currentImageWidth = jPEGReader->GetOutput()->GetDimensions()[0];
-      currentImageHeight = jPEGReader->GetOutput()->GetDimensions()[1];
-      //mBestImageActor->SetTexture(texture);
+      bestImage = image;
+      // the cached image may be shrunk, the camera model is for the original size
+      currentImageWidth = inputImageSet->imageSet[k]->imW;
+      currentImageHeight = inputImageSet->imageSet[k]->imH;
       newTextureLoaded = true;
       mBestImageActor->SetVisibility(1);
-      //GetInteractor()->Render();
-      qDebug() << "RERENDER";
+  }
+
+  // called when the cache has decoded an image the overlay may be waiting for
+  void RefreshBestImage()
+  {
+      if(!imageOverlayOn || !inputImageSet || !inputImageSet->isValid())
+          return;
+      SetBestImage(requestedBestImage);
+      newTextureLoaded = false;
   }
 
   // this function is buggy
@@ -323,7 +383,9 @@ public:
       //QtConcurrent::run(this, &vtk3DInteractionCallback::LoadNewBestImage,k);  // why need multiple threads???
 	  qDebug() << "in Set Best Image k = "<<k;
       LoadNewBestImage(k);
-       
+      if(!bestImage || currentImageWidth <= 0 || currentImageHeight <= 0)
+          return;
+
       double imageAspect = (double)currentImageWidth / (double)currentImageHeight;
 
       double scale_ratio = 1;
@@ -349,7 +411,7 @@ public:
 
       qDebug() << "MOVE IMAGE";
 	  
-      vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+      vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
       picker->SetTolerance(0.0005);
       picker->Pick(window_w/2, window_h/2, 0, GetInteractor()->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
       vtkIdType cellID = picker->GetCellId();
@@ -433,7 +495,7 @@ public:
         if(newTextureLoaded)
         {
             vtkSmartPointer<vtkTexture> texture = vtkSmartPointer<vtkTexture>::New();
-            texture->SetInputConnection(jPEGReader->GetOutputPort());
+            texture->SetInput(bestImage);
             mBestImageActor->SetTexture(texture);
             reRenderBestImage = true;
         }
@@ -488,10 +550,7 @@ public:
 			 {
 				 mSelectedPoints[i].actor->VisibilityOn();
 			 }
-			 for (int i = 0; i < mSelectedSurface.size(); i++)
-			 {
-				 mSelectedSurface[i].actor->VisibilityOn();
-			 }
+			 mSurfaceMarks.setAllVisible(true);
 		 }
          mSelectedActor2->VisibilityOn();
 		 mSurfaceSelector->VisibilityOn();
@@ -511,10 +570,7 @@ public:
 		  {
 			  mSelectedFrustum[i].second->VisibilityOff();
 		  }
-		  for (int i = 0; i < mSelectedSurface.size(); i++)
-		 {
-			 mSelectedSurface[i].actor->VisibilityOff();
-		 }
+		  mSurfaceMarks.setAllVisible(false);
 	  }
   }
 
@@ -543,6 +599,7 @@ public:
   void SetHyperImageData(vtkImageData* hypertexture)
   {
     this->mHyperImageData = hypertexture;
+    this->mHyperProbe.setImageData(hypertexture);
   }
 
   void SetIsDirectLight(bool input) {
@@ -720,7 +777,7 @@ public:
     interactor->GetLastEventPosition(lastPos);
     int currPos[2];
     interactor->GetEventPosition(currPos);
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+    vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
     picker->SetTolerance(0.0005);
     // Pick from this location. (screen location)
     picker->Pick(currPos[0], currPos[1], 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
@@ -796,7 +853,7 @@ public:
     interactor->GetLastEventPosition(lastPos);
     int currPos[2];
     interactor->GetEventPosition(currPos);
-    vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+    vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
 
     picker->PickTextureDataOn(); // default is off
 
@@ -838,34 +895,26 @@ public:
 
     // (3) then read the pixel value from rgbtexture and hypertexture.
     int components2 = 0;
-    int hdims[3];
 
-    if (mHyperImageData) mHyperImageData->GetDimensions(hdims);
-    if (hdims[0] != 0 || hdims[1] != 0 ) // hyperspectral data
+    if (mHyperProbe.isValid()) // hyperspectral data
     {
-      components2 = mHyperImageData->GetNumberOfScalarComponents();
-      std::vector<float> hyperPixels;
-      //hyperPixels.push_back(0);
+      // read the whole spectrum at once from the interleaved cube
+      components2 = mHyperProbe.getNumberOfBands();
+      std::vector<std::pair<int, int> > pixels(1, std::make_pair(icoords[0], icoords[1]));
+      mHyperProbe.getSpectra(pixels, mHyperPixels);
+#ifdef SHOWHYPERVALUES
       for (int c = 0; c < components2; ++c)
         {
-          float value = mHyperImageData->GetScalarComponentAsFloat( icoords[0], icoords[1], icoords[2], c);
-          hyperPixels.push_back(value);
-          shvalues += vtkVariant(value).ToString(); // type: float
+          shvalues += vtkVariant(mHyperPixels[c]).ToString(); // type: float
           if (c != (components2 - 1))
             {
             shvalues += ", ";
             }
         }
-      //hyperPixels.push_back(0);
       shvalues += " )";
       sprintf( text, " [Num Ch.: %i ]", components2  );
       shvalues += text;
-      // vector copy
-      if (hyperPixels.size() > 0)
-      {
-        mHyperPixels.resize(hyperPixels.size());
-        std::copy(hyperPixels.begin(), hyperPixels.end(), mHyperPixels.begin());
-      }
+#endif
     } else { // only RGB data -> need to be flipped
       if (imagergb != NULL) {
         components2 = imagergb->GetNumberOfScalarComponents();
@@ -922,7 +971,7 @@ public:
       // get window dimension
   //    int* dimens = interactor->GetRenderWindow()->Getstart()->GetFirstRenderer()->GetSize();
 
-      picker = vtkSmartPointer<vtkCellPicker>::New();
+      picker = NewCellPicker();
       picker->SetTolerance(0.0005);
 
       // Pick from this location. (screen location)
@@ -1180,8 +1229,11 @@ public:
 	  }
   }
   
-  void displaySurfaceNote(vtkSmartPointer<vtkDataSetMapper> mapper, vtkSmartPointer<vtkSelectionNode> points, QVector<double*> conrnerPoints)
+  // adds the cells of a surface note (or its outline on a CT volume) to the surface
+  // note batch, returns its key there
+  int displaySurfaceNote(vtkSmartPointer<vtkSelectionNode> points, QVector<double*> conrnerPoints, const ColorType color, bool isDisplay)
   {
+	  vtkSmartPointer<vtkPolyData> mark = vtkSmartPointer<vtkPolyData>::New();
 	  if (!isCTVolume)
 	  {
 		  vtkSmartPointer<vtkSelectionNode> selectedNodes = vtkSmartPointer<vtkSelectionNode>::New();
@@ -1195,7 +1247,7 @@ public:
 			  selection->AddNode(selectedNodes);
 			  extr->SetInput(1, selection);
 			  extr->Update();
-			  mapper->SetInput(extr->GetOutput());
+			  mark->ShallowCopy(extr->GetOutput());
 		  }
 	  }
 	  else
@@ -1221,11 +1273,23 @@ public:
 		  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
 		  cells->InsertNextCell(polyLine);
 
-		  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
-		  polyData->SetPoints(corners);
-		  polyData->SetLines(cells);
-		  mapper->SetInput(polyData);
+		  mark->SetPoints(corners);
+		  mark->SetLines(cells);
 	  }
+	  mSurfaceMarks.setCellType(isCTVolume ? AnnotationMarks::LINES : AnnotationMarks::POLYGONS);
+	  mSurfaceMarks.setLineWidth(5);
+	  mSurfaceMarks.setRenderer(this->GetInteractor()->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
+	  return mSurfaceMarks.add(mark, ColorPixel[color], isDisplay);
+  }
+
+  void invertSurfaceMarkColor(int mark)
+  {
+	  double color[3];
+	  mSurfaceMarks.getColor(mark, color);
+	  color[0] = 1 - color[0];
+	  color[1] = 1 - color[1];
+	  color[2] = 1 - color[2];
+	  mSurfaceMarks.setColor(mark, color);
   }
 
   bool displayFrustumNote(vtkSmartPointer<vtkDataSetMapper> mapper, vtkSmartPointer<vtkPlanes> planes)
@@ -1233,6 +1297,28 @@ public:
 	  vtkSmartPointer<QVTKInteractor> interactor = this->GetInteractor();
 	  vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
 
+	  if (!isCTVolume && this->mPolyData)
+	  {
+		  // the cell hierarchy visits only the part of the mesh near the frustum
+		  vtkSmartPointer<vtkIdTypeArray> ids = vtkSmartPointer<vtkIdTypeArray>::New();
+		  mMeshSelection.setMesh(this->mPolyData);
+		  if (!mMeshSelection.selectFrustum(planes, ids))
+			  return false;
+		  vtkSmartPointer<vtkSelectionNode> selectionNode = vtkSmartPointer<vtkSelectionNode>::New();
+		  selectionNode->SetFieldType(vtkSelectionNode::CELL);
+		  selectionNode->SetContentType(vtkSelectionNode::INDICES);
+		  selectionNode->SetSelectionList(ids);
+		  vtkSmartPointer<vtkSelection> selection = vtkSmartPointer<vtkSelection>::New();
+		  selection->AddNode(selectionNode);
+		  vtkSmartPointer<vtkExtractSelectedPolyDataIds> extr = vtkSmartPointer<vtkExtractSelectedPolyDataIds>::New();
+		  extr->SetInput(0, this->mPolyData);
+		  extr->SetInput(1, selection);
+		  extr->Update();
+		  qDebug()<<"selected cells"<<ids->GetNumberOfTuples();
+		  mapper->SetInput(extr->GetOutput());
+		  return true;
+	  }
+
 	  vtkSmartPointer<vtkExtractSelectedFrustum> extractor = vtkSmartPointer<vtkExtractSelectedFrustum>::New();
 	  extractor->SetInput(this->mPolyData);
 	  extractor->PreserveTopologyOff();
@@ -1289,14 +1375,12 @@ public:
 
   void highlightSurfaceNote(int id)
   {
-	  double* color = new double[3];
 	  if (mPointNoteHighlight != -1 || mSurfaceNoteHighlight != -1 || mFrustumNoteHighlight != -1)
 	  {
 		  //turnoffHighlight();
 	  }
 	  mSurfaceNoteHighlight = id;
-	  mSelectedSurface[mSurfaceNoteHighlight].actor->GetProperty()->GetColor(color);
-	  mSelectedSurface[mSurfaceNoteHighlight].actor->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);
+	  invertSurfaceMarkColor(mSelectedSurface[mSurfaceNoteHighlight].mark);
   }
 
   void highlightFrustumNote(int id)
@@ -1322,8 +1406,7 @@ public:
 	   }
 	   if (mSurfaceNoteHighlight != -1 && mSurfaceNoteHighlight < mSelectedSurface.size()) 
 	   {
-		   mSelectedSurface[mSurfaceNoteHighlight].actor->GetProperty()->GetColor(color);		 
-		   mSelectedSurface[mSurfaceNoteHighlight].actor->GetProperty()->SetColor(1-color[0], 1-color[1], 1-color[2]);		  
+		   invertSurfaceMarkColor(mSelectedSurface[mSurfaceNoteHighlight].mark);
 		   mSurfaceNoteHighlight = -1;		  
 	   }
 	   if (mFrustumNoteHighlight != -1 && mFrustumNoteHighlight < mSelectedFrustum.size())
@@ -1341,7 +1424,7 @@ public:
 	  int currPos[2];
 	  interactor->GetEventPosition(currPos);
 
-	  vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
 	  picker->SetTolerance(0.0005);
 
 	  // Pick from this location. (screen location)
@@ -1385,22 +1468,28 @@ public:
       vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
       int currPos[2];
       interactor->GetEventPosition(currPos);
-	  vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
 	  picker->Pick(currPos[0], currPos[1], 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
-	  if(picker->GetCellId() != -1)
+	  if(picker->GetCellId() != -1 && !isCTVolume)
+	  {
+		  // only the notes covering the picked cell are looked at
+		  QList<int> keys = mMeshSelection.surfaceNotesAt(picker->GetCellId());
+		  for (int k = 0; k < keys.size(); k++)
+		  {
+			  int i = surfaceMarkIndex(keys[k]);
+			  if (i == -1 || !mSurfaceMarks.isVisible(mSelectedSurface[i].mark))
+				  continue;
+			  //highlightSurfaceNote(i);
+			  mw()->mInformation->openSurfaceNote(mSelectedSurface[i].cellIds, mSelectedSurface[i].cornerPoints, false);
+			  return true;
+		  }
+	  }
+	  else if(picker->GetCellId() != -1)
 	  {
 		  for (int i = 0; i < mSelectedSurface.size(); i++)
 		  {
-			  if (!mSelectedSurface[i].actor->GetVisibility())
+			  if (!mSurfaceMarks.isVisible(mSelectedSurface[i].mark))
 				  continue;
-			  if (!isCTVolume && mSelectedSurface[i].cellIds->GetSelectionList()->LookupValue(picker->GetCellId()) != -1)
-			  {
-				  //highlightSurfaceNote(i);
-				  //qDebug()<<"Selected surface "<<i<<endl;
-				  mw()->mInformation->openSurfaceNote(mSelectedSurface[i].cellIds, mSelectedSurface[i].cornerPoints, false);
-				  return true;
-			  }
-			  else if (isCTVolume)
 			  {
 				  double* worldPosition = picker->GetPickPosition();
 				  vtkSmartPointer<vtkCamera> camera = renderer->GetActiveCamera();
@@ -1451,25 +1540,30 @@ public:
       vtkSmartPointer<vtkRenderer> renderer = interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
       int currPos[2];
       interactor->GetEventPosition(currPos);
-	  vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
 	  picker->Pick(currPos[0], currPos[1], 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 	  double* worldPosition = picker->GetPickPosition();
-	  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-      points->InsertNextPoint(worldPosition);
- 
-	  vtkSmartPointer<vtkPolyData> pointsPolydata = vtkSmartPointer<vtkPolyData>::New();
-	  pointsPolydata->SetPoints(points);
 	  for (int i = 0; i < mSelectedFrustum.size(); i++)
 	  {
 		  if (!mSelectedFrustum[i].second->GetVisibility())
 			  continue;
-		  vtkSmartPointer<vtkFrustumSource> frustum = vtkSmartPointer<vtkFrustumSource>::New();
-		  frustum->SetPlanes(mSelectedFrustum[i].first);
-		  vtkSmartPointer<vtkSelectEnclosedPoints> selectEnclosedPoints = vtkSmartPointer<vtkSelectEnclosedPoints>::New();
-		  selectEnclosedPoints->SetInput(pointsPolydata);
-		  selectEnclosedPoints->SetSurface(frustum->GetOutput());
-		  selectEnclosedPoints->Update();
-		  if(selectEnclosedPoints->IsInside(0))
+		  // the frustum is convex: inside means behind all of its planes
+		  bool isInside = true;
+		  vtkSmartPointer<vtkPlanes> planes = mSelectedFrustum[i].first;
+		  vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
+		  double center[3] = {0, 0, 0};
+		  for (int j = 0; j < planes->GetNumberOfPlanes(); j++)
+		  {
+			  planes->GetPlane(j, plane);
+			  for (int k = 0; k < 3; k++)
+				  center[k] += plane->GetOrigin()[k] / planes->GetNumberOfPlanes();
+		  }
+		  for (int j = 0; j < planes->GetNumberOfPlanes() && isInside; j++)
+		  {
+			  planes->GetPlane(j, plane);
+			  isInside = plane->EvaluateFunction(worldPosition) * plane->EvaluateFunction(center) >= 0;
+		  }
+		  if(isInside)
 		  {
 			  //highlightFrustumNote(i);
 			  //qDebug()<<"Selected Frustum "<<i<<endl;
@@ -1509,27 +1603,16 @@ public:
 
   void displayLoadSurfaceNote(vtkSmartPointer<vtkSelectionNode> cellIds, QVector<double*> points, const ColorType color, bool isDisplay = false)
   {
-	  vtkSmartPointer<vtkRenderer> renderer = this->GetInteractor()->GetRenderWindow()->GetRenderers()->GetFirstRenderer();
-	  vtkSmartPointer<vtkDataSetMapper> mapper = vtkSmartPointer<vtkDataSetMapper>::New();
-      vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-      actor->GetProperty()->SetColor(ColorPixel[color][0], ColorPixel[color][1], ColorPixel[color][2]);
-      actor->GetProperty()->SetLineWidth(5);
-      if (isDisplay)
-		  actor->VisibilityOn();
-	  else
-		  actor->VisibilityOff();
-      renderer->AddActor(actor);
 	  vtkSmartPointer<vtkSelectionNode> newCellIds = vtkSmartPointer<vtkSelectionNode>::New();
 	  newCellIds->DeepCopy(cellIds);
 	  SurfaceMark surfaceNote;
 	  surfaceNote.cellIds = newCellIds;
 	  surfaceNote.cornerPoints = points.toStdVector();
-	  surfaceNote.actor = actor;
+	  surfaceNote.mark = displaySurfaceNote(newCellIds, points, color, isDisplay);
+	  surfaceNote.key = mNextSurfaceKey++;
+	  if (!isCTVolume)
+		  mMeshSelection.addSurfaceNote(surfaceNote.key, newCellIds->GetSelectionList());
 	  mSelectedSurface.push_back(surfaceNote);
-	  displaySurfaceNote(mapper, newCellIds, points);
 	  qDebug()<<"load Surface note" << mSelectedSurface.size();
   }
 
@@ -1584,7 +1667,7 @@ public:
 
       int currPos[2];
       interactor->GetEventPosition(currPos);
-      vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+      vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
       picker->SetTolerance(0.0005);
 
       // Pick from this location. (screen location)
@@ -1650,7 +1733,7 @@ public:
 	  double y1 = renderer->GetPickY2();
 	  QVector<double*> points;
 
-	  vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
       picker->SetTolerance(0.0005);
       picker->Pick(x0, y0, 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 	  if (picker->GetCellId() == -1)
@@ -1658,7 +1741,7 @@ public:
 	  double* worldPosition1 = picker->GetPickPosition();
 	  points.push_back(worldPosition1);
 
-	  vtkSmartPointer<vtkCellPicker> picker1 = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker1 = NewCellPicker();
       picker1->SetTolerance(0.0005);
 	  picker1->Pick(x0, y1, 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 	  if (picker1->GetCellId() == -1)
@@ -1666,7 +1749,7 @@ public:
 	  double* worldPosition2 = picker1->GetPickPosition();
 	  points.push_back(worldPosition2);
 
-	  vtkSmartPointer<vtkCellPicker> picker2 = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker2 = NewCellPicker();
       picker2->SetTolerance(0.0005);
 	  picker2->Pick(x1, y1, 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 	  if (picker2->GetCellId() == -1)
@@ -1674,7 +1757,7 @@ public:
 	  double* worldPosition3 = picker2->GetPickPosition();
 	  points.push_back(worldPosition3);
 
-	  vtkSmartPointer<vtkCellPicker> picker3 = vtkSmartPointer<vtkCellPicker>::New();
+	  vtkSmartPointer<vtkCellPicker> picker3 = NewCellPicker();
       picker3->SetTolerance(0.0005);
 	  picker3->Pick(x1, y0, 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 	  if (picker3->GetCellId() == -1)
@@ -1693,15 +1776,6 @@ public:
      		qDebug() << "Selection not supported.";
 			return;
 	  }	
-	  vtkSmartPointer<vtkDataSetMapper> mapper = vtkSmartPointer<vtkDataSetMapper>::New();
-      vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-	  actor->SetMapper(mapper);
-	  actor->PickableOff();
-	  actor->GetProperty()->LightingOn();
-      actor->GetProperty()->SetColor(ColorPixel[mColor][0], ColorPixel[mColor][1], ColorPixel[mColor][2]);
-      actor->GetProperty()->SetLineWidth(5);
-      actor->VisibilityOn();
-      renderer->AddActor(actor);
 	  if (!res->GetNode(0) && !isCTVolume)
 		  return;
 
@@ -1724,9 +1798,11 @@ public:
 	  surfaceNote.cornerPoints.push_back(conerPoint3);
 	  surfaceNote.cornerPoints.push_back(conerPoint4);
 
-	  surfaceNote.actor = actor;
+	  surfaceNote.mark = displaySurfaceNote(res->GetNode(0), points, mColor, true);
+	  surfaceNote.key = mNextSurfaceKey++;
+	  if (!isCTVolume)
+		  mMeshSelection.addSurfaceNote(surfaceNote.key, surfaceNote.cellIds->GetSelectionList());
 	  mSelectedSurface.push_back(surfaceNote);
-      displaySurfaceNote(mapper, res->GetNode(0), points);
 	  mw()->mInformation->createSurfaceNote(res->GetNode(0), points, mColor, isCTVolume);
   }
 
@@ -1779,26 +1855,13 @@ public:
 			  return;
 		  }
 		  
-		  for (int i = 0; i < mSelectedSurface.size(); i++)
+		  int i = surfaceMarkIndex(mMeshSelection.findSurfaceNote(cellIds->GetSelectionList()));
+		  if (i != -1)
 		  {
-			  if (cellIds->GetSelectionList()->GetSize() != mSelectedSurface[i].cellIds->GetSelectionList()->GetSize())
-				  continue;
-			  bool elementExist = true;
-			  for (int j = 0; j < mSelectedSurface[i].cellIds->GetSelectionList()->GetSize(); j++)
-			  {
-				  if (cellIds->GetSelectionList()->LookupValue(mSelectedSurface[i].cellIds->GetSelectionList()->GetVariantValue(j)) == -1)
-				  {
-					  elementExist = false;
-					  break;
-				  }
-			  }
-			  if (elementExist)
-			  {
-				  mSelectedSurface[i].actor->VisibilityOff();
-				  mSelectedSurface.erase(mSelectedSurface.begin() + i);
-				  erase = true;
-				  break;
-			  }
+			  mSurfaceMarks.remove(mSelectedSurface[i].mark);
+			  mMeshSelection.removeSurfaceNote(mSelectedSurface[i].key);
+			  mSelectedSurface.erase(mSelectedSurface.begin() + i);
+			  erase = true;
 		  }
 	  }
 	  else
@@ -1818,7 +1881,8 @@ public:
 			  if (!isSame)
 				  continue;
 			  
-			  mSelectedSurface[i].actor->VisibilityOff();
+			  mSurfaceMarks.remove(mSelectedSurface[i].mark);
+			  mMeshSelection.removeSurfaceNote(mSelectedSurface[i].key);
 			  mSelectedSurface.erase(mSelectedSurface.begin() + i);
 			  erase = true;
 			  break;
@@ -1896,25 +1960,11 @@ public:
 			  return;
 		  }
 		 
-		  for (int i = 0; i < mSelectedSurface.size(); i++)
+		  int i = surfaceMarkIndex(mMeshSelection.findSurfaceNote(cellIds->GetSelectionList()));
+		  if (i != -1)
 		  {
-			  if (cellIds->GetSelectionList()->GetSize() != mSelectedSurface[i].cellIds->GetSelectionList()->GetSize())
-				  continue;
-			  bool elementExist = true;
-			  for (int j = 0; j < mSelectedSurface[i].cellIds->GetSelectionList()->GetSize(); j++)
-			  {
-				  if (cellIds->GetSelectionList()->LookupValue(mSelectedSurface[i].cellIds->GetSelectionList()->GetVariantValue(j)) == -1)
-				  {
-					  elementExist = false;
-					  break;
-				  }
-			  }
-			  if (elementExist)
-			  {
-				  mSelectedSurface[i].actor->VisibilityOn();
-				  open = true;
-				  break;
-			  }
+			  mSurfaceMarks.setVisible(mSelectedSurface[i].mark, true);
+			  open = true;
 		  }
 	  }
 	  else
@@ -1934,7 +1984,7 @@ public:
 			  if (!isSame)
 				  continue;
 			  
-			 mSelectedSurface[i].actor->VisibilityOn();
+			 mSurfaceMarks.setVisible(mSelectedSurface[i].mark, true);
 			 open = true;
 			 break;
 		  }
@@ -1998,12 +2048,14 @@ public:
 
     int currPos[2];
     interactor->GetEventPosition(currPos);
-    vtkSmartPointer<vtkCellPicker> currpicker = vtkSmartPointer<vtkCellPicker>::New();
+    vtkSmartPointer<vtkCellPicker> currpicker = NewCellPicker();
     currpicker->SetTolerance(0.0005);  
 
     // Pick from this location. (screen location)
     currpicker->Pick(currPos[0], currPos[1], 0, interactor->GetRenderWindow()->GetRenderers()->GetFirstRenderer());
 
+    // the geodesic path needs a cell of the mesh; markers and other props only give a straight line
+    mRubberStartCell = (currpicker->GetDataSet() == mPolyData.GetPointer()) ? currpicker->GetCellId() : -1;
     if (currpicker->GetCellId() != -1)
     {
       currpicker->GetPickPosition(mRubberStart);
@@ -2020,7 +2072,7 @@ public:
       // detect the current world coordinates
       int currPos[2];
       interactor->GetEventPosition(currPos);
-      vtkSmartPointer<vtkCellPicker> currpicker = vtkSmartPointer<vtkCellPicker>::New();
+      vtkSmartPointer<vtkCellPicker> currpicker = NewCellPicker();
       currpicker->SetTolerance(0.0005);
 
       // Pick from this location. (screen location)
@@ -2065,7 +2117,7 @@ public:
     int currPos[2];
     interactor->GetEventPosition(currPos);
 
-    vtkSmartPointer<vtkCellPicker> currpicker = vtkSmartPointer<vtkCellPicker>::New();
+    vtkSmartPointer<vtkCellPicker> currpicker = NewCellPicker();
     currpicker->SetTolerance(0.0005);
 
     // Pick from this location. (screen location)
@@ -2079,8 +2131,35 @@ public:
 
       mRubberDist = sqrt(vtkMath::Distance2BetweenPoints(mRubberStart,mRubberEnd));
 
+      bool isGeodesic = false;
+      vtkIdType rubberEndCell = (currpicker->GetDataSet() == mPolyData.GetPointer()) ? currpicker->GetCellId() : -1;
+      if (mUseGeodesic && mMeshGeodesic && !isCTVolume && mRubberStartCell != -1 && rubberEndCell != -1)
+      {
+        // replace the straight rubberband by the shortest path on the surface
+        vtkSmartPointer<vtkPoints> pathPoints = vtkSmartPointer<vtkPoints>::New();
+        double dist = mMeshGeodesic->computeDistance(mRubberStart, mRubberStartCell, mRubberEnd, rubberEndCell, pathPoints);
+        if (dist >= 0)
+        {
+          vtkSmartPointer<vtkPolyLine> polyLine = vtkSmartPointer<vtkPolyLine>::New();
+          polyLine->GetPointIds()->SetNumberOfIds(pathPoints->GetNumberOfPoints());
+          for (vtkIdType i = 0; i < pathPoints->GetNumberOfPoints(); i++)
+            polyLine->GetPointIds()->SetId(i, i);
+          vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+          lines->InsertNextCell(polyLine);
+          vtkSmartPointer<vtkPolyData> path = vtkSmartPointer<vtkPolyData>::New();
+          path->SetPoints(pathPoints);
+          path->SetLines(lines);
+
+          mSelectedMapper2->SetInput(path);
+          mSelectedMapper2->Update();
+          mSelectedActor2->VisibilityOn();
+          mRubberDist = dist;
+          isGeodesic = true;
+        }
+      }
+
       char text1[512]; memset( text1, 0, sizeof(text1) );
-      sprintf( text1, "   (%.2fcm)", mRubberDist/10. );
+      sprintf( text1, isGeodesic ? "   (%.2fcm on surface)" : "   (%.2fcm)", mRubberDist/10. );
 
       vtkSmartPointer<vtkVectorText> vtext = vtkSmartPointer<vtkVectorText>::New();
 
@@ -2274,12 +2353,21 @@ public:
         camera->GetFocalPoint(focalPos);
         vtkMath::Subtract(focalPos,camPos,mCurrViewVec);
         vtkMath::Normalize(mCurrViewVec);
-        int bestInputImage = currentBestImage;
+        int bestInputImage = requestedBestImage;
 		
         if(checkBestImageRequested)
         {
-            bestInputImage = inputImageSet->getClosestImage(camPos, mCurrViewVec); 
+            // the photo should show the part of the surface in the middle of the view
+            int *size = interactor->GetRenderWindow()->GetSize();
+            vtkSmartPointer<vtkCellPicker> picker = NewCellPicker();
+            picker->Pick(size[0] / 2, size[1] / 2, 0, renderer);
+            double surfacePoint[3];
+            picker->GetPickPosition(surfacePoint);
+            bestInputImage = inputImageSet->getBestImage(camPos, mCurrViewVec, picker->GetCellId() != -1 ? surfacePoint : NULL);
             checkBestImageRequested = false;
+            // decode the views around this one before the camera gets there
+            if(mInputImageCache)
+                mInputImageCache->prefetch(inputImageSet->getClosestImages(camPos, mCurrViewVec, PREFETCH_IMAGES));
         }
 		SetBestImage(bestInputImage);
         if(newTextureLoaded)
@@ -2307,6 +2395,11 @@ private:
 
   // for selection of triangle mesh
   vtkSmartPointer<vtkPolyData> mPolyData;
+  MeshLocator *mMeshLocator;
+  MeshGeodesic *mMeshGeodesic;
+  bool mUseGeodesic;
+  MeshSelection mMeshSelection; // cell hierarchy for frustum queries, cell -> surface note index
+  int mNextSurfaceKey;
   vtkSmartPointer<vtkDataSetMapper> mSelectedMapper;
   vtkSmartPointer<vtkActor> mSelectedActor;
 
@@ -2323,6 +2416,7 @@ private:
   // texture data
   vtkSmartPointer<vtkTexture> mRgbTexture;
   vtkSmartPointer<vtkImageData> mHyperImageData;
+  SpectralProbe mHyperProbe;
 
   vtkSmartPointer<vtkCornerAnnotation>  mInfoAnnotation;  // Pointer to the annotation
 
@@ -2348,6 +2442,7 @@ private:
 
   double mRubberStart[3];
   double mRubberEnd[3];
+  vtkIdType mRubberStartCell;
   double mRubberDist;
   bool mWasReadyRubberband;
 
@@ -2359,6 +2454,7 @@ private:
   std::vector<PointMark> mSelectedPoints;  //used for point note
   std::vector<std::pair<vtkSmartPointer<vtkPlanes>, vtkSmartPointer<vtkActor> > > mSelectedFrustum;   //used for frustum note
   std::vector<SurfaceMark> mSelectedSurface;  //used for surface note
+  AnnotationMarks mSurfaceMarks;  // all surface notes, drawn by one actor
   int mPointNoteHighlight;
   int mSurfaceNoteHighlight;
   int mFrustumNoteHighlight;
@@ -2379,11 +2475,13 @@ private:
   // for image overlays
   vtkSmartPointer<vtkActor> mBestImageActor;
   vtkSmartPointer<vtkPolyData> quad;
-  vtkSmartPointer<vtkJPEGReader> jPEGReader;
+  vtkSmartPointer<vtkImageData> bestImage; // texture of the overlay
+  InputImageCache *mInputImageCache;
   vtkSmartPointer<vtkPolyDataMapper> mapper;
   vtkSmartPointer<vtkCellArray> polygons;
   vtkSmartPointer<vtkPolygon> polygon;
   int currentBestImage;
+  int requestedBestImage;
   int currentImageWidth, currentImageHeight;
   bool checkBestImageRequested;
   bool imageadded;
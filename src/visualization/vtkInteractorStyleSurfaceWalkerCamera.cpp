@@ -40,10 +40,11 @@
 #include <vtkCellArray.h>
 #include <vtkTriangle.h>
 #include <vtkKdTreePointLocator.h>
+#include <vtkMath.h>
 #include <vtkExtractCells.h>
 #include <vtkUnstructuredGrid.h>
 #include <vtkGeometryFilter.h>
-#include "lscm_engine.h"
+#include "../function/meshFlattener.h"
 #include "vtkWidget.h"
 #include <vtkMatrix4x4.h>
 #include <vtkIdFilter.h>
@@ -57,10 +58,13 @@ vtkStandardNewMacro(vtkInteractorStyleSurfaceWalkerCamera);
 
 vtkInteractorStyleSurfaceWalkerCamera::vtkInteractorStyleSurfaceWalkerCamera()
 {
-    lscm_engine = new LSCM();
-    renderFlat = false;
+    mFlattener = NULL;
+    mVTKWidget = NULL;
+    mLiveFlatten = false;
     mExtractRadius = 0.01;
     mCamDistance = 1.0;
+    targetFaceID = -1;
+    mAdjacencyMesh = NULL;
 }
 
 void vtkInteractorStyleSurfaceWalkerCamera::OnLeftButtonDown()
@@ -153,6 +157,7 @@ void vtkInteractorStyleSurfaceWalkerCamera::testPointNormals()
 #endif
     normalGenerator->ComputePointNormalsOn();
     normalGenerator->ComputeCellNormalsOff();
+    normalGenerator->SplittingOff(); // keep the point ids of the shared locators and the adjacency
     normalGenerator->Update();
     /*
     // Optional settings
@@ -233,12 +238,6 @@ void vtkInteractorStyleSurfaceWalkerCamera::surfacePan()
 
     vtkCamera *camera = this->CurrentRenderer->GetActiveCamera();
 
-    if(renderFlat)
-    {
-        mVTKWidget->setNonFlattenedMesh(mPolyData);
-        renderFlat = false;
-    }
-
     vtkRenderWindowInteractor *rwi = this->Interactor;
 
     double viewFocus[4], focalDepth;
@@ -282,20 +281,27 @@ void vtkInteractorStyleSurfaceWalkerCamera::surfacePan()
         this->CurrentRenderer->UpdateLightsGeometryToFollowCamera();
     }
 
+    // the previous flat view stays on screen until the region under the new target is solved
+    if(mLiveFlatten)
+        requestFlattening();
+
     rwi->Render();
 }
 
-void vtkInteractorStyleSurfaceWalkerCamera::linkPolyData(vtkPolyData *polyData, vtkCamera *camera)
+void vtkInteractorStyleSurfaceWalkerCamera::linkPolyData(vtkPolyData *polyData, vtkCamera *camera, MeshLocator *locator)
 {
     mPolyData = polyData;
-
-    cellLocator = vtkSmartPointer<vtkCellLocator>::New();
-    cellLocator->SetDataSet(polyData);
-    cellLocator->BuildLocator();
-
-    kdTree = vtkSmartPointer<vtkKdTreePointLocator>::New();
-    kdTree->SetDataSet(polyData);
-    kdTree->BuildLocator();
+    mLiveFlatten = false;
+    if(mFlattener)
+        mFlattener->reset();
+    if(mVTKWidget)
+        mVTKWidget->setNonFlattenedMesh();
+
+    // the octree and kd-tree are shared with the pickers of the widget;
+    // this waits only if they are still being built after loading
+    locator->build(polyData);
+    cellLocator = locator->getCellLocator();
+    kdTree = locator->getPointLocator();
 
     //double aveNormal[3] = {0,0,0};
     testPointNormals();
@@ -334,6 +340,8 @@ void vtkInteractorStyleSurfaceWalkerCamera::linkPolyData(vtkPolyData *polyData,
     this->ComputeWorldToDisplay(viewFocus[0], viewFocus[1], viewFocus[2], displayPt);
     vtkSmartPointer<vtkCellPicker> picker = vtkSmartPointer<vtkCellPicker>::New();
     picker->SetTolerance(0.0005);
+    if (cellLocator)
+        picker->AddLocator(cellLocator);
     picker->Pick(displayPt[0], displayPt[1], 0, this->GetDefaultRenderer());
     camera->GetPosition(mCamPos);
     mViewTarget[0] = picker->GetPickPosition()[0];
@@ -352,79 +360,203 @@ void vtkInteractorStyleSurfaceWalkerCamera::linkVtkWidget(VtkWidget *_vtkWidget)
     mVTKWidget = _vtkWidget;
 }
 
+void vtkInteractorStyleSurfaceWalkerCamera::buildAdjacency()
+{
+    // CSR vertex -> cell table: the cells of point p are
+    // mPointCells[mPointCellOffsets[p] .. mPointCellOffsets[p+1]-1]
+    const vtkIdType numPoints = mPolyData->GetNumberOfPoints();
+    const vtkIdType numCells = mPolyData->GetNumberOfCells();
+    vtkIdType npts, *pts;
+
+    mPointCellOffsets.assign(numPoints + 1, 0);
+    for(vtkIdType c = 0; c < numCells; ++c)
+    {
+        mPolyData->GetCellPoints(c, npts, pts);
+        for(vtkIdType k = 0; k < npts; ++k)
+            mPointCellOffsets[pts[k] + 1]++;
+    }
+    for(vtkIdType p = 0; p < numPoints; ++p)
+        mPointCellOffsets[p + 1] += mPointCellOffsets[p];
+
+    mPointCells.resize(mPointCellOffsets[numPoints]);
+    std::vector<int> next(mPointCellOffsets.begin(), mPointCellOffsets.end() - 1);
+    for(vtkIdType c = 0; c < numCells; ++c)
+    {
+        mPolyData->GetCellPoints(c, npts, pts);
+        for(vtkIdType k = 0; k < npts; ++k)
+            mPointCells[next[pts[k]]++] = (int)c;
+    }
+
+    // scratch state of the flood fill, cleared again after every extraction
+    mLocalPointIds.assign(numPoints, -1);
+    mPointVisited.assign(numPoints, false);
+    mCellVisited.assign(numCells, false);
+    mAdjacencyMesh = mPolyData;
+}
+
 vtkPolyData* vtkInteractorStyleSurfaceWalkerCamera::extractSubset(double R)
 {
     qDebug() << "R: " << R;
-    vtkSmartPointer<vtkIdList> vertexList = vtkSmartPointer<vtkIdList>::New();
-    kdTree->FindPointsWithinRadius(R, mViewTarget, vertexList);
-    int numberOfVertices = vertexList->GetNumberOfIds();
-    qDebug() << "numverts: " << numberOfVertices;
-    vtkSmartPointer<vtkIdList> cellList = vtkSmartPointer<vtkIdList>::New();
-    for(int i = 0; i < numberOfVertices; ++i)
+    if(mAdjacencyMesh != mPolyData || (vtkIdType)mLocalPointIds.size() != mPolyData->GetNumberOfPoints())
+        buildAdjacency();
+
+    // Flood fill over the cells connected to the target face. A vertex within R
+    // of the view target pulls in all of its cells, so the region is the same set
+    // of cells as before but only the piece of surface under the camera.
+    const double R2 = R * R;
+    std::vector<vtkIdType> cells;      // global ids, in flood order
+    std::vector<vtkIdType> seenPoints; // to clear the visited flags afterwards
+    std::vector<vtkIdType> seeds;
+    if(targetFaceID >= 0 && targetFaceID < mPolyData->GetNumberOfCells())
+    {
+        seeds.push_back(targetFaceID);
+    }
+    else
+    {
+        vtkSmartPointer<vtkIdList> vertexList = vtkSmartPointer<vtkIdList>::New();
+        kdTree->FindPointsWithinRadius(R, mViewTarget, vertexList);
+        for(vtkIdType i = 0; i < vertexList->GetNumberOfIds(); ++i)
+        {
+            vtkIdType v = vertexList->GetId(i);
+            for(int j = mPointCellOffsets[v]; j < mPointCellOffsets[v + 1]; ++j)
+                seeds.push_back(mPointCells[j]);
+        }
+    }
+    for(size_t i = 0; i < seeds.size(); ++i)
+    {
+        if(!mCellVisited[seeds[i]])
+        {
+            mCellVisited[seeds[i]] = true;
+            cells.push_back(seeds[i]);
+        }
+    }
+
+    vtkIdType npts, *pts;
+    double x[3];
+    for(size_t head = 0; head < cells.size(); ++head)
     {
-        vtkIdType vi = vertexList->GetId(i);
-        vtkSmartPointer<vtkIdList> cellList_i = vtkSmartPointer<vtkIdList>::New();
-        mPolyData->GetPointCells(vi,cellList_i);
-        for(int j = 0; j < cellList_i->GetNumberOfIds(); ++j)
+        mPolyData->GetCellPoints(cells[head], npts, pts);
+        for(vtkIdType k = 0; k < npts; ++k)
         {
-            vtkIdType cj = cellList_i->GetId(j);
-            cellList->InsertUniqueId(cj);
+            vtkIdType v = pts[k];
+            if(mPointVisited[v])
+                continue;
+            mPointVisited[v] = true;
+            seenPoints.push_back(v);
+            mPolyData->GetPoint(v, x);
+            if(vtkMath::Distance2BetweenPoints(x, mViewTarget) > R2)
+                continue;
+            for(int j = mPointCellOffsets[v]; j < mPointCellOffsets[v + 1]; ++j)
+            {
+                int c = mPointCells[j];
+                if(!mCellVisited[c])
+                {
+                    mCellVisited[c] = true;
+                    cells.push_back(c);
+                }
+            }
         }
     }
-    int numberOfCells = cellList->GetNumberOfIds();
+    int numberOfCells = (int)cells.size();
     qDebug() << "numcells: " << numberOfCells;
 
-    vtkSmartPointer<vtkIdFilter> idFilter = vtkSmartPointer<vtkIdFilter>::New();
-    idFilter->PointIdsOff();
-    idFilter->CellIdsOn();
-    idFilter->SetInput(mPolyData);
-    idFilter->SetIdsArrayName("originalIDs");
-    idFilter->Update();
-    vtkSmartPointer<vtkDataSet> polyDataPlusIDs = idFilter->GetOutput();
-
-    vtkSmartPointer<vtkExtractCells> extractCells = vtkSmartPointer<vtkExtractCells>::New();
-    extractCells->SetInput(polyDataPlusIDs);
-    extractCells->SetCellList(cellList);
-    extractCells->Update();
-    vtkSmartPointer<vtkUnstructuredGrid> selected = vtkSmartPointer<vtkUnstructuredGrid>::New();
-    selected->ShallowCopy(extractCells->GetOutput());
+    // local mesh: points renumbered in order of first use, all point and cell data carried over
+    std::vector<vtkIdType> localPoints;
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->Allocate(polys->EstimateSize(numberOfCells, 3));
+    for(int i = 0; i < numberOfCells; ++i)
+    {
+        mPolyData->GetCellPoints(cells[i], npts, pts);
+        polys->InsertNextCell(npts);
+        for(vtkIdType k = 0; k < npts; ++k)
+        {
+            vtkIdType v = pts[k];
+            if(mLocalPointIds[v] < 0)
+            {
+                mLocalPointIds[v] = (vtkIdType)localPoints.size();
+                localPoints.push_back(v);
+            }
+            polys->InsertCellPoint(mLocalPointIds[v]);
+        }
+    }
+
+    const vtkIdType numberOfPoints = (vtkIdType)localPoints.size();
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataType(mPolyData->GetPoints()->GetDataType());
+    points->SetNumberOfPoints(numberOfPoints);
+    vtkPointData* inPD = mPolyData->GetPointData();
+    mPolyDataFlat = vtkSmartPointer<vtkPolyData>::New();
+    vtkPointData* outPD = mPolyDataFlat->GetPointData();
+    outPD->CopyAllocate(inPD, numberOfPoints);
+    // lets the LSCM solver warm start from the previous flattening
+    vtkSmartPointer<vtkIdTypeArray> originalPointIDs = vtkSmartPointer<vtkIdTypeArray>::New();
+    originalPointIDs->SetName("originalPointIDs");
+    originalPointIDs->SetNumberOfTuples(numberOfPoints);
+    for(vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+        points->SetPoint(i, mPolyData->GetPoint(localPoints[i]));
+        outPD->CopyData(inPD, localPoints[i], i);
+        originalPointIDs->SetValue(i, localPoints[i]);
+    }
+    outPD->AddArray(originalPointIDs);
 
     originalCellIDs = vtkSmartPointer<vtkIdTypeArray>::New();
-    originalCellIDs->DeepCopy(vtkIdTypeArray::SafeDownCast(extractCells->GetOutput()->GetCellData()->GetArray("originalIDs")));
+    originalCellIDs->SetName("originalIDs");
+    originalCellIDs->SetNumberOfTuples(numberOfCells);
+    vtkCellData* inCD = mPolyData->GetCellData();
+    vtkCellData* outCD = mPolyDataFlat->GetCellData();
+    outCD->CopyAllocate(inCD, numberOfCells);
+    for(int i = 0; i < numberOfCells; ++i)
+    {
+        originalCellIDs->SetValue(i, cells[i]);
+        outCD->CopyData(inCD, cells[i], i);
+    }
+    outCD->AddArray(originalCellIDs);
     localTargetFaceID = originalCellIDs->LookupValue(targetFaceID);
 
-    vtkSmartPointer<vtkGeometryFilter> geometryFilter = vtkSmartPointer<vtkGeometryFilter>::New();
-    #if VTK_MAJOR_VERSION <= 5
-      geometryFilter->SetInput(selected);
-    #else
-      geometryFilter->SetInputData(selected);
-    #endif
-      geometryFilter->Update();
-
-    mPolyDataFlat = vtkSmartPointer<vtkPolyData>::New();
-    mPolyDataFlat->ShallowCopy(geometryFilter->GetOutput());
+    mPolyDataFlat->SetPoints(points);
+    mPolyDataFlat->SetPolys(polys);
+    qDebug() << "numvertsflat" << numberOfPoints;
 
-    qDebug() << "numvertsflat" << mPolyDataFlat->GetPoints()->GetNumberOfPoints();
+    // leave the scratch flags clean for the next extraction
+    for(size_t i = 0; i < seenPoints.size(); ++i)
+        mPointVisited[seenPoints[i]] = false;
+    for(size_t i = 0; i < localPoints.size(); ++i)
+        mLocalPointIds[localPoints[i]] = -1;
+    for(size_t i = 0; i < cells.size(); ++i)
+        mCellVisited[cells[i]] = false;
 
-    /*
-    vtkSmartPointer<vtkPolyDataConnectivityFilter> connectFilter = vtkSmartPointer<vtkPolyDataConnectivityFilter>::New();
-    connectFilter->SetInput(mPolyDataFlat);
-    connectFilter->AddSeed(localTargetFaceID);
-    connectFilter->SetExtractionModeToCellSeededRegions();
-    connectFilter->Update();
-    mPolyDataFlat->ShallowCopy(connectFilter->GetOutput());
-
-    qDebug() << "numvertsflat" << mPolyDataFlat->GetPoints()->GetNumberOfPoints();
-    */
-	vtkPolyData *temp;
-	return temp;
+    return mPolyDataFlat;
 }
 
 void vtkInteractorStyleSurfaceWalkerCamera::flattenSubset()
 {
+    // toggles the live flat view: while it is on, every step of the walk
+    // re-flattens the region under the camera in the background
+    if(mLiveFlatten)
+    {
+        stopFlattening();
+        return;
+    }
+    mLiveFlatten = true;
+    requestFlattening();
+}
+
+void vtkInteractorStyleSurfaceWalkerCamera::stopFlattening()
+{
+    mLiveFlatten = false;
+    if(mFlattener)
+        mFlattener->cancel();
+    mVTKWidget->setNonFlattenedMesh();
+}
+
+void vtkInteractorStyleSurfaceWalkerCamera::requestFlattening()
+{
+    if(!mFlattener || !GetCurrentRenderer() || targetFaceID < 0)
+        return;
+
     int viewportWidth = GetCurrentRenderer()->GetSize()[0];
     int viewportHeight = GetCurrentRenderer()->GetSize()[1];
-    qDebug() << "Viewport: " << viewportWidth << "x" << viewportHeight;
     double viewFocus[3], topRight[3], diag[3];
     ComputeWorldToDisplay(mViewTarget[0], mViewTarget[1], mViewTarget[2], viewFocus);
     double focalDepth = viewFocus[2];
@@ -434,65 +566,19 @@ void vtkInteractorStyleSurfaceWalkerCamera::flattenSubset()
     diag[1] = mViewTarget[1] - topRight[1];
     diag[2] = mViewTarget[2] - topRight[2];
     mExtractRadius = vtkMath::Norm(diag);
-    qDebug() << "Radius: " << mExtractRadius;
 
+    // extraction is cheap and stays here; the solve and the alignment with the
+    // target face run on the flattener's thread
     extractSubset(mExtractRadius);
-    lscm_engine->FlattenMesh(mPolyDataFlat.GetPointer());
-    alignFlatMeshWith3D();
-    mPolyDataFlat->GetCenter(mViewTargetFlat);
-    renderFlat = true;
-    mVTKWidget->setFlattenedMesh(mPolyDataFlat);
-}
-
-void vtkInteractorStyleSurfaceWalkerCamera::alignFlatMeshWith3D()
-{
     vtkSmartPointer<vtkIdList> vertexList = vtkSmartPointer<vtkIdList>::New();
-    vtkSmartPointer<vtkIdList> vertexListFlat = vtkSmartPointer<vtkIdList>::New();
-
-    mPolyData->GetCellPoints(targetFaceID,vertexList);
-    int vID0 = vertexList->GetId(0);
-    int vID1 = vertexList->GetId(1);
-    int vID2 = vertexList->GetId(2);
-    //qDebug() << "global target: " << vID0 << ", " << vID1 << ", " << vID2;
-
-    mPolyDataFlat->GetCellPoints(localTargetFaceID,vertexListFlat);
-    int vID0flat = vertexListFlat->GetId(0);
-    int vID1flat = vertexListFlat->GetId(1);
-    int vID2flat = vertexListFlat->GetId(2);
-    //qDebug() << "local target: " << vID0flat << ", " << vID1flat << ", " << vID2flat;
-
-    double p0[3], p1[3], p2[3];
-    double q0[3], q1[3], q2[3];
-
-    mPolyData->GetPoints()->GetPoint(vID0,p0);
-    mPolyData->GetPoints()->GetPoint(vID1,p1);
-    mPolyData->GetPoints()->GetPoint(vID2,p2);
-
-    mPolyDataFlat->GetPoints()->GetPoint(vID0flat,q0);
-    mPolyDataFlat->GetPoints()->GetPoint(vID1flat,q1);
-    mPolyDataFlat->GetPoints()->GetPoint(vID2flat,q2);
-
-    vtkSmartPointer<vtkLandmarkTransform> landmarkTransform = vtkSmartPointer<vtkLandmarkTransform>::New();
-    vtkSmartPointer<vtkPoints> sourcePts = vtkSmartPointer<vtkPoints>::New();
-    sourcePts->InsertNextPoint(q0);
-    sourcePts->InsertNextPoint(q1);
-    sourcePts->InsertNextPoint(q2);
-    vtkSmartPointer<vtkPoints> targetPts = vtkSmartPointer<vtkPoints>::New();
-    targetPts->InsertNextPoint(p0);
-    targetPts->InsertNextPoint(p1);
-    targetPts->InsertNextPoint(p2);
-    landmarkTransform->SetSourceLandmarks(sourcePts);
-    landmarkTransform->SetTargetLandmarks(targetPts);
-    landmarkTransform->SetModeToSimilarity();
-    landmarkTransform->Update();
-
-    vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-    transformFilter->SetInput(mPolyDataFlat);
-    transformFilter->SetTransform(landmarkTransform);
-    transformFilter->Update();
-    //vtkMatrix4x4* mat = landmarkTransform->GetMatrix();
-    //std::cout << "Matrix: " << *mat << std::endl;
-    mPolyDataFlat = transformFilter->GetOutput();
+    mPolyData->GetCellPoints(targetFaceID, vertexList);
+    if(vertexList->GetNumberOfIds() < 3)
+        return;
+    double target[3][3];
+    for(int k = 0; k < 3; ++k)
+        mPolyData->GetPoint(vertexList->GetId(k), target[k]);
+    mFlattener->request(mPolyDataFlat, localTargetFaceID, target);
+    mPolyDataFlat = NULL; // owned by the job from now on
 }
 
 void vtkInteractorStyleSurfaceWalkerCamera::stickTargetToSurface(vtkCamera *camera, double rayRadius)
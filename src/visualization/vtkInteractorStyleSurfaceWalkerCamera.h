@@ -31,11 +31,13 @@
 #include <vtkCellLocator.h>
 #include <vtkKdTreePointLocator.h>
 #include <vtkCamera.h>
+#include <vector>
 
 class vtkMatrix4x4;
 class vtkPolyData;
 class VtkWidget;
-class LSCM;
+class MeshFlattener;
+class MeshLocator;
 
 /**
  * This class is to designed to provide surface walker camera mode. It is not being used!
@@ -48,12 +50,13 @@ public:
     vtkInteractorStyleSurfaceWalkerCamera();
     vtkTypeRevisionMacro(vtkInteractorStyleSurfaceWalkerCamera,vtkInteractorStyleTrackballCamera);
 
-    void linkPolyData(vtkPolyData *polyData, vtkCamera *camera);
+    void linkPolyData(vtkPolyData *polyData, vtkCamera *camera, MeshLocator *locator);
     void linkVtkWidget(VtkWidget *_vtkWidget);
+    void linkFlattener(MeshFlattener *flattener) { mFlattener = flattener; }
 
+    // turns the live flat view under the camera on or off
     void flattenSubset();
     vtkPolyData *extractSubset(double R);
-    void alignFlatMeshWith3D();
 
     virtual void OnLeftButtonDown();
     virtual void OnLeftButtonUp();
@@ -63,7 +66,6 @@ public:
 private:
     double mCamPos[3];
     double mViewTarget[3];
-    double mViewTargetFlat[3];
     double mCurrentGravity[3];
     double mCurrentUpVector[3];
     double mCurrentRightVector[3];
@@ -82,11 +84,21 @@ private:
     vtkSmartPointer<vtkKdTreePointLocator> kdTree;
     vtkSmartPointer<vtkIdTypeArray> originalCellIDs;
 
-    LSCM *lscm_engine;
+    // CSR vertex -> cell adjacency of mPolyData, built on the first extraction
+    void buildAdjacency();
+    vtkPolyData *mAdjacencyMesh;
+    std::vector<int> mPointCellOffsets;
+    std::vector<int> mPointCells;
+    std::vector<vtkIdType> mLocalPointIds; // -1 outside the subset being extracted
+    std::vector<bool> mPointVisited;
+    std::vector<bool> mCellVisited;
 
-    VtkWidget *mVTKWidget;
+    void requestFlattening();
+    void stopFlattening();
+    MeshFlattener *mFlattener;
+    bool mLiveFlatten;
 
-    bool renderFlat;
+    VtkWidget *mVTKWidget;
 
     double mExtractRadius;
 };
@@ -76,6 +76,8 @@
 
 #include <vtkDoubleArray.h>
 #include <vtkCellData.h>
+#include <vtkLODActor.h>
+#include <vtkMapperCollection.h>
 
 #include <vtkWindowToImageFilter.h> // Screenshot
 #include <vtkPNGWriter.h> // Screenshot
@@ -164,6 +166,10 @@ VtkWidget::VtkWidget(QWidget * parent)
   :  QWidget()
 {
   this->setParent(parent);
+  connect(&mMeshLOD, SIGNAL(levelsReady()), this, SLOT(attachMeshLevels()));
+  connect(&mMeshFlattener, SIGNAL(flattened()), this, SLOT(showFlattenedMesh()));
+  connect(&mInputImageCache, SIGNAL(imageReady(int)), this, SLOT(showBestImage()));
+  connect(&mSpectralAnalysis, SIGNAL(principalComponentsReady(int)), this, SLOT(showPrincipalComponents(int)));
   initializeMainWindow();
 }
 
@@ -172,6 +178,10 @@ VtkWidget::VtkWidget(VtkView *mvcont)
   :  QWidget()
 {
   this->setParent(mvcont);
+  connect(&mMeshLOD, SIGNAL(levelsReady()), this, SLOT(attachMeshLevels()));
+  connect(&mMeshFlattener, SIGNAL(flattened()), this, SLOT(showFlattenedMesh()));
+  connect(&mInputImageCache, SIGNAL(imageReady(int)), this, SLOT(showBestImage()));
+  connect(&mSpectralAnalysis, SIGNAL(principalComponentsReady(int)), this, SLOT(showPrincipalComponents(int)));
   id = mvcont->getNextViewerId();
   mFileInfoDialog = NULL;
 
@@ -464,6 +474,7 @@ void VtkWidget::connectSignals()
   connect(this, SIGNAL(currentWidgetModeChanged(WidgetMode)), mw()->mLightControl, SLOT( updateLightControl(WidgetMode) ) );
   connect(this, SIGNAL(resetLightControl()), mw()->mLightControl, SLOT( reset() ) );
   connect(this, SIGNAL(currentHyperPixelsChanged(std::vector<float>, std::vector<float>, const int*, const std::string*)), mw()->mPlotView, SLOT(updateSpectralPlot(std::vector<float>, std::vector<float>, const int*, const std::string*)) );
+  connect(this, SIGNAL(currentRegionSpectrumChanged(std::vector<float>, std::vector<float>, std::vector<float>, int)), mw()->mPlotView, SLOT(updateRegionSpectralPlot(std::vector<float>, std::vector<float>, std::vector<float>, int)) );
 
   }
 }
@@ -549,6 +560,14 @@ void VtkWidget::openPointNoteMark(const int cellId)
 void VtkWidget::openSurfaceNoteMark(vtkSmartPointer<vtkSelectionNode> cellIds, QVector<double*> cornerPoints, bool isCTVolume)
 {
 	mCallback3D->openSurfaceNoteMark(cellIds, cornerPoints.toStdVector(), isCTVolume);
+	if (!isCTVolume && cellIds)
+	{
+		// plot the average spectrum over the texture area of the note
+		std::vector<float> mean, stddev;
+		SpectralProbe probe = getSpectralProbe();
+		int numPixels = probe.getRegionStatistics(mVtkPolyData, vtkIdTypeArray::SafeDownCast(cellIds->GetSelectionList()), mean, stddev);
+		plotRegionSpectrum(mean, stddev, numPixels);
+	}
 }
 
 void VtkWidget::openFrustumNoteMark(vtkSmartPointer<vtkPoints> points, vtkSmartPointer<vtkDataArray> normals)
@@ -595,12 +614,254 @@ void VtkWidget::openPointNote2DMark(double* point)
 void VtkWidget::openSurfaceNote2DMark(double* point)
 {
 	mCallback2D->openSurfaceNoteMark(point);
+	if (mWidgetMode == IMAGE2D)
+	{
+		std::vector<float> mean, stddev;
+		SpectralProbe probe = getSpectralProbe();
+		int numPixels = probe.getRegionStatistics(point, mean, stddev);
+		plotRegionSpectrum(mean, stddev, numPixels);
+	}
 }
 
 void VtkWidget::openPolygonNote2DMark(std::vector<std::pair<double, double> >* polygon)
 {
 	mCallback2D->openPolygonNoteMark(polygon);
 	//// TO BE TESTED
+	if (mWidgetMode == IMAGE2D && polygon)
+	{
+		std::vector<float> mean, stddev;
+		SpectralProbe probe = getSpectralProbe();
+		int numPixels = probe.getRegionStatistics(*polygon, mean, stddev);
+		plotRegionSpectrum(mean, stddev, numPixels);
+	}
+}
+
+SpectralProbe VtkWidget::getSpectralProbe()
+{
+  int hdims[3] = {0,0,0};
+  if (mHyperImageData) mHyperImageData->GetDimensions(hdims);
+  if (hdims[0] != 0 || hdims[1] != 0) // hyperspectral data
+    return SpectralProbe(mHyperImageData);
+  if (mWidgetMode == MODEL3D) // RGB texture
+    return SpectralProbe(mRgbTexture ? mRgbTexture->GetInput() : NULL);
+  return SpectralProbe(mVtkImageData); // RGB image
+}
+
+bool VtkWidget::isSpectralImageReady()
+{
+  // nothing to build (or wait for) without a float cube
+  if (mBandCube.isReady() || mBandCube.getNumberOfBands() <= 0)
+    return true;
+  mBandCube.build(); // no-op while it is running
+  return false;
+}
+
+bool VtkWidget::setFalseColorComposite(int r, int g, int b)
+{
+  if (mWidgetMode != IMAGE2D || !mIsHyperspectral || !mVtkImageViewer || !mVtkImageData)
+    return false;
+
+  if (!mFalseColorImageData)
+    mFalseColorImageData = vtkSmartPointer<vtkImageData>::New();
+  if (!mBandCube.composite(r, g, b, mFalseColorImageData))
+    return false;
+  showFalseColorImage();
+  return true;
+}
+
+bool VtkWidget::setSpectralImage(SpectralImageMode mode, int r, int g, int b)
+{
+  if (mode == BANDCOMPOSITE)
+    return setFalseColorComposite(r, g, b);
+  if (mWidgetMode != IMAGE2D || !mIsHyperspectral || !mVtkImageViewer || !mVtkImageData)
+    return false;
+
+  const float* planes[3] = {NULL, NULL, NULL};
+  switch (mode)
+  {
+  default:
+  case BANDRATIO:
+    planes[0] = planes[1] = planes[2] = mSpectralAnalysis.getBandRatio(r, g);
+    break;
+  case NORMALIZEDDIFFERENCE:
+    planes[0] = planes[1] = planes[2] = mSpectralAnalysis.getNormalizedDifference(r, g);
+    break;
+  }
+  if (!planes[0] || !planes[1] || !planes[2])
+    return false;
+
+  if (!mFalseColorImageData)
+    mFalseColorImageData = vtkSmartPointer<vtkImageData>::New();
+  int width = mSpectralAnalysis.getWidth();
+  int height = mSpectralAnalysis.getHeight();
+  mFalseColorImageData->SetDimensions(width, height, 1);
+  mFalseColorImageData->SetScalarTypeToUnsignedChar();
+  mFalseColorImageData->SetNumberOfScalarComponents(3);
+  mFalseColorImageData->AllocateScalars();
+  unsigned char* rgb = static_cast<unsigned char*>(mFalseColorImageData->GetScalarPointer());
+  SpectralAnalysis::stretchToBytes(planes[0], width * height, rgb, 3);
+  for (int k = 1; k < 3; k++)
+  {
+    if (planes[k] != planes[0])
+      SpectralAnalysis::stretchToBytes(planes[k], width * height, rgb + k, 3);
+    else // gray image
+      for (int p = 0; p < width * height; p++)
+        rgb[3 * p + k] = rgb[3 * p];
+  }
+  mFalseColorImageData->Modified();
+
+  showFalseColorImage();
+  return true;
+}
+
+bool VtkWidget::openPrincipalComponents(int numComponents)
+{
+  if (mWidgetMode != IMAGE2D || !mIsHyperspectral || mSpectralAnalysis.getNumberOfBands() <= 0)
+    return false;
+  mSpectralAnalysis.computePrincipalComponents(numComponents);
+  return true;
+}
+
+void VtkWidget::showPrincipalComponents(int numComponents)
+{
+  // every component becomes an image object of its own, opened like any other image
+  QString folder = QDir::toNativeSeparators(QDir::tempPath());
+  QString baseName = QFileInfo(mFilename).completeBaseName();
+  int width = mSpectralAnalysis.getWidth();
+  int height = mSpectralAnalysis.getHeight();
+  QStringList fileNames;
+  for (int m = 0; m < numComponents; m++)
+  {
+    const float* plane = mSpectralAnalysis.getPrincipalComponent(m, numComponents);
+    if (!plane)
+      return;
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(width, height, 1);
+    image->SetScalarTypeToUnsignedChar();
+    image->SetNumberOfScalarComponents(3);
+    image->AllocateScalars();
+    unsigned char* rgb = static_cast<unsigned char*>(image->GetScalarPointer());
+    SpectralAnalysis::stretchToBytes(plane, width * height, rgb, 3);
+    for (int p = 0; p < width * height; p++) // gray image
+      rgb[3 * p + 1] = rgb[3 * p + 2] = rgb[3 * p];
+
+    QString fileName = folder + QDir::separator() + QString("%1_PC%2of%3.png").arg(baseName).arg(m + 1).arg(numComponents);
+    vtkSmartPointer<vtkPNGWriter> writer = vtkSmartPointer<vtkPNGWriter>::New();
+    writer->SetFileName(fileName.toLocal8Bit().data());
+    writer->SetInput(image);
+    writer->Write();
+    fileNames.append(fileName);
+  }
+
+  MainWindow* mainWindow = mw();
+  for (int m = 0; m < fileNames.size(); m++)
+    mainWindow->openImages(fileNames[m]);
+}
+
+void VtkWidget::showFalseColorImage()
+{
+  mFalseColorImageData->SetOrigin(mVtkImageData->GetOrigin());
+  mFalseColorImageData->SetSpacing(mVtkImageData->GetSpacing());
+
+  if (!mIsFalseColorOn)
+  {
+    mIsFalseColorOn = true;
+    mVtkImageViewer->SetInput(mFalseColorImageData);
+  }
+  refresh2D();
+}
+
+void VtkWidget::setTrueColor()
+{
+  if (!mIsFalseColorOn)
+    return;
+  mIsFalseColorOn = false;
+  if (mVtkImageViewer && mVtkImageData)
+  {
+    mVtkImageViewer->SetInput(mVtkImageData);
+    refresh2D();
+  }
+}
+
+void VtkWidget::setSimilarityMapOn(bool on)
+{
+  if (on && !mIsSimilarityMapOn)
+  {
+    // norms are computed with the first reference, here we only check the cube
+    if (!mSimilarity.isValid())
+      mSimilarity.setImageData(mHyperImageData);
+    if (mSimilarity.isValid() && !mHyperPixels.empty())
+      mSimilarity.setReference(mHyperPixels, mSimilarityMetric);
+  }
+  mIsSimilarityMapOn = on;
+  refreshSimilarityMap();
+}
+
+void VtkWidget::setSimilarityMetric(SimilarityMetric metric)
+{
+  mSimilarityMetric = metric;
+  if (mIsSimilarityMapOn && !mHyperPixels.empty() && mSimilarity.setReference(mHyperPixels, mSimilarityMetric))
+    refreshSimilarityMap();
+}
+
+void VtkWidget::setSimilarityThreshold(double fraction)
+{
+  mSimilarityThreshold = fraction;
+  if (mIsSimilarityMapOn)
+    refreshSimilarityMap();
+}
+
+void VtkWidget::refreshSimilarityMap()
+{
+  static const unsigned char highlight[4] = {255, 0, 255, 160}; // magenta
+  bool isShown = mIsSimilarityMapOn && mSimilarity.hasReference();
+  float threshold = (float)(mSimilarityThreshold * mSimilarity.getMaxScore());
+
+  if (mWidgetMode == IMAGE2D && mRenderer && mVtkImageData)
+  {
+    if (!mSimilarityActor)
+    {
+      mSimilarityImageData = vtkSmartPointer<vtkImageData>::New();
+      mSimilarityActor = vtkSmartPointer<vtkImageActor>::New();
+      mSimilarityActor->PickableOff();
+    }
+    if (isShown)
+    {
+      mSimilarity.makeOverlay(threshold, highlight, mSimilarityImageData);
+      mSimilarityImageData->SetOrigin(mVtkImageData->GetOrigin());
+      mSimilarityImageData->SetSpacing(mVtkImageData->GetSpacing());
+      mSimilarityActor->SetInput(mSimilarityImageData);
+      mSimilarityActor->SetInterpolate(mIsInterpolateOn);
+      mSimilarityActor->SetPosition(0, 0, 0.01); // just above the image
+      if (!mRenderer->HasViewProp(mSimilarityActor))
+        mRenderer->AddViewProp(mSimilarityActor);
+    }
+    else if (mRenderer->HasViewProp(mSimilarityActor))
+      mRenderer->RemoveViewProp(mSimilarityActor);
+    refresh2D();
+  }
+  else if (mWidgetMode == MODEL3D && mActor && mRgbTexture)
+  {
+    if (isShown)
+    {
+      if (!mSimilarityTexture)
+      {
+        mSimilarityImageData = vtkSmartPointer<vtkImageData>::New();
+        mSimilarityTexture = vtkSmartPointer<vtkTexture>::New();
+        mSimilarityTexture->SetInput(mSimilarityImageData);
+      }
+      if (!mSimilarity.blendOverlay(threshold, highlight, mRgbTexture->GetInput(), mSimilarityImageData))
+        mSimilarityTexture = NULL; // texture and cube sizes differ
+    }
+    refresh3D();
+  }
+}
+
+void VtkWidget::plotRegionSpectrum(const std::vector<float>& mean, const std::vector<float>& stddev, int numPixels)
+{
+  if (numPixels <= 0 || mean.size() != mWavelengths.size())
+    return;
+  emit currentRegionSpectrumChanged(mWavelengths, mean, stddev, numPixels);
 }
 
 void VtkWidget::loadPointNote2DMark(double* point, const ColorType color, bool isDisplay)
@@ -636,6 +897,15 @@ void VtkWidget::setVisibilityDistance(bool status)
   update();
 }
 
+void VtkWidget::setMeasureGeodesic(bool status)
+{
+  mMeasureGeodesic = status;
+  if (mMeasureGeodesic && mWidgetMode == MODEL3D)
+    mMeshGeodesic.build(mVtkPolyData); // in the background, the first measurement waits for it
+  if (mCallback3D) mCallback3D->SetUseGeodesic(mMeasureGeodesic);
+  update();
+}
+
 
 void VtkWidget::setOrthogonalView(OrthogonalView3D view)
 {
@@ -745,6 +1015,7 @@ void VtkWidget::initializeMainWindow()
   mIsDirectionalLight = true;
   mUseRubberband = false;
   mIsRubberbandVisible = false;
+  mMeasureGeodesic = false;
   mUserIsAnnotating = false;
   mWidgetMode = EMPTYWIDGET;
   mQVTKWidget = NULL;
@@ -824,6 +1095,10 @@ void VtkWidget::initializeMainWindow()
   mIsInterpolateOn = false;
   mDisplayInfoOn = true;
   mIsHyperspectral = false;
+  mIsFalseColorOn = false;
+  mIsSimilarityMapOn = false;
+  mSimilarityMetric = SPECTRALANGLE;
+  mSimilarityThreshold = 0.1;
   //================================================================
   int width = this->frameGeometry().width();
   int height = this->frameGeometry().height();
@@ -1234,7 +1509,7 @@ void VtkWidget::refresh3D()
     mRgbTexture->Modified();
 
     if (mIsTextureOn)
-      mActor->SetTexture(mRgbTexture);
+      mActor->SetTexture(getDisplayTexture());
     else
       mActor->SetTexture(NULL);
     mActor->Modified();
@@ -1323,6 +1598,8 @@ void VtkWidget::setTrackballCameraMode()
 
     mCameraMode3D = TRACKBALLMODE;
 	mLastCameraMode3D = TRACKBALLMODE;
+    mMeshFlattener.cancel();
+    setNonFlattenedMesh(); // the live flat view ends with the walker
     vtkSmartPointer<vtkInteractorStyleTrackballCamera> style = vtkSmartPointer<vtkInteractorStyleTrackballCamera>::New();
     mCallback3D->GetInteractor()->SetInteractorStyle(style);
 
@@ -1342,7 +1619,8 @@ void VtkWidget::setSurfaceWalkerCameraMode()
     style->SetDefaultRenderer(mRenderer);
     style->SetCurrentRenderer(mRenderer);
     style->linkVtkWidget(this);
-    style->linkPolyData(mVtkPolyData, mCamera);
+    style->linkFlattener(&mMeshFlattener);
+    style->linkPolyData(mVtkPolyData, mCamera, &mMeshLocator);
 /*
     style->AddObserver(vtkCommand::MouseMoveEvent, mCallback3D);
     style->AddObserver(vtkCommand::LeftButtonPressEvent, mCallback3D);
@@ -1413,8 +1691,8 @@ void VtkWidget::Rendering3D()
 //------------------------------------------------------------------------------------------
   // Material Property Control
   // Actor: For setting colors, surface properties, and the position of the object
-  mActor = vtkSmartPointer<vtkActor>::New();
-  mActor->SetMapper(mMapper);
+  createModelActor();
+  mMeshLocator.build(mVtkPolyData); // in the background, pickers use it once it is ready
   //VTK Shading option.
   mActor->GetProperty()->SetInterpolationToFlat();
 //  mActor->GetProperty()->SetInterpolationToGouraud();
@@ -1470,7 +1748,7 @@ void VtkWidget::Rendering3D()
     //texture
     if (mIsTextureOn && !mRgbTextureFilename.isEmpty())
     { qDebug() << "rendering mRgbTextureFilename = " << mRgbTextureFilename;
-        mActor->SetTexture(mRgbTexture);
+        mActor->SetTexture(getDisplayTexture());
     }
     else
         mActor->SetTexture(NULL);
@@ -1562,6 +1840,11 @@ void VtkWidget::Rendering3D()
   mCallback3D->SetRgbTexture(mRgbTexture);
   mCallback3D->SetHyperImageData(mHyperImageData);
   mCallback3D->SetPolyData(mVtkPolyData);
+  mCallback3D->SetMeshLocator(&mMeshLocator);
+  mCallback3D->SetMeshGeodesic(&mMeshGeodesic);
+  mCallback3D->SetUseGeodesic(mMeasureGeodesic);
+  if (mMeasureGeodesic)
+    mMeshGeodesic.build(mVtkPolyData);
   mCallback3D->SetGLversion(mGLversion);
   mCallback3D->SetNumCore(mNumCore);
   mCallback3D->SetModelDetail(mNumberOfPoints, mNumberOfPolys, mNumberOfStrips, mNumberOfLines, mNumberOfVerts, mNumberOfCells);
@@ -1572,6 +1855,7 @@ void VtkWidget::Rendering3D()
   QString simplefn2 = fi2.fileName();
   mCallback3D->SetTextureFilename(simplefn2);
   mCallback3D->inputImageSet = inputImageSet;
+  mCallback3D->SetInputImageCache(&mInputImageCache);
 
   // link surface walker camera will poly data
   //style->linkPolyData(mVtkPolyData, mCamera);
@@ -1633,8 +1917,7 @@ void VtkWidget::refreshGeometry3D()
   mMapper->SetInputConnection(mVtkPolyData->GetProducerPort()); // this is new version (on July 16)
   mMapper->ScalarVisibilityOff();
 
-  mActor = vtkSmartPointer<vtkActor>::New();
-  mActor->SetMapper(mMapper);
+  createModelActor();
   mActor->GetProperty()->SetInterpolationToFlat();
 
   mNumberOfPoints = mVtkPolyData->GetNumberOfPoints();
@@ -1677,7 +1960,7 @@ void VtkWidget::refreshGeometry3D()
 
     if (mIsTextureOn && !mRgbTextureFilename.isEmpty())
     {
-        mActor->SetTexture(mRgbTexture);
+        mActor->SetTexture(getDisplayTexture());
     }
     else
         mActor->SetTexture(NULL);
@@ -1726,6 +2009,43 @@ void VtkWidget::refreshGeometry3D()
   mQVTKWidget->update(); //MK: this is important!
 }
 
+void VtkWidget::createModelActor()
+{
+  mMeshLOD.clear();
+  if (MeshLOD::isLarge(mVtkPolyData))
+  {
+    // vtkLODActor draws a coarser level when the full mesh does not fit the
+    // interactive frame time, and the full mesh again once the camera stops.
+    // Until the pyramid is built, the full mapper stands in for the levels
+    // (otherwise vtkLODActor falls back to its own point cloud and outline).
+    vtkSmartPointer<vtkLODActor> lodActor = vtkSmartPointer<vtkLODActor>::New();
+    lodActor->AddLODMapper(mMapper);
+    mActor = lodActor;
+    mMeshLOD.build(mVtkPolyData);
+  }
+  else
+  {
+    mActor = vtkSmartPointer<vtkActor>::New();
+  }
+  mActor->SetMapper(mMapper); // picking always resolves against this mapper's full resolution input
+}
+
+void VtkWidget::attachMeshLevels()
+{
+  vtkLODActor* lodActor = vtkLODActor::SafeDownCast(mActor);
+  if (!lodActor || mMeshLOD.getInput() != mVtkPolyData || mMeshLOD.getNumberOfLevels() == 0)
+    return;
+
+  lodActor->GetLODMappers()->RemoveAllItems();
+  for (int k = 0; k < mMeshLOD.getNumberOfLevels(); k++)
+  {
+    vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+    mapper->SetInput(mMeshLOD.getLevel(k));
+    mapper->ScalarVisibilityOff();
+    lodActor->AddLODMapper(mapper);
+  }
+}
+
 // Note: some of this code was borrowed and modified from the VTK screenshot tutorial/example code.
 //
 // http://www.vtk.org/Wiki/VTK/Examples/Cxx/Utilities/Screenshot
@@ -2038,7 +2358,10 @@ void VtkWidget::Rendering2D()
   // This part is the crashing point in the deploy mode
   // connect the data to the imageviewer
 
-  mVtkImageViewer->SetInput(mVtkImageData); // we use only mVTKImageData for RGB display
+  if (mIsFalseColorOn && mFalseColorImageData)
+    mVtkImageViewer->SetInput(mFalseColorImageData); // band composite of mHyperImageData
+  else
+    mVtkImageViewer->SetInput(mVtkImageData); // we use only mVTKImageData for RGB display
 
 //  vtkSmartPointer<vtkImageData> tempImageData = vtkSmartPointer<vtkImageData>::New();
 //  int dimss[3];  mVtkImageData->GetDimensions(dimss);
@@ -2714,8 +3037,10 @@ void VtkWidget::testObject()
 }
 
 
-bool VtkWidget::ReadData(QString filename)
+bool VtkWidget::ReadData(QString filename, QString cacheFolder)
 {
+  mCacheFolder = cacheFolder;
+
   //MK: find out file type
   QFileInfo fi(filename);
   mFilename = fi.absoluteFilePath();	//Use the original file path to read data instead of the file that will be copied into project folder. This path will be updated later in mainWindow.cpp
@@ -2818,6 +3143,7 @@ bool VtkWidget::Read3DModels(QString filename)
   mIsDICOM = false;
 
   ReadCHEROb * r3d = new ReadCHEROb;
+  r3d->setCacheFolder(mCacheFolder); // mesh cache and hyperspectral (EXR) textures
 
   if (!(r3d->read3D(filename, mChannelNames, mWavelengths, mRgbTextureFilename, mMaterials, mVtkPolyData, mRgbTexture, mHyperImageData, mIsTextureOn)))
     return false;
@@ -2828,6 +3154,8 @@ bool VtkWidget::Read3DModels(QString filename)
 
   inputImageSet = new InputImageSet();
   inputImageSet->loadImageSetFromPMVSOutput(directory);
+  mInputImageCache.setImageSet(inputImageSet);
+  inputImageSet->buildViewIndex(mVtkPolyData);
 
 //  qDebug() << "IsTextureOn: " << mIsTextureOn;
 //  qDebug() << "mChannelNames size after read3D: " << mChannelNames.size();
@@ -3367,16 +3695,25 @@ void VtkWidget::RenderingStack()
 
 bool VtkWidget::ReadHDRImage(QString filename)
 {
-  ReadCHEROb *rh;
+  ReadCHEROb rh;
   vtkTexture* texture;
 
   // new file should be open with mCTVisualization == STACK always
   mCTVisualization = STACK;
 
-  if (!(rh->readEXR(filename, mChannelNames, mWavelengths, texture, mVtkImageData, mHyperImageData)) )
+  rh.setCacheFolder(mCacheFolder); // decoded cube is cached next to the object's notes
+  if (!(rh.readEXR(filename, mChannelNames, mWavelengths, texture, mVtkImageData, mHyperImageData)) )
     return false;
 
   mIsHyperspectral = true;
+  mIsFalseColorOn = false;
+  mBandCube.setImageData(mHyperImageData); // band-sequential mirror is built when a composite is requested
+  mSimilarity.setImageData(mHyperImageData);
+  int hdims[3] = {0, 0, 0};
+  mHyperImageData->GetDimensions(hdims);
+  bool isFloat = mHyperImageData->GetScalarType() == VTK_FLOAT;
+  mSpectralAnalysis.setCube(isFloat ? static_cast<const float*>(mHyperImageData->GetScalarPointer()) : NULL,
+    hdims[0], hdims[1], mHyperImageData->GetNumberOfScalarComponents(), &mBandCube);
 
   //mkDebug md; md.qDebugImageData(mVtkImageData, mHyperImageData); // fine
   //imagedata1:  626   832   1 :  3
@@ -3551,6 +3888,8 @@ void VtkWidget::getHyperPixelsSignals(vtkObject*, unsigned long, void*, void*)
   if (mCallback3D) {
     mHyperPixels = mCallback3D->GetHyperPixels();
   }
+  if (mIsSimilarityMapOn && mSimilarity.setReference(mHyperPixels, mSimilarityMetric))
+    refreshSimilarityMap();
   std::string fname = this->mFilename.toStdString();
   emit currentHyperPixelsChanged(mWavelengths, mHyperPixels, &icoords[0], &fname);
 }
@@ -3582,12 +3921,49 @@ double VtkWidget::get2DImageWidth()
 
 void VtkWidget::setFlattenedMesh(vtkPolyData *flatMesh)
 {
-    mVtkPolyData = flatMesh;
-    refreshGeometry3D();
+    if(!flatMesh || !mActor)
+        return;
+    if(!mFlatActor)
+    {
+        mFlatMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+        mFlatMapper->ScalarVisibilityOff();
+        mFlatActor = vtkSmartPointer<vtkActor>::New();
+        mFlatActor->SetMapper(mFlatMapper);
+        mFlatActor->PickableOff(); // notes are still picked on the model
+    }
+    mFlatMapper->SetInput(flatMesh);
+    mFlatActor->SetProperty(mActor->GetProperty());
+    mFlatActor->SetTexture(mActor->GetTexture());
+    if(!mRenderer->HasViewProp(mFlatActor))
+        mRenderer->AddActor(mFlatActor);
+    mFlatActor->VisibilityOn();
+    mActor->VisibilityOff();
+    mQVTKWidget->update();
+}
+
+void VtkWidget::showFlattenedMesh()
+{
+    // a solve may finish after the walker was left
+    if(mCameraMode3D != SURFACEWALKERMODE || !mMeshFlattener.getResult())
+        return;
+    setFlattenedMesh(mMeshFlattener.getResult());
 }
 
-void VtkWidget::setNonFlattenedMesh(vtkPolyData *nonFlatMesh)
+void VtkWidget::showBestImage()
 {
-    mVtkPolyData = nonFlatMesh;
-    refreshGeometry3D();
+    if(mWidgetMode != MODEL3D || !mCallback3D)
+        return;
+    mCallback3D->RefreshBestImage();
+}
+
+void VtkWidget::setNonFlattenedMesh()
+{
+    if(mFlatActor)
+    {
+        mRenderer->RemoveActor(mFlatActor);
+        mFlatMapper->SetInput(NULL); // release the flat mesh
+    }
+    if(mActor)
+        mActor->VisibilityOn();
+    mQVTKWidget->update();
 }
@@ -44,6 +44,7 @@
 #include <vtkActor.h>
 #include <QVTKInteractorAdapter.h>
 #include <vtkImageViewer2.h>
+#include <vtkImageActor.h>
 #include <vtkDataSetMapper.h>
 #include <vtkMatrix4x4.h>
 #include <vtkSmartVolumeMapper.h>
@@ -86,6 +87,15 @@
 #include "../information/metadata.h"
 #include "../vtkEnums.h"
 #include "../information/fileInfoDialog.h"
+#include "../function/spectralProbe.h"
+#include "../function/bandCube.h"
+#include "../function/spectralAnalysis.h"
+#include "../function/spectralSimilarity.h"
+#include "../function/meshLOD.h"
+#include "../function/meshLocator.h"
+#include "../function/meshFlattener.h"
+#include "../function/meshGeodesic.h"
+#include "../io/inputimagecache.h"
 
 
 //-------------------By YY----------------------------------
@@ -143,7 +153,7 @@ public:
 
   int getId() {return id;}
   bool isCurrent() { return mvc()->currentId == this->id;}
-  bool ReadData(QString filename);
+  bool ReadData(QString filename, QString cacheFolder = QString());
   bool isDICOM() {return mIsDICOM;}
   bool isRTI() {return mIsRTI;}
   void zoomIn();
@@ -159,6 +169,7 @@ public:
 
   void setMeasureDistance(bool useRubberband);
   void setVisibilityDistance(bool removeRubberband);
+  void setMeasureGeodesic(bool alongSurface);
   void rubberbandStart();
   void rubberbandEnd();
 
@@ -174,6 +185,7 @@ public:
   int getSliceCurrent() const {return mSliceCurrent;}
   bool getUseRubberband() const {return mUseRubberband;}
   bool getIsRubberbandVisible() const {return mIsRubberbandVisible;}
+  bool getMeasureGeodesic() const {return mMeasureGeodesic;}
   CTOrientation getOrientationCurrent() const {return mOrientationCurrent;}
   CTVisualization getCTVisualization() const {return mCTVisualization;}
   int getBlendType() const {return mBlendType;}
@@ -216,11 +228,32 @@ public:
   void setOrthogonalView(OrthogonalView3D view);
   void launchSpinView();
 
+  // the flat view has its own actor; the model, its LOD pyramid and locators are left alone
   void setFlattenedMesh(vtkPolyData *flatMesh);
-  void setNonFlattenedMesh(vtkPolyData *nonFlatMesh);
+  void setNonFlattenedMesh();
   void flattenMesh();
 
   vtkSmartPointer<vtkPolyData> get3DPolyData()	const {return mVtkPolyData;}
+  SpectralProbe getSpectralProbe();
+  // false-colour composite of three hyperspectral bands for 2D images
+  bool setFalseColorComposite(int r, int g, int b);
+  // band ratio images; r and g select the bands of BANDRATIO and NORMALIZEDDIFFERENCE
+  bool setSpectralImage(SpectralImageMode mode, int r, int g, int b);
+  // starts the PCA in the background; each of the numComponents components is then
+  // opened as an image of its own
+  bool openPrincipalComponents(int numComponents);
+  void setTrueColor();
+  // starts the band-sequential mirror in the background on the first call and is false
+  // until it is built; spectral images would block until then
+  bool isSpectralImageReady();
+  bool getIsFalseColorOn() const {return mIsFalseColorOn;}
+  bool getIsHyperspectral() const {return mIsHyperspectral;}
+  std::vector<float> getWavelengths() const {return mWavelengths;}
+  // overlay of the pixels whose spectrum matches the last probed one
+  void setSimilarityMapOn(bool on);
+  void setSimilarityMetric(SimilarityMetric metric);
+  void setSimilarityThreshold(double fraction); // fraction of the largest score in the image
+  bool getIsSimilarityMapOn() const {return mIsSimilarityMapOn;}
 
   double get2DImageHeight();
   double get2DImageWidth();
@@ -248,6 +281,7 @@ signals:
 
   void currentImageChanged();
   void currentHyperPixelsChanged(std::vector<float> wavelengths, std::vector<float> hyperPixels, const int* icoords, const std::string* fname);
+  void currentRegionSpectrumChanged(std::vector<float> wavelengths, std::vector<float> meanPixels, std::vector<float> stdPixels, int numPixels);
 
 public slots:
   void updateDisplayPanel();
@@ -308,6 +342,10 @@ public slots:
 
 protected slots:
   void updateIntensityL12(double intensity1, double intensity2);
+  void attachMeshLevels();
+  void showFlattenedMesh();
+  void showBestImage();
+  void showPrincipalComponents(int numComponents);
   void getHyperPixelsSignals(vtkObject*, unsigned long, void*, void*);
   void saveFileInfo(QWidget* editBox);
 
@@ -324,6 +362,11 @@ private:
   std::vector<float> mWavelengths;
   vtkSmartPointer<vtkLightActor> mLightActor;
 
+  void plotRegionSpectrum(const std::vector<float>& mean, const std::vector<float>& stddev, int numPixels);
+  void showFalseColorImage();
+  void refreshSimilarityMap();
+  vtkTexture* getDisplayTexture() {return (mIsSimilarityMapOn && mSimilarityTexture) ? mSimilarityTexture.GetPointer() : mRgbTexture;}
+
   // all the data set shoulld be transfered as vtkDataSetMapper
   void Rendering3D();
   void RenderingRTIData(); // by YY
@@ -338,6 +381,7 @@ private:
   void RenderingVolume(int blendType = 0, float reductionFactor = 1.0f, CTVolumeRenderMode volumeRenderMode = CPURAYCASTTEXTURE); // default -> cpu rendering
 
   void refreshGeometry3D();
+  void createModelActor();
 
   int id;  //the very important unique id of each subwindow.
 
@@ -374,6 +418,15 @@ private:
   // this member contains pointer to the image data that was read by ITK and VTK
   vtkImageData* mVtkImageData; // RGB for 2D images (including stack)
   vtkImageData* mHyperImageData; // HyperSpectral Data
+  BandCube mBandCube; // band-sequential mirror of mHyperImageData, built on first use
+  SpectralAnalysis mSpectralAnalysis; // PCA and band ratio images, cached per object
+  SpectralSimilarity mSimilarity; // spectral angle / distance to the probed pixel
+  vtkSmartPointer<vtkImageData> mSimilarityImageData; // 2D: RGBA overlay, 3D: texture with the matches blended in
+  vtkSmartPointer<vtkImageActor> mSimilarityActor;
+  vtkSmartPointer<vtkTexture> mSimilarityTexture;
+  SimilarityMetric mSimilarityMetric;
+  double mSimilarityThreshold;
+  vtkSmartPointer<vtkImageData> mFalseColorImageData; // displayed instead of mVtkImageData when mIsFalseColorOn
   vtkPolyData* mVtkPolyData; // for 3D surface polygon data
   vtkTexture* mRgbTexture;
   vtkDataArray* mTCoords;
@@ -382,7 +435,14 @@ private:
   // for 2/3D rendering
   QString mTFilename;
   vtkSmartPointer<vtkPolyDataMapper> mMapper;  // The previous version is vtkDataSetMapper. To use hardware selector, switch to vtkPolyDataMapper
-  vtkSmartPointer<vtkActor> mActor;
+  vtkSmartPointer<vtkActor> mActor; // a vtkLODActor for large meshes
+  vtkSmartPointer<vtkPolyDataMapper> mFlatMapper; // surface walker flat view, drawn instead of mActor
+  vtkSmartPointer<vtkActor> mFlatActor;
+  MeshLOD mMeshLOD; // decimated levels of mVtkPolyData for interaction
+  MeshLocator mMeshLocator; // cell octree and point kd-tree of the loaded mesh, for picking
+  MeshFlattener mMeshFlattener; // background LSCM solves of the surface walker
+  InputImageCache mInputImageCache; // decoded photos of inputImageSet for the image overlay
+  MeshGeodesic mMeshGeodesic; // triangle adjacency for measuring along the surface, built on first use
   vtkSmartPointer<vtkCamera> mCamera;
   vtkSmartPointer<vtkLight> mLight1;
   vtkSmartPointer<vtkLight> mLight2;
@@ -406,6 +466,8 @@ private:
   VtkView *mparentView;
 
   bool mIsHyperspectral;
+  bool mIsFalseColorOn;
+  bool mIsSimilarityMapOn;
   bool mIsDICOM;
   bool mIsRTI;
   bool mIsTextureOn;
@@ -413,6 +475,7 @@ private:
   bool mDisplayPolyIndicateOn;
   bool mUseRubberband;
   bool mIsRubberbandVisible;
+  bool mMeasureGeodesic;
   bool mIsDirectionalLight;
   bool mUserIsAnnotating;
 
@@ -485,6 +548,7 @@ private:
   int mNumberOfCells;
 
   QString mRgbTextureFilename;
+  QString mCacheFolder; // object folder in the project, for caches of decoded data
   std::vector<std::string> mChannelNames;
   QGLFormat format;
 
@@ -46,6 +46,8 @@ enum NoteType{NOTE2D = 0, NOTE3D, NONE};
 enum NoteMode{UNDECLARE=0, POINTNOTE, SURFACENOTE, POLYGONNOTE, FRUSTUMNOTE, ANNOTATION};
 enum ColorType{MAROON=0, RED, ORANGE, YELLOW, LIME, GREEN, AQUA, BLUE, PINK, PURPLE, WHITE};
 enum LightControlType{Model3DLIGHTCONTROL=0, RTILIGHTCONTROL}; //YY
+enum SimilarityMetric{SPECTRALANGLE=0, EUCLIDEANDISTANCE};
+enum SpectralImageMode{BANDCOMPOSITE=0, BANDRATIO, NORMALIZEDDIFFERENCE};
 
 enum RenderingRTI
 {